@@ -23,6 +23,19 @@
 #include <mousepad/mousepad-window.h>
 #include <mousepad/mousepad-window-ui.h>
 
+#include <glib/gstdio.h>
+
+
+
+/* a document of the open-file index, with the keys it is stored under */
+typedef struct
+{
+  MousepadApplication  *application;
+  MousepadDocument     *document;
+  gchar               **keys;
+}
+MousepadIndexEntry;
+
 
 
 static void        mousepad_application_finalize                  (GObject             *object);
@@ -38,6 +51,10 @@ static void        mousepad_application_new_window                (MousepadWindo
                                                                    MousepadApplication *application);
 static void        mousepad_application_create_languages_menu     (MousepadApplication *application);
 static void        mousepad_application_create_style_schemes_menu (MousepadApplication *application);
+static void        mousepad_application_index_entry_free          (gpointer             data);
+static void        mousepad_application_index_update              (MousepadIndexEntry  *entry);
+static void        mousepad_application_document_finalized        (gpointer             data,
+                                                                   GObject             *document);
 
 
 
@@ -60,6 +77,10 @@ struct _MousepadApplication
   GtkBuilder  *builder;
   GPtrArray   *languages_tooltips, *style_schemes_tooltips;
   guint        n_style_schemes;
+
+  /* the documents of all the windows, by inode and canonical path, and their entries */
+  GHashTable  *documents;
+  GHashTable  *index_entries;
 };
 
 
@@ -110,6 +131,11 @@ mousepad_application_init (MousepadApplication *application)
   mousepad_settings_init ();
   application->prefs_dialog = NULL;
 
+  /* the open-file index, whose entries also own its keys */
+  application->documents = g_hash_table_new (g_str_hash, g_str_equal);
+  application->index_entries = g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL,
+                                                      mousepad_application_index_entry_free);
+
   /* check if we have a saved accel map */
   filename = mousepad_util_get_save_location (MOUSEPAD_ACCELS_RELPATH, FALSE);
   if (G_LIKELY (filename != NULL))
@@ -139,6 +165,9 @@ mousepad_application_finalize (GObject *object)
    * isn't a good option eighter */
   mousepad_replace_dialog_history_clean ();
 
+  /* release the compiled search patterns */
+  mousepad_util_search_regex_cache_clear ();
+
   /* save the current accel map */
   filename = mousepad_util_get_save_location (MOUSEPAD_ACCELS_RELPATH, TRUE);
   if (G_LIKELY (filename != NULL))
@@ -162,6 +191,10 @@ mousepad_application_finalize (GObject *object)
   /* cleanup the list of windows */
   g_slist_free (application->windows);
 
+  /* cleanup the open-file index */
+  g_hash_table_destroy (application->index_entries);
+  g_hash_table_destroy (application->documents);
+
   mousepad_settings_finalize ();
 
   /* destroy the GtkBuilder instance */
@@ -218,8 +251,8 @@ mousepad_application_window_destroyed (GtkWidget           *window,
   /* remove the window from the list */
   application->windows = g_slist_remove (application->windows, window);
 
-  /* quit if there are no windows opened */
-  if (application->windows == NULL)
+  /* quit if there are no windows opened, unless the main loop isn't running yet */
+  if (application->windows == NULL && gtk_main_level () > 0)
     gtk_main_quit ();
 }
 
@@ -242,6 +275,158 @@ mousepad_application_take_window (MousepadApplication *application,
 
 
 
+static gchar **
+mousepad_application_get_file_keys (const gchar *filename)
+{
+  GStatBuf   statb;
+  gchar    **keys;
+  gchar     *path;
+  guint      n = 0;
+
+  keys = g_new0 (gchar *, 3);
+  if (filename == NULL)
+    return keys;
+
+  /* the same file, whatever the path it is opened from */
+  if (g_stat (filename, &statb) == 0)
+    keys[n++] = g_strdup_printf ("inode:%" G_GUINT64_FORMAT ":%" G_GUINT64_FORMAT,
+                                 (guint64) statb.st_dev, (guint64) statb.st_ino);
+
+  /* the path with its symbolic links resolved, or as is for a file not created yet */
+  path = realpath (filename, NULL);
+  keys[n] = g_strconcat ("path:", path != NULL ? path : filename, NULL);
+  free (path);
+
+  return keys;
+}
+
+
+
+static void
+mousepad_application_index_remove_keys (MousepadIndexEntry *entry)
+{
+  GHashTable *documents = entry->application->documents;
+  gchar     **key;
+
+  /* another document may have been stored under the same key since */
+  for (key = entry->keys; *key != NULL; key++)
+    if (g_hash_table_lookup (documents, *key) == entry->document)
+      g_hash_table_remove (documents, *key);
+
+  g_strfreev (entry->keys);
+  entry->keys = NULL;
+}
+
+
+
+static void
+mousepad_application_index_update (MousepadIndexEntry *entry)
+{
+  gchar **key;
+
+  mousepad_application_index_remove_keys (entry);
+
+  /* store the document under the keys of its current file */
+  entry->keys = mousepad_application_get_file_keys (mousepad_file_get_filename (entry->document->file));
+  for (key = entry->keys; *key != NULL; key++)
+    g_hash_table_replace (entry->application->documents, *key, entry->document);
+}
+
+
+
+static void
+mousepad_application_index_entry_free (gpointer data)
+{
+  MousepadIndexEntry *entry = data;
+
+  mousepad_disconnect_by_func (G_OBJECT (entry->document->file),
+                               mousepad_application_index_update, entry);
+  g_object_weak_unref (G_OBJECT (entry->document), mousepad_application_document_finalized, entry);
+
+  mousepad_application_index_remove_keys (entry);
+  g_slice_free (MousepadIndexEntry, entry);
+}
+
+
+
+static void
+mousepad_application_document_finalized (gpointer  data,
+                                         GObject  *document)
+{
+  MousepadIndexEntry *entry = data;
+
+  /* the weak reference is already gone */
+  g_hash_table_steal (entry->application->index_entries, document);
+  mousepad_disconnect_by_func (G_OBJECT (entry->document->file),
+                               mousepad_application_index_update, entry);
+
+  mousepad_application_index_remove_keys (entry);
+  g_slice_free (MousepadIndexEntry, entry);
+}
+
+
+
+void
+mousepad_application_index_document (MousepadApplication *application,
+                                     MousepadDocument    *document)
+{
+  MousepadIndexEntry *entry;
+
+  g_return_if_fail (MOUSEPAD_IS_APPLICATION (application));
+  g_return_if_fail (MOUSEPAD_IS_DOCUMENT (document));
+
+  entry = g_hash_table_lookup (application->index_entries, document);
+  if (entry == NULL)
+    {
+      entry = g_slice_new0 (MousepadIndexEntry);
+      entry->application = application;
+      entry->document = document;
+      g_hash_table_insert (application->index_entries, document, entry);
+
+      /* follow the document until it is destroyed */
+      g_signal_connect_swapped (G_OBJECT (document->file), "filename-changed",
+                                G_CALLBACK (mousepad_application_index_update), entry);
+      g_object_weak_ref (G_OBJECT (document), mousepad_application_document_finalized, entry);
+    }
+
+  mousepad_application_index_update (entry);
+}
+
+
+
+MousepadDocument *
+mousepad_application_find_document (MousepadApplication *application,
+                                    const gchar         *filename)
+{
+  MousepadIndexEntry  *entry;
+  MousepadDocument    *document = NULL;
+  gchar              **keys, **key;
+
+  g_return_val_if_fail (MOUSEPAD_IS_APPLICATION (application), NULL);
+  g_return_val_if_fail (filename != NULL, NULL);
+
+  keys = mousepad_application_get_file_keys (filename);
+  for (key = keys; *key != NULL && document == NULL; key++)
+    {
+      entry = g_hash_table_lookup (application->index_entries,
+                                   g_hash_table_lookup (application->documents, *key));
+      if (entry == NULL)
+        continue;
+
+      /* the file of the document may have been replaced or moved since it was indexed,
+       * and its inode reused by another one */
+      mousepad_application_index_update (entry);
+      if (g_hash_table_lookup (application->documents, *key) == entry->document)
+        document = entry->document;
+    }
+
+  g_strfreev (keys);
+
+  return document;
+}
+
+
+
 static GtkWidget *
 mousepad_application_create_window (MousepadApplication *application)
 {
@@ -364,9 +549,12 @@ mousepad_application_new_window_with_files (MousepadApplication  *application,
       succeed = TRUE;
     }
 
-  /* show the window */
+  /* show the window, or destroy it if all the files failed to open or were already
+   * open in another window */
   if (succeed == TRUE)
     gtk_widget_show (window);
+  else
+    gtk_widget_destroy (window);
 
   return succeed;
 }
@@ -17,7 +17,7 @@
 #ifndef __MOUSEPAD_APPLICATION_H__
 #define __MOUSEPAD_APPLICATION_H__
 
-#include <gtk/gtk.h>
+#include <mousepad/mousepad-document.h>
 
 G_BEGIN_DECLS
 
@@ -40,6 +40,12 @@ gboolean             mousepad_application_has_windows                (MousepadAp
 void                 mousepad_application_take_window                (MousepadApplication  *application,
                                                                       GtkWindow            *window);
 
+void                 mousepad_application_index_document             (MousepadApplication  *application,
+                                                                      MousepadDocument     *document);
+
+MousepadDocument    *mousepad_application_find_document              (MousepadApplication  *application,
+                                                                      const gchar          *filename);
+
 gboolean             mousepad_application_new_window_with_files      (MousepadApplication  *application,
                                                                       GdkScreen            *screen,
                                                                       const gchar          *working_dir,
@@ -19,7 +19,12 @@
 #include <mousepad/mousepad-settings.h>
 #include <mousepad/mousepad-util.h>
 #include <mousepad/mousepad-document.h>
+#include <mousepad/mousepad-folding.h>
+#include <mousepad/mousepad-highlighter.h>
 #include <mousepad/mousepad-marshal.h>
+#include <mousepad/mousepad-minimap.h>
+#include <mousepad/mousepad-overview.h>
+#include <mousepad/mousepad-undo-manager.h>
 #include <mousepad/mousepad-view.h>
 #include <mousepad/mousepad-window.h>
 
@@ -37,12 +42,39 @@ static void      mousepad_document_finalize                (GObject
 static void      mousepad_document_notify_cursor_position  (GtkTextBuffer          *buffer,
                                                             GParamSpec             *pspec,
                                                             MousepadDocument       *document);
+static void      mousepad_document_insert_text             (GtkTextBuffer          *buffer,
+                                                            GtkTextIter            *location,
+                                                            const gchar            *text,
+                                                            gint                    len,
+                                                            MousepadDocument       *document);
+static void      mousepad_document_delete_range            (GtkTextBuffer          *buffer,
+                                                            GtkTextIter            *start,
+                                                            GtkTextIter            *end,
+                                                            MousepadDocument       *document);
+static gint      mousepad_document_get_column              (MousepadDocument       *document,
+                                                            const GtkTextIter      *iter,
+                                                            gint                    tab_size);
 static void      mousepad_document_notify_has_selection    (GtkTextBuffer          *buffer,
                                                             GParamSpec             *pspec,
                                                             MousepadDocument       *document);
+static void      mousepad_document_notify_column_selection (MousepadView           *view,
+                                                            GParamSpec             *pspec,
+                                                            MousepadDocument       *document);
+static void      mousepad_document_tab_width_changed       (MousepadDocument       *document);
+static gboolean  mousepad_document_tick                    (GtkWidget              *widget,
+                                                            GdkFrameClock          *frame_clock,
+                                                            gpointer                data);
+static void      mousepad_document_schedule_tick           (MousepadDocument       *document);
+static void      mousepad_document_user_action             (GtkTextBuffer          *buffer,
+                                                            MousepadDocument       *document);
+static void      mousepad_document_emit_cursor_changed     (MousepadDocument       *document);
+static void      mousepad_document_emit_selection_changed  (MousepadDocument       *document);
 static void      mousepad_document_notify_overwrite        (GtkTextView            *textview,
                                                             GParamSpec             *pspec,
                                                             MousepadDocument       *document);
+static void      mousepad_document_notify_long_lines       (MousepadView           *view,
+                                                            GParamSpec             *pspec,
+                                                            MousepadDocument       *document);
 static void      mousepad_document_notify_language         (GtkSourceBuffer        *buffer,
                                                             GParamSpec             *pspec,
                                                             MousepadDocument       *document);
@@ -57,20 +89,40 @@ static void      mousepad_document_drag_data_received      (GtkWidget
 static void      mousepad_document_filename_changed        (MousepadDocument       *document,
                                                             const gchar            *filename);
 static void      mousepad_document_label_color             (MousepadDocument       *document);
+static gboolean  mousepad_document_query_tab_tooltip       (GtkWidget              *widget,
+                                                            gint                    x,
+                                                            gint                    y,
+                                                            gboolean                keyboard_mode,
+                                                            GtkTooltip             *tooltip,
+                                                            MousepadDocument       *document);
 static void      mousepad_document_tab_button_clicked      (GtkWidget              *widget,
                                                             MousepadDocument       *document);
 
 
+/* distance in characters between two column checkpoints on a long line */
+#define MOUSEPAD_COLUMN_CHECKPOINT_INTERVAL 1024
+
+
+
 enum
 {
   CLOSE_TAB,
   CURSOR_CHANGED,
   SELECTION_CHANGED,
   OVERWRITE_CHANGED,
+  LONG_LINES_CHANGED,
   LANGUAGE_CHANGED,
   LAST_SIGNAL
 };
 
+typedef struct
+{
+  gint offset;
+  gint index;
+  gint column;
+}
+MousepadColumnCheckpoint;
+
 struct _MousepadDocumentClass
 {
   GtkScrolledWindowClass __parent__;
@@ -88,6 +140,41 @@ struct _MousepadDocumentPrivate
   /* utf-8 valid document names */
   gchar               *utf8_filename;
   gchar               *utf8_basename;
+
+  /* multi-term highlighting */
+  MousepadHighlighter *highlighter;
+
+  /* match markers on the scrollbar */
+  MousepadOverview    *overview;
+
+  /* reduced view of the whole document */
+  MousepadMinimap     *minimap;
+
+  /* folded regions of the text */
+  MousepadFolding     *folding;
+
+  /* symbols of the buffer, for the outline panel */
+  MousepadOutline     *outline;
+
+  /* words of the buffer, for completion */
+  MousepadWordIndex   *word_index;
+
+  /* visual column checkpoints on the cursor line, sorted by offset */
+  GArray              *checkpoints;
+  gint                 checkpoints_line;
+  gint                 checkpoints_tab_size;
+
+  /* cursor and selection changes waiting for the next frame */
+  guint                tick_id;
+  guint                cursor_pending : 1;
+  guint                selection_pending : 1;
+  guint                in_user_action : 1;
+
+  /* statusbar fields last emitted, sent again as is on tab switches */
+  gint                 line;
+  gint                 column;
+  gint                 selection_length;
+  gint                 selection;
 };
 
 
@@ -148,6 +235,14 @@ mousepad_document_class_init (MousepadDocumentClass *klass)
                   g_cclosure_marshal_VOID__BOOLEAN,
                   G_TYPE_NONE, 1, G_TYPE_BOOLEAN);
 
+  document_signals[LONG_LINES_CHANGED] =
+    g_signal_new (I_("long-lines-changed"),
+                  G_TYPE_FROM_CLASS (gobject_class),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL,
+                  g_cclosure_marshal_VOID__BOOLEAN,
+                  G_TYPE_NONE, 1, G_TYPE_BOOLEAN);
+
   document_signals[LANGUAGE_CHANGED] =
     g_signal_new (I_("language-changed"),
                   G_TYPE_FROM_CLASS (gobject_class),
@@ -163,6 +258,7 @@ static void
 mousepad_document_init (MousepadDocument *document)
 {
   GtkTargetList        *target_list;
+  MousepadUndoManager  *undo_manager;
 
   /* private structure */
   document->priv = mousepad_document_get_instance_private (document);
@@ -172,6 +268,12 @@ mousepad_document_init (MousepadDocument *document)
   document->priv->utf8_basename = NULL;
   document->priv->label = NULL;
   document->priv->css_provider = gtk_css_provider_new ();
+  document->priv->checkpoints = g_array_new (FALSE, FALSE, sizeof (MousepadColumnCheckpoint));
+  document->priv->checkpoints_line = -1;
+
+  /* nothing was emitted yet */
+  document->priv->cursor_pending = TRUE;
+  document->priv->selection_pending = TRUE;
 
   /* setup the scolled window */
   gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (document),
@@ -185,6 +287,15 @@ mousepad_document_init (MousepadDocument *document)
   document->search_context = gtk_source_search_context_new (GTK_SOURCE_BUFFER (document->buffer), NULL);
   gtk_source_search_context_set_highlight (document->search_context, FALSE);
 
+  /* bound the memory taken by the undo history */
+  undo_manager = mousepad_undo_manager_new (document->buffer);
+  gtk_source_buffer_set_undo_manager (GTK_SOURCE_BUFFER (document->buffer),
+                                      GTK_SOURCE_UNDO_MANAGER (undo_manager));
+  g_object_unref (undo_manager);
+
+  /* index the words of the buffer */
+  document->priv->word_index = mousepad_word_index_new (document->buffer);
+
   /* initialize the file */
   document->file = mousepad_file_new (document->buffer);
 
@@ -199,18 +310,45 @@ mousepad_document_init (MousepadDocument *document)
   gtk_container_add (GTK_CONTAINER (document), GTK_WIDGET (document->textview));
   gtk_widget_show (GTK_WIDGET (document->textview));
 
+  /* setup the multi-term highlighting */
+  document->priv->highlighter = mousepad_highlighter_new (GTK_TEXT_VIEW (document->textview));
+
+  /* setup the match markers */
+  document->priv->overview = mousepad_overview_new (GTK_SCROLLED_WINDOW (document),
+                                                    GTK_TEXT_VIEW (document->textview),
+                                                    document->search_context);
+
+  /* setup the minimap */
+  document->priv->minimap = mousepad_minimap_new (GTK_TEXT_VIEW (document->textview));
+
+  /* setup code folding */
+  document->priv->folding = mousepad_folding_new (document->textview);
+
+  /* setup the symbol outline */
+  document->priv->outline = mousepad_outline_new (GTK_SOURCE_BUFFER (document->buffer));
+
   /* also allow dropping of uris and tabs in the textview */
   target_list = gtk_drag_dest_get_target_list (GTK_WIDGET (document->textview));
   gtk_target_list_add_table (target_list, drop_targets, G_N_ELEMENTS (drop_targets));
 
   /* attach signals to the text view and buffer */
+  g_signal_connect (G_OBJECT (document->buffer), "insert-text", G_CALLBACK (mousepad_document_insert_text), document);
+  g_signal_connect (G_OBJECT (document->buffer), "delete-range", G_CALLBACK (mousepad_document_delete_range), document);
   g_signal_connect (G_OBJECT (document->buffer), "notify::cursor-position", G_CALLBACK (mousepad_document_notify_cursor_position), document);
   g_signal_connect (G_OBJECT (document->buffer), "notify::has-selection", G_CALLBACK (mousepad_document_notify_has_selection), document);
+  g_signal_connect (G_OBJECT (document->buffer), "begin-user-action", G_CALLBACK (mousepad_document_user_action), document);
+  g_signal_connect (G_OBJECT (document->buffer), "end-user-action", G_CALLBACK (mousepad_document_user_action), document);
   g_signal_connect_swapped (G_OBJECT (document->buffer), "modified-changed", G_CALLBACK (mousepad_document_label_color), document);
   g_signal_connect_swapped (G_OBJECT (document->file), "readonly-changed", G_CALLBACK (mousepad_document_label_color), document);
   g_signal_connect (G_OBJECT (document->textview), "notify::overwrite", G_CALLBACK (mousepad_document_notify_overwrite), document);
+  g_signal_connect (G_OBJECT (document->textview), "notify::column-selection", G_CALLBACK (mousepad_document_notify_column_selection), document);
+  g_signal_connect (G_OBJECT (document->textview), "notify::long-lines", G_CALLBACK (mousepad_document_notify_long_lines), document);
   g_signal_connect (G_OBJECT (document->textview), "drag-data-received", G_CALLBACK (mousepad_document_drag_data_received), document);
   g_signal_connect (G_OBJECT (document->buffer), "notify::language", G_CALLBACK (mousepad_document_notify_language), document);
+
+  /* the cursor column is shown in tab widths */
+  MOUSEPAD_SETTING_CONNECT_OBJECT (TAB_WIDTH, G_CALLBACK (mousepad_document_tab_width_changed),
+                                   document, G_CONNECT_SWAPPED);
 }
 
 
@@ -224,6 +362,13 @@ mousepad_document_finalize (GObject *object)
   g_free (document->priv->utf8_filename);
   g_free (document->priv->utf8_basename);
   g_object_unref (document->priv->css_provider);
+  g_object_unref (document->priv->highlighter);
+  g_object_unref (document->priv->overview);
+  g_object_unref (document->priv->minimap);
+  g_object_unref (document->priv->folding);
+  g_object_unref (document->priv->outline);
+  g_object_unref (document->priv->word_index);
+  g_array_free (document->priv->checkpoints, TRUE);
 
   /* release the file */
   g_object_unref (G_OBJECT (document->file));
@@ -237,20 +382,249 @@ mousepad_document_finalize (GObject *object)
 
 
 
+static void
+mousepad_document_checkpoints_truncate (MousepadDocument *document,
+                                        gint              offset)
+{
+  GArray *checkpoints = document->priv->checkpoints;
+
+  /* checkpoints up to the edit stay valid, the column of a position only
+   * depends on the text before it */
+  while (checkpoints->len > 0
+         && g_array_index (checkpoints, MousepadColumnCheckpoint, checkpoints->len - 1).offset > offset)
+    g_array_set_size (checkpoints, checkpoints->len - 1);
+}
+
+
+
+static void
+mousepad_document_insert_text (GtkTextBuffer    *buffer,
+                               GtkTextIter      *location,
+                               const gchar      *text,
+                               gint              len,
+                               MousepadDocument *document)
+{
+  gint line;
+
+  line = gtk_text_iter_get_line (location);
+
+  if (line == document->priv->checkpoints_line)
+    mousepad_document_checkpoints_truncate (document, gtk_text_iter_get_line_offset (location));
+  else if (line < document->priv->checkpoints_line
+           && (memchr (text, '\n', len) != NULL || memchr (text, '\r', len) != NULL))
+    document->priv->checkpoints_line = -1;
+}
+
+
+
+static void
+mousepad_document_delete_range (GtkTextBuffer    *buffer,
+                                GtkTextIter      *start,
+                                GtkTextIter      *end,
+                                MousepadDocument *document)
+{
+  gint start_line, end_line;
+
+  start_line = gtk_text_iter_get_line (start);
+  end_line = gtk_text_iter_get_line (end);
+
+  if (start_line == document->priv->checkpoints_line)
+    mousepad_document_checkpoints_truncate (document, gtk_text_iter_get_line_offset (start));
+  else if (start_line < document->priv->checkpoints_line && start_line != end_line)
+    document->priv->checkpoints_line = -1;
+}
+
+
+
+static gint
+mousepad_document_get_column (MousepadDocument  *document,
+                              const GtkTextIter *iter,
+                              gint               tab_size)
+{
+  MousepadColumnCheckpoint  checkpoint;
+  GArray                   *checkpoints = document->priv->checkpoints;
+  GtkTextIter               needle;
+  const gchar              *p;
+  gchar                    *text;
+  gint                      offset, lower, upper, middle, start_index;
+
+  /* start over on another line or with another tab size */
+  if (gtk_text_iter_get_line (iter) != document->priv->checkpoints_line
+      || tab_size != document->priv->checkpoints_tab_size)
+    {
+      document->priv->checkpoints_line = gtk_text_iter_get_line (iter);
+      document->priv->checkpoints_tab_size = tab_size;
+      g_array_set_size (checkpoints, 0);
+    }
+
+  /* the start of the line is always a checkpoint */
+  if (checkpoints->len == 0)
+    {
+      checkpoint.offset = checkpoint.index = checkpoint.column = 0;
+      g_array_append_val (checkpoints, checkpoint);
+    }
+
+  /* look up the last checkpoint before the iter */
+  offset = gtk_text_iter_get_line_offset (iter);
+  for (lower = 0, upper = checkpoints->len - 1; lower < upper; )
+    {
+      middle = (lower + upper + 1) / 2;
+      if (g_array_index (checkpoints, MousepadColumnCheckpoint, middle).offset <= offset)
+        lower = middle;
+      else
+        upper = middle - 1;
+    }
+
+  checkpoint = g_array_index (checkpoints, MousepadColumnCheckpoint, lower);
+  if (checkpoint.offset == offset)
+    return checkpoint.column;
+
+  /* walk the text from the checkpoint to the iter */
+  start_index = checkpoint.index;
+  needle = *iter;
+  gtk_text_iter_set_line_index (&needle, start_index);
+  text = gtk_text_iter_get_slice (&needle, iter);
+
+  for (p = text; *p != '\0'; )
+    {
+      /* append the real tab offset or 1 */
+      if (*p == '\t')
+        checkpoint.column += tab_size - (checkpoint.column % tab_size);
+      else
+        checkpoint.column++;
+
+      p = g_utf8_next_char (p);
+      checkpoint.offset++;
+
+      /* leave checkpoints behind on long walks and one at the iter */
+      if (checkpoint.offset % MOUSEPAD_COLUMN_CHECKPOINT_INTERVAL == 0 || *p == '\0')
+        {
+          checkpoint.index = start_index + (p - text);
+          g_array_insert_val (checkpoints, ++lower, checkpoint);
+        }
+    }
+
+  g_free (text);
+
+  return checkpoint.column;
+}
+
+
+
+static gboolean
+mousepad_document_tick (GtkWidget     *widget,
+                        GdkFrameClock *frame_clock,
+                        gpointer       data)
+{
+  MousepadDocument *document = MOUSEPAD_DOCUMENT (data);
+
+  document->priv->tick_id = 0;
+
+  /* emit what changed since the last frame, at most once each */
+  if (document->priv->cursor_pending)
+    mousepad_document_emit_cursor_changed (document);
+
+  if (document->priv->selection_pending)
+    mousepad_document_emit_selection_changed (document);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+
+static void
+mousepad_document_schedule_tick (MousepadDocument *document)
+{
+  /* wait for the end of a bulk edit, its own notifications are meaningless */
+  if (document->priv->tick_id == 0 && ! document->priv->in_user_action)
+    document->priv->tick_id = gtk_widget_add_tick_callback (GTK_WIDGET (document),
+                                                            mousepad_document_tick,
+                                                            document, NULL);
+}
+
+
+
+static void
+mousepad_document_user_action (GtkTextBuffer    *buffer,
+                               MousepadDocument *document)
+{
+  g_return_if_fail (MOUSEPAD_IS_DOCUMENT (document));
+
+  /* these signals are only emitted for the outermost user action */
+  document->priv->in_user_action = ! document->priv->in_user_action;
+
+  if (! document->priv->in_user_action
+      && (document->priv->cursor_pending || document->priv->selection_pending))
+    mousepad_document_schedule_tick (document);
+}
+
+
+
 static void
 mousepad_document_notify_cursor_position (GtkTextBuffer    *buffer,
                                           GParamSpec       *pspec,
                                           MousepadDocument *document)
+{
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+  g_return_if_fail (MOUSEPAD_IS_DOCUMENT (document));
+
+  document->priv->cursor_pending = TRUE;
+  mousepad_document_schedule_tick (document);
+}
+
+
+
+static void
+mousepad_document_notify_has_selection (GtkTextBuffer    *buffer,
+                                        GParamSpec       *pspec,
+                                        MousepadDocument *document)
+{
+  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
+  g_return_if_fail (MOUSEPAD_IS_DOCUMENT (document));
+
+  document->priv->selection_pending = TRUE;
+  mousepad_document_schedule_tick (document);
+}
+
+
+
+static void
+mousepad_document_notify_column_selection (MousepadView     *view,
+                                           GParamSpec       *pspec,
+                                           MousepadDocument *document)
+{
+  g_return_if_fail (MOUSEPAD_IS_VIEW (view));
+  g_return_if_fail (MOUSEPAD_IS_DOCUMENT (document));
+
+  /* the column selection changed, its length is shown with the cursor */
+  document->priv->cursor_pending = TRUE;
+  document->priv->selection_pending = TRUE;
+  mousepad_document_schedule_tick (document);
+}
+
+
+
+static void
+mousepad_document_tab_width_changed (MousepadDocument *document)
+{
+  /* the cursor column depends on it */
+  document->priv->cursor_pending = TRUE;
+  mousepad_document_schedule_tick (document);
+}
+
+
+
+static void
+mousepad_document_emit_cursor_changed (MousepadDocument *document)
 {
   GtkTextIter iter;
   gint        line, column, selection;
   gint        tab_size;
 
-  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
-  g_return_if_fail (MOUSEPAD_IS_DOCUMENT (document));
+  document->priv->cursor_pending = FALSE;
 
   /* get the current iter position */
-  gtk_text_buffer_get_iter_at_mark (buffer, &iter, gtk_text_buffer_get_insert (buffer));
+  gtk_text_buffer_get_iter_at_mark (document->buffer, &iter, gtk_text_buffer_get_insert (document->buffer));
 
   /* get the current line number */
   line = gtk_text_iter_get_line (&iter) + 1;
@@ -259,11 +633,16 @@ mousepad_document_notify_cursor_position (GtkTextBuffer    *buffer,
   tab_size = MOUSEPAD_SETTING_GET_INT (TAB_WIDTH);
 
   /* get the column */
-  column = mousepad_util_get_real_line_offset (&iter, tab_size);
+  column = mousepad_document_get_column (document, &iter, tab_size);
 
   /* get length of the selection */
   selection = mousepad_view_get_selection_length (document->textview, NULL);
 
+  /* keep them for the tab switches */
+  document->priv->line = line;
+  document->priv->column = column;
+  document->priv->selection_length = selection;
+
   /* emit the signal */
   g_signal_emit (G_OBJECT (document), document_signals[CURSOR_CHANGED], 0, line, column, selection);
 }
@@ -271,15 +650,12 @@ mousepad_document_notify_cursor_position (GtkTextBuffer    *buffer,
 
 
 static void
-mousepad_document_notify_has_selection (GtkTextBuffer    *buffer,
-                                        GParamSpec       *pspec,
-                                        MousepadDocument *document)
+mousepad_document_emit_selection_changed (MousepadDocument *document)
 {
   gint     selection;
   gboolean is_column_selection;
 
-  g_return_if_fail (GTK_IS_TEXT_BUFFER (buffer));
-  g_return_if_fail (MOUSEPAD_IS_DOCUMENT (document));
+  document->priv->selection_pending = FALSE;
 
   /* get length of the selection */
   selection = mousepad_view_get_selection_length (document->textview, &is_column_selection);
@@ -292,6 +668,9 @@ mousepad_document_notify_has_selection (GtkTextBuffer    *buffer,
   if (selection == 1 && is_column_selection)
     selection = 2;
 
+  /* keep it for the tab switches */
+  document->priv->selection = selection;
+
   /* emit the signal */
   g_signal_emit (G_OBJECT (document), document_signals[SELECTION_CHANGED], 0, selection);
 }
@@ -317,6 +696,21 @@ mousepad_document_notify_overwrite (GtkTextView      *textview,
 
 
 
+static void
+mousepad_document_notify_long_lines (MousepadView     *view,
+                                     GParamSpec       *pspec,
+                                     MousepadDocument *document)
+{
+  g_return_if_fail (MOUSEPAD_IS_DOCUMENT (document));
+  g_return_if_fail (MOUSEPAD_IS_VIEW (view));
+
+  /* emit the signal */
+  g_signal_emit (G_OBJECT (document), document_signals[LONG_LINES_CHANGED], 0,
+                 mousepad_view_get_long_lines (view));
+}
+
+
+
 static void
 mousepad_document_notify_language (GtkSourceBuffer  *buffer,
                                    GParamSpec       *pspec,
@@ -381,15 +775,12 @@ mousepad_document_filename_changed (MousepadDocument *document,
       document->priv->utf8_filename = utf8_filename;
       document->priv->utf8_basename = utf8_basename;
 
-      /* update the tab label and tooltip */
+      /* update the tab label */
       if (G_UNLIKELY (document->priv->label))
         {
-          /* set the tab label */
+          /* set the tab label, the tooltip is built when it shows up */
           gtk_label_set_text (GTK_LABEL (document->priv->label), utf8_basename);
 
-          /* set the tab tooltip */
-          gtk_widget_set_tooltip_text (document->priv->ebox, utf8_filename);
-
           /* update label color */
           mousepad_document_label_color (document);
         }
@@ -459,14 +850,25 @@ mousepad_document_send_signals (MousepadDocument *document)
 {
   g_return_if_fail (MOUSEPAD_IS_DOCUMENT (document));
 
-  /* re-send the cursor changed signal */
-  mousepad_document_notify_cursor_position (document->buffer, NULL, document);
+  /* re-send the cursor position, only computed again if it changed meanwhile */
+  if (document->priv->cursor_pending)
+    mousepad_document_emit_cursor_changed (document);
+  else
+    g_signal_emit (G_OBJECT (document), document_signals[CURSOR_CHANGED], 0, document->priv->line,
+                   document->priv->column, document->priv->selection_length);
 
   /* re-send the overwrite signal */
   mousepad_document_notify_overwrite (GTK_TEXT_VIEW (document->textview), NULL, document);
 
-  /* re-send the selection status */
-  mousepad_document_notify_has_selection (document->buffer, NULL, document);
+  /* re-send the selection status, the same way */
+  if (document->priv->selection_pending)
+    mousepad_document_emit_selection_changed (document);
+  else
+    g_signal_emit (G_OBJECT (document), document_signals[SELECTION_CHANGED], 0,
+                   document->priv->selection);
+
+  /* re-send the long lines protection */
+  mousepad_document_notify_long_lines (document->textview, NULL, document);
 
   /* re-send the language signal */
   mousepad_document_notify_language (GTK_SOURCE_BUFFER (document->buffer), NULL, document);
@@ -487,7 +889,9 @@ mousepad_document_get_tab_label (MousepadDocument *document)
   document->priv->ebox = g_object_new (GTK_TYPE_EVENT_BOX, "border-width", 2,
                                        "visible-window", FALSE, NULL);
   gtk_box_pack_start (GTK_BOX (hbox), document->priv->ebox, TRUE, TRUE, 0);
-  gtk_widget_set_tooltip_text (document->priv->ebox, document->priv->utf8_filename);
+  gtk_widget_set_has_tooltip (document->priv->ebox, TRUE);
+  g_signal_connect (G_OBJECT (document->priv->ebox), "query-tooltip",
+                    G_CALLBACK (mousepad_document_query_tab_tooltip), document);
   gtk_widget_show (document->priv->ebox);
 
   /* create the label */
@@ -513,6 +917,34 @@ mousepad_document_get_tab_label (MousepadDocument *document)
 
 
 
+static gboolean
+mousepad_document_query_tab_tooltip (GtkWidget        *widget,
+                                     gint              x,
+                                     gint              y,
+                                     gboolean          keyboard_mode,
+                                     GtkTooltip       *tooltip,
+                                     MousepadDocument *document)
+{
+  GtkSourceUndoManager *undo_manager;
+  gchar                *size, *text;
+
+  /* the file name, and the memory taken by the undo history */
+  undo_manager = gtk_source_buffer_get_undo_manager (GTK_SOURCE_BUFFER (document->buffer));
+  size = g_format_size (mousepad_undo_manager_get_memory (MOUSEPAD_UNDO_MANAGER (undo_manager)));
+  if (document->priv->utf8_filename != NULL)
+    text = g_strdup_printf (_("%s\nUndo history: %s"), document->priv->utf8_filename, size);
+  else
+    text = g_strdup_printf (_("Undo history: %s"), size);
+
+  gtk_tooltip_set_text (tooltip, text);
+  g_free (text);
+  g_free (size);
+
+  return TRUE;
+}
+
+
+
 static void
 mousepad_document_tab_button_clicked (GtkWidget        *widget,
                                       MousepadDocument *document)
@@ -548,3 +980,35 @@ mousepad_document_get_filename (MousepadDocument *document)
 
   return document->priv->utf8_filename;
 }
+
+
+
+void
+mousepad_document_set_highlight_terms (MousepadDocument    *document,
+                                       const gchar * const *terms,
+                                       gboolean             match_case)
+{
+  g_return_if_fail (MOUSEPAD_IS_DOCUMENT (document));
+
+  mousepad_highlighter_set_terms (document->priv->highlighter, terms, match_case);
+}
+
+
+
+MousepadWordIndex *
+mousepad_document_get_word_index (MousepadDocument *document)
+{
+  g_return_val_if_fail (MOUSEPAD_IS_DOCUMENT (document), NULL);
+
+  return document->priv->word_index;
+}
+
+
+
+MousepadOutline *
+mousepad_document_get_outline (MousepadDocument *document)
+{
+  g_return_val_if_fail (MOUSEPAD_IS_DOCUMENT (document), NULL);
+
+  return document->priv->outline;
+}
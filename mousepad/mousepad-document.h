@@ -19,7 +19,9 @@
 
 #include <mousepad/mousepad-util.h>
 #include <mousepad/mousepad-file.h>
+#include <mousepad/mousepad-outline.h>
 #include <mousepad/mousepad-view.h>
+#include <mousepad/mousepad-word-index.h>
 
 G_BEGIN_DECLS
 
@@ -57,24 +59,32 @@ struct _MousepadDocument
   GtkTextTag              *tag;
 };
 
-GType             mousepad_document_get_type       (void) G_GNUC_CONST;
+GType              mousepad_document_get_type            (void) G_GNUC_CONST;
 
-MousepadDocument *mousepad_document_new            (void);
+MousepadDocument  *mousepad_document_new                 (void);
 
-void              mousepad_document_set_overwrite  (MousepadDocument *document,
-                                                    gboolean          overwrite);
+void               mousepad_document_set_overwrite       (MousepadDocument    *document,
+                                                          gboolean             overwrite);
 
-void              mousepad_document_focus_textview (MousepadDocument *document);
+void               mousepad_document_focus_textview      (MousepadDocument    *document);
 
-void              mousepad_document_send_signals   (MousepadDocument *document);
+void               mousepad_document_send_signals        (MousepadDocument    *document);
 
-GtkWidget        *mousepad_document_get_tab_label  (MousepadDocument *document);
+GtkWidget         *mousepad_document_get_tab_label       (MousepadDocument    *document);
 
-const gchar      *mousepad_document_get_basename   (MousepadDocument *document);
+const gchar       *mousepad_document_get_basename        (MousepadDocument    *document);
 
-const gchar      *mousepad_document_get_filename   (MousepadDocument *document);
+const gchar       *mousepad_document_get_filename        (MousepadDocument    *document);
 
-gboolean          mousepad_document_get_word_wrap  (MousepadDocument *document);
+gboolean           mousepad_document_get_word_wrap       (MousepadDocument    *document);
+
+void               mousepad_document_set_highlight_terms (MousepadDocument    *document,
+                                                          const gchar * const *terms,
+                                                          gboolean             match_case);
+
+MousepadWordIndex *mousepad_document_get_word_index      (MousepadDocument    *document);
+
+MousepadOutline   *mousepad_document_get_outline         (MousepadDocument    *document);
 
 G_END_DECLS
 
@@ -387,6 +387,11 @@ mousepad_encoding_dialog_read_file (MousepadEncodingDialog *dialog,
     {
       /* no error, hide the box */
       gtk_widget_hide (dialog->error_box);
+
+      /* protect the preview against very long lines */
+      mousepad_view_set_long_lines (dialog->document->textview,
+                                    mousepad_file_get_longest_line (dialog->document->file)
+                                    > MOUSEPAD_VIEW_LONG_LINE_LENGTH);
     }
   else
     {
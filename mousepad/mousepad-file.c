@@ -67,6 +67,9 @@ struct _MousepadFile
   /* line ending of the file */
   MousepadLineEnding  line_ending;
 
+  /* length in bytes of the longest line read from the file */
+  gsize               longest_line;
+
   /* our last modification time */
   gint                mtime;
 
@@ -145,6 +148,7 @@ mousepad_file_init (MousepadFile *file)
 #else
   file->line_ending       = MOUSEPAD_EOL_UNIX;
 #endif
+  file->longest_line      = 0;
   file->readonly          = TRUE;
   file->mtime             = 0;
   file->write_bom         = FALSE;
@@ -497,7 +501,7 @@ mousepad_file_open (MousepadFile  *file,
   const gchar      *charset;
   GtkTextIter       start_iter, end_iter;
   struct stat       statb;
-  const gchar      *end, *n, *m;
+  const gchar      *end, *n, *m, *line;
   MousepadEncoding  bom_encoding;
 
   g_return_val_if_fail (MOUSEPAD_IS_FILE (file), FALSE);
@@ -505,6 +509,9 @@ mousepad_file_open (MousepadFile  *file,
   g_return_val_if_fail (error == NULL || *error == NULL, FALSE);
   g_return_val_if_fail (file->filename != NULL || template_filename != NULL, FALSE);
 
+  /* nothing read yet */
+  file->longest_line = 0;
+
   /* get the filename */
   if (G_UNLIKELY (template_filename != NULL))
     filename = template_filename;
@@ -619,9 +626,16 @@ mousepad_file_open (MousepadFile  *file,
           /* get the iter at the beginning of the document */
           gtk_text_buffer_get_start_iter (file->buffer, &start_iter);
 
-          /* insert the file contents in the buffer (for documents with cr line ending) */
-          for (n = m = contents; n < end; n = g_utf8_next_char (n))
+          /* insert the file contents in the buffer (for documents with cr line ending),
+           * and measure the longest line on the way */
+          for (n = m = line = contents; n < end; n = g_utf8_next_char (n))
             {
+              if (G_UNLIKELY (*n == '\n' || *n == '\r'))
+                {
+                  file->longest_line = MAX (file->longest_line, (gsize) (n - line));
+                  line = n + 1;
+                }
+
               if (G_UNLIKELY (*n == '\r'))
                 {
                   /* insert the text in the buffer */
@@ -641,6 +655,8 @@ mousepad_file_open (MousepadFile  *file,
           if (G_LIKELY (n - m > 0))
             gtk_text_buffer_insert (file->buffer, &start_iter, m, n - m);
 
+          file->longest_line = MAX (file->longest_line, (gsize) (end - line));
+
           /* get the start iter */
           gtk_text_buffer_get_start_iter (file->buffer, &start_iter);
 
@@ -916,6 +932,16 @@ mousepad_file_reload (MousepadFile  *file,
 
 
 
+gsize
+mousepad_file_get_longest_line (MousepadFile *file)
+{
+  g_return_val_if_fail (MOUSEPAD_IS_FILE (file), 0);
+
+  return file->longest_line;
+}
+
+
+
 gboolean
 mousepad_file_get_externally_modified (MousepadFile  *file,
                                        GError       **error)
@@ -93,6 +93,8 @@ gboolean            mousepad_file_save                     (MousepadFile
 gboolean            mousepad_file_reload                   (MousepadFile        *file,
                                                             GError             **error);
 
+gsize               mousepad_file_get_longest_line         (MousepadFile        *file);
+
 gboolean            mousepad_file_get_externally_modified  (MousepadFile        *file,
                                                             GError             **error);
 
@@ -0,0 +1,1035 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <mousepad/mousepad-private.h>
+#include <mousepad/mousepad-settings.h>
+#include <mousepad/mousepad-folding.h>
+
+#include <gtksourceview/gtksource.h>
+
+
+
+/* size (in bytes) of an insertion above which the whole buffer is scanned again in the
+ * background, columns of indentation per bracket depth, and position of the markers in
+ * the gutter (after the line numbers) */
+#define MOUSEPAD_FOLDING_REBUILD_SIZE     (1 << 16)
+#define MOUSEPAD_FOLDING_DEPTH_COLUMNS    1024
+#define MOUSEPAD_FOLDING_GUTTER_POSITION  10
+
+/* markers of the folded and unfolded regions: "▸" and "▾" */
+#define MOUSEPAD_FOLDING_FOLDED           "\342\226\270"
+#define MOUSEPAD_FOLDING_UNFOLDED         "\342\226\276"
+
+
+
+typedef struct
+{
+  /* indentation (in columns, -1 for a blank line), brackets opened minus brackets closed
+   * on the line, and bracket depth at the line start */
+  gint16 indent;
+  gint16 delta;
+  gint32 depth;
+}
+MousepadFoldLine;
+
+typedef struct
+{
+  /* the hidden text, from the end of the header line to the end of the region */
+  GtkTextMark *start;
+  GtkTextMark *end;
+}
+MousepadFold;
+
+typedef struct
+{
+  gchar *text;
+  guint  tab_width;
+}
+MousepadFoldingBuild;
+
+
+
+static void      mousepad_folding_finalize          (GObject                      *object);
+static void      mousepad_folding_update_enabled    (MousepadFolding              *folding);
+static void      mousepad_folding_build             (MousepadFolding              *folding);
+static void      mousepad_folding_insert_text       (GtkTextBuffer                *buffer,
+                                                     GtkTextIter                  *location,
+                                                     gchar                        *text,
+                                                     gint                          len,
+                                                     MousepadFolding              *folding);
+static void      mousepad_folding_inserted_text     (GtkTextBuffer                *buffer,
+                                                     GtkTextIter                  *location,
+                                                     gchar                        *text,
+                                                     gint                          len,
+                                                     MousepadFolding              *folding);
+static void      mousepad_folding_delete_range      (GtkTextBuffer                *buffer,
+                                                     GtkTextIter                  *start,
+                                                     GtkTextIter                  *end,
+                                                     MousepadFolding              *folding);
+static void      mousepad_folding_deleted_range     (GtkTextBuffer                *buffer,
+                                                     GtkTextIter                  *start,
+                                                     GtkTextIter                  *end,
+                                                     MousepadFolding              *folding);
+static void      mousepad_folding_cursor_moved      (MousepadFolding              *folding);
+static void      mousepad_folding_query_data        (GtkSourceGutterRenderer      *renderer,
+                                                     GtkTextIter                  *start,
+                                                     GtkTextIter                  *end,
+                                                     GtkSourceGutterRendererState  state,
+                                                     MousepadFolding              *folding);
+static gboolean  mousepad_folding_query_activatable (GtkSourceGutterRenderer      *renderer,
+                                                     GtkTextIter                  *iter,
+                                                     GdkRectangle                 *area,
+                                                     GdkEvent                     *event,
+                                                     MousepadFolding              *folding);
+static void      mousepad_folding_activate          (GtkSourceGutterRenderer      *renderer,
+                                                     GtkTextIter                  *iter,
+                                                     GdkRectangle                 *area,
+                                                     GdkEvent                     *event,
+                                                     MousepadFolding              *folding);
+
+
+
+struct _MousepadFoldingClass
+{
+  GObjectClass __parent__;
+};
+
+struct _MousepadFolding
+{
+  GObject                  __parent__;
+
+  /* the view, its buffer, the gutter markers and the tag hiding the folded text */
+  MousepadView            *view;
+  GtkTextBuffer           *buffer;
+  GtkSourceGutterRenderer *renderer;
+  GtkTextTag              *tag;
+
+  /* a line of each buffer line, in a gap buffer following the edits, and the number
+   * of lines from the start whose depth is up to date */
+  MousepadFoldLine        *lines;
+  guint                    n_lines;
+  guint                    gap;
+  guint                    gap_size;
+  guint                    n_valid;
+
+  /* the folded regions, sorted by position */
+  GPtrArray               *folds;
+
+  /* first line and line count of an edit, between its "before" and "after" handlers */
+  gint                     edit_first;
+  gint                     edit_line_count;
+  guint                    edit_pending : 1;
+
+  /* tab width the indentation is measured with */
+  guint                    tab_width;
+
+  /* a background build is running, and it must start again from a new snapshot (e.g.
+   * the tab width changed), or the region edited since its snapshot must be scanned again */
+  guint                    building : 1;
+  guint                    stale : 1;
+  GtkTextMark             *dirty_start;
+  GtkTextMark             *dirty_end;
+  guint                    dirty : 1;
+
+  guint                    enabled : 1;
+};
+
+
+
+G_DEFINE_TYPE (MousepadFolding, mousepad_folding, G_TYPE_OBJECT)
+
+
+
+static void
+mousepad_folding_class_init (MousepadFoldingClass *klass)
+{
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = mousepad_folding_finalize;
+}
+
+
+
+static void
+mousepad_folding_init (MousepadFolding *folding)
+{
+  folding->lines = NULL;
+  folding->n_lines = 0;
+  folding->gap = 0;
+  folding->gap_size = 0;
+  folding->n_valid = 0;
+  folding->folds = g_ptr_array_new ();
+  folding->edit_pending = FALSE;
+  folding->building = FALSE;
+  folding->stale = FALSE;
+  folding->dirty = FALSE;
+  folding->enabled = FALSE;
+}
+
+
+
+/**
+ * Lines
+ **/
+static void
+mousepad_folding_scan_line (const gchar      *p,
+                            const gchar      *end,
+                            guint             tab_width,
+                            MousepadFoldLine *line)
+{
+  gboolean quoted = FALSE;
+  gint     indent = 0, delta = 0;
+
+  for (; p < end && (*p == ' ' || *p == '\t'); p++)
+    indent += (*p == '\t') ? tab_width - indent % tab_width : 1;
+
+  /* blank lines go with the next region */
+  if (p == end)
+    {
+      line->indent = -1;
+      line->delta = 0;
+      return;
+    }
+
+  /* brackets in double-quoted strings don't count */
+  for (; p < end; p++)
+    {
+      if (*p == '"')
+        quoted = ! quoted;
+      else if (quoted)
+        {
+          if (*p == '\\' && p + 1 < end)
+            p++;
+        }
+      else if (*p == '{' || *p == '[')
+        delta++;
+      else if (*p == '}' || *p == ']')
+        delta--;
+    }
+
+  line->indent = MIN (indent, MOUSEPAD_FOLDING_DEPTH_COLUMNS - 1);
+  line->delta = CLAMP (delta, G_MININT16, G_MAXINT16);
+}
+
+
+
+static void
+mousepad_folding_scan (const gchar *text,
+                       guint        tab_width,
+                       GArray      *lines)
+{
+  MousepadFoldLine  line = { 0, 0, 0 };
+  const gchar      *p, *eol;
+
+  /* split the lines as the text buffer does */
+  for (p = eol = text; ; eol++)
+    {
+      if (*eol == '\n' || *eol == '\r' || *eol == '\0'
+          || (eol[0] == '\342' && eol[1] == '\200' && eol[2] == '\251'))
+        {
+          mousepad_folding_scan_line (p, eol, tab_width, &line);
+          g_array_append_val (lines, line);
+
+          if (*eol == '\0')
+            break;
+          else if (*eol == '\342')
+            eol += 2;
+          else if (eol[0] == '\r' && eol[1] == '\n')
+            eol++;
+
+          p = eol + 1;
+        }
+    }
+}
+
+
+
+static inline MousepadFoldLine *
+mousepad_folding_get_line (MousepadFolding *folding,
+                           guint            n)
+{
+  return folding->lines + (n < folding->gap ? n : n + folding->gap_size);
+}
+
+
+
+static void
+mousepad_folding_move_gap (MousepadFolding *folding,
+                           guint            position)
+{
+  if (position < folding->gap)
+    memmove (folding->lines + position + folding->gap_size, folding->lines + position,
+             (folding->gap - position) * sizeof (MousepadFoldLine));
+  else if (position > folding->gap)
+    memmove (folding->lines + folding->gap, folding->lines + folding->gap + folding->gap_size,
+             (position - folding->gap) * sizeof (MousepadFoldLine));
+
+  folding->gap = position;
+}
+
+
+
+static void
+mousepad_folding_replace_lines (MousepadFolding *folding,
+                                guint            first,
+                                guint            n_old,
+                                GArray          *lines)
+{
+  guint capacity, tail;
+
+  /* drop the old lines into the gap, which stays where the edits happen */
+  mousepad_folding_move_gap (folding, first + n_old);
+  folding->gap = first;
+  folding->gap_size += n_old;
+  folding->n_lines -= n_old;
+
+  /* grow the gap when needed, the lines after it staying at the end */
+  if (folding->gap_size < lines->len)
+    {
+      tail = folding->n_lines - folding->gap;
+      capacity = MAX (2 * (folding->n_lines + folding->gap_size), folding->n_lines + lines->len + 64);
+      folding->lines = g_renew (MousepadFoldLine, folding->lines, capacity);
+      memmove (folding->lines + capacity - tail, folding->lines + folding->gap + folding->gap_size,
+               tail * sizeof (MousepadFoldLine));
+      folding->gap_size = capacity - folding->n_lines;
+    }
+
+  memcpy (folding->lines + folding->gap, lines->data, lines->len * sizeof (MousepadFoldLine));
+  folding->gap += lines->len;
+  folding->gap_size -= lines->len;
+  folding->n_lines += lines->len;
+
+  /* the depths after the first line follow from it */
+  folding->n_valid = MIN (folding->n_valid, first);
+}
+
+
+
+static gint
+mousepad_folding_get_level (MousepadFolding *folding,
+                            guint            n)
+{
+  MousepadFoldLine *line, *previous;
+
+  /* bring the depths up to date as far as needed */
+  for (; folding->n_valid <= n; folding->n_valid++)
+    {
+      line = mousepad_folding_get_line (folding, folding->n_valid);
+      if (folding->n_valid == 0)
+        line->depth = 0;
+      else
+        {
+          previous = mousepad_folding_get_line (folding, folding->n_valid - 1);
+          line->depth = MAX (previous->depth + previous->delta, 0);
+        }
+    }
+
+  line = mousepad_folding_get_line (folding, n);
+  if (line->indent < 0)
+    return -1;
+
+  return line->depth * MOUSEPAD_FOLDING_DEPTH_COLUMNS + line->indent;
+}
+
+
+
+static gboolean
+mousepad_folding_is_header (MousepadFolding *folding,
+                            gint             header)
+{
+  guint n;
+  gint  level, next = -1;
+
+  if (folding->lines == NULL || folding->building
+      || (level = mousepad_folding_get_level (folding, header)) < 0)
+    return FALSE;
+
+  /* a region starts where the next line goes deeper */
+  for (n = header + 1; n < folding->n_lines && next < 0; n++)
+    next = mousepad_folding_get_level (folding, n);
+
+  return next > level;
+}
+
+
+
+static gint
+mousepad_folding_get_region_end (MousepadFolding *folding,
+                                 gint             header)
+{
+  guint n;
+  gint  level, line_level, last = -1;
+
+  if (folding->lines == NULL || folding->building
+      || (level = mousepad_folding_get_level (folding, header)) < 0)
+    return -1;
+
+  /* the region goes on with the deeper lines, leaving out the trailing blank lines */
+  for (n = header + 1; n < folding->n_lines; n++)
+    {
+      line_level = mousepad_folding_get_level (folding, n);
+      if (line_level < 0)
+        continue;
+      else if (line_level <= level)
+        break;
+
+      last = n;
+    }
+
+  return last;
+}
+
+
+
+/**
+ * Background build
+ **/
+static void
+mousepad_folding_build_free (gpointer data)
+{
+  MousepadFoldingBuild *build = data;
+
+  g_free (build->text);
+  g_slice_free (MousepadFoldingBuild, build);
+}
+
+
+
+static void
+mousepad_folding_build_thread (GTask        *task,
+                               gpointer      source_object,
+                               gpointer      task_data,
+                               GCancellable *cancellable)
+{
+  MousepadFoldingBuild *build = task_data;
+  GArray               *lines;
+
+  lines = g_array_new (FALSE, FALSE, sizeof (MousepadFoldLine));
+  mousepad_folding_scan (build->text, build->tab_width, lines);
+
+  g_task_return_pointer (task, lines, (GDestroyNotify) g_array_unref);
+}
+
+
+
+static void
+mousepad_folding_scan_dirty (MousepadFolding *folding)
+{
+  GtkTextIter  start, end;
+  GArray      *lines;
+  gchar       *text;
+  gint         head, last, tail;
+
+  folding->dirty = FALSE;
+
+  /* the lines before and after the edited region are the same as in the snapshot */
+  gtk_text_buffer_get_iter_at_mark (folding->buffer, &start, folding->dirty_start);
+  gtk_text_buffer_get_iter_at_mark (folding->buffer, &end, folding->dirty_end);
+  head = gtk_text_iter_get_line (&start);
+  last = gtk_text_iter_get_line (&end);
+  tail = gtk_text_buffer_get_line_count (folding->buffer) - 1 - last;
+  if (G_UNLIKELY ((guint) (head + tail) > folding->n_lines))
+    {
+      mousepad_folding_build (folding);
+      return;
+    }
+
+  /* scan the edited lines, they replace the ones of the snapshot in between */
+  gtk_text_iter_set_line_offset (&start, 0);
+  if (! gtk_text_iter_ends_line (&end))
+    gtk_text_iter_forward_to_line_end (&end);
+
+  text = gtk_text_buffer_get_text (folding->buffer, &start, &end, TRUE);
+  lines = g_array_new (FALSE, FALSE, sizeof (MousepadFoldLine));
+  mousepad_folding_scan (text, folding->tab_width, lines);
+  mousepad_folding_replace_lines (folding, head, folding->n_lines - head - tail, lines);
+
+  g_array_unref (lines);
+  g_free (text);
+
+  /* this should not happen, but better safe than sorry */
+  if (G_UNLIKELY (folding->n_lines != (guint) gtk_text_buffer_get_line_count (folding->buffer)))
+    mousepad_folding_build (folding);
+}
+
+
+
+static void
+mousepad_folding_build_ready (GObject      *object,
+                              GAsyncResult *result,
+                              gpointer      data)
+{
+  MousepadFolding *folding = MOUSEPAD_FOLDING (object);
+  GArray          *lines;
+
+  lines = g_task_propagate_pointer (G_TASK (result), NULL);
+  folding->building = FALSE;
+
+  /* the snapshot was scanned with outdated settings, start again from a fresh one */
+  if (folding->stale && folding->enabled)
+    {
+      g_array_unref (lines);
+      mousepad_folding_build (folding);
+      return;
+    }
+  else if (! folding->enabled)
+    {
+      g_array_unref (lines);
+      return;
+    }
+
+  g_free (folding->lines);
+  folding->n_lines = lines->len;
+  folding->lines = (MousepadFoldLine *) g_array_free (lines, FALSE);
+  folding->gap = folding->n_lines;
+  folding->gap_size = 0;
+  folding->n_valid = 0;
+
+  /* always install the build, then catch up with the edits made meanwhile */
+  if (folding->dirty)
+    mousepad_folding_scan_dirty (folding);
+
+  gtk_source_gutter_renderer_queue_draw (folding->renderer);
+}
+
+
+
+static void
+mousepad_folding_build (MousepadFolding *folding)
+{
+  MousepadFoldingBuild *build;
+  GtkTextIter           start, end;
+  GTask                *task;
+
+  /* the running build will be restarted */
+  if (folding->building)
+    {
+      folding->stale = TRUE;
+      return;
+    }
+
+  folding->building = TRUE;
+  folding->stale = FALSE;
+  folding->dirty = FALSE;
+  folding->edit_pending = FALSE;
+
+  build = g_slice_new (MousepadFoldingBuild);
+  gtk_text_buffer_get_bounds (folding->buffer, &start, &end);
+  build->text = gtk_text_buffer_get_text (folding->buffer, &start, &end, TRUE);
+  build->tab_width = folding->tab_width;
+
+  task = g_task_new (folding, NULL, mousepad_folding_build_ready, NULL);
+  g_task_set_task_data (task, build, mousepad_folding_build_free);
+  g_task_run_in_thread (task, mousepad_folding_build_thread);
+  g_object_unref (task);
+}
+
+
+
+/**
+ * Following the buffer
+ **/
+static void
+mousepad_folding_add_dirty (MousepadFolding   *folding,
+                            const GtkTextIter *start,
+                            const GtkTextIter *end)
+{
+  GtkTextIter iter;
+
+  /* the region edited during a build, scanned again once the build is installed */
+  if (! folding->dirty)
+    {
+      gtk_text_buffer_move_mark (folding->buffer, folding->dirty_start, start);
+      gtk_text_buffer_move_mark (folding->buffer, folding->dirty_end, end);
+      folding->dirty = TRUE;
+      return;
+    }
+
+  gtk_text_buffer_get_iter_at_mark (folding->buffer, &iter, folding->dirty_start);
+  if (gtk_text_iter_compare (start, &iter) < 0)
+    gtk_text_buffer_move_mark (folding->buffer, folding->dirty_start, start);
+
+  gtk_text_buffer_get_iter_at_mark (folding->buffer, &iter, folding->dirty_end);
+  if (gtk_text_iter_compare (end, &iter) > 0)
+    gtk_text_buffer_move_mark (folding->buffer, folding->dirty_end, end);
+}
+
+
+
+static void
+mousepad_folding_edit_begin (MousepadFolding   *folding,
+                             const GtkTextIter *iter)
+{
+  folding->edit_first = gtk_text_iter_get_line (iter);
+  folding->edit_line_count = gtk_text_buffer_get_line_count (folding->buffer);
+  folding->edit_pending = TRUE;
+}
+
+
+
+static void
+mousepad_folding_edit_end (MousepadFolding   *folding,
+                           const GtkTextIter *iter)
+{
+  GtkTextIter  start, end;
+  GArray      *lines;
+  gchar       *text;
+  gint         last;
+
+  if (! folding->edit_pending || folding->building)
+    return;
+
+  folding->edit_pending = FALSE;
+
+  /* scan the edited lines again */
+  last = gtk_text_iter_get_line (iter);
+  gtk_text_buffer_get_iter_at_line (folding->buffer, &start, folding->edit_first);
+  end = *iter;
+  if (! gtk_text_iter_ends_line (&end))
+    gtk_text_iter_forward_to_line_end (&end);
+
+  text = gtk_text_buffer_get_text (folding->buffer, &start, &end, TRUE);
+  lines = g_array_new (FALSE, FALSE, sizeof (MousepadFoldLine));
+  mousepad_folding_scan (text, folding->tab_width, lines);
+
+  /* they replace the lines the edit started from, as many as were not added */
+  mousepad_folding_replace_lines (folding, folding->edit_first,
+                                  last - folding->edit_first + 1 + folding->edit_line_count
+                                  - gtk_text_buffer_get_line_count (folding->buffer),
+                                  lines);
+
+  g_array_unref (lines);
+  g_free (text);
+
+  /* this should not happen, but better safe than sorry */
+  if (G_UNLIKELY (folding->n_lines != (guint) gtk_text_buffer_get_line_count (folding->buffer)))
+    mousepad_folding_build (folding);
+}
+
+
+
+static void
+mousepad_folding_insert_text (GtkTextBuffer   *buffer,
+                              GtkTextIter     *location,
+                              gchar           *text,
+                              gint             len,
+                              MousepadFolding *folding)
+{
+  if (! folding->enabled)
+    return;
+  else if (folding->building)
+    mousepad_folding_add_dirty (folding, location, location);
+  else if (len <= MOUSEPAD_FOLDING_REBUILD_SIZE)
+    mousepad_folding_edit_begin (folding, location);
+}
+
+
+
+static void
+mousepad_folding_inserted_text (GtkTextBuffer   *buffer,
+                                GtkTextIter     *location,
+                                gchar           *text,
+                                gint             len,
+                                MousepadFolding *folding)
+{
+  /* scan large insertions (e.g. when loading a file) in the background */
+  if (! folding->enabled)
+    return;
+  else if (len > MOUSEPAD_FOLDING_REBUILD_SIZE)
+    mousepad_folding_build (folding);
+  else
+    mousepad_folding_edit_end (folding, location);
+}
+
+
+
+static void
+mousepad_folding_delete_range (GtkTextBuffer   *buffer,
+                               GtkTextIter     *start,
+                               GtkTextIter     *end,
+                               MousepadFolding *folding)
+{
+  if (! folding->enabled)
+    return;
+  else if (folding->building)
+    mousepad_folding_add_dirty (folding, start, end);
+  else
+    mousepad_folding_edit_begin (folding, start);
+}
+
+
+
+static void
+mousepad_folding_deleted_range (GtkTextBuffer   *buffer,
+                                GtkTextIter     *start,
+                                GtkTextIter     *end,
+                                MousepadFolding *folding)
+{
+  MousepadFold *fold;
+  GtkTextIter   fold_start, fold_end;
+  guint         n;
+
+  if (! folding->enabled)
+    return;
+
+  mousepad_folding_edit_end (folding, start);
+
+  /* forget the folded regions that were deleted */
+  for (n = folding->folds->len; n > 0; n--)
+    {
+      fold = g_ptr_array_index (folding->folds, n - 1);
+      gtk_text_buffer_get_iter_at_mark (buffer, &fold_start, fold->start);
+      gtk_text_buffer_get_iter_at_mark (buffer, &fold_end, fold->end);
+      if (gtk_text_iter_compare (&fold_start, &fold_end) >= 0)
+        {
+          gtk_text_buffer_delete_mark (buffer, fold->start);
+          gtk_text_buffer_delete_mark (buffer, fold->end);
+          g_slice_free (MousepadFold, fold);
+          g_ptr_array_remove_index (folding->folds, n - 1);
+        }
+    }
+}
+
+
+
+/**
+ * Folding
+ **/
+static gint
+mousepad_folding_find_fold (MousepadFolding *folding,
+                            gint             header)
+{
+  MousepadFold *fold;
+  GtkTextIter   iter;
+  guint         n;
+
+  for (n = 0; n < folding->folds->len; n++)
+    {
+      fold = g_ptr_array_index (folding->folds, n);
+      gtk_text_buffer_get_iter_at_mark (folding->buffer, &iter, fold->start);
+      if (gtk_text_iter_get_line (&iter) == header)
+        return n;
+    }
+
+  return -1;
+}
+
+
+
+static void
+mousepad_folding_fold (MousepadFolding *folding,
+                       gint             header)
+{
+  MousepadFold *fold;
+  GtkTextIter   start, end, iter;
+  guint         n;
+  gint          last;
+
+  last = mousepad_folding_get_region_end (folding, header);
+  if (last < 0)
+    return;
+
+  /* hide the lines after the header, up to the end of the region */
+  gtk_text_buffer_get_iter_at_line (folding->buffer, &start, header);
+  if (! gtk_text_iter_ends_line (&start))
+    gtk_text_iter_forward_to_line_end (&start);
+
+  gtk_text_buffer_get_iter_at_line (folding->buffer, &end, last);
+  if (! gtk_text_iter_ends_line (&end))
+    gtk_text_iter_forward_to_line_end (&end);
+
+  /* keep the cursor out of the hidden text */
+  gtk_text_buffer_get_iter_at_mark (folding->buffer, &iter, gtk_text_buffer_get_insert (folding->buffer));
+  if (gtk_text_iter_compare (&iter, &start) > 0 && gtk_text_iter_compare (&iter, &end) < 0)
+    gtk_text_buffer_place_cursor (folding->buffer, &start);
+
+  /* text typed at the edges of the region stays out of it */
+  fold = g_slice_new (MousepadFold);
+  fold->start = gtk_text_buffer_create_mark (folding->buffer, NULL, &start, FALSE);
+  fold->end = gtk_text_buffer_create_mark (folding->buffer, NULL, &end, TRUE);
+
+  for (n = 0; n < folding->folds->len; n++)
+    {
+      gtk_text_buffer_get_iter_at_mark (folding->buffer, &iter,
+                                        ((MousepadFold *) g_ptr_array_index (folding->folds, n))->start);
+      if (gtk_text_iter_compare (&iter, &start) > 0)
+        break;
+    }
+
+  g_ptr_array_insert (folding->folds, n, fold);
+
+  gtk_text_buffer_apply_tag (folding->buffer, folding->tag, &start, &end);
+}
+
+
+
+static void
+mousepad_folding_unfold (MousepadFolding *folding,
+                         guint            n)
+{
+  MousepadFold *fold;
+  GtkTextIter   start, end, inner_start, inner_end;
+
+  fold = g_ptr_array_index (folding->folds, n);
+  g_ptr_array_remove_index (folding->folds, n);
+
+  gtk_text_buffer_get_iter_at_mark (folding->buffer, &start, fold->start);
+  gtk_text_buffer_get_iter_at_mark (folding->buffer, &end, fold->end);
+  gtk_text_buffer_remove_tag (folding->buffer, folding->tag, &start, &end);
+
+  gtk_text_buffer_delete_mark (folding->buffer, fold->start);
+  gtk_text_buffer_delete_mark (folding->buffer, fold->end);
+  g_slice_free (MousepadFold, fold);
+
+  /* the regions folded inside it stay folded */
+  for (; n < folding->folds->len; n++)
+    {
+      fold = g_ptr_array_index (folding->folds, n);
+      gtk_text_buffer_get_iter_at_mark (folding->buffer, &inner_start, fold->start);
+      if (gtk_text_iter_compare (&inner_start, &end) >= 0)
+        break;
+
+      gtk_text_buffer_get_iter_at_mark (folding->buffer, &inner_end, fold->end);
+      gtk_text_buffer_apply_tag (folding->buffer, folding->tag, &inner_start, &inner_end);
+    }
+}
+
+
+
+static void
+mousepad_folding_unfold_all (MousepadFolding *folding)
+{
+  while (folding->folds->len > 0)
+    mousepad_folding_unfold (folding, folding->folds->len - 1);
+}
+
+
+
+static void
+mousepad_folding_cursor_moved (MousepadFolding *folding)
+{
+  MousepadFold *fold;
+  GtkTextIter   cursor, start, end;
+  guint         n;
+
+  /* unfold the regions the cursor went into, the inner ones first */
+  gtk_text_buffer_get_iter_at_mark (folding->buffer, &cursor, gtk_text_buffer_get_insert (folding->buffer));
+  for (n = folding->folds->len; n > 0; n--)
+    {
+      fold = g_ptr_array_index (folding->folds, n - 1);
+      gtk_text_buffer_get_iter_at_mark (folding->buffer, &start, fold->start);
+      gtk_text_buffer_get_iter_at_mark (folding->buffer, &end, fold->end);
+      if (gtk_text_iter_compare (&cursor, &start) > 0 && gtk_text_iter_compare (&cursor, &end) < 0)
+        mousepad_folding_unfold (folding, n - 1);
+    }
+}
+
+
+
+/**
+ * Gutter markers
+ **/
+static void
+mousepad_folding_query_data (GtkSourceGutterRenderer      *renderer,
+                             GtkTextIter                  *start,
+                             GtkTextIter                  *end,
+                             GtkSourceGutterRendererState  state,
+                             MousepadFolding              *folding)
+{
+  const gchar *marker = "";
+  gint         line;
+
+  line = gtk_text_iter_get_line (start);
+  if (mousepad_folding_find_fold (folding, line) >= 0)
+    marker = MOUSEPAD_FOLDING_FOLDED;
+  else if (mousepad_folding_is_header (folding, line))
+    marker = MOUSEPAD_FOLDING_UNFOLDED;
+
+  gtk_source_gutter_renderer_text_set_text (GTK_SOURCE_GUTTER_RENDERER_TEXT (renderer), marker, -1);
+}
+
+
+
+static gboolean
+mousepad_folding_query_activatable (GtkSourceGutterRenderer *renderer,
+                                    GtkTextIter             *iter,
+                                    GdkRectangle            *area,
+                                    GdkEvent                *event,
+                                    MousepadFolding         *folding)
+{
+  gint line;
+
+  line = gtk_text_iter_get_line (iter);
+
+  return mousepad_folding_find_fold (folding, line) >= 0 || mousepad_folding_is_header (folding, line);
+}
+
+
+
+static void
+mousepad_folding_activate (GtkSourceGutterRenderer *renderer,
+                           GtkTextIter             *iter,
+                           GdkRectangle            *area,
+                           GdkEvent                *event,
+                           MousepadFolding         *folding)
+{
+  gint line, n;
+
+  line = gtk_text_iter_get_line (iter);
+  n = mousepad_folding_find_fold (folding, line);
+  if (n >= 0)
+    mousepad_folding_unfold (folding, n);
+  else
+    mousepad_folding_fold (folding, line);
+
+  gtk_source_gutter_renderer_queue_draw (renderer);
+}
+
+
+
+/**
+ * Settings
+ **/
+static void
+mousepad_folding_update_enabled (MousepadFolding *folding)
+{
+  gboolean enabled;
+
+  /* scanning long lines on each change would crawl */
+  enabled = MOUSEPAD_SETTING_GET_BOOLEAN (CODE_FOLDING) && ! mousepad_view_get_long_lines (folding->view);
+  if (enabled == folding->enabled)
+    return;
+
+  folding->enabled = enabled;
+  gtk_source_gutter_renderer_set_visible (folding->renderer, enabled);
+
+  /* the buffer is only followed while enabled */
+  if (enabled)
+    mousepad_folding_build (folding);
+  else
+    {
+      mousepad_folding_unfold_all (folding);
+      g_free (folding->lines);
+      folding->lines = NULL;
+      folding->n_lines = 0;
+      folding->gap = 0;
+      folding->gap_size = 0;
+      folding->n_valid = 0;
+    }
+}
+
+
+
+static void
+mousepad_folding_tab_width_changed (MousepadFolding *folding)
+{
+  folding->tab_width = MAX (gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (folding->view)), 1);
+
+  if (folding->enabled)
+    mousepad_folding_build (folding);
+}
+
+
+
+static void
+mousepad_folding_finalize (GObject *object)
+{
+  MousepadFolding *folding = MOUSEPAD_FOLDING (object);
+
+  g_signal_handlers_disconnect_by_data (folding->buffer, folding);
+  g_signal_handlers_disconnect_by_data (folding->view, folding);
+  g_signal_handlers_disconnect_by_data (folding->renderer, folding);
+
+  /* no build is running, since it holds a reference on us */
+  mousepad_folding_unfold_all (folding);
+  g_ptr_array_free (folding->folds, TRUE);
+  g_free (folding->lines);
+  gtk_text_buffer_delete_mark (folding->buffer, folding->dirty_start);
+  gtk_text_buffer_delete_mark (folding->buffer, folding->dirty_end);
+
+  /* release the renderer, widget and buffer references */
+  g_object_unref (folding->renderer);
+  g_object_unref (folding->buffer);
+  g_object_unref (folding->view);
+
+  (*G_OBJECT_CLASS (mousepad_folding_parent_class)->finalize) (object);
+}
+
+
+
+MousepadFolding *
+mousepad_folding_new (MousepadView *view)
+{
+  MousepadFolding *folding;
+  GtkSourceGutter *gutter;
+  GtkTextIter      iter;
+  gint             width;
+
+  g_return_val_if_fail (MOUSEPAD_IS_VIEW (view), NULL);
+
+  folding = g_object_new (MOUSEPAD_TYPE_FOLDING, NULL);
+  folding->view = g_object_ref (view);
+  folding->buffer = g_object_ref (gtk_text_view_get_buffer (GTK_TEXT_VIEW (view)));
+  folding->tab_width = MAX (gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (view)), 1);
+  folding->tag = gtk_text_buffer_create_tag (folding->buffer, NULL, "invisible", TRUE, NULL);
+
+  /* the region edited during a build, text typed at its edges goes in */
+  gtk_text_buffer_get_start_iter (folding->buffer, &iter);
+  folding->dirty_start = gtk_text_buffer_create_mark (folding->buffer, NULL, &iter, TRUE);
+  folding->dirty_end = gtk_text_buffer_create_mark (folding->buffer, NULL, &iter, FALSE);
+
+  /* put the markers after the line numbers */
+  folding->renderer = g_object_ref_sink (gtk_source_gutter_renderer_text_new ());
+  gutter = gtk_source_view_get_gutter (GTK_SOURCE_VIEW (view), GTK_TEXT_WINDOW_LEFT);
+  gtk_source_gutter_insert (gutter, folding->renderer, MOUSEPAD_FOLDING_GUTTER_POSITION);
+  gtk_source_gutter_renderer_text_measure (GTK_SOURCE_GUTTER_RENDERER_TEXT (folding->renderer),
+                                           MOUSEPAD_FOLDING_UNFOLDED, &width, NULL);
+  gtk_source_gutter_renderer_set_size (folding->renderer, width);
+  gtk_source_gutter_renderer_set_padding (folding->renderer, 2, -1);
+  gtk_source_gutter_renderer_set_visible (folding->renderer, FALSE);
+
+  g_signal_connect (folding->renderer, "query-data",
+                    G_CALLBACK (mousepad_folding_query_data), folding);
+  g_signal_connect (folding->renderer, "query-activatable",
+                    G_CALLBACK (mousepad_folding_query_activatable), folding);
+  g_signal_connect (folding->renderer, "activate",
+                    G_CALLBACK (mousepad_folding_activate), folding);
+
+  /* follow the buffer: the edited lines are needed before and after the changes */
+  g_signal_connect (folding->buffer, "insert-text",
+                    G_CALLBACK (mousepad_folding_insert_text), folding);
+  g_signal_connect_after (folding->buffer, "insert-text",
+                          G_CALLBACK (mousepad_folding_inserted_text), folding);
+  g_signal_connect (folding->buffer, "delete-range",
+                    G_CALLBACK (mousepad_folding_delete_range), folding);
+  g_signal_connect_after (folding->buffer, "delete-range",
+                          G_CALLBACK (mousepad_folding_deleted_range), folding);
+  g_signal_connect_swapped (folding->buffer, "notify::cursor-position",
+                            G_CALLBACK (mousepad_folding_cursor_moved), folding);
+
+  /* follow the view and the setting */
+  g_signal_connect_swapped (view, "notify::tab-width",
+                            G_CALLBACK (mousepad_folding_tab_width_changed), folding);
+  g_signal_connect_swapped (view, "notify::long-lines",
+                            G_CALLBACK (mousepad_folding_update_enabled), folding);
+
+  mousepad_folding_update_enabled (folding);
+  MOUSEPAD_SETTING_CONNECT_OBJECT (CODE_FOLDING, G_CALLBACK (mousepad_folding_update_enabled),
+                                   folding, G_CONNECT_SWAPPED);
+
+  return folding;
+}
@@ -0,0 +1,40 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __MOUSEPAD_FOLDING_H__
+#define __MOUSEPAD_FOLDING_H__
+
+#include <mousepad/mousepad-view.h>
+
+G_BEGIN_DECLS
+
+typedef struct _MousepadFoldingClass MousepadFoldingClass;
+typedef struct _MousepadFolding      MousepadFolding;
+
+#define MOUSEPAD_TYPE_FOLDING            (mousepad_folding_get_type ())
+#define MOUSEPAD_FOLDING(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), MOUSEPAD_TYPE_FOLDING, MousepadFolding))
+#define MOUSEPAD_FOLDING_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), MOUSEPAD_TYPE_FOLDING, MousepadFoldingClass))
+#define MOUSEPAD_IS_FOLDING(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), MOUSEPAD_TYPE_FOLDING))
+#define MOUSEPAD_IS_FOLDING_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), MOUSEPAD_TYPE_FOLDING))
+#define MOUSEPAD_FOLDING_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), MOUSEPAD_TYPE_FOLDING, MousepadFoldingClass))
+
+GType            mousepad_folding_get_type (void) G_GNUC_CONST;
+
+MousepadFolding *mousepad_folding_new      (MousepadView *view);
+
+G_END_DECLS
+
+#endif /* !__MOUSEPAD_FOLDING_H__ */
@@ -0,0 +1,585 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <mousepad/mousepad-private.h>
+#include <mousepad/mousepad-highlighter.h>
+
+
+
+/* time (in microseconds) spent in each idle iteration, and number of lines scanned
+ * between two checks of this time */
+#define MOUSEPAD_HIGHLIGHTER_IDLE_BUDGET 8000
+#define MOUSEPAD_HIGHLIGHTER_BATCH_SIZE  256
+
+
+
+typedef struct
+{
+  /* byte classes: the bytes which don't occur in any term share the class 0 */
+  guint8  classes[256];
+  guint   n_classes;
+
+  /* complete transition table, of n_states * n_classes entries */
+  guint  *delta;
+  guint   n_states;
+
+  /* the term ending at each state or -1, and the next state on the failure chain which
+   * has an output, or 0 since the root never has one */
+  gint   *output;
+  guint  *output_link;
+
+  /* byte length of each term */
+  gsize  *lengths;
+}
+MousepadAhoCorasick;
+
+
+
+static void      mousepad_highlighter_finalize     (GObject             *object);
+static void      mousepad_highlighter_insert_text  (GtkTextBuffer       *buffer,
+                                                    GtkTextIter         *location,
+                                                    gchar               *text,
+                                                    gint                 len,
+                                                    MousepadHighlighter *highlighter);
+static void      mousepad_highlighter_delete_range (GtkTextBuffer       *buffer,
+                                                    GtkTextIter         *start,
+                                                    GtkTextIter         *end,
+                                                    MousepadHighlighter *highlighter);
+
+
+
+struct _MousepadHighlighterClass
+{
+  GObjectClass __parent__;
+};
+
+struct _MousepadHighlighter
+{
+  GObject              __parent__;
+
+  /* the view whose visible region is highlighted first, and its buffer */
+  GtkTextView         *view;
+  GtkTextBuffer       *buffer;
+
+  /* the automaton matching the terms, and the tag of each term */
+  MousepadAhoCorasick *automaton;
+  GPtrArray           *tags;
+
+  /* the background scan goes on from this mark */
+  GtkTextMark         *scan_mark;
+
+  /* lines edited since they were scanned */
+  GtkTextMark         *dirty_start;
+  GtkTextMark         *dirty_end;
+  guint                dirty : 1;
+
+  /* the visible lines last scanned ahead of the background scan */
+  gint                 visible_start;
+  gint                 visible_end;
+
+  /* idle scan source */
+  guint                idle_id;
+};
+
+
+
+/* background colors of the terms, used in turn */
+static const gchar *term_colors[] =
+{
+  "#ffff78", "#a8e6a1", "#9fd3ff", "#ffb3b3", "#e0b8ff", "#ffd59a", "#9ff0e6", "#d9d9d9"
+};
+
+
+
+/**
+ * Aho-Corasick automaton
+ **/
+static MousepadAhoCorasick *
+mousepad_aho_corasick_new (GPtrArray *terms,
+                           gboolean   match_case)
+{
+  MousepadAhoCorasick *automaton;
+  GArray              *delta, *output;
+  const guchar        *p;
+  guint               *table, *fail, *queue;
+  guint                n, i, c, state, next, head = 0, tail = 0;
+  gint                 none = -1;
+
+  automaton = g_new0 (MousepadAhoCorasick, 1);
+
+  /* give a class to each byte occurring in the terms, the same to both cases of ASCII
+   * letters when not matching case */
+  for (i = 0, n = 1; i < terms->len; i++)
+    for (p = g_ptr_array_index (terms, i); *p != '\0'; p++)
+      if (automaton->classes[*p] == 0)
+        {
+          if (match_case)
+            automaton->classes[*p] = n++;
+          else
+            {
+              automaton->classes[(guchar) g_ascii_tolower (*p)] = n;
+              automaton->classes[(guchar) g_ascii_toupper (*p)] = n++;
+            }
+        }
+
+  automaton->n_classes = n;
+
+  /* build the trie of the terms: 0 is the root, so it also means there is no edge */
+  delta = g_array_new (FALSE, TRUE, sizeof (guint));
+  output = g_array_new (FALSE, FALSE, sizeof (gint));
+  g_array_set_size (delta, n);
+  g_array_append_val (output, none);
+  automaton->lengths = g_new (gsize, terms->len);
+
+  for (i = 0; i < terms->len; i++)
+    {
+      for (p = g_ptr_array_index (terms, i), state = 0; *p != '\0'; p++, state = next)
+        {
+          c = automaton->classes[*p];
+          next = g_array_index (delta, guint, state * n + c);
+          if (next == 0)
+            {
+              next = output->len;
+              g_array_index (delta, guint, state * n + c) = next;
+              g_array_set_size (delta, delta->len + n);
+              g_array_append_val (output, none);
+            }
+        }
+
+      /* the first of duplicated terms wins */
+      if (g_array_index (output, gint, state) == -1)
+        g_array_index (output, gint, state) = i;
+
+      automaton->lengths[i] = p - (const guchar *) g_ptr_array_index (terms, i);
+    }
+
+  automaton->n_states = output->len;
+  automaton->output = (gint *) g_array_free (output, FALSE);
+  automaton->delta = table = (guint *) g_array_free (delta, FALSE);
+  automaton->output_link = g_new0 (guint, automaton->n_states);
+
+  /* complete the transitions breadth first, the failure state of each state being
+   * already complete when it is reached */
+  fail = g_new0 (guint, automaton->n_states);
+  queue = g_new (guint, automaton->n_states);
+  for (c = 0; c < n; c++)
+    if (table[c] != 0)
+      queue[tail++] = table[c];
+
+  while (head < tail)
+    {
+      state = queue[head++];
+      for (c = 0; c < n; c++)
+        {
+          next = table[state * n + c];
+          if (next != 0)
+            {
+              fail[next] = table[fail[state] * n + c];
+              automaton->output_link[next] = automaton->output[fail[next]] != -1
+                                             ? fail[next] : automaton->output_link[fail[next]];
+              queue[tail++] = next;
+            }
+          else
+            table[state * n + c] = table[fail[state] * n + c];
+        }
+    }
+
+  /* cleanup */
+  g_free (fail);
+  g_free (queue);
+
+  return automaton;
+}
+
+
+
+static void
+mousepad_aho_corasick_free (MousepadAhoCorasick *automaton)
+{
+  if (automaton == NULL)
+    return;
+
+  g_free (automaton->delta);
+  g_free (automaton->output);
+  g_free (automaton->output_link);
+  g_free (automaton->lengths);
+  g_free (automaton);
+}
+
+
+
+/**
+ * GObject stuff
+ **/
+G_DEFINE_TYPE (MousepadHighlighter, mousepad_highlighter, G_TYPE_OBJECT)
+
+
+
+static void
+mousepad_highlighter_class_init (MousepadHighlighterClass *klass)
+{
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = mousepad_highlighter_finalize;
+}
+
+
+
+static void
+mousepad_highlighter_init (MousepadHighlighter *highlighter)
+{
+  highlighter->automaton = NULL;
+  highlighter->tags = g_ptr_array_new ();
+  highlighter->dirty = FALSE;
+  highlighter->visible_start = -1;
+  highlighter->visible_end = -1;
+  highlighter->idle_id = 0;
+}
+
+
+
+static void
+mousepad_highlighter_clear (MousepadHighlighter *highlighter)
+{
+  GtkTextTagTable *table;
+  guint            i;
+
+  /* stop the scan */
+  if (highlighter->idle_id != 0)
+    g_source_remove (highlighter->idle_id);
+
+  /* removing the tags from the table also removes them from the buffer */
+  table = gtk_text_buffer_get_tag_table (highlighter->buffer);
+  for (i = 0; i < highlighter->tags->len; i++)
+    gtk_text_tag_table_remove (table, g_ptr_array_index (highlighter->tags, i));
+
+  g_ptr_array_set_size (highlighter->tags, 0);
+  mousepad_aho_corasick_free (highlighter->automaton);
+  highlighter->automaton = NULL;
+  highlighter->dirty = FALSE;
+}
+
+
+
+static void
+mousepad_highlighter_finalize (GObject *object)
+{
+  MousepadHighlighter *highlighter = MOUSEPAD_HIGHLIGHTER (object);
+
+  /* drop the terms and stop watching the buffer */
+  mousepad_highlighter_clear (highlighter);
+  g_signal_handlers_disconnect_by_data (highlighter->buffer, highlighter);
+
+  /* cleanup */
+  gtk_text_buffer_delete_mark (highlighter->buffer, highlighter->scan_mark);
+  gtk_text_buffer_delete_mark (highlighter->buffer, highlighter->dirty_start);
+  gtk_text_buffer_delete_mark (highlighter->buffer, highlighter->dirty_end);
+  g_ptr_array_free (highlighter->tags, TRUE);
+
+  /* release the view and buffer references */
+  g_object_unref (highlighter->buffer);
+  g_object_unref (highlighter->view);
+
+  (*G_OBJECT_CLASS (mousepad_highlighter_parent_class)->finalize) (object);
+}
+
+
+
+/**
+ * Scanning
+ **/
+static void
+mousepad_highlighter_scan (MousepadHighlighter *highlighter,
+                           GtkTextIter         *iter,
+                           const GtkTextIter   *limit)
+{
+  MousepadAhoCorasick *automaton = highlighter->automaton;
+  GtkTextIter          end, line_end, match_start, match_end;
+  gchar               *text;
+  gsize                i;
+  guint                state, match;
+  gint                 term;
+
+  /* scan at most a batch of whole lines, the limit being at a line start */
+  gtk_text_iter_set_line_offset (iter, 0);
+  end = *iter;
+  gtk_text_iter_forward_lines (&end, MOUSEPAD_HIGHLIGHTER_BATCH_SIZE);
+  if (gtk_text_iter_compare (&end, limit) > 0)
+    end = *limit;
+
+  /* remove the previous matches */
+  for (i = 0; i < highlighter->tags->len; i++)
+    gtk_text_buffer_remove_tag (highlighter->buffer, g_ptr_array_index (highlighter->tags, i),
+                                iter, &end);
+
+  while (gtk_text_iter_compare (iter, &end) < 0)
+    {
+      /* the slice keeps the byte indexes of the line, unlike the text */
+      line_end = *iter;
+      if (! gtk_text_iter_ends_line (&line_end))
+        gtk_text_iter_forward_to_line_end (&line_end);
+
+      text = gtk_text_iter_get_slice (iter, &line_end);
+
+      /* run the automaton over the line, reporting all the terms ending at each byte */
+      for (i = 0, state = 0; text[i] != '\0'; i++)
+        {
+          state = automaton->delta[state * automaton->n_classes
+                                   + automaton->classes[(guchar) text[i]]];
+
+          for (match = automaton->output[state] != -1 ? state : automaton->output_link[state];
+               match != 0; match = automaton->output_link[match])
+            {
+              term = automaton->output[match];
+              match_start = match_end = *iter;
+              gtk_text_iter_set_line_index (&match_start, i + 1 - automaton->lengths[term]);
+              gtk_text_iter_set_line_index (&match_end, i + 1);
+              gtk_text_buffer_apply_tag (highlighter->buffer,
+                                         g_ptr_array_index (highlighter->tags, term),
+                                         &match_start, &match_end);
+            }
+        }
+
+      g_free (text);
+
+      if (! gtk_text_iter_forward_line (iter))
+        break;
+    }
+
+  *iter = end;
+}
+
+
+
+static gboolean
+mousepad_highlighter_idle (gpointer data)
+{
+  MousepadHighlighter *highlighter = MOUSEPAD_HIGHLIGHTER (data);
+  GtkTextIter          iter, limit, scan;
+  GdkRectangle         rect;
+  gint64               deadline;
+  gint                 first, last;
+
+  deadline = g_get_monotonic_time () + MOUSEPAD_HIGHLIGHTER_IDLE_BUDGET;
+
+  /* rescan the edited lines first */
+  if (highlighter->dirty)
+    {
+      gtk_text_buffer_get_iter_at_mark (highlighter->buffer, &iter, highlighter->dirty_start);
+      gtk_text_buffer_get_iter_at_mark (highlighter->buffer, &limit, highlighter->dirty_end);
+      gtk_text_iter_forward_line (&limit);
+
+      do
+        mousepad_highlighter_scan (highlighter, &iter, &limit);
+      while (gtk_text_iter_compare (&iter, &limit) < 0 && g_get_monotonic_time () < deadline);
+
+      /* remember where to go on next time */
+      if (gtk_text_iter_compare (&iter, &limit) < 0)
+        gtk_text_buffer_move_mark (highlighter->buffer, highlighter->dirty_start, &iter);
+      else
+        highlighter->dirty = FALSE;
+    }
+
+  /* then the visible lines, when the background scan didn't reach them yet */
+  if (gtk_widget_get_mapped (GTK_WIDGET (highlighter->view)))
+    {
+      gtk_text_view_get_visible_rect (highlighter->view, &rect);
+      gtk_text_view_get_line_at_y (highlighter->view, &iter, rect.y, NULL);
+      gtk_text_view_get_line_at_y (highlighter->view, &limit, rect.y + rect.height, NULL);
+      gtk_text_iter_forward_line (&limit);
+      gtk_text_buffer_get_iter_at_mark (highlighter->buffer, &scan, highlighter->scan_mark);
+
+      first = gtk_text_iter_get_line (&iter);
+      last = gtk_text_iter_get_line (&limit);
+      if ((first != highlighter->visible_start || last != highlighter->visible_end)
+          && gtk_text_iter_compare (&limit, &scan) > 0)
+        {
+          highlighter->visible_start = first;
+          highlighter->visible_end = last;
+
+          if (gtk_text_iter_compare (&iter, &scan) < 0)
+            iter = scan;
+
+          while (gtk_text_iter_compare (&iter, &limit) < 0)
+            mousepad_highlighter_scan (highlighter, &iter, &limit);
+        }
+    }
+
+  /* and the rest of the buffer in the background */
+  gtk_text_buffer_get_iter_at_mark (highlighter->buffer, &iter, highlighter->scan_mark);
+  gtk_text_buffer_get_end_iter (highlighter->buffer, &limit);
+  while (! gtk_text_iter_is_end (&iter) && g_get_monotonic_time () < deadline)
+    mousepad_highlighter_scan (highlighter, &iter, &limit);
+
+  gtk_text_buffer_move_mark (highlighter->buffer, highlighter->scan_mark, &iter);
+
+  return highlighter->dirty || ! gtk_text_iter_is_end (&iter);
+}
+
+
+
+static void
+mousepad_highlighter_idle_destroy (gpointer data)
+{
+  MOUSEPAD_HIGHLIGHTER (data)->idle_id = 0;
+}
+
+
+
+static void
+mousepad_highlighter_schedule (MousepadHighlighter *highlighter)
+{
+  if (highlighter->idle_id == 0)
+    highlighter->idle_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, mousepad_highlighter_idle,
+                                            highlighter, mousepad_highlighter_idle_destroy);
+}
+
+
+
+static void
+mousepad_highlighter_invalidate (MousepadHighlighter *highlighter,
+                                 const GtkTextIter   *start,
+                                 const GtkTextIter   *end)
+{
+  GtkTextIter iter;
+
+  if (highlighter->automaton == NULL)
+    return;
+
+  /* extend the edited range */
+  if (highlighter->dirty)
+    {
+      gtk_text_buffer_get_iter_at_mark (highlighter->buffer, &iter, highlighter->dirty_start);
+      if (gtk_text_iter_compare (start, &iter) < 0)
+        gtk_text_buffer_move_mark (highlighter->buffer, highlighter->dirty_start, start);
+
+      gtk_text_buffer_get_iter_at_mark (highlighter->buffer, &iter, highlighter->dirty_end);
+      if (gtk_text_iter_compare (end, &iter) > 0)
+        gtk_text_buffer_move_mark (highlighter->buffer, highlighter->dirty_end, end);
+    }
+  else
+    {
+      gtk_text_buffer_move_mark (highlighter->buffer, highlighter->dirty_start, start);
+      gtk_text_buffer_move_mark (highlighter->buffer, highlighter->dirty_end, end);
+      highlighter->dirty = TRUE;
+    }
+
+  mousepad_highlighter_schedule (highlighter);
+}
+
+
+
+static void
+mousepad_highlighter_insert_text (GtkTextBuffer       *buffer,
+                                  GtkTextIter         *location,
+                                  gchar               *text,
+                                  gint                 len,
+                                  MousepadHighlighter *highlighter)
+{
+  GtkTextIter start = *location;
+
+  /* the location was moved to the end of the inserted text */
+  gtk_text_iter_backward_chars (&start, g_utf8_strlen (text, len));
+  mousepad_highlighter_invalidate (highlighter, &start, location);
+}
+
+
+
+static void
+mousepad_highlighter_delete_range (GtkTextBuffer       *buffer,
+                                   GtkTextIter         *start,
+                                   GtkTextIter         *end,
+                                   MousepadHighlighter *highlighter)
+{
+  mousepad_highlighter_invalidate (highlighter, start, end);
+}
+
+
+
+/**
+ * Public functions
+ **/
+MousepadHighlighter *
+mousepad_highlighter_new (GtkTextView *view)
+{
+  MousepadHighlighter *highlighter;
+  GtkTextIter          start;
+
+  g_return_val_if_fail (GTK_IS_TEXT_VIEW (view), NULL);
+
+  highlighter = g_object_new (MOUSEPAD_TYPE_HIGHLIGHTER, NULL);
+  highlighter->view = g_object_ref (view);
+  highlighter->buffer = g_object_ref (gtk_text_view_get_buffer (view));
+
+  /* text inserted at the scan mark or at the edges of the edited range belongs to them */
+  gtk_text_buffer_get_start_iter (highlighter->buffer, &start);
+  highlighter->scan_mark = gtk_text_buffer_create_mark (highlighter->buffer, NULL, &start, TRUE);
+  highlighter->dirty_start = gtk_text_buffer_create_mark (highlighter->buffer, NULL, &start, TRUE);
+  highlighter->dirty_end = gtk_text_buffer_create_mark (highlighter->buffer, NULL, &start, FALSE);
+
+  /* the locations are up to date after the default handlers */
+  g_signal_connect_after (highlighter->buffer, "insert-text",
+                          G_CALLBACK (mousepad_highlighter_insert_text), highlighter);
+  g_signal_connect_after (highlighter->buffer, "delete-range",
+                          G_CALLBACK (mousepad_highlighter_delete_range), highlighter);
+
+  return highlighter;
+}
+
+
+
+void
+mousepad_highlighter_set_terms (MousepadHighlighter *highlighter,
+                                const gchar * const *terms,
+                                gboolean             match_case)
+{
+  GtkTextTag  *tag;
+  GtkTextIter  start;
+  GPtrArray   *valid;
+
+  g_return_if_fail (MOUSEPAD_IS_HIGHLIGHTER (highlighter));
+
+  /* drop the previous terms and their matches */
+  mousepad_highlighter_clear (highlighter);
+
+  /* only keep the single line terms, since the buffer is scanned line by line */
+  valid = g_ptr_array_new ();
+  for (; terms != NULL && *terms != NULL; terms++)
+    if (**terms != '\0' && strpbrk (*terms, "\r\n") == NULL
+        && strstr (*terms, "\342\200\251") == NULL)
+      {
+        tag = gtk_text_buffer_create_tag (highlighter->buffer, NULL, "background",
+                                          term_colors[valid->len % G_N_ELEMENTS (term_colors)],
+                                          NULL);
+        g_ptr_array_add (highlighter->tags, tag);
+        g_ptr_array_add (valid, (gpointer) *terms);
+      }
+
+  if (valid->len > 0)
+    {
+      highlighter->automaton = mousepad_aho_corasick_new (valid, match_case);
+
+      /* scan the whole buffer again, visible lines first */
+      gtk_text_buffer_get_start_iter (highlighter->buffer, &start);
+      gtk_text_buffer_move_mark (highlighter->buffer, highlighter->scan_mark, &start);
+      highlighter->visible_start = -1;
+      highlighter->visible_end = -1;
+      mousepad_highlighter_schedule (highlighter);
+    }
+
+  g_ptr_array_free (valid, TRUE);
+}
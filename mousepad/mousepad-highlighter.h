@@ -0,0 +1,44 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __MOUSEPAD_HIGHLIGHTER_H__
+#define __MOUSEPAD_HIGHLIGHTER_H__
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+typedef struct _MousepadHighlighterClass MousepadHighlighterClass;
+typedef struct _MousepadHighlighter      MousepadHighlighter;
+
+#define MOUSEPAD_TYPE_HIGHLIGHTER            (mousepad_highlighter_get_type ())
+#define MOUSEPAD_HIGHLIGHTER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), MOUSEPAD_TYPE_HIGHLIGHTER, MousepadHighlighter))
+#define MOUSEPAD_HIGHLIGHTER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), MOUSEPAD_TYPE_HIGHLIGHTER, MousepadHighlighterClass))
+#define MOUSEPAD_IS_HIGHLIGHTER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), MOUSEPAD_TYPE_HIGHLIGHTER))
+#define MOUSEPAD_IS_HIGHLIGHTER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), MOUSEPAD_TYPE_HIGHLIGHTER))
+#define MOUSEPAD_HIGHLIGHTER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), MOUSEPAD_TYPE_HIGHLIGHTER, MousepadHighlighterClass))
+
+GType                mousepad_highlighter_get_type  (void) G_GNUC_CONST;
+
+MousepadHighlighter *mousepad_highlighter_new       (GtkTextView         *view);
+
+void                 mousepad_highlighter_set_terms (MousepadHighlighter *highlighter,
+                                                     const gchar * const *terms,
+                                                     gboolean             match_case);
+
+G_END_DECLS
+
+#endif /* !__MOUSEPAD_HIGHLIGHTER_H__ */
@@ -0,0 +1,820 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <mousepad/mousepad-private.h>
+#include <mousepad/mousepad-settings.h>
+#include <mousepad/mousepad-minimap.h>
+
+#include <gtksourceview/gtksource.h>
+
+
+
+/* number of columns shown and size (in pixels) of a character, and number of lines
+ * of a tile (tiles grow with the insertions until they are rendered again) */
+#define MOUSEPAD_MINIMAP_COLUMNS      100
+#define MOUSEPAD_MINIMAP_CHAR_WIDTH   1
+#define MOUSEPAD_MINIMAP_LINE_HEIGHT  2
+#define MOUSEPAD_MINIMAP_WIDTH        (MOUSEPAD_MINIMAP_COLUMNS * MOUSEPAD_MINIMAP_CHAR_WIDTH)
+#define MOUSEPAD_MINIMAP_TILE_LINES   128
+
+/* number of screens of tiles kept rendered on each side of the ones in sight */
+#define MOUSEPAD_MINIMAP_KEPT_SCREENS 2
+
+
+
+typedef struct
+{
+  /* start of the tile, always at a line start */
+  GtkTextMark     *mark;
+
+  /* the rendered lines or NULL, and whether they are outdated */
+  cairo_surface_t *surface;
+  guint            dirty : 1;
+
+  /* the running render */
+  GCancellable    *cancellable;
+}
+MousepadMinimapTile;
+
+typedef struct
+{
+  /* the lines of the tile, cut to the shown columns */
+  gchar   *text;
+  guint    n_lines;
+  guint    tab_width;
+  guint32  foreground;
+}
+MousepadMinimapRender;
+
+
+
+static void      mousepad_minimap_finalize      (GObject         *object);
+static void      mousepad_minimap_set_enabled   (MousepadMinimap *minimap);
+static void      mousepad_minimap_style_changed (MousepadMinimap *minimap);
+static void      mousepad_minimap_insert_text   (GtkTextBuffer   *buffer,
+                                                 GtkTextIter     *location,
+                                                 gchar           *text,
+                                                 gint             len,
+                                                 MousepadMinimap *minimap);
+static void      mousepad_minimap_delete_range  (GtkTextBuffer   *buffer,
+                                                 GtkTextIter     *start,
+                                                 GtkTextIter     *end,
+                                                 MousepadMinimap *minimap);
+static void      mousepad_minimap_deleted_range (GtkTextBuffer   *buffer,
+                                                 GtkTextIter     *start,
+                                                 GtkTextIter     *end,
+                                                 MousepadMinimap *minimap);
+static gboolean  mousepad_minimap_draw          (GtkWidget       *widget,
+                                                 cairo_t         *cr,
+                                                 MousepadMinimap *minimap);
+static gboolean  mousepad_minimap_button_press  (GtkWidget       *widget,
+                                                 GdkEventButton  *event,
+                                                 MousepadMinimap *minimap);
+static gboolean  mousepad_minimap_motion_notify (GtkWidget       *widget,
+                                                 GdkEventMotion  *event,
+                                                 MousepadMinimap *minimap);
+
+
+
+struct _MousepadMinimapClass
+{
+  GObjectClass __parent__;
+};
+
+struct _MousepadMinimap
+{
+  GObject        __parent__;
+
+  /* the text view whose right border shows the minimap, and its buffer */
+  GtkTextView   *view;
+  GtkTextBuffer *buffer;
+  GtkAdjustment *vadjustment;
+
+  /* the tiles, sorted by position, the first one at the buffer start */
+  GPtrArray     *tiles;
+
+  /* the tiles a deletion may merge, between its "before" and "after" handlers */
+  guint          delete_first;
+  guint          delete_last;
+
+  /* colors of the text, from the style scheme */
+  GdkRGBA        foreground;
+  GdkRGBA        background;
+  guint          background_set : 1;
+
+  guint          enabled : 1;
+};
+
+
+
+G_DEFINE_TYPE (MousepadMinimap, mousepad_minimap, G_TYPE_OBJECT)
+
+
+
+static void
+mousepad_minimap_class_init (MousepadMinimapClass *klass)
+{
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = mousepad_minimap_finalize;
+}
+
+
+
+static void
+mousepad_minimap_init (MousepadMinimap *minimap)
+{
+  minimap->tiles = g_ptr_array_new ();
+  minimap->background_set = FALSE;
+  minimap->enabled = FALSE;
+}
+
+
+
+/**
+ * Tiles
+ **/
+static void
+mousepad_minimap_tile_cancel (MousepadMinimapTile *tile)
+{
+  if (tile->cancellable != NULL)
+    {
+      g_cancellable_cancel (tile->cancellable);
+      g_clear_object (&tile->cancellable);
+    }
+}
+
+
+
+static void
+mousepad_minimap_tile_invalidate (MousepadMinimapTile *tile)
+{
+  /* the outdated surface is shown until the new one is ready */
+  mousepad_minimap_tile_cancel (tile);
+  tile->dirty = TRUE;
+}
+
+
+
+static MousepadMinimapTile *
+mousepad_minimap_tile_new (MousepadMinimap   *minimap,
+                           const GtkTextIter *iter)
+{
+  MousepadMinimapTile *tile;
+
+  /* text inserted at the start of the tile belongs to it */
+  tile = g_slice_new (MousepadMinimapTile);
+  tile->mark = gtk_text_buffer_create_mark (minimap->buffer, NULL, iter, TRUE);
+  tile->surface = NULL;
+  tile->dirty = TRUE;
+  tile->cancellable = NULL;
+
+  return tile;
+}
+
+
+
+static void
+mousepad_minimap_tile_free (MousepadMinimap     *minimap,
+                            MousepadMinimapTile *tile)
+{
+  mousepad_minimap_tile_cancel (tile);
+  gtk_text_buffer_delete_mark (minimap->buffer, tile->mark);
+
+  if (tile->surface != NULL)
+    cairo_surface_destroy (tile->surface);
+
+  g_slice_free (MousepadMinimapTile, tile);
+}
+
+
+
+static void
+mousepad_minimap_clear (MousepadMinimap *minimap)
+{
+  guint n;
+
+  for (n = 0; n < minimap->tiles->len; n++)
+    mousepad_minimap_tile_free (minimap, g_ptr_array_index (minimap->tiles, n));
+
+  g_ptr_array_set_size (minimap->tiles, 0);
+}
+
+
+
+static gint
+mousepad_minimap_tile_get_line (MousepadMinimap *minimap,
+                                guint            n)
+{
+  MousepadMinimapTile *tile;
+  GtkTextIter          iter;
+
+  if (n >= minimap->tiles->len)
+    return gtk_text_buffer_get_line_count (minimap->buffer);
+
+  tile = g_ptr_array_index (minimap->tiles, n);
+  gtk_text_buffer_get_iter_at_mark (minimap->buffer, &iter, tile->mark);
+
+  return gtk_text_iter_get_line (&iter);
+}
+
+
+
+static guint
+mousepad_minimap_find_tile (MousepadMinimap *minimap,
+                            gint             line)
+{
+  guint low = 0, high = minimap->tiles->len, mid;
+
+  /* the last tile starting at or before the line */
+  while (high - low > 1)
+    {
+      mid = (low + high) / 2;
+      if (mousepad_minimap_tile_get_line (minimap, mid) <= line)
+        low = mid;
+      else
+        high = mid;
+    }
+
+  return low;
+}
+
+
+
+static void
+mousepad_minimap_invalidate_all (MousepadMinimap *minimap)
+{
+  guint n;
+
+  for (n = 0; n < minimap->tiles->len; n++)
+    mousepad_minimap_tile_invalidate (g_ptr_array_index (minimap->tiles, n));
+}
+
+
+
+static void
+mousepad_minimap_redraw (MousepadMinimap *minimap)
+{
+  GdkWindow *window;
+
+  window = gtk_text_view_get_window (minimap->view, GTK_TEXT_WINDOW_RIGHT);
+  if (window != NULL)
+    gdk_window_invalidate_rect (window, NULL, FALSE);
+}
+
+
+
+/**
+ * Rendering
+ **/
+static void
+mousepad_minimap_render_free (gpointer data)
+{
+  MousepadMinimapRender *render = data;
+
+  g_free (render->text);
+  g_slice_free (MousepadMinimapRender, render);
+}
+
+
+
+static void
+mousepad_minimap_render_thread (GTask        *task,
+                                gpointer      source_object,
+                                gpointer      task_data,
+                                GCancellable *cancellable)
+{
+  MousepadMinimapRender *render = task_data;
+  cairo_surface_t       *surface;
+  const gchar           *p;
+  guint32               *row;
+  guchar                *data;
+  gunichar               c;
+  guint                  line = 0, column = 0, x;
+  gint                   stride;
+
+  /* one pixel row per line, the next one is left blank between the lines */
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, MOUSEPAD_MINIMAP_WIDTH,
+                                        render->n_lines * MOUSEPAD_MINIMAP_LINE_HEIGHT);
+  cairo_surface_flush (surface);
+  data = cairo_image_surface_get_data (surface);
+  stride = cairo_image_surface_get_stride (surface);
+  memset (data, 0, stride * render->n_lines * MOUSEPAD_MINIMAP_LINE_HEIGHT);
+
+  for (p = render->text; *p != '\0' && line < render->n_lines; p = g_utf8_next_char (p))
+    {
+      c = g_utf8_get_char (p);
+      if (c == '\n')
+        {
+          line++;
+          column = 0;
+        }
+      else if (c == '\t')
+        column += render->tab_width - column % render->tab_width;
+      else if (column < MOUSEPAD_MINIMAP_COLUMNS)
+        {
+          if (! g_unichar_isspace (c))
+            {
+              row = (guint32 *) (data + line * MOUSEPAD_MINIMAP_LINE_HEIGHT * stride);
+              for (x = 0; x < MOUSEPAD_MINIMAP_CHAR_WIDTH; x++)
+                row[column * MOUSEPAD_MINIMAP_CHAR_WIDTH + x] = render->foreground;
+            }
+
+          column++;
+        }
+    }
+
+  cairo_surface_mark_dirty (surface);
+
+  g_task_return_pointer (task, surface, (GDestroyNotify) cairo_surface_destroy);
+}
+
+
+
+static void
+mousepad_minimap_render_ready (GObject      *object,
+                               GAsyncResult *result,
+                               gpointer      data)
+{
+  MousepadMinimap     *minimap = MOUSEPAD_MINIMAP (object);
+  MousepadMinimapTile *tile = data;
+  cairo_surface_t     *surface;
+
+  /* a cancelled render has been superseded, or its tile dropped */
+  surface = g_task_propagate_pointer (G_TASK (result), NULL);
+  if (surface == NULL)
+    return;
+
+  g_clear_object (&tile->cancellable);
+  if (tile->surface != NULL)
+    cairo_surface_destroy (tile->surface);
+
+  tile->surface = surface;
+  mousepad_minimap_redraw (minimap);
+}
+
+
+
+static void
+mousepad_minimap_render (MousepadMinimap *minimap,
+                         guint            n)
+{
+  MousepadMinimapRender *render;
+  MousepadMinimapTile   *tile = g_ptr_array_index (minimap->tiles, n);
+  GtkTextIter            start, end;
+  GString               *text;
+  GTask                 *task;
+  gchar                 *slice;
+  gint                   line, n_lines, split;
+  guint                  alpha;
+
+  line = mousepad_minimap_tile_get_line (minimap, n);
+  n_lines = mousepad_minimap_tile_get_line (minimap, n + 1) - line;
+
+  /* split the tiles grown by the insertions */
+  for (split = n_lines - (n_lines - 1) % MOUSEPAD_MINIMAP_TILE_LINES - 1;
+       split > 0; split -= MOUSEPAD_MINIMAP_TILE_LINES)
+    {
+      gtk_text_buffer_get_iter_at_line (minimap->buffer, &start, line + split);
+      g_ptr_array_insert (minimap->tiles, n + 1, mousepad_minimap_tile_new (minimap, &start));
+    }
+
+  n_lines = MIN (n_lines, MOUSEPAD_MINIMAP_TILE_LINES);
+
+  /* take the shown part of the lines, no matter how long they are */
+  text = g_string_new (NULL);
+  gtk_text_buffer_get_iter_at_line (minimap->buffer, &start, line);
+  for (line = 0; line < n_lines; line++)
+    {
+      end = start;
+      if (! gtk_text_iter_forward_chars (&end, MOUSEPAD_MINIMAP_COLUMNS)
+          || gtk_text_iter_get_line (&end) != gtk_text_iter_get_line (&start))
+        {
+          end = start;
+          if (! gtk_text_iter_ends_line (&end))
+            gtk_text_iter_forward_to_line_end (&end);
+        }
+
+      slice = gtk_text_iter_get_slice (&start, &end);
+      g_string_append (text, slice);
+      g_string_append_c (text, '\n');
+      g_free (slice);
+
+      gtk_text_iter_forward_line (&start);
+    }
+
+  render = g_slice_new (MousepadMinimapRender);
+  render->text = g_string_free (text, FALSE);
+  render->n_lines = n_lines;
+  render->tab_width = MAX (gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (minimap->view)), 1);
+
+  /* premultiplied, a little faded to tell the minimap from the text */
+  alpha = minimap->foreground.alpha * 0xb0;
+  render->foreground = alpha << 24
+                       | (guint) (minimap->foreground.red * alpha) << 16
+                       | (guint) (minimap->foreground.green * alpha) << 8
+                       | (guint) (minimap->foreground.blue * alpha);
+
+  tile->dirty = FALSE;
+  tile->cancellable = g_cancellable_new ();
+  task = g_task_new (minimap, tile->cancellable, mousepad_minimap_render_ready, tile);
+  g_task_set_task_data (task, render, mousepad_minimap_render_free);
+  g_task_run_in_thread (task, mousepad_minimap_render_thread);
+  g_object_unref (task);
+}
+
+
+
+/**
+ * Following the buffer
+ **/
+static void
+mousepad_minimap_insert_text (GtkTextBuffer   *buffer,
+                              GtkTextIter     *location,
+                              gchar           *text,
+                              gint             len,
+                              MousepadMinimap *minimap)
+{
+  guint n;
+
+  if (! minimap->enabled)
+    return;
+
+  /* the text goes to the tile of the location, even at its start */
+  n = mousepad_minimap_find_tile (minimap, gtk_text_iter_get_line (location));
+  mousepad_minimap_tile_invalidate (g_ptr_array_index (minimap->tiles, n));
+
+  mousepad_minimap_redraw (minimap);
+}
+
+
+
+static void
+mousepad_minimap_delete_range (GtkTextBuffer   *buffer,
+                               GtkTextIter     *start,
+                               GtkTextIter     *end,
+                               MousepadMinimap *minimap)
+{
+  guint n;
+
+  if (! minimap->enabled)
+    return;
+
+  minimap->delete_first = mousepad_minimap_find_tile (minimap, gtk_text_iter_get_line (start));
+  minimap->delete_last = mousepad_minimap_find_tile (minimap, gtk_text_iter_get_line (end));
+
+  for (n = minimap->delete_first; n <= minimap->delete_last; n++)
+    mousepad_minimap_tile_invalidate (g_ptr_array_index (minimap->tiles, n));
+}
+
+
+
+static void
+mousepad_minimap_deleted_range (GtkTextBuffer   *buffer,
+                                GtkTextIter     *start,
+                                GtkTextIter     *end,
+                                MousepadMinimap *minimap)
+{
+  MousepadMinimapTile *tile;
+  GtkTextIter          iter;
+  guint                n;
+  gint                 line;
+
+  if (! minimap->enabled)
+    return;
+
+  /* the tiles starting inside the deleted range are now empty, or start in the middle
+   * of a line: move them to the next line start, or merge them with the previous tile */
+  line = mousepad_minimap_tile_get_line (minimap, minimap->delete_first);
+  for (n = minimap->delete_first + 1; n <= minimap->delete_last && n < minimap->tiles->len; )
+    {
+      tile = g_ptr_array_index (minimap->tiles, n);
+      gtk_text_buffer_get_iter_at_mark (buffer, &iter, tile->mark);
+      if ((gtk_text_iter_starts_line (&iter) || gtk_text_iter_forward_line (&iter))
+          && gtk_text_iter_get_line (&iter) > line
+          && (n + 1 == minimap->tiles->len || gtk_text_iter_get_line (&iter)
+                                              < mousepad_minimap_tile_get_line (minimap, n + 1)))
+        {
+          gtk_text_buffer_move_mark (buffer, tile->mark, &iter);
+          line = gtk_text_iter_get_line (&iter);
+          n++;
+        }
+      else
+        {
+          mousepad_minimap_tile_free (minimap, tile);
+          g_ptr_array_remove_index (minimap->tiles, n);
+          minimap->delete_last--;
+        }
+    }
+
+  mousepad_minimap_redraw (minimap);
+}
+
+
+
+/**
+ * Drawing
+ **/
+static gint
+mousepad_minimap_get_offset (MousepadMinimap *minimap,
+                             gint             height)
+{
+  gdouble range;
+  gint    map_height;
+
+  /* the minimap follows the scrolling when taller than the view */
+  map_height = gtk_text_buffer_get_line_count (minimap->buffer) * MOUSEPAD_MINIMAP_LINE_HEIGHT;
+  range = gtk_adjustment_get_upper (minimap->vadjustment)
+          - gtk_adjustment_get_lower (minimap->vadjustment)
+          - gtk_adjustment_get_page_size (minimap->vadjustment);
+  if (map_height <= height || range <= 0)
+    return 0;
+
+  return (gtk_adjustment_get_value (minimap->vadjustment)
+          - gtk_adjustment_get_lower (minimap->vadjustment)) / range * (map_height - height);
+}
+
+
+
+static gboolean
+mousepad_minimap_draw (GtkWidget       *widget,
+                       cairo_t         *cr,
+                       MousepadMinimap *minimap)
+{
+  MousepadMinimapTile *tile;
+  GdkRectangle         rect;
+  GtkTextIter          iter;
+  GdkWindow           *window;
+  guint                n, first_tile, last_tile, margin;
+  gint                 height, offset, line, first, last;
+
+  window = gtk_text_view_get_window (minimap->view, GTK_TEXT_WINDOW_RIGHT);
+  if (! minimap->enabled || window == NULL || ! gtk_cairo_should_draw_window (cr, window))
+    return FALSE;
+
+  cairo_save (cr);
+  gtk_cairo_transform_to_window (cr, widget, window);
+
+  height = gdk_window_get_height (window);
+  offset = mousepad_minimap_get_offset (minimap, height);
+
+  if (minimap->background_set)
+    {
+      gdk_cairo_set_source_rgba (cr, &minimap->background);
+      cairo_paint (cr);
+    }
+
+  /* paint the tiles in sight, only rendering the outdated ones again */
+  first_tile = mousepad_minimap_find_tile (minimap, offset / MOUSEPAD_MINIMAP_LINE_HEIGHT);
+  for (n = first_tile; n < minimap->tiles->len; n++)
+    {
+      line = mousepad_minimap_tile_get_line (minimap, n);
+      if (line * MOUSEPAD_MINIMAP_LINE_HEIGHT >= offset + height)
+        break;
+
+      tile = g_ptr_array_index (minimap->tiles, n);
+      if (tile->dirty)
+        mousepad_minimap_render (minimap, n);
+
+      if (tile->surface != NULL)
+        {
+          cairo_set_source_surface (cr, tile->surface, 0, line * MOUSEPAD_MINIMAP_LINE_HEIGHT - offset);
+          cairo_paint (cr);
+        }
+    }
+
+  /* drop the surfaces of the tiles far from sight, so that scrolling through a long
+   * document doesn't keep all of it rendered */
+  last_tile = n;
+  margin = MOUSEPAD_MINIMAP_KEPT_SCREENS * (last_tile - first_tile + 1);
+  for (n = 0; n < minimap->tiles->len; n++)
+    {
+      if (n + margin >= first_tile && n < last_tile + margin)
+        continue;
+
+      tile = g_ptr_array_index (minimap->tiles, n);
+      if (tile->surface != NULL)
+        {
+          mousepad_minimap_tile_invalidate (tile);
+          cairo_surface_destroy (tile->surface);
+          tile->surface = NULL;
+        }
+    }
+
+  /* shade the lines shown in the view */
+  gtk_text_view_get_visible_rect (minimap->view, &rect);
+  gtk_text_view_get_line_at_y (minimap->view, &iter, rect.y, NULL);
+  first = gtk_text_iter_get_line (&iter);
+  gtk_text_view_get_line_at_y (minimap->view, &iter, rect.y + rect.height, NULL);
+  last = gtk_text_iter_get_line (&iter);
+
+  cairo_set_source_rgba (cr, minimap->foreground.red, minimap->foreground.green,
+                         minimap->foreground.blue, 0.12);
+  cairo_rectangle (cr, 0, first * MOUSEPAD_MINIMAP_LINE_HEIGHT - offset, MOUSEPAD_MINIMAP_WIDTH,
+                   (last - first + 1) * MOUSEPAD_MINIMAP_LINE_HEIGHT);
+  cairo_fill (cr);
+
+  cairo_restore (cr);
+
+  return FALSE;
+}
+
+
+
+static void
+mousepad_minimap_scroll_to (MousepadMinimap *minimap,
+                            gdouble          y)
+{
+  GtkTextIter iter;
+  GdkWindow  *window;
+  gint        line_y, line_height;
+
+  window = gtk_text_view_get_window (minimap->view, GTK_TEXT_WINDOW_RIGHT);
+  y += mousepad_minimap_get_offset (minimap, gdk_window_get_height (window));
+
+  /* center the pointed line in the view */
+  gtk_text_buffer_get_iter_at_line (minimap->buffer, &iter, y / MOUSEPAD_MINIMAP_LINE_HEIGHT);
+  gtk_text_view_get_line_yrange (minimap->view, &iter, &line_y, &line_height);
+  gtk_adjustment_set_value (minimap->vadjustment,
+                            line_y - gtk_adjustment_get_page_size (minimap->vadjustment) / 2);
+}
+
+
+
+static gboolean
+mousepad_minimap_button_press (GtkWidget       *widget,
+                               GdkEventButton  *event,
+                               MousepadMinimap *minimap)
+{
+  if (! minimap->enabled || event->button != 1 || event->type != GDK_BUTTON_PRESS
+      || event->window != gtk_text_view_get_window (minimap->view, GTK_TEXT_WINDOW_RIGHT))
+    return FALSE;
+
+  mousepad_minimap_scroll_to (minimap, event->y);
+
+  return TRUE;
+}
+
+
+
+static gboolean
+mousepad_minimap_motion_notify (GtkWidget       *widget,
+                                GdkEventMotion  *event,
+                                MousepadMinimap *minimap)
+{
+  if (! minimap->enabled || ! (event->state & GDK_BUTTON1_MASK)
+      || event->window != gtk_text_view_get_window (minimap->view, GTK_TEXT_WINDOW_RIGHT))
+    return FALSE;
+
+  mousepad_minimap_scroll_to (minimap, event->y);
+
+  return TRUE;
+}
+
+
+
+/**
+ * Settings and style
+ **/
+static void
+mousepad_minimap_style_changed (MousepadMinimap *minimap)
+{
+  GtkSourceStyleScheme *scheme;
+  GtkSourceStyle       *style = NULL;
+  gboolean              foreground_set = FALSE, background_set = FALSE;
+  gchar                *foreground = NULL, *background = NULL;
+
+  /* take the text colors of the scheme, or fall back to the theme */
+  scheme = gtk_source_buffer_get_style_scheme (GTK_SOURCE_BUFFER (minimap->buffer));
+  if (scheme != NULL)
+    style = gtk_source_style_scheme_get_style (scheme, "text");
+
+  if (style != NULL)
+    g_object_get (style, "foreground-set", &foreground_set, "foreground", &foreground,
+                  "background-set", &background_set, "background", &background, NULL);
+
+  if (! foreground_set || ! gdk_rgba_parse (&minimap->foreground, foreground))
+    gtk_style_context_get_color (gtk_widget_get_style_context (GTK_WIDGET (minimap->view)),
+                                 gtk_widget_get_state_flags (GTK_WIDGET (minimap->view)),
+                                 &minimap->foreground);
+
+  minimap->background_set = background_set && gdk_rgba_parse (&minimap->background, background);
+
+  g_free (foreground);
+  g_free (background);
+
+  /* the colors are baked into the tiles */
+  mousepad_minimap_invalidate_all (minimap);
+  mousepad_minimap_redraw (minimap);
+}
+
+
+
+static void
+mousepad_minimap_set_enabled (MousepadMinimap *minimap)
+{
+  GtkTextIter start;
+  gboolean    enabled;
+
+  enabled = MOUSEPAD_SETTING_GET_BOOLEAN (SHOW_MINIMAP);
+  if (enabled == minimap->enabled)
+    return;
+
+  minimap->enabled = enabled;
+  gtk_text_view_set_border_window_size (minimap->view, GTK_TEXT_WINDOW_RIGHT,
+                                        enabled ? MOUSEPAD_MINIMAP_WIDTH : 0);
+
+  /* the buffer is only followed while shown */
+  mousepad_minimap_clear (minimap);
+  if (enabled)
+    {
+      gtk_text_buffer_get_start_iter (minimap->buffer, &start);
+      g_ptr_array_add (minimap->tiles, mousepad_minimap_tile_new (minimap, &start));
+    }
+}
+
+
+
+static void
+mousepad_minimap_finalize (GObject *object)
+{
+  MousepadMinimap *minimap = MOUSEPAD_MINIMAP (object);
+
+  g_signal_handlers_disconnect_by_data (minimap->buffer, minimap);
+  g_signal_handlers_disconnect_by_data (minimap->view, minimap);
+  g_signal_handlers_disconnect_by_data (minimap->vadjustment, minimap);
+
+  /* no render is running, since it holds a reference on us */
+  mousepad_minimap_clear (minimap);
+  g_ptr_array_free (minimap->tiles, TRUE);
+
+  /* release the widget and buffer references */
+  g_object_unref (minimap->vadjustment);
+  g_object_unref (minimap->buffer);
+  g_object_unref (minimap->view);
+
+  (*G_OBJECT_CLASS (mousepad_minimap_parent_class)->finalize) (object);
+}
+
+
+
+MousepadMinimap *
+mousepad_minimap_new (GtkTextView *view)
+{
+  MousepadMinimap *minimap;
+
+  g_return_val_if_fail (GTK_SOURCE_IS_VIEW (view), NULL);
+
+  /* the view is expected to be in its scrolled window already */
+  minimap = g_object_new (MOUSEPAD_TYPE_MINIMAP, NULL);
+  minimap->view = g_object_ref (view);
+  minimap->buffer = g_object_ref (gtk_text_view_get_buffer (view));
+  minimap->vadjustment = g_object_ref (gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (view)));
+
+  /* follow the buffer: the tiles are needed before an insertion, around a deletion */
+  g_signal_connect (minimap->buffer, "insert-text",
+                    G_CALLBACK (mousepad_minimap_insert_text), minimap);
+  g_signal_connect (minimap->buffer, "delete-range",
+                    G_CALLBACK (mousepad_minimap_delete_range), minimap);
+  g_signal_connect_after (minimap->buffer, "delete-range",
+                          G_CALLBACK (mousepad_minimap_deleted_range), minimap);
+
+  /* the tiles are only painted again when the view scrolls */
+  g_signal_connect_swapped (minimap->vadjustment, "value-changed",
+                            G_CALLBACK (mousepad_minimap_redraw), minimap);
+
+  /* draw in the right border of the view, and scroll it from there */
+  g_signal_connect_after (view, "draw", G_CALLBACK (mousepad_minimap_draw), minimap);
+  g_signal_connect (view, "button-press-event",
+                    G_CALLBACK (mousepad_minimap_button_press), minimap);
+  g_signal_connect (view, "motion-notify-event",
+                    G_CALLBACK (mousepad_minimap_motion_notify), minimap);
+
+  /* follow the color scheme and the tab width */
+  g_signal_connect_swapped (minimap->buffer, "notify::style-scheme",
+                            G_CALLBACK (mousepad_minimap_style_changed), minimap);
+  g_signal_connect_swapped (view, "notify::tab-width",
+                            G_CALLBACK (mousepad_minimap_style_changed), minimap);
+
+  /* follow the setting */
+  mousepad_minimap_set_enabled (minimap);
+  mousepad_minimap_style_changed (minimap);
+  MOUSEPAD_SETTING_CONNECT_OBJECT (SHOW_MINIMAP, G_CALLBACK (mousepad_minimap_set_enabled),
+                                   minimap, G_CONNECT_SWAPPED);
+
+  return minimap;
+}
@@ -0,0 +1,40 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __MOUSEPAD_MINIMAP_H__
+#define __MOUSEPAD_MINIMAP_H__
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+typedef struct _MousepadMinimapClass MousepadMinimapClass;
+typedef struct _MousepadMinimap      MousepadMinimap;
+
+#define MOUSEPAD_TYPE_MINIMAP            (mousepad_minimap_get_type ())
+#define MOUSEPAD_MINIMAP(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), MOUSEPAD_TYPE_MINIMAP, MousepadMinimap))
+#define MOUSEPAD_MINIMAP_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), MOUSEPAD_TYPE_MINIMAP, MousepadMinimapClass))
+#define MOUSEPAD_IS_MINIMAP(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), MOUSEPAD_TYPE_MINIMAP))
+#define MOUSEPAD_IS_MINIMAP_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), MOUSEPAD_TYPE_MINIMAP))
+#define MOUSEPAD_MINIMAP_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), MOUSEPAD_TYPE_MINIMAP, MousepadMinimapClass))
+
+GType            mousepad_minimap_get_type (void) G_GNUC_CONST;
+
+MousepadMinimap *mousepad_minimap_new      (GtkTextView *view);
+
+G_END_DECLS
+
+#endif /* !__MOUSEPAD_MINIMAP_H__ */
@@ -0,0 +1,800 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <mousepad/mousepad-private.h>
+#include <mousepad/mousepad-settings.h>
+#include <mousepad/mousepad-outline.h>
+
+
+
+/* delay (in ms) before parsing the edited lines again, lines parsed around them (for
+ * the symbols spanning several lines), number of edited lines above which the whole
+ * buffer is parsed again in the background, and padding (in pixels) per symbol level */
+#define MOUSEPAD_OUTLINE_DELAY          300
+#define MOUSEPAD_OUTLINE_CONTEXT_LINES  4
+#define MOUSEPAD_OUTLINE_REBUILD_LINES  4096
+#define MOUSEPAD_OUTLINE_LEVEL_PADDING  12
+
+
+
+typedef struct
+{
+  /* space separated language ids, and a multi-line pattern with a "name" group and
+   * optionally a "level" group, whose length gives the symbol level (the indentation
+   * of the line is used otherwise) */
+  const gchar *languages;
+  const gchar *pattern;
+}
+MousepadOutlineRule;
+
+typedef struct
+{
+  gint   line;
+  guint  level;
+  gchar *name;
+}
+MousepadOutlineSymbol;
+
+typedef struct
+{
+  gchar     *text;
+  GPtrArray *regexes;
+}
+MousepadOutlineBuild;
+
+
+
+static void     mousepad_outline_finalize       (GObject         *object);
+static void     mousepad_outline_update_enabled (MousepadOutline *outline);
+static void     mousepad_outline_build          (MousepadOutline *outline);
+static gboolean mousepad_outline_update         (gpointer         data);
+
+
+
+struct _MousepadOutlineClass
+{
+  GObjectClass __parent__;
+};
+
+struct _MousepadOutline
+{
+  GObject        __parent__;
+
+  /* the buffer, and its symbols with a mark at the start of their line */
+  GtkTextBuffer *buffer;
+  GtkListStore  *store;
+
+  /* regexes of the buffer language, NULL when there are none */
+  GPtrArray     *regexes;
+
+  /* the region edited since the last parse */
+  GtkTextMark   *dirty_start;
+  GtkTextMark   *dirty_end;
+  guint          dirty : 1;
+
+  /* a background build is running, and whether it has to be started again, with the
+   * line count of its snapshot */
+  guint          building : 1;
+  guint          rebuild : 1;
+  gint           build_line_count;
+
+  guint          timeout_id;
+  guint          enabled : 1;
+};
+
+
+
+/* symbols of the supported languages */
+static const MousepadOutlineRule rules[] =
+{
+  /* function definitions starting at the line start */
+  { "c chdr cpp cpphdr objc",
+    "^(?:[A-Za-z_][\\w \\t\\*&:<>,]*\\s)?\\**"
+    "(?<name>(?!(?:if|for|while|switch|return|else|do|sizeof|case)\\b)[A-Za-z_~][\\w:~]*)"
+    "\\s*\\([^;{}()]*\\)\\s*(?:const\\s*)?\\{" },
+  { "c chdr cpp cpphdr objc",
+    "^(?:typedef\\s+)?(?:struct|union|enum|class|namespace)\\s+(?<name>[A-Za-z_]\\w*)"
+    "\\s*(?::[^;{]*)?\\{" },
+  { "python python3",
+    "^[ \\t]*(?:async[ \\t]+)?(?:def|class)[ \\t]+(?<name>\\w+)" },
+  { "sh",
+    "^[ \\t]*(?:function[ \\t]+)?(?<name>[A-Za-z_][\\w-]*)[ \\t]*\\(\\)" },
+  { "js typescript",
+    "^[ \\t]*(?:export[ \\t]+)?(?:default[ \\t]+)?(?:async[ \\t]+)?(?:function\\*?|class)"
+    "[ \\t]+(?<name>[\\w$]+)" },
+  { "java c-sharp vala",
+    "^[ \\t]*(?:(?:public|private|protected|internal|static|abstract|sealed|partial)[ \\t]+)*"
+    "(?:class|interface|enum|struct|namespace|record)[ \\t]+(?<name>\\w+)" },
+  { "java c-sharp vala",
+    "^[ \\t]*(?:(?:public|private|protected|internal|static|final|abstract|override|virtual"
+    "|async|synchronized)[ \\t]+)+[\\w<>\\[\\],.? \\t]*?(?<name>[A-Za-z_]\\w*)[ \\t]*"
+    "\\([^;{}()]*\\)[^;{}()]*\\{" },
+  { "rust",
+    "^[ \\t]*(?:pub(?:\\([^)\\n]*\\))?[ \\t]+)?(?:(?:async|const|unsafe|extern[ \\t]+\"[^\"\\n]*\")"
+    "[ \\t]+)*(?:fn|struct|enum|trait|mod|union)[ \\t]+(?<name>\\w+)" },
+  { "rust",
+    "^[ \\t]*impl(?:<[^>\\n]*>)?[ \\t]+(?<name>[^{\\n]*?)[ \\t]*(?:where\\b[^{]*)?\\{" },
+  { "go",
+    "^(?:func[ \\t]+(?:\\([^)\\n]*\\)[ \\t]*)?|type[ \\t]+)(?<name>\\w+)" },
+  { "perl",
+    "^[ \\t]*sub[ \\t]+(?<name>[\\w:]+)" },
+  { "ruby",
+    "^[ \\t]*(?:def|class|module)[ \\t]+(?<name>[\\w.:?!=]+)" },
+  { "php",
+    "^[ \\t]*(?:(?:public|private|protected|static|abstract|final)[ \\t]+)*"
+    "(?:function|class|interface|trait)[ \\t]+&?(?<name>\\w+)" },
+  { "lua",
+    "^[ \\t]*(?:local[ \\t]+)?function[ \\t]+(?<name>[\\w.:]+)" },
+
+  /* headings and sections */
+  { "markdown",
+    "^#(?<level>#{0,5})[ \\t]+(?<name>[^\\n]*?)[ \\t#]*$" },
+  { "latex",
+    "^[ \\t]*\\\\(?:part|chapter|(?:sub)*section)\\*?\\{(?<name>[^}\\n]*)\\}" },
+  { "ini desktop",
+    "^[ \\t]*\\[(?<name>[^\\]\\n]+)\\]" },
+  { "makefile",
+    "^(?<name>[^:#=\\s][^:#=\\n]*?)[ \\t]*::?(?!=)" }
+};
+
+
+
+G_DEFINE_TYPE (MousepadOutline, mousepad_outline, G_TYPE_OBJECT)
+
+
+
+static void
+mousepad_outline_class_init (MousepadOutlineClass *klass)
+{
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = mousepad_outline_finalize;
+}
+
+
+
+static void
+mousepad_outline_init (MousepadOutline *outline)
+{
+  outline->store = gtk_list_store_new (MOUSEPAD_OUTLINE_N_COLUMNS,
+                                       G_TYPE_STRING, G_TYPE_UINT, G_TYPE_POINTER);
+  outline->regexes = NULL;
+  outline->dirty = FALSE;
+  outline->building = FALSE;
+  outline->rebuild = FALSE;
+  outline->timeout_id = 0;
+  outline->enabled = FALSE;
+}
+
+
+
+/**
+ * Parsing
+ **/
+static GPtrArray *
+mousepad_outline_get_regexes (GtkSourceLanguage *language)
+{
+  static GHashTable *regexes_table = NULL;
+  GPtrArray         *regexes;
+  GRegex            *regex;
+  const gchar       *id;
+  gchar            **ids;
+  guint              n, m;
+
+  if (language == NULL)
+    return NULL;
+
+  /* compile the rules of each language once */
+  if (G_UNLIKELY (regexes_table == NULL))
+    regexes_table = g_hash_table_new (g_str_hash, g_str_equal);
+
+  id = gtk_source_language_get_id (language);
+  if (g_hash_table_lookup_extended (regexes_table, id, NULL, (gpointer *) &regexes))
+    return regexes;
+
+  regexes = NULL;
+  for (n = 0; n < G_N_ELEMENTS (rules); n++)
+    {
+      ids = g_strsplit (rules[n].languages, " ", -1);
+      for (m = 0; ids[m] != NULL; m++)
+        if (g_strcmp0 (ids[m], id) == 0)
+          break;
+
+      if (ids[m] != NULL)
+        {
+          regex = g_regex_new (rules[n].pattern,
+                               G_REGEX_MULTILINE | G_REGEX_NEWLINE_ANYCRLF | G_REGEX_OPTIMIZE,
+                               0, NULL);
+          if (G_LIKELY (regex != NULL))
+            {
+              if (regexes == NULL)
+                regexes = g_ptr_array_new_with_free_func ((GDestroyNotify) g_regex_unref);
+
+              g_ptr_array_add (regexes, regex);
+            }
+          else
+            g_warn_if_reached ();
+        }
+
+      g_strfreev (ids);
+    }
+
+  g_hash_table_insert (regexes_table, g_strdup (id), regexes);
+
+  return regexes;
+}
+
+
+
+static void
+mousepad_outline_symbol_clear (gpointer data)
+{
+  g_free (((MousepadOutlineSymbol *) data)->name);
+}
+
+
+
+static gint
+mousepad_outline_symbol_compare (gconstpointer a,
+                                 gconstpointer b)
+{
+  return ((const MousepadOutlineSymbol *) a)->line - ((const MousepadOutlineSymbol *) b)->line;
+}
+
+
+
+static GArray *
+mousepad_outline_parse (GPtrArray   *regexes,
+                        const gchar *text,
+                        gint         first_line)
+{
+  MousepadOutlineSymbol  symbol;
+  GMatchInfo            *match_info;
+  const gchar           *p, *q;
+  GArray                *symbols;
+  gchar                 *level;
+  guint                  n, columns;
+  gint                   start, end, line;
+
+  symbols = g_array_new (FALSE, FALSE, sizeof (MousepadOutlineSymbol));
+  g_array_set_clear_func (symbols, mousepad_outline_symbol_clear);
+
+  for (n = 0; n < regexes->len; n++)
+    {
+      p = text;
+      line = first_line;
+      g_regex_match (g_ptr_array_index (regexes, n), text, 0, &match_info);
+      for (; g_match_info_matches (match_info); g_match_info_next (match_info, NULL))
+        {
+          if (! g_match_info_fetch_named_pos (match_info, "name", &start, &end) || start == end)
+            continue;
+
+          /* count the lines up to the name, as the text buffer does */
+          for (; p < text + start; p++)
+            if (*p == '\n' || (*p == '\r' && p[1] != '\n')
+                || (p[0] == '\342' && p[1] == '\200' && p[2] == '\251'))
+              line++;
+
+          symbol.line = line;
+          symbol.name = g_strndup (text + start, end - start);
+
+          /* the level is given by the pattern, or by the line indentation */
+          level = g_match_info_fetch_named (match_info, "level");
+          if (level != NULL)
+            symbol.level = strlen (level);
+          else
+            {
+              for (q = text + start; q > text && q[-1] != '\n' && q[-1] != '\r'; q--);
+              for (columns = 0; *q == ' ' || *q == '\t'; q++)
+                columns += (*q == '\t') ? 4 : 1;
+
+              symbol.level = columns / 4;
+            }
+
+          g_free (level);
+          g_array_append_val (symbols, symbol);
+        }
+
+      g_match_info_free (match_info);
+    }
+
+  /* the rules are matched one after the other */
+  if (regexes->len > 1)
+    g_array_sort (symbols, mousepad_outline_symbol_compare);
+
+  return symbols;
+}
+
+
+
+/**
+ * Symbols
+ **/
+static gint
+mousepad_outline_get_row_line (MousepadOutline *outline,
+                               GtkTreeIter     *row)
+{
+  GtkTextMark *mark;
+  GtkTextIter  iter;
+
+  gtk_tree_model_get (GTK_TREE_MODEL (outline->store), row, MOUSEPAD_OUTLINE_COLUMN_MARK, &mark, -1);
+  gtk_text_buffer_get_iter_at_mark (outline->buffer, &iter, mark);
+
+  return gtk_text_iter_get_line (&iter);
+}
+
+
+
+static gint
+mousepad_outline_find_row (MousepadOutline *outline,
+                           gint             line)
+{
+  GtkTreeIter row;
+  gint        low, high, middle;
+
+  /* the first symbol on the line or after it, the rows being sorted by line */
+  low = 0;
+  high = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (outline->store), NULL);
+  while (low < high)
+    {
+      middle = (low + high) / 2;
+      gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (outline->store), &row, NULL, middle);
+      if (mousepad_outline_get_row_line (outline, &row) < line)
+        low = middle + 1;
+      else
+        high = middle;
+    }
+
+  return low;
+}
+
+
+
+static void
+mousepad_outline_remove_symbols (MousepadOutline *outline,
+                                 gint             first,
+                                 gint             last)
+{
+  GtkTextMark *mark;
+  GtkTreeIter  row;
+  gboolean     valid;
+
+  valid = gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (outline->store), &row, NULL,
+                                         mousepad_outline_find_row (outline, first));
+  while (valid && mousepad_outline_get_row_line (outline, &row) <= last)
+    {
+      gtk_tree_model_get (GTK_TREE_MODEL (outline->store), &row, MOUSEPAD_OUTLINE_COLUMN_MARK, &mark, -1);
+      gtk_text_buffer_delete_mark (outline->buffer, mark);
+      valid = gtk_list_store_remove (outline->store, &row);
+    }
+}
+
+
+
+static void
+mousepad_outline_insert_symbols (MousepadOutline *outline,
+                                 GArray          *symbols)
+{
+  MousepadOutlineSymbol *symbol;
+  GtkTextMark           *mark;
+  GtkTextIter            iter;
+  guint                  n;
+  gint                   position = -1;
+
+  /* text typed at the line start stays after the mark */
+  for (n = 0; n < symbols->len; n++)
+    {
+      /* skip the symbols dropped after a build */
+      symbol = &g_array_index (symbols, MousepadOutlineSymbol, n);
+      if (symbol->name == NULL)
+        continue;
+      else if (position < 0)
+        position = mousepad_outline_find_row (outline, symbol->line);
+
+      gtk_text_buffer_get_iter_at_line (outline->buffer, &iter, symbol->line);
+      mark = gtk_text_buffer_create_mark (outline->buffer, NULL, &iter, TRUE);
+      gtk_list_store_insert_with_values (outline->store, NULL, position++,
+                                         MOUSEPAD_OUTLINE_COLUMN_NAME, symbol->name,
+                                         MOUSEPAD_OUTLINE_COLUMN_PADDING,
+                                         symbol->level * MOUSEPAD_OUTLINE_LEVEL_PADDING,
+                                         MOUSEPAD_OUTLINE_COLUMN_MARK, mark,
+                                         -1);
+    }
+}
+
+
+
+static void
+mousepad_outline_clear (MousepadOutline *outline)
+{
+  mousepad_outline_remove_symbols (outline, 0, G_MAXINT);
+  outline->dirty = FALSE;
+
+  if (outline->timeout_id != 0)
+    g_source_remove (outline->timeout_id);
+}
+
+
+
+/**
+ * Background build
+ **/
+static void
+mousepad_outline_build_free (gpointer data)
+{
+  MousepadOutlineBuild *build = data;
+
+  g_free (build->text);
+  g_ptr_array_unref (build->regexes);
+  g_slice_free (MousepadOutlineBuild, build);
+}
+
+
+
+static void
+mousepad_outline_build_thread (GTask        *task,
+                               gpointer      source_object,
+                               gpointer      task_data,
+                               GCancellable *cancellable)
+{
+  MousepadOutlineBuild *build = task_data;
+
+  g_task_return_pointer (task, mousepad_outline_parse (build->regexes, build->text, 0),
+                         (GDestroyNotify) g_array_unref);
+}
+
+
+
+static void
+mousepad_outline_build_ready (GObject      *object,
+                              GAsyncResult *result,
+                              gpointer      data)
+{
+  MousepadOutline       *outline = MOUSEPAD_OUTLINE (object);
+  MousepadOutlineSymbol *symbol;
+  GtkTextIter            iter;
+  GArray                *symbols;
+  guint                  n;
+  gint                   first = G_MAXINT, last = G_MAXINT, delta = 0;
+
+  symbols = g_task_propagate_pointer (G_TASK (result), NULL);
+  outline->building = FALSE;
+
+  /* the language changed, or the outline was hidden meanwhile */
+  if (! outline->enabled || outline->rebuild || outline->regexes == NULL)
+    {
+      g_array_unref (symbols);
+      if (outline->enabled && outline->rebuild && outline->regexes != NULL)
+        mousepad_outline_build (outline);
+
+      return;
+    }
+
+  /* the lines edited since the snapshot will be parsed again: the symbols before them
+   * are kept as is, and those after them are shifted by the lines added or removed */
+  if (outline->dirty)
+    {
+      gtk_text_buffer_get_iter_at_mark (outline->buffer, &iter, outline->dirty_start);
+      first = gtk_text_iter_get_line (&iter);
+      gtk_text_buffer_get_iter_at_mark (outline->buffer, &iter, outline->dirty_end);
+      delta = gtk_text_buffer_get_line_count (outline->buffer) - outline->build_line_count;
+      last = gtk_text_iter_get_line (&iter) - delta;
+    }
+
+  for (n = 0; n < symbols->len; n++)
+    {
+      symbol = &g_array_index (symbols, MousepadOutlineSymbol, n);
+      if (symbol->line >= first && symbol->line <= last)
+        {
+          g_free (symbol->name);
+          symbol->name = NULL;
+        }
+      else if (symbol->line > last)
+        symbol->line += delta;
+    }
+
+  mousepad_outline_remove_symbols (outline, 0, G_MAXINT);
+  mousepad_outline_insert_symbols (outline, symbols);
+  g_array_unref (symbols);
+
+  if (outline->dirty)
+    mousepad_outline_update (outline);
+}
+
+
+
+static void
+mousepad_outline_build (MousepadOutline *outline)
+{
+  MousepadOutlineBuild *build;
+  GtkTextIter           start, end;
+  GTask                *task;
+
+  /* the running build will be restarted */
+  if (outline->building)
+    {
+      outline->rebuild = TRUE;
+      return;
+    }
+
+  outline->building = TRUE;
+  outline->rebuild = FALSE;
+  outline->dirty = FALSE;
+  outline->build_line_count = gtk_text_buffer_get_line_count (outline->buffer);
+
+  build = g_slice_new (MousepadOutlineBuild);
+  gtk_text_buffer_get_bounds (outline->buffer, &start, &end);
+  build->text = gtk_text_buffer_get_text (outline->buffer, &start, &end, TRUE);
+  build->regexes = g_ptr_array_ref (outline->regexes);
+
+  task = g_task_new (outline, NULL, mousepad_outline_build_ready, NULL);
+  g_task_set_task_data (task, build, mousepad_outline_build_free);
+  g_task_run_in_thread (task, mousepad_outline_build_thread);
+  g_object_unref (task);
+}
+
+
+
+/**
+ * Following the buffer
+ **/
+static gboolean
+mousepad_outline_update (gpointer data)
+{
+  MousepadOutline       *outline = data;
+  MousepadOutlineSymbol *symbol;
+  GtkTextIter            start, end;
+  GArray                *symbols;
+  gchar                 *text;
+  guint                  n;
+  gint                   first, last;
+
+  /* wait for the build, which parses the edited lines afterwards */
+  if (outline->building || ! outline->dirty)
+    return FALSE;
+
+  gtk_text_buffer_get_iter_at_mark (outline->buffer, &start, outline->dirty_start);
+  gtk_text_buffer_get_iter_at_mark (outline->buffer, &end, outline->dirty_end);
+  first = MAX (gtk_text_iter_get_line (&start) - MOUSEPAD_OUTLINE_CONTEXT_LINES, 0);
+  last = gtk_text_iter_get_line (&end) + MOUSEPAD_OUTLINE_CONTEXT_LINES;
+  outline->dirty = FALSE;
+
+  if (last - first > MOUSEPAD_OUTLINE_REBUILD_LINES)
+    {
+      mousepad_outline_build (outline);
+      return FALSE;
+    }
+
+  /* parse the edited lines again, with a few lines around them, and a few more after
+   * them for the symbols whose pattern goes on past their line */
+  gtk_text_buffer_get_iter_at_line (outline->buffer, &start, first);
+  gtk_text_buffer_get_iter_at_line (outline->buffer, &end, last + MOUSEPAD_OUTLINE_CONTEXT_LINES);
+  if (! gtk_text_iter_ends_line (&end))
+    gtk_text_iter_forward_to_line_end (&end);
+
+  text = gtk_text_buffer_get_text (outline->buffer, &start, &end, TRUE);
+  symbols = mousepad_outline_parse (outline->regexes, text, first);
+
+  /* only the symbols of the replaced lines are kept */
+  for (n = 0; n < symbols->len; n++)
+    {
+      symbol = &g_array_index (symbols, MousepadOutlineSymbol, n);
+      if (symbol->line > last)
+        {
+          g_free (symbol->name);
+          symbol->name = NULL;
+        }
+    }
+
+  mousepad_outline_remove_symbols (outline, first, last);
+  mousepad_outline_insert_symbols (outline, symbols);
+
+  g_array_unref (symbols);
+  g_free (text);
+
+  return FALSE;
+}
+
+
+
+static void
+mousepad_outline_update_destroy (gpointer data)
+{
+  MOUSEPAD_OUTLINE (data)->timeout_id = 0;
+}
+
+
+
+static void
+mousepad_outline_invalidate (MousepadOutline   *outline,
+                             const GtkTextIter *start,
+                             const GtkTextIter *end)
+{
+  GtkTextIter iter;
+
+  if (! outline->enabled || outline->regexes == NULL)
+    return;
+
+  /* extend the edited region */
+  if (! outline->dirty)
+    {
+      gtk_text_buffer_move_mark (outline->buffer, outline->dirty_start, start);
+      gtk_text_buffer_move_mark (outline->buffer, outline->dirty_end, end);
+      outline->dirty = TRUE;
+    }
+  else
+    {
+      gtk_text_buffer_get_iter_at_mark (outline->buffer, &iter, outline->dirty_start);
+      if (gtk_text_iter_compare (start, &iter) < 0)
+        gtk_text_buffer_move_mark (outline->buffer, outline->dirty_start, start);
+
+      gtk_text_buffer_get_iter_at_mark (outline->buffer, &iter, outline->dirty_end);
+      if (gtk_text_iter_compare (end, &iter) > 0)
+        gtk_text_buffer_move_mark (outline->buffer, outline->dirty_end, end);
+    }
+
+  /* wait for the changes to settle */
+  if (outline->timeout_id != 0)
+    g_source_remove (outline->timeout_id);
+
+  if (! outline->building)
+    outline->timeout_id = g_timeout_add_full (G_PRIORITY_LOW, MOUSEPAD_OUTLINE_DELAY,
+                                              mousepad_outline_update, outline,
+                                              mousepad_outline_update_destroy);
+}
+
+
+
+static void
+mousepad_outline_inserted_text (GtkTextBuffer   *buffer,
+                                GtkTextIter     *location,
+                                gchar           *text,
+                                gint             len,
+                                MousepadOutline *outline)
+{
+  GtkTextIter start = *location;
+
+  gtk_text_iter_backward_chars (&start, g_utf8_strlen (text, len));
+  mousepad_outline_invalidate (outline, &start, location);
+}
+
+
+
+static void
+mousepad_outline_deleted_range (GtkTextBuffer   *buffer,
+                                GtkTextIter     *start,
+                                GtkTextIter     *end,
+                                MousepadOutline *outline)
+{
+  mousepad_outline_invalidate (outline, start, end);
+}
+
+
+
+static void
+mousepad_outline_language_changed (MousepadOutline *outline)
+{
+  outline->regexes = mousepad_outline_get_regexes (
+                       gtk_source_buffer_get_language (GTK_SOURCE_BUFFER (outline->buffer)));
+
+  if (outline->enabled)
+    {
+      mousepad_outline_clear (outline);
+      if (outline->regexes != NULL)
+        mousepad_outline_build (outline);
+    }
+}
+
+
+
+static void
+mousepad_outline_update_enabled (MousepadOutline *outline)
+{
+  gboolean enabled;
+
+  /* only parse when the outline is shown */
+  enabled = MOUSEPAD_SETTING_GET_BOOLEAN (OUTLINE_VISIBLE);
+  if (enabled == outline->enabled)
+    return;
+
+  outline->enabled = enabled;
+  if (! enabled)
+    mousepad_outline_clear (outline);
+  else if (outline->regexes != NULL)
+    mousepad_outline_build (outline);
+}
+
+
+
+static void
+mousepad_outline_finalize (GObject *object)
+{
+  MousepadOutline *outline = MOUSEPAD_OUTLINE (object);
+
+  g_signal_handlers_disconnect_by_data (outline->buffer, outline);
+
+  /* no build is running, since it holds a reference on us */
+  mousepad_outline_clear (outline);
+  gtk_text_buffer_delete_mark (outline->buffer, outline->dirty_start);
+  gtk_text_buffer_delete_mark (outline->buffer, outline->dirty_end);
+
+  /* release the store and buffer references */
+  g_object_unref (outline->store);
+  g_object_unref (outline->buffer);
+
+  (*G_OBJECT_CLASS (mousepad_outline_parent_class)->finalize) (object);
+}
+
+
+
+MousepadOutline *
+mousepad_outline_new (GtkSourceBuffer *buffer)
+{
+  MousepadOutline *outline;
+  GtkTextIter      iter;
+
+  g_return_val_if_fail (GTK_SOURCE_IS_BUFFER (buffer), NULL);
+
+  outline = g_object_new (MOUSEPAD_TYPE_OUTLINE, NULL);
+  outline->buffer = g_object_ref (GTK_TEXT_BUFFER (buffer));
+  outline->regexes = mousepad_outline_get_regexes (gtk_source_buffer_get_language (buffer));
+
+  /* the edited region, growing with the edits at its ends */
+  gtk_text_buffer_get_start_iter (outline->buffer, &iter);
+  outline->dirty_start = gtk_text_buffer_create_mark (outline->buffer, NULL, &iter, TRUE);
+  outline->dirty_end = gtk_text_buffer_create_mark (outline->buffer, NULL, &iter, FALSE);
+
+  /* follow the buffer, once the changes are done */
+  g_signal_connect_after (buffer, "insert-text",
+                          G_CALLBACK (mousepad_outline_inserted_text), outline);
+  g_signal_connect_after (buffer, "delete-range",
+                          G_CALLBACK (mousepad_outline_deleted_range), outline);
+  g_signal_connect_swapped (buffer, "notify::language",
+                            G_CALLBACK (mousepad_outline_language_changed), outline);
+
+  /* follow the setting */
+  mousepad_outline_update_enabled (outline);
+  MOUSEPAD_SETTING_CONNECT_OBJECT (OUTLINE_VISIBLE, G_CALLBACK (mousepad_outline_update_enabled),
+                                   outline, G_CONNECT_SWAPPED);
+
+  return outline;
+}
+
+
+
+GtkTreeModel *
+mousepad_outline_get_model (MousepadOutline *outline)
+{
+  g_return_val_if_fail (MOUSEPAD_IS_OUTLINE (outline), NULL);
+
+  return GTK_TREE_MODEL (outline->store);
+}
+
+
+
+void
+mousepad_outline_get_iter (MousepadOutline *outline,
+                           GtkTreeIter     *row,
+                           GtkTextIter     *iter)
+{
+  GtkTextMark *mark;
+
+  g_return_if_fail (MOUSEPAD_IS_OUTLINE (outline));
+
+  gtk_tree_model_get (GTK_TREE_MODEL (outline->store), row, MOUSEPAD_OUTLINE_COLUMN_MARK, &mark, -1);
+  gtk_text_buffer_get_iter_at_mark (outline->buffer, iter, mark);
+}
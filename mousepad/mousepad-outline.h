@@ -0,0 +1,54 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __MOUSEPAD_OUTLINE_H__
+#define __MOUSEPAD_OUTLINE_H__
+
+#include <gtksourceview/gtksource.h>
+
+G_BEGIN_DECLS
+
+enum
+{
+  MOUSEPAD_OUTLINE_COLUMN_NAME,
+  MOUSEPAD_OUTLINE_COLUMN_PADDING,
+  MOUSEPAD_OUTLINE_COLUMN_MARK,
+  MOUSEPAD_OUTLINE_N_COLUMNS
+};
+
+typedef struct _MousepadOutlineClass MousepadOutlineClass;
+typedef struct _MousepadOutline      MousepadOutline;
+
+#define MOUSEPAD_TYPE_OUTLINE            (mousepad_outline_get_type ())
+#define MOUSEPAD_OUTLINE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), MOUSEPAD_TYPE_OUTLINE, MousepadOutline))
+#define MOUSEPAD_OUTLINE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), MOUSEPAD_TYPE_OUTLINE, MousepadOutlineClass))
+#define MOUSEPAD_IS_OUTLINE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), MOUSEPAD_TYPE_OUTLINE))
+#define MOUSEPAD_IS_OUTLINE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), MOUSEPAD_TYPE_OUTLINE))
+#define MOUSEPAD_OUTLINE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), MOUSEPAD_TYPE_OUTLINE, MousepadOutlineClass))
+
+GType            mousepad_outline_get_type  (void) G_GNUC_CONST;
+
+MousepadOutline *mousepad_outline_new       (GtkSourceBuffer *buffer);
+
+GtkTreeModel    *mousepad_outline_get_model (MousepadOutline *outline);
+
+void             mousepad_outline_get_iter  (MousepadOutline *outline,
+                                             GtkTreeIter     *row,
+                                             GtkTextIter     *iter);
+
+G_END_DECLS
+
+#endif /* !__MOUSEPAD_OUTLINE_H__ */
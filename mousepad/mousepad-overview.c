@@ -0,0 +1,770 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <mousepad/mousepad-private.h>
+#include <mousepad/mousepad-overview.h>
+#include <mousepad/mousepad-util.h>
+
+
+
+/* delay (in milliseconds) before the markers follow a change, height (in pixels) of the
+ * markers, and number of edited lines above which the whole buffer is scanned again */
+#define MOUSEPAD_OVERVIEW_DELAY          200
+#define MOUSEPAD_OVERVIEW_BUCKET_HEIGHT  3
+#define MOUSEPAD_OVERVIEW_MAX_DIRTY      1000
+
+
+
+typedef struct
+{
+  gchar  *text;
+  guint   n_lines;
+  GRegex *regex;
+}
+MousepadOverviewScan;
+
+
+
+static void      mousepad_overview_finalize      (GObject          *object);
+static void      mousepad_overview_schedule      (MousepadOverview *overview);
+static void      mousepad_overview_insert_text   (GtkTextBuffer    *buffer,
+                                                  GtkTextIter      *location,
+                                                  gchar            *text,
+                                                  gint              len,
+                                                  MousepadOverview *overview);
+static void      mousepad_overview_delete_range  (GtkTextBuffer    *buffer,
+                                                  GtkTextIter      *start,
+                                                  GtkTextIter      *end,
+                                                  MousepadOverview *overview);
+static gboolean  mousepad_overview_draw          (GtkWidget        *scrollbar,
+                                                  cairo_t          *cr,
+                                                  MousepadOverview *overview);
+static gboolean  mousepad_overview_button_press  (GtkWidget        *scrollbar,
+                                                  GdkEventButton   *event,
+                                                  MousepadOverview *overview);
+
+
+
+struct _MousepadOverviewClass
+{
+  GObjectClass __parent__;
+};
+
+struct _MousepadOverview
+{
+  GObject                 __parent__;
+
+  /* the scrolled window whose vertical scrollbar shows the markers, its text view, and
+   * the search context providing the pattern: the scrolled window is usually the owner
+   * of the overview, it and its scrollbar are only weak pointers */
+  GtkScrolledWindow      *window;
+  GtkWidget              *scrollbar;
+  GtkTextView            *view;
+  GtkTextBuffer          *buffer;
+  GtkSourceSearchContext *search_context;
+
+  /* the pattern shown or NULL, and the number of matches starting on each line */
+  GRegex                 *regex;
+  GArray                 *line_matches;
+
+  /* the running background scan, and whether a new one is needed */
+  GCancellable           *cancellable;
+  guint                   rescan : 1;
+
+  /* lines edited since they were scanned */
+  GtkTextMark            *dirty_start;
+  GtkTextMark            *dirty_end;
+  guint                   dirty : 1;
+
+  /* overlay scrolling setting of the window, restored when there are no markers */
+  guint                   overlay_scrolling : 1;
+
+  /* the rendered markers, or NULL when outdated */
+  cairo_surface_t        *surface;
+  gint                    surface_width;
+  gint                    surface_height;
+
+  /* update timeout */
+  guint                   timeout_id;
+};
+
+
+
+G_DEFINE_TYPE (MousepadOverview, mousepad_overview, G_TYPE_OBJECT)
+
+
+
+static void
+mousepad_overview_class_init (MousepadOverviewClass *klass)
+{
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = mousepad_overview_finalize;
+}
+
+
+
+static void
+mousepad_overview_init (MousepadOverview *overview)
+{
+  overview->regex = NULL;
+  overview->line_matches = g_array_new (FALSE, TRUE, sizeof (guint));
+  overview->cancellable = NULL;
+  overview->rescan = FALSE;
+  overview->dirty = FALSE;
+  overview->surface = NULL;
+  overview->timeout_id = 0;
+}
+
+
+
+static void
+mousepad_overview_finalize (GObject *object)
+{
+  MousepadOverview *overview = MOUSEPAD_OVERVIEW (object);
+
+  /* stop the updates */
+  if (overview->timeout_id != 0)
+    g_source_remove (overview->timeout_id);
+
+  g_signal_handlers_disconnect_by_data (overview->buffer, overview);
+  g_signal_handlers_disconnect_by_data (overview->search_context, overview);
+  g_signal_handlers_disconnect_by_data (
+    gtk_source_search_context_get_settings (overview->search_context), overview);
+  if (overview->scrollbar != NULL)
+    {
+      g_signal_handlers_disconnect_by_data (overview->scrollbar, overview);
+      g_object_remove_weak_pointer (G_OBJECT (overview->scrollbar), (gpointer *) &overview->scrollbar);
+    }
+
+  if (overview->window != NULL)
+    g_object_remove_weak_pointer (G_OBJECT (overview->window), (gpointer *) &overview->window);
+
+  /* cleanup */
+  gtk_text_buffer_delete_mark (overview->buffer, overview->dirty_start);
+  gtk_text_buffer_delete_mark (overview->buffer, overview->dirty_end);
+  g_array_unref (overview->line_matches);
+
+  if (overview->regex != NULL)
+    g_regex_unref (overview->regex);
+
+  if (overview->surface != NULL)
+    cairo_surface_destroy (overview->surface);
+
+  /* no scan is running, since it holds a reference on us */
+  g_clear_object (&overview->cancellable);
+
+  /* release the widgets and buffer references */
+  g_object_unref (overview->search_context);
+  g_object_unref (overview->buffer);
+  g_object_unref (overview->view);
+
+  (*G_OBJECT_CLASS (mousepad_overview_parent_class)->finalize) (object);
+}
+
+
+
+static void
+mousepad_overview_redraw (MousepadOverview *overview)
+{
+  if (overview->surface != NULL)
+    {
+      cairo_surface_destroy (overview->surface);
+      overview->surface = NULL;
+    }
+
+  if (overview->scrollbar != NULL)
+    gtk_widget_queue_draw (overview->scrollbar);
+}
+
+
+
+/**
+ * Scanning
+ **/
+static guint
+mousepad_overview_count (GRegex      *regex,
+                         const gchar *text)
+{
+  GMatchInfo *match_info;
+  guint       count = 0;
+
+  g_regex_match (regex, text, 0, &match_info);
+  while (g_match_info_matches (match_info))
+    {
+      count++;
+      g_match_info_next (match_info, NULL);
+    }
+
+  g_match_info_free (match_info);
+
+  return count;
+}
+
+
+
+static void
+mousepad_overview_scan_free (gpointer data)
+{
+  MousepadOverviewScan *scan = data;
+
+  g_free (scan->text);
+  g_regex_unref (scan->regex);
+  g_free (scan);
+}
+
+
+
+static void
+mousepad_overview_scan_thread (GTask        *task,
+                               gpointer      source_object,
+                               gpointer      task_data,
+                               GCancellable *cancellable)
+{
+  MousepadOverviewScan *scan = task_data;
+  GMatchInfo           *match_info;
+  GArray               *line_matches;
+  const gchar          *p, *match, *eol;
+  guint                 line = 0, n = 0;
+  gint                  start;
+
+  line_matches = g_array_sized_new (FALSE, TRUE, sizeof (guint), scan->n_lines);
+  g_array_set_size (line_matches, scan->n_lines);
+
+  /* count the matches on each line, following the newlines up to each match */
+  p = scan->text;
+  g_regex_match (scan->regex, scan->text, 0, &match_info);
+  while (g_match_info_matches (match_info))
+    {
+      g_match_info_fetch_pos (match_info, 0, &start, NULL);
+      for (match = scan->text + start; (eol = memchr (p, '\n', match - p)) != NULL; p = eol + 1)
+        line++;
+
+      p = match;
+      g_array_index (line_matches, guint, MIN (line, scan->n_lines - 1))++;
+
+      /* don't go on with an outdated snapshot */
+      if ((++n & 0xfff) == 0 && g_cancellable_is_cancelled (cancellable))
+        break;
+
+      g_match_info_next (match_info, NULL);
+    }
+
+  g_match_info_free (match_info);
+
+  g_task_return_pointer (task, line_matches, (GDestroyNotify) g_array_unref);
+}
+
+
+
+static void
+mousepad_overview_scan_ready (GObject      *object,
+                              GAsyncResult *result,
+                              gpointer      data)
+{
+  MousepadOverview *overview = MOUSEPAD_OVERVIEW (object);
+  GArray           *line_matches;
+
+  /* a cancelled scan has been superseded already */
+  line_matches = g_task_propagate_pointer (G_TASK (result), NULL);
+  if (line_matches == NULL)
+    return;
+
+  g_array_unref (overview->line_matches);
+  overview->line_matches = line_matches;
+  g_clear_object (&overview->cancellable);
+
+  mousepad_overview_redraw (overview);
+}
+
+
+
+static void
+mousepad_overview_cancel (MousepadOverview *overview)
+{
+  if (overview->cancellable != NULL)
+    {
+      g_cancellable_cancel (overview->cancellable);
+      g_clear_object (&overview->cancellable);
+    }
+}
+
+
+
+static void
+mousepad_overview_scan (MousepadOverview *overview)
+{
+  MousepadOverviewScan *scan;
+  GtkTextIter           start, end;
+  GTask                *task;
+
+  /* start again from a fresh snapshot */
+  mousepad_overview_cancel (overview);
+  overview->rescan = FALSE;
+  overview->dirty = FALSE;
+
+  scan = g_new (MousepadOverviewScan, 1);
+  gtk_text_buffer_get_bounds (overview->buffer, &start, &end);
+  scan->text = gtk_text_buffer_get_text (overview->buffer, &start, &end, TRUE);
+  scan->n_lines = gtk_text_buffer_get_line_count (overview->buffer);
+  scan->regex = g_regex_ref (overview->regex);
+
+  overview->cancellable = g_cancellable_new ();
+  task = g_task_new (overview, overview->cancellable, mousepad_overview_scan_ready, NULL);
+  g_task_set_task_data (task, scan, mousepad_overview_scan_free);
+  g_task_run_in_thread (task, mousepad_overview_scan_thread);
+  g_object_unref (task);
+}
+
+
+
+static gboolean
+mousepad_overview_scan_lines (MousepadOverview *overview,
+                              gint              first,
+                              gint              last)
+{
+  GtkTextIter  start, end;
+  gboolean     changed = FALSE;
+  gchar       *text;
+  guint        count;
+  gint         line;
+
+  for (line = first; line <= last; line++)
+    {
+      gtk_text_buffer_get_iter_at_line (overview->buffer, &start, line);
+      end = start;
+      if (! gtk_text_iter_ends_line (&end))
+        gtk_text_iter_forward_to_line_end (&end);
+
+      text = gtk_text_buffer_get_text (overview->buffer, &start, &end, TRUE);
+      count = mousepad_overview_count (overview->regex, text);
+      g_free (text);
+
+      if (count != g_array_index (overview->line_matches, guint, line))
+        {
+          g_array_index (overview->line_matches, guint, line) = count;
+          changed = TRUE;
+        }
+    }
+
+  return changed;
+}
+
+
+
+static void
+mousepad_overview_clear (MousepadOverview *overview)
+{
+  if (overview->regex == NULL)
+    return;
+
+  mousepad_overview_cancel (overview);
+  g_regex_unref (overview->regex);
+  overview->regex = NULL;
+  overview->rescan = FALSE;
+  overview->dirty = FALSE;
+  g_array_set_size (overview->line_matches, 0);
+
+  if (overview->window != NULL)
+    gtk_scrolled_window_set_overlay_scrolling (overview->window, overview->overlay_scrolling);
+  mousepad_overview_redraw (overview);
+}
+
+
+
+static gboolean
+mousepad_overview_update (gpointer data)
+{
+  MousepadOverview        *overview = MOUSEPAD_OVERVIEW (data);
+  GtkSourceSearchSettings *settings;
+  MousepadSearchFlags      flags = 0;
+  GtkTextIter              iter;
+  const gchar             *text;
+  GRegex                  *regex = NULL;
+  gint                     first, last;
+
+  /* the markers go along with the occurrences highlighting */
+  settings = gtk_source_search_context_get_settings (overview->search_context);
+  text = gtk_source_search_settings_get_search_text (settings);
+  if (text != NULL && gtk_source_search_context_get_highlight (overview->search_context))
+    {
+      if (gtk_source_search_settings_get_case_sensitive (settings))
+        flags |= MOUSEPAD_SEARCH_FLAGS_MATCH_CASE;
+      if (gtk_source_search_settings_get_regex_enabled (settings))
+        flags |= MOUSEPAD_SEARCH_FLAGS_ENABLE_REGEX;
+      if (gtk_source_search_settings_get_at_word_boundaries (settings))
+        flags |= MOUSEPAD_SEARCH_FLAGS_WHOLE_WORD;
+
+      regex = mousepad_util_search_get_regex (text, flags, NULL);
+    }
+
+  if (regex == NULL)
+    {
+      mousepad_overview_clear (overview);
+      return FALSE;
+    }
+
+  /* a new pattern is searched in the whole buffer */
+  if (overview->regex == NULL)
+    {
+      if (overview->window != NULL)
+        {
+          overview->overlay_scrolling = gtk_scrolled_window_get_overlay_scrolling (overview->window);
+          gtk_scrolled_window_set_overlay_scrolling (overview->window, FALSE);
+        }
+    }
+  else if (strcmp (g_regex_get_pattern (regex), g_regex_get_pattern (overview->regex)) == 0
+           && g_regex_get_compile_flags (regex) == g_regex_get_compile_flags (overview->regex))
+    {
+      g_regex_unref (regex);
+      regex = NULL;
+    }
+
+  if (regex != NULL)
+    {
+      if (overview->regex != NULL)
+        g_regex_unref (overview->regex);
+
+      overview->regex = regex;
+      overview->rescan = TRUE;
+    }
+
+  /* rescan the edited lines, or everything when there are too many of them */
+  if (overview->dirty && ! overview->rescan)
+    {
+      gtk_text_buffer_get_iter_at_mark (overview->buffer, &iter, overview->dirty_start);
+      first = gtk_text_iter_get_line (&iter);
+      gtk_text_buffer_get_iter_at_mark (overview->buffer, &iter, overview->dirty_end);
+      last = gtk_text_iter_get_line (&iter);
+
+      if (last - first >= MOUSEPAD_OVERVIEW_MAX_DIRTY
+          || overview->line_matches->len != (guint) gtk_text_buffer_get_line_count (overview->buffer))
+        overview->rescan = TRUE;
+      else
+        {
+          overview->dirty = FALSE;
+          if (mousepad_overview_scan_lines (overview, first, last))
+            mousepad_overview_redraw (overview);
+        }
+    }
+
+  if (overview->rescan)
+    mousepad_overview_scan (overview);
+
+  return FALSE;
+}
+
+
+
+static void
+mousepad_overview_update_destroy (gpointer data)
+{
+  MOUSEPAD_OVERVIEW (data)->timeout_id = 0;
+}
+
+
+
+static void
+mousepad_overview_schedule (MousepadOverview *overview)
+{
+  /* wait for the changes to settle */
+  if (overview->timeout_id != 0)
+    g_source_remove (overview->timeout_id);
+
+  overview->timeout_id = g_timeout_add_full (G_PRIORITY_LOW, MOUSEPAD_OVERVIEW_DELAY,
+                                             mousepad_overview_update, overview,
+                                             mousepad_overview_update_destroy);
+}
+
+
+
+/**
+ * Buffer changes
+ **/
+static void
+mousepad_overview_invalidate (MousepadOverview  *overview,
+                              const GtkTextIter *start,
+                              const GtkTextIter *end)
+{
+  GtkTextIter iter;
+
+  /* extend the edited range */
+  if (overview->dirty)
+    {
+      gtk_text_buffer_get_iter_at_mark (overview->buffer, &iter, overview->dirty_start);
+      if (gtk_text_iter_compare (start, &iter) < 0)
+        gtk_text_buffer_move_mark (overview->buffer, overview->dirty_start, start);
+
+      gtk_text_buffer_get_iter_at_mark (overview->buffer, &iter, overview->dirty_end);
+      if (gtk_text_iter_compare (end, &iter) > 0)
+        gtk_text_buffer_move_mark (overview->buffer, overview->dirty_end, end);
+    }
+  else
+    {
+      gtk_text_buffer_move_mark (overview->buffer, overview->dirty_start, start);
+      gtk_text_buffer_move_mark (overview->buffer, overview->dirty_end, end);
+      overview->dirty = TRUE;
+    }
+
+  mousepad_overview_schedule (overview);
+}
+
+
+
+static void
+mousepad_overview_insert_text (GtkTextBuffer    *buffer,
+                               GtkTextIter      *location,
+                               gchar            *text,
+                               gint              len,
+                               MousepadOverview *overview)
+{
+  GtkTextIter  start;
+  const gchar *p, *end = text + len;
+  guint        n_lines = 0, line, n;
+
+  if (overview->regex == NULL)
+    return;
+
+  /* line numbers are meaningless for a running scan, which has to start again */
+  if (overview->cancellable != NULL || overview->rescan)
+    {
+      overview->rescan = TRUE;
+      mousepad_overview_schedule (overview);
+      return;
+    }
+
+  /* the location was moved to the end of the inserted text */
+  start = *location;
+  gtk_text_iter_backward_chars (&start, g_utf8_strlen (text, len));
+
+  /* insert an empty entry for each new line */
+  for (p = text; (p = memchr (p, '\n', end - p)) != NULL; p++)
+    n_lines++;
+
+  n = overview->line_matches->len;
+  line = gtk_text_iter_get_line (&start) + 1;
+  if (n_lines > 0 && line <= n)
+    {
+      g_array_set_size (overview->line_matches, n + n_lines);
+      memmove (&g_array_index (overview->line_matches, guint, line + n_lines),
+               &g_array_index (overview->line_matches, guint, line),
+               (n - line) * sizeof (guint));
+      memset (&g_array_index (overview->line_matches, guint, line), 0, n_lines * sizeof (guint));
+    }
+
+  mousepad_overview_invalidate (overview, &start, location);
+}
+
+
+
+static void
+mousepad_overview_delete_range (GtkTextBuffer    *buffer,
+                                GtkTextIter      *start,
+                                GtkTextIter      *end,
+                                MousepadOverview *overview)
+{
+  guint first, last;
+
+  if (overview->regex == NULL)
+    return;
+
+  /* line numbers are meaningless for a running scan, which has to start again */
+  if (overview->cancellable != NULL || overview->rescan)
+    {
+      overview->rescan = TRUE;
+      mousepad_overview_schedule (overview);
+      return;
+    }
+
+  /* remove the entries of the joined lines, before the deletion */
+  first = gtk_text_iter_get_line (start);
+  last = gtk_text_iter_get_line (end);
+  if (last > first && last < overview->line_matches->len)
+    g_array_remove_range (overview->line_matches, first + 1, last - first);
+
+  mousepad_overview_invalidate (overview, start, start);
+}
+
+
+
+/**
+ * Rendering and jumping
+ **/
+static gboolean
+mousepad_overview_draw (GtkWidget        *scrollbar,
+                        cairo_t          *cr,
+                        MousepadOverview *overview)
+{
+  cairo_t *surface_cr;
+  guint   *buckets;
+  guint    n_lines, n_buckets, max = 0, line, bucket;
+  gint     width, height;
+
+  n_lines = overview->line_matches->len;
+  if (overview->regex == NULL || n_lines == 0)
+    return FALSE;
+
+  width = gtk_widget_get_allocated_width (scrollbar);
+  height = gtk_widget_get_allocated_height (scrollbar);
+  n_buckets = height / MOUSEPAD_OVERVIEW_BUCKET_HEIGHT;
+  if (n_buckets == 0)
+    return FALSE;
+
+  /* render the markers only when they changed, not at each scroll */
+  if (overview->surface == NULL || overview->surface_width != width
+      || overview->surface_height != height)
+    {
+      if (overview->surface != NULL)
+        cairo_surface_destroy (overview->surface);
+
+      overview->surface = gdk_window_create_similar_surface (gtk_widget_get_window (scrollbar),
+                                                             CAIRO_CONTENT_COLOR_ALPHA,
+                                                             width, height);
+      overview->surface_width = width;
+      overview->surface_height = height;
+
+      /* gather the lines into buckets of the strip height */
+      buckets = g_new0 (guint, n_buckets);
+      for (line = 0; line < n_lines; line++)
+        {
+          bucket = (guint64) line * n_buckets / n_lines;
+          buckets[bucket] += g_array_index (overview->line_matches, guint, line);
+          max = MAX (max, buckets[bucket]);
+        }
+
+      /* the more matches, the more opaque the marker */
+      surface_cr = cairo_create (overview->surface);
+      for (bucket = 0; bucket < n_buckets; bucket++)
+        if (buckets[bucket] > 0)
+          {
+            cairo_set_source_rgba (surface_cr, 0.9, 0.5, 0.0, 0.4 + 0.6 * buckets[bucket] / max);
+            cairo_rectangle (surface_cr, 1, bucket * MOUSEPAD_OVERVIEW_BUCKET_HEIGHT,
+                             width - 2, MOUSEPAD_OVERVIEW_BUCKET_HEIGHT - 1);
+            cairo_fill (surface_cr);
+          }
+
+      cairo_destroy (surface_cr);
+      g_free (buckets);
+    }
+
+  cairo_set_source_surface (cr, overview->surface, 0, 0);
+  cairo_paint (cr);
+
+  return FALSE;
+}
+
+
+
+static gboolean
+mousepad_overview_button_press (GtkWidget        *scrollbar,
+                                GdkEventButton   *event,
+                                MousepadOverview *overview)
+{
+  GtkTextIter iter, start, end;
+  guint64     n_lines, n_buckets, bucket, line, last;
+  gint        slider_start, slider_end;
+
+  n_lines = overview->line_matches->len;
+  if (overview->regex == NULL || n_lines == 0 || overview->cancellable != NULL
+      || event->type != GDK_BUTTON_PRESS || event->button != 1)
+    return FALSE;
+
+  /* leave the slider alone */
+  gtk_range_get_slider_range (GTK_RANGE (scrollbar), &slider_start, &slider_end);
+  if (event->y >= slider_start && event->y < slider_end)
+    return FALSE;
+
+  n_buckets = gtk_widget_get_allocated_height (scrollbar) / MOUSEPAD_OVERVIEW_BUCKET_HEIGHT;
+  bucket = event->y / MOUSEPAD_OVERVIEW_BUCKET_HEIGHT;
+  if (bucket >= n_buckets)
+    return FALSE;
+
+  /* find the first line of the bucket with a match, as rendered */
+  line = (bucket * n_lines + n_buckets - 1) / n_buckets;
+  last = ((bucket + 1) * n_lines + n_buckets - 1) / n_buckets;
+  while (line < last && g_array_index (overview->line_matches, guint, line) == 0)
+    line++;
+
+  /* nothing there, let the scrollbar work as usual */
+  if (line >= last)
+    return FALSE;
+
+  /* select the first match from this line */
+  gtk_text_buffer_get_iter_at_line (overview->buffer, &iter, line);
+  if (gtk_source_search_context_forward2 (overview->search_context, &iter, &start, &end, NULL))
+    gtk_text_buffer_select_range (overview->buffer, &start, &end);
+  else
+    gtk_text_buffer_place_cursor (overview->buffer, &iter);
+
+  gtk_text_view_scroll_to_mark (overview->view, gtk_text_buffer_get_insert (overview->buffer),
+                                0.0, TRUE, 0.0, 0.5);
+
+  return TRUE;
+}
+
+
+
+/**
+ * Public functions
+ **/
+MousepadOverview *
+mousepad_overview_new (GtkScrolledWindow      *window,
+                       GtkTextView            *view,
+                       GtkSourceSearchContext *search_context)
+{
+  MousepadOverview *overview;
+  GtkTextIter       start;
+
+  g_return_val_if_fail (GTK_IS_SCROLLED_WINDOW (window), NULL);
+  g_return_val_if_fail (GTK_IS_TEXT_VIEW (view), NULL);
+  g_return_val_if_fail (GTK_SOURCE_IS_SEARCH_CONTEXT (search_context), NULL);
+
+  overview = g_object_new (MOUSEPAD_TYPE_OVERVIEW, NULL);
+  overview->window = window;
+  overview->scrollbar = gtk_scrolled_window_get_vscrollbar (window);
+  g_object_add_weak_pointer (G_OBJECT (overview->window), (gpointer *) &overview->window);
+  g_object_add_weak_pointer (G_OBJECT (overview->scrollbar), (gpointer *) &overview->scrollbar);
+  overview->view = g_object_ref (view);
+  overview->buffer = g_object_ref (gtk_text_view_get_buffer (view));
+  overview->search_context = g_object_ref (search_context);
+  overview->overlay_scrolling = gtk_scrolled_window_get_overlay_scrolling (window);
+
+  /* text inserted at the edges of the edited range belongs to it */
+  gtk_text_buffer_get_start_iter (overview->buffer, &start);
+  overview->dirty_start = gtk_text_buffer_create_mark (overview->buffer, NULL, &start, TRUE);
+  overview->dirty_end = gtk_text_buffer_create_mark (overview->buffer, NULL, &start, FALSE);
+
+  /* follow the pattern and its highlighting */
+  g_signal_connect_swapped (gtk_source_search_context_get_settings (search_context), "notify",
+                            G_CALLBACK (mousepad_overview_schedule), overview);
+  g_signal_connect_swapped (search_context, "notify::highlight",
+                            G_CALLBACK (mousepad_overview_schedule), overview);
+
+  /* follow the buffer: the line numbers are needed before a deletion, after an insertion */
+  g_signal_connect_after (overview->buffer, "insert-text",
+                          G_CALLBACK (mousepad_overview_insert_text), overview);
+  g_signal_connect (overview->buffer, "delete-range",
+                    G_CALLBACK (mousepad_overview_delete_range), overview);
+
+  /* draw over the scrollbar, and jump to the markers */
+  g_signal_connect_after (overview->scrollbar, "draw",
+                          G_CALLBACK (mousepad_overview_draw), overview);
+  g_signal_connect (overview->scrollbar, "button-press-event",
+                    G_CALLBACK (mousepad_overview_button_press), overview);
+
+  return overview;
+}
@@ -473,6 +473,14 @@ mousepad_replace_dialog_response (GtkWidget *widget,
   g_signal_emit (G_OBJECT (dialog), dialog_signals[SEARCH], 0,
                  flags, search_str, replace_str, &matches);
 
+  /* the pattern was aborted before it could freeze the application */
+  if (G_UNLIKELY (matches == MOUSEPAD_SEARCH_TOO_EXPENSIVE))
+    {
+      mousepad_util_entry_error (dialog->search_entry, TRUE);
+      gtk_label_set_text (GTK_LABEL (dialog->hits_label), _("Pattern too expensive"));
+      return;
+    }
+
   /* reset counter */
   if (response_id == MOUSEPAD_RESPONSE_REPLACE && replace_all)
     matches = 0;
@@ -46,6 +46,11 @@ static void      mousepad_search_bar_match_case_toggled         (GtkWidget
                                                                  MousepadSearchBar       *bar);
 static void      mousepad_search_bar_enable_regex_toggled       (GtkWidget               *button,
                                                                  MousepadSearchBar       *bar);
+static void      mousepad_search_bar_terms_changed              (MousepadSearchBar       *bar);
+static void      mousepad_search_bar_term_toggle                (MousepadSearchBar       *bar);
+static void      mousepad_search_bar_term_remove                (GtkWidget               *menuitem,
+                                                                 MousepadSearchBar       *bar);
+static void      mousepad_search_bar_terms_clear                (MousepadSearchBar       *bar);
 
 
 
@@ -53,6 +58,7 @@ enum
 {
   HIDE_BAR,
   SEARCH,
+  TERMS_CHANGED,
   LAST_SIGNAL
 };
 
@@ -72,6 +78,10 @@ struct _MousepadSearchBar
   GtkWidget           *match_case_entry;
   GtkWidget           *enable_regex_entry;
 
+  /* terms highlighted all at once, and the menu to manage them */
+  gchar              **terms;
+  GtkWidget           *terms_menu;
+
   /* flags */
   guint                highlight_all : 1;
   guint                match_case : 1;
@@ -128,6 +138,14 @@ mousepad_search_bar_class_init (MousepadSearchBarClass *klass)
                   MOUSEPAD_TYPE_SEARCH_FLAGS,
                   G_TYPE_STRING, G_TYPE_STRING);
 
+  search_bar_signals[TERMS_CHANGED] =
+    g_signal_new (I_("terms-changed"),
+                  G_TYPE_FROM_CLASS (gobject_class),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL,
+                  g_cclosure_marshal_VOID__BOXED,
+                  G_TYPE_NONE, 1, G_TYPE_STRV);
+
   /* setup key bindings for the search bar */
   binding_set = gtk_binding_set_by_class (klass);
   gtk_binding_entry_add_signal (binding_set, GDK_KEY_Escape, 0, "hide-bar", 0);
@@ -188,6 +206,7 @@ mousepad_search_bar_init (MousepadSearchBar *bar)
   bar->match_case = MOUSEPAD_SETTING_GET_BOOLEAN (SEARCH_MATCH_CASE);
   bar->enable_regex = MOUSEPAD_SETTING_GET_BOOLEAN (SEARCH_ENABLE_REGEX);
   bar->highlight_all = MOUSEPAD_SETTING_GET_BOOLEAN (SEARCH_HIGHLIGHT_ALL);
+  bar->terms = g_new0 (gchar *, 1);
 
   /* the close button */
   image = gtk_image_new_from_icon_name ("window-close", GTK_ICON_SIZE_BUTTON);
@@ -265,6 +284,27 @@ mousepad_search_bar_init (MousepadSearchBar *bar)
 
   MOUSEPAD_SETTING_BIND (SEARCH_HIGHLIGHT_ALL, item, "active", G_SETTINGS_BIND_DEFAULT);
 
+  /* highlighted terms: the button adds or removes the entry text, the menu lists them */
+  image = gtk_image_new_from_icon_name ("list-add", TOOL_BAR_ICON_SIZE);
+  gtk_widget_show (image);
+
+  bar->terms_menu = gtk_menu_new ();
+  item = gtk_menu_tool_button_new (image, _("_Terms"));
+  gtk_menu_tool_button_set_menu (GTK_MENU_TOOL_BUTTON (item), bar->terms_menu);
+  gtk_widget_set_tooltip_text (GTK_WIDGET (item),
+                               _("Add the search text to the highlighted terms, or remove it"));
+  gtk_menu_tool_button_set_arrow_tooltip_text (GTK_MENU_TOOL_BUTTON (item),
+                                               _("Highlighted terms"));
+  gtk_tool_item_set_is_important (item, TRUE);
+  gtk_tool_button_set_use_underline (GTK_TOOL_BUTTON (item), TRUE);
+  gtk_toolbar_insert (GTK_TOOLBAR (bar), item, -1);
+  g_signal_connect_swapped (G_OBJECT (item), "clicked",
+                            G_CALLBACK (mousepad_search_bar_term_toggle), bar);
+  gtk_widget_show (GTK_WIDGET (item));
+
+  /* fill the menu */
+  mousepad_search_bar_terms_changed (bar);
+
   /* check button for case sensitive, including the proxy menu item */
   item = gtk_tool_item_new ();
   g_signal_connect_object (G_OBJECT (bar), "destroy",
@@ -331,6 +371,11 @@ mousepad_search_bar_init (MousepadSearchBar *bar)
 static void
 mousepad_search_bar_finalize (GObject *object)
 {
+  MousepadSearchBar *bar = MOUSEPAD_SEARCH_BAR (object);
+
+  /* cleanup */
+  g_strfreev (bar->terms);
+
   (*G_OBJECT_CLASS (mousepad_search_bar_parent_class)->finalize) (object);
 }
 
@@ -371,6 +416,10 @@ mousepad_search_bar_find_string (MousepadSearchBar   *bar,
 
       /* change the entry style */
       mousepad_util_entry_error (bar->entry, nmatches < 1);
+
+      /* tell why there is no match when the pattern was aborted */
+      gtk_widget_set_tooltip_text (bar->entry, nmatches == MOUSEPAD_SEARCH_TOO_EXPENSIVE
+                                               ? _("Pattern too expensive") : NULL);
     }
 }
 
@@ -458,6 +507,10 @@ mousepad_search_bar_match_case_toggled (GtkWidget         *button,
 
   /* search ahead with this new flags */
   mousepad_search_bar_entry_changed (NULL, bar);
+
+  /* the highlighted terms follow this flag too */
+  if (*bar->terms != NULL)
+    g_signal_emit (G_OBJECT (bar), search_bar_signals[TERMS_CHANGED], 0, bar->terms);
 }
 
 
@@ -482,6 +535,138 @@ mousepad_search_bar_enable_regex_toggled (GtkWidget         *button,
 
 
 
+static void
+mousepad_search_bar_terms_changed (MousepadSearchBar *bar)
+{
+  GtkWidget  *menuitem;
+  gchar     **term;
+
+  /* rebuild the menu */
+  mousepad_util_container_clear (GTK_CONTAINER (bar->terms_menu));
+
+  for (term = bar->terms; *term != NULL; term++)
+    {
+      menuitem = gtk_menu_item_new_with_label (*term);
+      gtk_widget_set_tooltip_text (menuitem, _("Stop highlighting this term"));
+      gtk_menu_shell_append (GTK_MENU_SHELL (bar->terms_menu), menuitem);
+      g_signal_connect (G_OBJECT (menuitem), "activate",
+                        G_CALLBACK (mousepad_search_bar_term_remove), bar);
+      gtk_widget_show (menuitem);
+    }
+
+  if (term == bar->terms)
+    {
+      menuitem = gtk_menu_item_new_with_label (_("No highlighted terms"));
+      gtk_widget_set_sensitive (menuitem, FALSE);
+      gtk_menu_shell_append (GTK_MENU_SHELL (bar->terms_menu), menuitem);
+      gtk_widget_show (menuitem);
+    }
+  else
+    {
+      menuitem = gtk_separator_menu_item_new ();
+      gtk_menu_shell_append (GTK_MENU_SHELL (bar->terms_menu), menuitem);
+      gtk_widget_show (menuitem);
+
+      menuitem = gtk_menu_item_new_with_mnemonic (_("_Clear All Terms"));
+      gtk_menu_shell_append (GTK_MENU_SHELL (bar->terms_menu), menuitem);
+      g_signal_connect_swapped (G_OBJECT (menuitem), "activate",
+                                G_CALLBACK (mousepad_search_bar_terms_clear), bar);
+      gtk_widget_show (menuitem);
+    }
+}
+
+
+
+static void
+mousepad_search_bar_terms_set (MousepadSearchBar  *bar,
+                               gchar             **terms)
+{
+  g_strfreev (bar->terms);
+  bar->terms = terms;
+
+  /* update the menu and the documents */
+  mousepad_search_bar_terms_changed (bar);
+  g_signal_emit (G_OBJECT (bar), search_bar_signals[TERMS_CHANGED], 0, bar->terms);
+}
+
+
+
+static void
+mousepad_search_bar_terms_remove (MousepadSearchBar *bar,
+                                  const gchar       *text)
+{
+  GPtrArray  *terms;
+  gchar     **term;
+
+  terms = g_ptr_array_new ();
+  for (term = bar->terms; *term != NULL; term++)
+    if (g_strcmp0 (*term, text) != 0)
+      g_ptr_array_add (terms, g_strdup (*term));
+
+  g_ptr_array_add (terms, NULL);
+  mousepad_search_bar_terms_set (bar, (gchar **) g_ptr_array_free (terms, FALSE));
+}
+
+
+
+static void
+mousepad_search_bar_term_toggle (MousepadSearchBar *bar)
+{
+  const gchar  *text;
+  gchar       **terms;
+  guint         n_terms;
+
+  g_return_if_fail (MOUSEPAD_IS_SEARCH_BAR (bar));
+
+  /* the entry text is a single line, but may be empty */
+  text = gtk_entry_get_text (GTK_ENTRY (bar->entry));
+  if (*text == '\0')
+    return;
+
+  /* remove the term when already there, append it otherwise */
+  for (n_terms = 0; bar->terms[n_terms] != NULL; n_terms++)
+    if (strcmp (bar->terms[n_terms], text) == 0)
+      break;
+
+  if (bar->terms[n_terms] != NULL)
+    mousepad_search_bar_terms_remove (bar, text);
+  else
+    {
+      terms = g_renew (gchar *, g_strdupv (bar->terms), n_terms + 2);
+      terms[n_terms] = g_strdup (text);
+      terms[n_terms + 1] = NULL;
+      mousepad_search_bar_terms_set (bar, terms);
+    }
+}
+
+
+
+static void
+mousepad_search_bar_term_remove (GtkWidget         *menuitem,
+                                 MousepadSearchBar *bar)
+{
+  gchar *text;
+
+  g_return_if_fail (MOUSEPAD_IS_SEARCH_BAR (bar));
+
+  /* the menu item is destroyed with the menu rebuild */
+  text = g_strdup (gtk_menu_item_get_label (GTK_MENU_ITEM (menuitem)));
+  mousepad_search_bar_terms_remove (bar, text);
+  g_free (text);
+}
+
+
+
+static void
+mousepad_search_bar_terms_clear (MousepadSearchBar *bar)
+{
+  g_return_if_fail (MOUSEPAD_IS_SEARCH_BAR (bar));
+
+  mousepad_search_bar_terms_set (bar, g_new0 (gchar *, 1));
+}
+
+
+
 GtkEditable *
 mousepad_search_bar_entry (MousepadSearchBar *bar)
 {
@@ -40,6 +40,12 @@ G_BEGIN_DECLS
 #define MOUSEPAD_SETTING_WORD_WRAP                    "/preferences/view/word-wrap"
 #define MOUSEPAD_SETTING_MATCH_BRACES                 "/preferences/view/match-braces"
 #define MOUSEPAD_SETTING_COLOR_SCHEME                 "/preferences/view/color-scheme"
+#define MOUSEPAD_SETTING_STRIP_ON_SAVE                "/preferences/view/strip-trailing-spaces-on-save"
+#define MOUSEPAD_SETTING_UNDO_MEMORY_LIMIT            "/preferences/view/undo-memory-limit"
+#define MOUSEPAD_SETTING_SPLIT_LONG_LINES             "/preferences/view/split-long-lines"
+#define MOUSEPAD_SETTING_WORD_COMPLETION              "/preferences/view/word-completion"
+#define MOUSEPAD_SETTING_SHOW_MINIMAP                 "/preferences/view/show-minimap"
+#define MOUSEPAD_SETTING_CODE_FOLDING                 "/preferences/view/code-folding"
 #define MOUSEPAD_SETTING_TOOLBAR_STYLE                "/preferences/window/toolbar-style"
 #define MOUSEPAD_SETTING_TOOLBAR_ICON_SIZE            "/preferences/window/toolbar-icon-size"
 #define MOUSEPAD_SETTING_ALWAYS_SHOW_TABS             "/preferences/window/always-show-tabs"
@@ -53,6 +59,7 @@ G_BEGIN_DECLS
 #define MOUSEPAD_SETTING_MENUBAR_VISIBLE              "/preferences/window/menubar-visible"
 #define MOUSEPAD_SETTING_TOOLBAR_VISIBLE              "/preferences/window/toolbar-visible"
 #define MOUSEPAD_SETTING_STATUSBAR_VISIBLE            "/preferences/window/statusbar-visible"
+#define MOUSEPAD_SETTING_OUTLINE_VISIBLE              "/preferences/window/outline-visible"
 #define MOUSEPAD_SETTING_MENUBAR_VISIBLE_FULLSCREEN   "/preferences/window/menubar-visible-in-fullscreen"
 #define MOUSEPAD_SETTING_TOOLBAR_VISIBLE_FULLSCREEN   "/preferences/window/toolbar-visible-in-fullscreen"
 #define MOUSEPAD_SETTING_STATUSBAR_VISIBLE_FULLSCREEN "/preferences/window/statusbar-visible-in-fullscreen"
@@ -50,6 +50,7 @@ struct _MousepadStatusbar
   guint               overwrite_enabled : 1;
 
   /* extra labels in the statusbar */
+  GtkWidget          *long_lines;
   GtkWidget          *language;
   GtkWidget          *position;
   GtkWidget          *overwrite;
@@ -113,6 +114,21 @@ mousepad_statusbar_init (MousepadStatusbar *statusbar)
   g_object_unref (label);
   g_list_free (frame);
 
+  /* long lines notice, with its separator, hidden unless needed */
+  statusbar->long_lines = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 8);
+  gtk_box_pack_start (GTK_BOX (box), statusbar->long_lines, FALSE, TRUE, 0);
+  gtk_widget_set_tooltip_text (statusbar->long_lines,
+                               _("This document has very long lines: syntax highlighting, "
+                                 "bracket matching and word wrap are disabled"));
+
+  separator = gtk_separator_new (GTK_ORIENTATION_VERTICAL);
+  gtk_box_pack_start (GTK_BOX (statusbar->long_lines), separator, FALSE, FALSE, 0);
+  gtk_widget_show (separator);
+
+  label = gtk_label_new (_("Long Lines"));
+  gtk_box_pack_start (GTK_BOX (statusbar->long_lines), label, FALSE, TRUE, 0);
+  gtk_widget_show (label);
+
   /* separator */
   separator = gtk_separator_new (GTK_ORIENTATION_VERTICAL);
   gtk_box_pack_start (GTK_BOX (box), separator, FALSE, FALSE, 0);
@@ -257,6 +273,17 @@ mousepad_statusbar_set_language (MousepadStatusbar *statusbar,
 
 
 
+void
+mousepad_statusbar_set_long_lines (MousepadStatusbar *statusbar,
+                                   gboolean           long_lines)
+{
+  g_return_if_fail (MOUSEPAD_IS_STATUSBAR (statusbar));
+
+  gtk_widget_set_visible (statusbar->long_lines, long_lines);
+}
+
+
+
 void
 mousepad_statusbar_set_cursor_position (MousepadStatusbar *statusbar,
                                         gint               line,
@@ -46,6 +46,9 @@ void        mousepad_statusbar_set_cursor_position  (MousepadStatusbar *statusba
 void        mousepad_statusbar_set_overwrite        (MousepadStatusbar *statusbar,
                                                      gboolean           overwrite);
 
+void        mousepad_statusbar_set_long_lines       (MousepadStatusbar *statusbar,
+                                                     gboolean           long_lines);
+
 void        mousepad_statusbar_set_language         (MousepadStatusbar *statusbar,
                                                      GtkSourceLanguage *language);
 
@@ -0,0 +1,1173 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <mousepad/mousepad-private.h>
+#include <mousepad/mousepad-settings.h>
+#include <mousepad/mousepad-undo-manager.h>
+
+
+
+/* size of the arena chunks holding the history text, a text larger than a quarter of
+ * it gets a chunk of its own */
+#define MOUSEPAD_UNDO_CHUNK_SIZE 65536
+
+/* both sides of a replacement must be at least this long (in bytes) for the one which
+ * is not in the buffer to be stored as a delta against the other */
+#define MOUSEPAD_UNDO_DELTA_MIN  1024
+
+/* number of typed or erased characters merged into a single action at most */
+#define MOUSEPAD_UNDO_MERGE_MAX  1024
+
+
+
+/* delta operations: add literal bytes, copy bytes from the reference, skip them */
+enum
+{
+  DELTA_ADD,
+  DELTA_COPY,
+  DELTA_SKIP
+};
+
+typedef struct
+{
+  gsize size;
+  gsize used;
+  gsize live;
+  gchar data[1];
+}
+MousepadUndoChunk;
+
+typedef struct
+{
+  /* the text which is not in the buffer, or NULL when it is: the erased text of the
+   * actions which can be undone, the inserted text of those which can be redone */
+  MousepadUndoChunk *chunk;
+  gsize              chunk_offset;
+  gsize              stored;
+
+  /* byte length of the text, and its position and length in chars in the buffer */
+  gsize              bytes;
+  gint               offset;
+  gint               length;
+
+  guint              insert : 1;
+  guint              group_start : 1;
+  guint              delta : 1;
+}
+MousepadUndoAction;
+
+
+
+static void     mousepad_undo_manager_iface_init      (GtkSourceUndoManagerIface *iface);
+static void     mousepad_undo_manager_finalize        (GObject                   *object);
+static gboolean mousepad_undo_manager_can_undo        (GtkSourceUndoManager      *undo_manager);
+static gboolean mousepad_undo_manager_can_redo        (GtkSourceUndoManager      *undo_manager);
+static void     mousepad_undo_manager_undo            (GtkSourceUndoManager      *undo_manager);
+static void     mousepad_undo_manager_redo            (GtkSourceUndoManager      *undo_manager);
+static void     mousepad_undo_manager_begin_not_undoable_action
+                                                      (GtkSourceUndoManager      *undo_manager);
+static void     mousepad_undo_manager_end_not_undoable_action
+                                                      (GtkSourceUndoManager      *undo_manager);
+static void     mousepad_undo_manager_insert_text     (GtkTextBuffer             *buffer,
+                                                       GtkTextIter               *location,
+                                                       const gchar               *text,
+                                                       gint                       len,
+                                                       MousepadUndoManager       *manager);
+static void     mousepad_undo_manager_delete_range    (GtkTextBuffer             *buffer,
+                                                       GtkTextIter               *start,
+                                                       GtkTextIter               *end,
+                                                       MousepadUndoManager       *manager);
+static void     mousepad_undo_manager_begin_user_action
+                                                      (GtkTextBuffer             *buffer,
+                                                       MousepadUndoManager       *manager);
+static void     mousepad_undo_manager_end_user_action (GtkTextBuffer             *buffer,
+                                                       MousepadUndoManager       *manager);
+static void     mousepad_undo_manager_modified_changed
+                                                      (GtkTextBuffer             *buffer,
+                                                       MousepadUndoManager       *manager);
+static void     mousepad_undo_manager_budget_changed  (MousepadUndoManager       *manager,
+                                                       gchar                     *key,
+                                                       GSettings                 *settings);
+
+
+
+struct _MousepadUndoManagerClass
+{
+  GObjectClass __parent__;
+};
+
+struct _MousepadUndoManager
+{
+  GObject            __parent__;
+
+  /* the buffer owns the manager, so it is not referenced */
+  GtkTextBuffer     *buffer;
+
+  /* the actions before the position can be undone, the others redone, and the position
+   * matching the saved buffer, or -1 if it is out of reach */
+  GArray            *actions;
+  guint              position;
+  gint               saved_position;
+
+  /* the arena holding the history text, the chunk being filled and the memory taken
+   * by all the chunks */
+  GPtrArray         *chunks;
+  MousepadUndoChunk *current;
+  gsize              chunk_memory;
+
+  /* the text erased by the last action, kept aside while more may be merged to it */
+  GString           *pending;
+
+  /* memory budget in bytes */
+  gsize              budget;
+
+  /* nesting level of the not undoable actions */
+  gint               not_undoable;
+
+  guint              in_user_action : 1;
+  guint              group_pending : 1;
+  guint              pending_open : 1;
+  guint              mergeable : 1;
+  guint              applying : 1;
+  guint              history_lost : 1;
+  guint              can_undo : 1;
+  guint              can_redo : 1;
+};
+
+
+
+/**
+ * GObject stuff
+ **/
+G_DEFINE_TYPE_WITH_CODE (MousepadUndoManager, mousepad_undo_manager, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (GTK_SOURCE_TYPE_UNDO_MANAGER,
+                                                mousepad_undo_manager_iface_init))
+
+
+
+static void
+mousepad_undo_manager_class_init (MousepadUndoManagerClass *klass)
+{
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = mousepad_undo_manager_finalize;
+}
+
+
+
+static void
+mousepad_undo_manager_iface_init (GtkSourceUndoManagerIface *iface)
+{
+  iface->can_undo = mousepad_undo_manager_can_undo;
+  iface->can_redo = mousepad_undo_manager_can_redo;
+  iface->undo = mousepad_undo_manager_undo;
+  iface->redo = mousepad_undo_manager_redo;
+  iface->begin_not_undoable_action = mousepad_undo_manager_begin_not_undoable_action;
+  iface->end_not_undoable_action = mousepad_undo_manager_end_not_undoable_action;
+}
+
+
+
+static void
+mousepad_undo_manager_init (MousepadUndoManager *manager)
+{
+  manager->buffer = NULL;
+  manager->actions = g_array_new (FALSE, FALSE, sizeof (MousepadUndoAction));
+  manager->position = 0;
+  manager->saved_position = 0;
+  manager->chunks = g_ptr_array_new_with_free_func (g_free);
+  manager->current = NULL;
+  manager->chunk_memory = 0;
+  manager->pending = g_string_new (NULL);
+  manager->budget = G_MAXSIZE;
+  manager->not_undoable = 0;
+  manager->in_user_action = FALSE;
+  manager->group_pending = FALSE;
+  manager->pending_open = FALSE;
+  manager->mergeable = FALSE;
+  manager->applying = FALSE;
+  manager->history_lost = FALSE;
+  manager->can_undo = FALSE;
+  manager->can_redo = FALSE;
+}
+
+
+
+static void
+mousepad_undo_manager_finalize (GObject *object)
+{
+  MousepadUndoManager *manager = MOUSEPAD_UNDO_MANAGER (object);
+
+  /* stop watching the buffer, if it is still alive */
+  if (manager->buffer != NULL)
+    {
+      g_signal_handlers_disconnect_by_data (manager->buffer, manager);
+      g_object_remove_weak_pointer (G_OBJECT (manager->buffer), (gpointer *) &manager->buffer);
+    }
+
+  /* cleanup */
+  g_array_free (manager->actions, TRUE);
+  g_ptr_array_free (manager->chunks, TRUE);
+  g_string_free (manager->pending, TRUE);
+
+  (*G_OBJECT_CLASS (mousepad_undo_manager_parent_class)->finalize) (object);
+}
+
+
+
+/**
+ * Delta compression
+ **/
+static void
+mousepad_undo_delta_put (GString *delta,
+                         guint    op,
+                         gsize    length)
+{
+  gsize  value = (length << 2) | op;
+  guchar byte;
+
+  /* variable length encoding, seven bits at a time */
+  do
+    {
+      byte = value & 0x7f;
+      value >>= 7;
+      g_string_append_c (delta, value != 0 ? byte | 0x80 : byte);
+    }
+  while (value != 0);
+}
+
+
+
+/* encode the text as the reference with some bytes skipped and others added, line by
+ * line: this catches most of the big replacements, which change every line a bit
+ * (indentation, tabs and spaces, trailing spaces, replace all) */
+static GString *
+mousepad_undo_delta_encode (const gchar *text,
+                            gsize        bytes,
+                            const gchar *ref,
+                            gsize        ref_bytes)
+{
+  GString     *delta;
+  const gchar *text_end = text + bytes, *ref_end = ref + ref_bytes;
+  const gchar *text_eol, *ref_eol;
+  gsize        text_length, ref_length, prefix, suffix, copy = 0, skip = 0;
+
+  delta = g_string_sized_new (bytes / 4);
+
+  while (text < text_end)
+    {
+      /* the next line of the text, and of the reference */
+      text_eol = memchr (text, '\n', text_end - text);
+      text_eol = text_eol != NULL ? text_eol + 1 : text_end;
+      ref_eol = ref < ref_end ? memchr (ref, '\n', ref_end - ref) : NULL;
+      ref_eol = ref_eol != NULL ? ref_eol + 1 : ref_end;
+      text_length = text_eol - text;
+      ref_length = ref_eol - ref;
+
+      /* their common prefix and suffix */
+      for (prefix = 0; prefix < text_length && prefix < ref_length; prefix++)
+        if (text[prefix] != ref[prefix])
+          break;
+
+      for (suffix = 0; prefix + suffix < text_length && prefix + suffix < ref_length; suffix++)
+        if (text_eol[-1 - (gssize) suffix] != ref_eol[-1 - (gssize) suffix])
+          break;
+
+      /* copy the prefix, merged with the previous copies */
+      if (prefix > 0)
+        {
+          if (skip > 0)
+            mousepad_undo_delta_put (delta, DELTA_SKIP, skip);
+
+          skip = 0;
+          copy += prefix;
+        }
+
+      /* add the bytes which differ in the text, and skip those of the reference */
+      if (prefix + suffix < text_length)
+        {
+          if (copy > 0)
+            mousepad_undo_delta_put (delta, DELTA_COPY, copy);
+
+          copy = 0;
+          mousepad_undo_delta_put (delta, DELTA_ADD, text_length - prefix - suffix);
+          g_string_append_len (delta, text + prefix, text_length - prefix - suffix);
+        }
+
+      if (prefix + suffix < ref_length)
+        {
+          if (copy > 0)
+            mousepad_undo_delta_put (delta, DELTA_COPY, copy);
+
+          copy = 0;
+          skip += ref_length - prefix - suffix;
+        }
+
+      /* copy the suffix */
+      if (suffix > 0)
+        {
+          if (skip > 0)
+            mousepad_undo_delta_put (delta, DELTA_SKIP, skip);
+
+          skip = 0;
+          copy += suffix;
+        }
+
+      text = text_eol;
+      ref = ref_eol;
+    }
+
+  /* the trailing skip is useless */
+  if (copy > 0)
+    mousepad_undo_delta_put (delta, DELTA_COPY, copy);
+
+  return delta;
+}
+
+
+
+static gchar *
+mousepad_undo_delta_decode (const gchar *delta,
+                            gsize        delta_bytes,
+                            const gchar *ref,
+                            gsize        bytes)
+{
+  const guchar *p = (const guchar *) delta, *end = p + delta_bytes;
+  gchar        *text, *out;
+  gsize         value, length;
+  guint         shift;
+
+  text = out = g_malloc (bytes + 1);
+
+  while (p < end)
+    {
+      for (value = 0, shift = 0; *p & 0x80; p++, shift += 7)
+        value |= (gsize) (*p & 0x7f) << shift;
+
+      value |= (gsize) *p++ << shift;
+      length = value >> 2;
+
+      switch (value & 3)
+        {
+        case DELTA_ADD:
+          memcpy (out, p, length);
+          out += length;
+          p += length;
+          break;
+
+        case DELTA_COPY:
+          memcpy (out, ref, length);
+          out += length;
+          ref += length;
+          break;
+
+        default:
+          ref += length;
+          break;
+        }
+    }
+
+  *out = '\0';
+
+  return text;
+}
+
+
+
+/**
+ * History storage
+ **/
+static MousepadUndoChunk *
+mousepad_undo_manager_chunk_new (MousepadUndoManager *manager,
+                                 gsize                size)
+{
+  MousepadUndoChunk *chunk;
+
+  chunk = g_malloc (G_STRUCT_OFFSET (MousepadUndoChunk, data) + size);
+  chunk->size = size;
+  chunk->used = 0;
+  chunk->live = 0;
+
+  g_ptr_array_add (manager->chunks, chunk);
+  manager->chunk_memory += size;
+
+  return chunk;
+}
+
+
+
+static void
+mousepad_undo_manager_store (MousepadUndoManager *manager,
+                             MousepadUndoAction  *action,
+                             const gchar         *text,
+                             const gchar         *ref,
+                             gsize                ref_bytes)
+{
+  MousepadUndoChunk *chunk = manager->current;
+  GString           *delta = NULL;
+  const gchar       *data = text;
+  gsize              stored = action->bytes;
+
+  /* store the text as a delta against the other side of the replacement if it's worth it */
+  action->delta = FALSE;
+  if (ref != NULL && action->bytes >= MOUSEPAD_UNDO_DELTA_MIN && ref_bytes >= MOUSEPAD_UNDO_DELTA_MIN)
+    {
+      delta = mousepad_undo_delta_encode (text, action->bytes, ref, ref_bytes);
+      if (delta->len < action->bytes)
+        {
+          data = delta->str;
+          stored = delta->len;
+          action->delta = TRUE;
+        }
+    }
+
+  /* append it to the current chunk, or to a chunk of its own if it is large */
+  if (stored > MOUSEPAD_UNDO_CHUNK_SIZE / 4)
+    chunk = mousepad_undo_manager_chunk_new (manager, stored);
+  else if (chunk == NULL || chunk->size - chunk->used < stored)
+    chunk = manager->current = mousepad_undo_manager_chunk_new (manager, MOUSEPAD_UNDO_CHUNK_SIZE);
+
+  memcpy (chunk->data + chunk->used, data, stored);
+  action->chunk = chunk;
+  action->chunk_offset = chunk->used;
+  action->stored = stored;
+  chunk->used += stored;
+  chunk->live += stored;
+
+  if (delta != NULL)
+    g_string_free (delta, TRUE);
+}
+
+
+
+/* returns the stored text of the action, which may point to the arena, so it must be
+ * used before the action is released: to_free is set when it has to be freed */
+static const gchar *
+mousepad_undo_manager_load (MousepadUndoAction  *action,
+                            const gchar         *ref,
+                            gchar              **to_free)
+{
+  const gchar *data = action->chunk->data + action->chunk_offset;
+
+  if (action->delta)
+    return *to_free = mousepad_undo_delta_decode (data, action->stored, ref, action->bytes);
+
+  *to_free = NULL;
+
+  return data;
+}
+
+
+
+static void
+mousepad_undo_manager_release (MousepadUndoManager *manager,
+                               MousepadUndoAction  *action)
+{
+  MousepadUndoChunk *chunk = action->chunk;
+
+  if (chunk == NULL)
+    return;
+
+  action->chunk = NULL;
+  chunk->live -= action->stored;
+
+  /* free the chunk once no more text lives in it, or reuse it if it is the current one */
+  if (chunk->live == 0)
+    {
+      if (chunk == manager->current)
+        chunk->used = 0;
+      else
+        {
+          manager->chunk_memory -= chunk->size;
+          g_ptr_array_remove_fast (manager->chunks, chunk);
+        }
+    }
+}
+
+
+
+/* stores the text erased by the last action, as a delta against the text replacing it
+ * if any */
+static void
+mousepad_undo_manager_close_pending (MousepadUndoManager *manager,
+                                     const gchar         *ref,
+                                     gsize                ref_bytes)
+{
+  MousepadUndoAction *action;
+
+  if (! manager->pending_open)
+    return;
+
+  manager->pending_open = FALSE;
+  action = &g_array_index (manager->actions, MousepadUndoAction, manager->actions->len - 1);
+  mousepad_undo_manager_store (manager, action, manager->pending->str, ref, ref_bytes);
+
+  /* don't keep a large buffer around */
+  if (manager->pending->allocated_len > MOUSEPAD_UNDO_CHUNK_SIZE)
+    {
+      g_string_free (manager->pending, TRUE);
+      manager->pending = g_string_new (NULL);
+    }
+  else
+    g_string_truncate (manager->pending, 0);
+}
+
+
+
+/* drops the actions from the given index on */
+static void
+mousepad_undo_manager_truncate (MousepadUndoManager *manager,
+                                guint                length)
+{
+  guint n;
+
+  if (length >= manager->actions->len)
+    return;
+
+  for (n = length; n < manager->actions->len; n++)
+    mousepad_undo_manager_release (manager, &g_array_index (manager->actions, MousepadUndoAction, n));
+
+  /* the pending text belongs to the last action */
+  manager->pending_open = FALSE;
+  g_string_truncate (manager->pending, 0);
+
+  g_array_set_size (manager->actions, length);
+  manager->position = MIN (manager->position, length);
+  if (manager->saved_position > (gint) length)
+    manager->saved_position = -1;
+}
+
+
+
+/* drops the given number of actions from the oldest history */
+static void
+mousepad_undo_manager_evict (MousepadUndoManager *manager,
+                             guint                n_actions)
+{
+  guint n;
+  gint  saved_position;
+
+  if (n_actions == 0)
+    return;
+
+  /* the saved position stays in reach if it is not in the dropped history */
+  manager->saved_position = manager->saved_position >= (gint) n_actions
+                            ? manager->saved_position - (gint) n_actions : -1;
+
+  if (n_actions == manager->actions->len)
+    {
+      saved_position = manager->saved_position;
+      mousepad_undo_manager_truncate (manager, 0);
+      manager->saved_position = saved_position;
+      return;
+    }
+
+  for (n = 0; n < n_actions; n++)
+    mousepad_undo_manager_release (manager, &g_array_index (manager->actions, MousepadUndoAction, n));
+
+  g_array_remove_range (manager->actions, 0, n_actions);
+  manager->position -= n_actions;
+}
+
+
+
+static void
+mousepad_undo_manager_clear (MousepadUndoManager *manager)
+{
+  mousepad_undo_manager_truncate (manager, 0);
+
+  /* all the chunks are free now */
+  g_ptr_array_set_size (manager->chunks, 0);
+  manager->current = NULL;
+  manager->chunk_memory = 0;
+
+  manager->saved_position = gtk_text_buffer_get_modified (manager->buffer) ? -1 : 0;
+  manager->mergeable = FALSE;
+}
+
+
+
+static void
+mousepad_undo_manager_enforce_budget (MousepadUndoManager *manager)
+{
+  MousepadUndoAction *action;
+  gsize               memory, target, freed = 0;
+  guint               n, n_actions;
+
+  memory = mousepad_undo_manager_get_memory (manager);
+  if (memory <= manager->budget)
+    return;
+
+  /* evict the oldest groups down to three quarters of the budget, so that it doesn't
+   * happen again at the next change */
+  target = manager->budget / 4 * 3;
+  n_actions = manager->position;
+  for (n = 0; n < manager->position; )
+    {
+      action = &g_array_index (manager->actions, MousepadUndoAction, n++);
+      freed += action->stored + sizeof (MousepadUndoAction);
+      if (n == manager->actions->len)
+        freed += manager->pending->allocated_len;
+
+      if (memory - MIN (freed, memory) <= target
+          && (n == manager->actions->len
+              || g_array_index (manager->actions, MousepadUndoAction, n).group_start))
+        {
+          n_actions = n;
+          break;
+        }
+    }
+
+  mousepad_undo_manager_evict (manager, n_actions);
+
+  /* the redo history goes too if this was not enough */
+  if (mousepad_undo_manager_get_memory (manager) > manager->budget)
+    mousepad_undo_manager_truncate (manager, manager->position);
+}
+
+
+
+static void
+mousepad_undo_manager_update_state (MousepadUndoManager *manager)
+{
+  gboolean can_undo, can_redo;
+
+  can_undo = manager->position > 0;
+  can_redo = manager->position < manager->actions->len;
+
+  if (manager->can_undo != can_undo)
+    {
+      manager->can_undo = can_undo;
+      gtk_source_undo_manager_can_undo_changed (GTK_SOURCE_UNDO_MANAGER (manager));
+    }
+
+  if (manager->can_redo != can_redo)
+    {
+      manager->can_redo = can_redo;
+      gtk_source_undo_manager_can_redo_changed (GTK_SOURCE_UNDO_MANAGER (manager));
+    }
+}
+
+
+
+/**
+ * Recording
+ **/
+static gboolean
+mousepad_undo_manager_start_group (MousepadUndoManager *manager)
+{
+  gboolean start = manager->group_pending || ! manager->in_user_action;
+
+  manager->group_pending = FALSE;
+
+  return start;
+}
+
+
+
+/* whether a single character typed or erased at the start of a user action may be
+ * merged into the last action */
+static gboolean
+mousepad_undo_manager_can_merge (MousepadUndoManager *manager,
+                                 MousepadUndoAction  *last,
+                                 const gchar         *text,
+                                 gint                 length,
+                                 gboolean             insert)
+{
+  return manager->mergeable && manager->in_user_action && manager->group_pending
+         && last != NULL && last->group_start && last->insert == insert
+         && manager->saved_position != (gint) manager->actions->len
+         && last->length < MOUSEPAD_UNDO_MERGE_MAX
+         && length == 1 && *text != '\n' && *text != '\r';
+}
+
+
+
+static void
+mousepad_undo_manager_insert_text (GtkTextBuffer       *buffer,
+                                   GtkTextIter         *location,
+                                   const gchar         *text,
+                                   gint                 len,
+                                   MousepadUndoManager *manager)
+{
+  MousepadUndoAction *last = NULL, action;
+  GtkTextIter         iter;
+  gint                offset, length;
+
+  if (manager->applying)
+    return;
+
+  /* the history can't follow changes it doesn't record */
+  if (manager->not_undoable > 0)
+    {
+      manager->history_lost = TRUE;
+      return;
+    }
+
+  offset = gtk_text_iter_get_offset (location);
+  length = g_utf8_strlen (text, len);
+  if (length == 0)
+    return;
+
+  /* a change drops the redo history */
+  mousepad_undo_manager_truncate (manager, manager->position);
+  if (manager->actions->len > 0)
+    last = &g_array_index (manager->actions, MousepadUndoAction, manager->actions->len - 1);
+
+  /* typing at the end of the last typed word, or at the start of a new one if the previous
+   * character is not a space */
+  if (mousepad_undo_manager_can_merge (manager, last, text, length, TRUE)
+      && last->offset + last->length == offset)
+    {
+      iter = *location;
+      gtk_text_iter_backward_char (&iter);
+      if (g_unichar_isspace (g_utf8_get_char (text)) || ! g_unichar_isspace (gtk_text_iter_get_char (&iter)))
+        {
+          last->length++;
+          last->bytes += len;
+          manager->group_pending = FALSE;
+          return;
+        }
+    }
+
+  /* a new action, which replaces the text erased just before in the same group */
+  action.group_start = mousepad_undo_manager_start_group (manager);
+  mousepad_undo_manager_close_pending (manager, ! action.group_start && last != NULL && ! last->insert
+                                                && last->offset == offset ? text : NULL, len);
+
+  action.chunk = NULL;
+  action.chunk_offset = 0;
+  action.stored = 0;
+  action.bytes = len;
+  action.offset = offset;
+  action.length = length;
+  action.insert = TRUE;
+  action.delta = FALSE;
+  g_array_append_val (manager->actions, action);
+  manager->position = manager->actions->len;
+  manager->mergeable = action.group_start && manager->in_user_action && length == 1
+                       && *text != '\n' && *text != '\r';
+
+  if (! manager->in_user_action)
+    mousepad_undo_manager_enforce_budget (manager);
+
+  mousepad_undo_manager_update_state (manager);
+}
+
+
+
+static void
+mousepad_undo_manager_delete_range (GtkTextBuffer       *buffer,
+                                    GtkTextIter         *start,
+                                    GtkTextIter         *end,
+                                    MousepadUndoManager *manager)
+{
+  MousepadUndoAction *last = NULL, action;
+  gchar              *text;
+  gint                offset, length;
+
+  if (manager->applying)
+    return;
+
+  /* the history can't follow changes it doesn't record */
+  if (manager->not_undoable > 0)
+    {
+      manager->history_lost = TRUE;
+      return;
+    }
+
+  offset = gtk_text_iter_get_offset (start);
+  length = gtk_text_iter_get_offset (end) - offset;
+  if (length == 0)
+    return;
+
+  /* a change drops the redo history */
+  mousepad_undo_manager_truncate (manager, manager->position);
+  if (manager->actions->len > 0)
+    last = &g_array_index (manager->actions, MousepadUndoAction, manager->actions->len - 1);
+
+  text = gtk_text_iter_get_slice (start, end);
+
+  /* erasing on either side of the last erased text */
+  if (mousepad_undo_manager_can_merge (manager, last, text, length, FALSE) && manager->pending_open
+      && (offset + 1 == last->offset || offset == last->offset))
+    {
+      if (offset == last->offset)
+        g_string_append (manager->pending, text);
+      else
+        g_string_prepend (manager->pending, text);
+
+      last->offset = offset;
+      last->length++;
+      last->bytes = manager->pending->len;
+      manager->group_pending = FALSE;
+      g_free (text);
+
+      return;
+    }
+
+  /* a new action, whose text is kept aside until no more can be merged to it */
+  action.group_start = mousepad_undo_manager_start_group (manager);
+  mousepad_undo_manager_close_pending (manager, NULL, 0);
+
+  g_string_append (manager->pending, text);
+  manager->pending_open = TRUE;
+
+  action.chunk = NULL;
+  action.chunk_offset = 0;
+  action.stored = 0;
+  action.bytes = manager->pending->len;
+  action.offset = offset;
+  action.length = length;
+  action.insert = FALSE;
+  action.delta = FALSE;
+  g_array_append_val (manager->actions, action);
+  manager->position = manager->actions->len;
+  manager->mergeable = action.group_start && manager->in_user_action && length == 1
+                       && *text != '\n' && *text != '\r';
+
+  g_free (text);
+
+  if (! manager->in_user_action)
+    mousepad_undo_manager_enforce_budget (manager);
+
+  mousepad_undo_manager_update_state (manager);
+}
+
+
+
+static void
+mousepad_undo_manager_begin_user_action (GtkTextBuffer       *buffer,
+                                         MousepadUndoManager *manager)
+{
+  if (manager->applying)
+    return;
+
+  /* the first change of the user action starts a group */
+  manager->in_user_action = TRUE;
+  manager->group_pending = TRUE;
+}
+
+
+
+static void
+mousepad_undo_manager_end_user_action (GtkTextBuffer       *buffer,
+                                       MousepadUndoManager *manager)
+{
+  if (manager->applying)
+    return;
+
+  manager->in_user_action = FALSE;
+  manager->group_pending = FALSE;
+
+  mousepad_undo_manager_enforce_budget (manager);
+  mousepad_undo_manager_update_state (manager);
+}
+
+
+
+static void
+mousepad_undo_manager_modified_changed (GtkTextBuffer       *buffer,
+                                        MousepadUndoManager *manager)
+{
+  /* remember the position of the saved buffer */
+  if (! manager->applying && ! gtk_text_buffer_get_modified (buffer))
+    manager->saved_position = manager->position;
+}
+
+
+
+static void
+mousepad_undo_manager_budget_changed (MousepadUndoManager *manager,
+                                      gchar               *key,
+                                      GSettings           *settings)
+{
+  /* the setting is in MiB */
+  manager->budget = (gsize) mousepad_setting_get_int (MOUSEPAD_SETTING_UNDO_MEMORY_LIMIT) << 20;
+
+  mousepad_undo_manager_enforce_budget (manager);
+  mousepad_undo_manager_update_state (manager);
+}
+
+
+
+/**
+ * GtkSourceUndoManager
+ **/
+static gboolean
+mousepad_undo_manager_can_undo (GtkSourceUndoManager *undo_manager)
+{
+  return MOUSEPAD_UNDO_MANAGER (undo_manager)->position > 0;
+}
+
+
+
+static gboolean
+mousepad_undo_manager_can_redo (GtkSourceUndoManager *undo_manager)
+{
+  MousepadUndoManager *manager = MOUSEPAD_UNDO_MANAGER (undo_manager);
+
+  return manager->position < manager->actions->len;
+}
+
+
+
+static void
+mousepad_undo_manager_get_range (MousepadUndoManager *manager,
+                                 MousepadUndoAction  *action,
+                                 GtkTextIter         *start,
+                                 GtkTextIter         *end)
+{
+  gtk_text_buffer_get_iter_at_offset (manager->buffer, start, action->offset);
+  *end = *start;
+  gtk_text_iter_forward_chars (end, action->length);
+}
+
+
+
+static void
+mousepad_undo_manager_apply_done (MousepadUndoManager *manager,
+                                  gint                 cursor)
+{
+  GtkTextIter iter;
+
+  gtk_text_buffer_end_user_action (manager->buffer);
+
+  /* place the cursor where the last change was reverted */
+  gtk_text_buffer_get_iter_at_offset (manager->buffer, &iter, cursor);
+  gtk_text_buffer_place_cursor (manager->buffer, &iter);
+
+  /* the buffer is unmodified again at the saved position */
+  gtk_text_buffer_set_modified (manager->buffer, manager->saved_position != (gint) manager->position);
+  manager->applying = FALSE;
+  manager->mergeable = FALSE;
+
+  mousepad_undo_manager_enforce_budget (manager);
+  mousepad_undo_manager_update_state (manager);
+}
+
+
+
+static void
+mousepad_undo_manager_undo (GtkSourceUndoManager *undo_manager)
+{
+  MousepadUndoManager *manager = MOUSEPAD_UNDO_MANAGER (undo_manager);
+  MousepadUndoAction  *action, *erased;
+  GtkTextIter          start, end;
+  const gchar         *old;
+  gchar               *text, *to_free;
+  guint                first, n;
+  gint                 cursor = 0;
+
+  g_return_if_fail (manager->buffer != NULL);
+  g_return_if_fail (manager->position > 0);
+
+  mousepad_undo_manager_close_pending (manager, NULL, 0);
+
+  /* the first action of the last group */
+  for (first = manager->position - 1; first > 0; first--)
+    if (g_array_index (manager->actions, MousepadUndoAction, first).group_start)
+      break;
+
+  manager->applying = TRUE;
+  gtk_text_buffer_begin_user_action (manager->buffer);
+
+  for (n = manager->position; n > first; n--)
+    {
+      action = &g_array_index (manager->actions, MousepadUndoAction, n - 1);
+      mousepad_undo_manager_get_range (manager, action, &start, &end);
+      cursor = action->offset;
+
+      if (action->insert)
+        {
+          /* the inserted text leaves the buffer, so it is kept for redo */
+          text = gtk_text_buffer_get_slice (manager->buffer, &start, &end, TRUE);
+          gtk_text_buffer_delete (manager->buffer, &start, &end);
+
+          /* the text it replaced comes back at once, the one going being stored as a
+           * delta against it */
+          erased = n - 1 > first ? action - 1 : NULL;
+          if (erased != NULL && ! erased->insert && erased->offset == action->offset)
+            {
+              old = mousepad_undo_manager_load (erased, text, &to_free);
+              gtk_text_buffer_insert (manager->buffer, &start, old, erased->bytes);
+              mousepad_undo_manager_store (manager, action, text, old, erased->bytes);
+              mousepad_undo_manager_release (manager, erased);
+              cursor += erased->length;
+              g_free (to_free);
+              n--;
+            }
+          else
+            mousepad_undo_manager_store (manager, action, text, NULL, 0);
+
+          g_free (text);
+        }
+      else
+        {
+          /* the erased text comes back */
+          old = mousepad_undo_manager_load (action, NULL, &to_free);
+          gtk_text_buffer_insert (manager->buffer, &start, old, action->bytes);
+          mousepad_undo_manager_release (manager, action);
+          cursor += action->length;
+          g_free (to_free);
+        }
+    }
+
+  manager->position = first;
+  mousepad_undo_manager_apply_done (manager, cursor);
+}
+
+
+
+static void
+mousepad_undo_manager_redo (GtkSourceUndoManager *undo_manager)
+{
+  MousepadUndoManager *manager = MOUSEPAD_UNDO_MANAGER (undo_manager);
+  MousepadUndoAction  *action, *inserted;
+  GtkTextIter          start, end;
+  const gchar         *new;
+  gchar               *text, *to_free;
+  guint                last, n;
+  gint                 cursor = 0;
+
+  g_return_if_fail (manager->buffer != NULL);
+  g_return_if_fail (manager->position < manager->actions->len);
+
+  /* the end of the next group */
+  for (last = manager->position + 1; last < manager->actions->len; last++)
+    if (g_array_index (manager->actions, MousepadUndoAction, last).group_start)
+      break;
+
+  manager->applying = TRUE;
+  gtk_text_buffer_begin_user_action (manager->buffer);
+
+  for (n = manager->position; n < last; n++)
+    {
+      action = &g_array_index (manager->actions, MousepadUndoAction, n);
+      mousepad_undo_manager_get_range (manager, action, &start, &end);
+      cursor = action->offset;
+
+      if (action->insert)
+        {
+          /* the inserted text comes back */
+          new = mousepad_undo_manager_load (action, NULL, &to_free);
+          gtk_text_buffer_insert (manager->buffer, &start, new, action->bytes);
+          mousepad_undo_manager_release (manager, action);
+          cursor += action->length;
+          g_free (to_free);
+        }
+      else
+        {
+          /* the erased text leaves the buffer, so it is kept for undo */
+          text = gtk_text_buffer_get_slice (manager->buffer, &start, &end, TRUE);
+          gtk_text_buffer_delete (manager->buffer, &start, &end);
+
+          /* the text replacing it comes in at once, the one going being stored as a
+           * delta against it */
+          inserted = n + 1 < last ? action + 1 : NULL;
+          if (inserted != NULL && inserted->insert && inserted->offset == action->offset)
+            {
+              new = mousepad_undo_manager_load (inserted, text, &to_free);
+              gtk_text_buffer_insert (manager->buffer, &start, new, inserted->bytes);
+              mousepad_undo_manager_store (manager, action, text, new, inserted->bytes);
+              mousepad_undo_manager_release (manager, inserted);
+              cursor += inserted->length;
+              g_free (to_free);
+              n++;
+            }
+          else
+            mousepad_undo_manager_store (manager, action, text, NULL, 0);
+
+          g_free (text);
+        }
+    }
+
+  manager->position = last;
+  mousepad_undo_manager_apply_done (manager, cursor);
+}
+
+
+
+static void
+mousepad_undo_manager_begin_not_undoable_action (GtkSourceUndoManager *undo_manager)
+{
+  MousepadUndoManager *manager = MOUSEPAD_UNDO_MANAGER (undo_manager);
+
+  mousepad_undo_manager_close_pending (manager, NULL, 0);
+  manager->not_undoable++;
+}
+
+
+
+static void
+mousepad_undo_manager_end_not_undoable_action (GtkSourceUndoManager *undo_manager)
+{
+  MousepadUndoManager *manager = MOUSEPAD_UNDO_MANAGER (undo_manager);
+
+  g_return_if_fail (manager->not_undoable > 0);
+
+  /* the history doesn't match the buffer anymore if it was changed meanwhile */
+  if (--manager->not_undoable == 0 && manager->history_lost)
+    {
+      manager->history_lost = FALSE;
+      mousepad_undo_manager_clear (manager);
+      mousepad_undo_manager_update_state (manager);
+    }
+}
+
+
+
+/**
+ * Public API
+ **/
+MousepadUndoManager *
+mousepad_undo_manager_new (GtkTextBuffer *buffer)
+{
+  MousepadUndoManager *manager;
+
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), NULL);
+
+  manager = g_object_new (MOUSEPAD_TYPE_UNDO_MANAGER, NULL);
+  manager->buffer = buffer;
+  g_object_add_weak_pointer (G_OBJECT (buffer), (gpointer *) &manager->buffer);
+
+  /* follow the memory budget setting */
+  mousepad_undo_manager_budget_changed (manager, NULL, NULL);
+  mousepad_setting_connect_object (MOUSEPAD_SETTING_UNDO_MEMORY_LIMIT,
+                                   G_CALLBACK (mousepad_undo_manager_budget_changed),
+                                   manager, G_CONNECT_SWAPPED);
+
+  /* record the changes of the buffer before they happen */
+  g_signal_connect (buffer, "insert-text", G_CALLBACK (mousepad_undo_manager_insert_text), manager);
+  g_signal_connect (buffer, "delete-range", G_CALLBACK (mousepad_undo_manager_delete_range), manager);
+  g_signal_connect (buffer, "begin-user-action", G_CALLBACK (mousepad_undo_manager_begin_user_action), manager);
+  g_signal_connect (buffer, "end-user-action", G_CALLBACK (mousepad_undo_manager_end_user_action), manager);
+  g_signal_connect (buffer, "modified-changed", G_CALLBACK (mousepad_undo_manager_modified_changed), manager);
+
+  return manager;
+}
+
+
+
+gsize
+mousepad_undo_manager_get_memory (MousepadUndoManager *manager)
+{
+  g_return_val_if_fail (MOUSEPAD_IS_UNDO_MANAGER (manager), 0);
+
+  return manager->chunk_memory + manager->actions->len * sizeof (MousepadUndoAction)
+         + manager->pending->allocated_len;
+}
@@ -0,0 +1,43 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __MOUSEPAD_UNDO_MANAGER_H__
+#define __MOUSEPAD_UNDO_MANAGER_H__
+
+#include <gtk/gtk.h>
+#include <gtksourceview/gtksource.h>
+
+G_BEGIN_DECLS
+
+typedef struct _MousepadUndoManagerClass MousepadUndoManagerClass;
+typedef struct _MousepadUndoManager      MousepadUndoManager;
+
+#define MOUSEPAD_TYPE_UNDO_MANAGER            (mousepad_undo_manager_get_type ())
+#define MOUSEPAD_UNDO_MANAGER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), MOUSEPAD_TYPE_UNDO_MANAGER, MousepadUndoManager))
+#define MOUSEPAD_UNDO_MANAGER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), MOUSEPAD_TYPE_UNDO_MANAGER, MousepadUndoManagerClass))
+#define MOUSEPAD_IS_UNDO_MANAGER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), MOUSEPAD_TYPE_UNDO_MANAGER))
+#define MOUSEPAD_IS_UNDO_MANAGER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), MOUSEPAD_TYPE_UNDO_MANAGER))
+#define MOUSEPAD_UNDO_MANAGER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), MOUSEPAD_TYPE_UNDO_MANAGER, MousepadUndoManagerClass))
+
+GType                mousepad_undo_manager_get_type   (void) G_GNUC_CONST;
+
+MousepadUndoManager *mousepad_undo_manager_new        (GtkTextBuffer       *buffer);
+
+gsize                mousepad_undo_manager_get_memory (MousepadUndoManager *manager);
+
+G_END_DECLS
+
+#endif /* !__MOUSEPAD_UNDO_MANAGER_H__ */
@@ -20,6 +20,16 @@
 
 
 
+/* number of compiled search patterns kept in the cache */
+#define MOUSEPAD_SEARCH_REGEX_CACHE_SIZE 16
+
+/* search budget: maximum backtracking steps per start position, and maximum time (in
+ * seconds) a pattern may spend on the whole text, checked after each match */
+#define MOUSEPAD_SEARCH_REGEX_MATCH_LIMIT 1000000
+#define MOUSEPAD_SEARCH_REGEX_TIME_BUDGET 1.0
+
+
+
 static gboolean
 mousepad_util_iter_word_characters (const GtkTextIter *iter)
 {
@@ -236,97 +246,177 @@ mousepad_util_key_name (const gchar *name)
 
 
 
-gchar *
-mousepad_util_utf8_strcapital (const gchar *str)
+/* case conversions done by mousepad_util_utf8_convert_case () */
+typedef enum
 {
-  gunichar     c;
-  const gchar *p;
-  gchar       *buf;
-  GString     *result;
-  gboolean     upper = TRUE;
+  MOUSEPAD_UTIL_CASE_LOWER,
+  MOUSEPAD_UTIL_CASE_UPPER,
+  MOUSEPAD_UTIL_CASE_TITLE,
+  MOUSEPAD_UTIL_CASE_OPPOSITE
+}
+MousepadUtilCase;
 
-  g_return_val_if_fail (g_utf8_validate (str, -1, NULL), NULL);
+/* a byte in each lane of a 64 bits word */
+#define MOUSEPAD_UTIL_LANES(byte) (G_GUINT64_CONSTANT (0x0101010101010101) * (byte))
 
-  /* create a new string */
-  result = g_string_sized_new (strlen (str));
 
-  /* walk though the string */
-  for (p = str; *p != '\0'; p = g_utf8_next_char (p))
-    {
-      /* get the unicode char */
-      c = g_utf8_get_char (p);
 
-      /* only change the case of alpha chars */
-      if (g_unichar_isalpha (c))
+/* high bit of each lane set when the (ascii) byte is in [first, last] */
+static inline guint64
+mousepad_util_ascii_range_mask (guint64 word,
+                                guchar  first,
+                                guchar  last)
+{
+  return ((word + MOUSEPAD_UTIL_LANES (0x80 - first))
+          ^ (word + MOUSEPAD_UTIL_LANES (0x7f - last))) & MOUSEPAD_UTIL_LANES (0x80);
+}
+
+
+
+static void
+mousepad_util_ascii_convert_case (gchar            *str,
+                                  gsize             length,
+                                  MousepadUtilCase  mode,
+                                  gboolean         *upper)
+{
+  guint64 word, mask;
+  gsize   i = 0;
+
+  if (mode == MOUSEPAD_UTIL_CASE_TITLE)
+    {
+      for (; i < length; i++)
         {
-          /* check case */
-          if (upper ? g_unichar_isupper (c) : g_unichar_islower (c))
+          if (g_ascii_isalpha (str[i]))
             {
-              /* currect case is already correct */
-              g_string_append_unichar (result, c);
+              str[i] = *upper ? g_ascii_toupper (str[i]) : g_ascii_tolower (str[i]);
+
+              /* next char must be lowercase */
+              *upper = FALSE;
             }
           else
             {
-              /* convert the case of the char and append it */
-              buf = upper ? g_utf8_strup (p, 1) : g_utf8_strdown (p, 1);
-              g_string_append (result, buf);
-              g_free (buf);
+              /* next alpha char uppercase after a space */
+              *upper = g_ascii_isspace (str[i]);
             }
-
-          /* next char must be lowercase */
-          upper = FALSE;
         }
+
+      return;
+    }
+
+  /* flip the 0x20 bit of the letters to convert, eight bytes at a time */
+  for (; i + 8 <= length; i += 8)
+    {
+      memcpy (&word, str + i, 8);
+
+      if (mode == MOUSEPAD_UTIL_CASE_LOWER)
+        mask = mousepad_util_ascii_range_mask (word, 'A', 'Z');
+      else if (mode == MOUSEPAD_UTIL_CASE_UPPER)
+        mask = mousepad_util_ascii_range_mask (word, 'a', 'z');
       else
-        {
-          /* append the char */
-          g_string_append_unichar (result, c);
+        mask = mousepad_util_ascii_range_mask (word, 'A', 'Z')
+               | mousepad_util_ascii_range_mask (word, 'a', 'z');
 
-          /* next alpha char uppercase after a space */
-          upper = g_unichar_isspace (c);
+      if (mask != 0)
+        {
+          word ^= mask >> 2;
+          memcpy (str + i, &word, 8);
         }
     }
 
-  /* return the result */
-  return g_string_free (result, FALSE);
+  for (; i < length; i++)
+    {
+      if (mode == MOUSEPAD_UTIL_CASE_LOWER || (mode == MOUSEPAD_UTIL_CASE_OPPOSITE && g_ascii_isupper (str[i])))
+        str[i] = g_ascii_tolower (str[i]);
+      else
+        str[i] = g_ascii_toupper (str[i]);
+    }
 }
 
 
 
-gchar *
-mousepad_util_utf8_stropposite (const gchar *str)
+static gchar *
+mousepad_util_utf8_convert_case (const gchar      *str,
+                                 MousepadUtilCase  mode)
 {
+  GString     *result;
+  guint64      word;
   gunichar     c;
-  const gchar *p;
+  const gchar *p, *run, *end;
   gchar       *buf;
-  GString     *result;
+  gsize        length, len;
+  gboolean     upper = TRUE;
 
   g_return_val_if_fail (g_utf8_validate (str, -1, NULL), NULL);
 
-  /* create a new string */
-  result = g_string_sized_new (strlen (str));
+  /* the result has the size of the string, but for a few special cases */
+  length = strlen (str);
+  result = g_string_sized_new (length);
 
-  /* walk though the string */
-  for (p = str; *p != '\0'; p = g_utf8_next_char (p))
+  for (p = str, end = str + length; p < end; )
     {
-      /* get the unicode char */
-      c = g_utf8_get_char (p);
+      /* measure the ascii run, a word at a time */
+      for (run = p; end - p >= 8; p += 8)
+        {
+          memcpy (&word, p, 8);
+          if (word & MOUSEPAD_UTIL_LANES (0x80))
+            break;
+        }
 
-      /* only change the case of alpha chars */
-      if (g_unichar_isalpha (c))
+      while (p < end && ! (*p & 0x80))
+        p++;
+
+      /* convert it in place in the result */
+      if (p > run)
         {
-          /* get the opposite case of the char */
-          if (g_unichar_isupper (c))
-            buf = g_utf8_strdown (p, 1);
+          len = result->len;
+          g_string_append_len (result, run, p - run);
+          mousepad_util_ascii_convert_case (result->str + len, p - run, mode, &upper);
+        }
+
+      if (p == end)
+        break;
+
+      /* measure the non-ascii run */
+      for (run = p; p < end && (*p & 0x80); p++);
+
+      if (mode == MOUSEPAD_UTIL_CASE_LOWER || mode == MOUSEPAD_UTIL_CASE_UPPER)
+        {
+          /* leave special casing (eg. ß to SS) to glib, once per run */
+          if (mode == MOUSEPAD_UTIL_CASE_LOWER)
+            buf = g_utf8_strdown (run, p - run);
           else
-            buf = g_utf8_strup (p, 1);
+            buf = g_utf8_strup (run, p - run);
 
-          /* append to the buffer */
           g_string_append (result, buf);
           g_free (buf);
+
+          continue;
         }
-      else
+
+      for (; run < p; run = g_utf8_next_char (run))
         {
-          /* append the char */
+          /* get the unicode char */
+          c = g_utf8_get_char (run);
+
+          /* only change the case of alpha chars */
+          if (g_unichar_isalpha (c))
+            {
+              if (mode == MOUSEPAD_UTIL_CASE_TITLE)
+                {
+                  c = upper ? g_unichar_toupper (c) : g_unichar_tolower (c);
+
+                  /* next char must be lowercase */
+                  upper = FALSE;
+                }
+              else
+                c = g_unichar_isupper (c) ? g_unichar_tolower (c) : g_unichar_toupper (c);
+            }
+          else if (mode == MOUSEPAD_UTIL_CASE_TITLE)
+            {
+              /* next alpha char uppercase after a space */
+              upper = g_unichar_isspace (c);
+            }
+
           g_string_append_unichar (result, c);
         }
     }
@@ -337,6 +427,38 @@ mousepad_util_utf8_stropposite (const gchar *str)
 
 
 
+gchar *
+mousepad_util_utf8_strdown (const gchar *str)
+{
+  return mousepad_util_utf8_convert_case (str, MOUSEPAD_UTIL_CASE_LOWER);
+}
+
+
+
+gchar *
+mousepad_util_utf8_strup (const gchar *str)
+{
+  return mousepad_util_utf8_convert_case (str, MOUSEPAD_UTIL_CASE_UPPER);
+}
+
+
+
+gchar *
+mousepad_util_utf8_strcapital (const gchar *str)
+{
+  return mousepad_util_utf8_convert_case (str, MOUSEPAD_UTIL_CASE_TITLE);
+}
+
+
+
+gchar *
+mousepad_util_utf8_stropposite (const gchar *str)
+{
+  return mousepad_util_utf8_convert_case (str, MOUSEPAD_UTIL_CASE_OPPOSITE);
+}
+
+
+
 gchar *
 mousepad_util_escape_underscores (const gchar *str)
 {
@@ -491,6 +613,649 @@ mousepad_util_get_real_line_offset (const GtkTextIter *iter,
 
 
 
+gchar *
+mousepad_util_tabs_to_spaces (const gchar *text,
+                              gsize        length,
+                              gint         column,
+                              gint         tab_size)
+{
+  const gchar *p, *tab, *end = text + length;
+  GString     *string;
+  gint         n_spaces;
+
+  /* nothing to do without tabs */
+  tab = memchr (text, '\t', length);
+  if (tab == NULL)
+    return NULL;
+
+  string = g_string_sized_new (length + tab_size);
+
+  /* copy the text between the tabs in one go, following the visual column */
+  for (p = text; tab != NULL; p = tab + 1, tab = memchr (p, '\t', end - p))
+    {
+      column += g_utf8_strlen (p, tab - p);
+      g_string_append_len (string, p, tab - p);
+
+      /* fill up to the next tab stop */
+      n_spaces = tab_size - column % tab_size;
+      column += n_spaces;
+      while (n_spaces-- > 0)
+        g_string_append_c (string, ' ');
+    }
+
+  g_string_append_len (string, p, end - p);
+
+  return g_string_free (string, FALSE);
+}
+
+
+
+gchar *
+mousepad_util_spaces_to_tabs (const gchar *text,
+                              gsize        length,
+                              gint         tab_size)
+{
+  GString *string;
+  gboolean changed = FALSE;
+  gsize    i, run_start = 0;
+  gint     column = 0, n_spaces = 0;
+
+  string = g_string_sized_new (length);
+
+  /* only the leading whitespace of the line is converted */
+  for (i = 0; i < length && (text[i] == ' ' || text[i] == '\t'); i++)
+    {
+      if (text[i] == ' ')
+        {
+          if (n_spaces++ == 0)
+            run_start = i;
+
+          /* a run of spaces reaching a tab stop becomes a tab */
+          if (++column % tab_size == 0)
+            {
+              g_string_append_c (string, '\t');
+              n_spaces = 0;
+              changed = TRUE;
+            }
+        }
+      else
+        {
+          /* spaces followed by a tab within the same tab stop are left alone */
+          g_string_append_len (string, text + run_start, n_spaces);
+          g_string_append_c (string, '\t');
+          column += tab_size - column % tab_size;
+          n_spaces = 0;
+        }
+    }
+
+  if (! changed)
+    {
+      g_string_free (string, TRUE);
+      return NULL;
+    }
+
+  /* append the pending spaces and the rest of the line */
+  g_string_append_len (string, text + run_start, n_spaces);
+  g_string_append_len (string, text + i, length - i);
+
+  return g_string_free (string, FALSE);
+}
+
+
+
+GArray *
+mousepad_util_find_trailing_blanks (const gchar *text,
+                                    gsize        length)
+{
+  GArray            *ranges;
+  MousepadLineRange  range;
+  const gchar       *p, *line_start, *line_end, *blank, *end = text + length;
+
+  ranges = g_array_new (FALSE, FALSE, sizeof (MousepadLineRange));
+
+  for (p = text, range.line = 0; p <= end; range.line++)
+    {
+      /* find the end of the line, the buffer knows \n, \r, \r\n and the paragraph
+       * separator U+2029 */
+      line_start = p;
+      for (line_end = p; line_end < end; line_end++)
+        if (*line_end == '\n' || *line_end == '\r'
+            || (*line_end == '\342' && end - line_end >= 3
+                && line_end[1] == '\200' && line_end[2] == '\251'))
+          break;
+
+      /* walk back over the trailing spaces and tabs */
+      for (blank = line_end; blank > line_start && (blank[-1] == ' ' || blank[-1] == '\t'); blank--);
+
+      /* only report lines that actually need stripping */
+      if (blank != line_end)
+        {
+          range.start = blank - line_start;
+          range.end = line_end - line_start;
+          g_array_append_val (ranges, range);
+        }
+
+      /* skip the line delimiter */
+      if (line_end < end && line_end[0] == '\r' && line_end + 1 < end && line_end[1] == '\n')
+        line_end++;
+      else if (line_end < end && line_end[0] == '\342')
+        line_end += 2;
+      p = line_end + 1;
+    }
+
+  return ranges;
+}
+
+
+
+gchar *
+mousepad_util_reverse_lines (const gchar *text,
+                             gsize        length)
+{
+  GArray      *starts;
+  const gchar *p, *end = text + length;
+  gchar       *reversed, *q;
+  gsize        start, stop;
+  guint        n;
+
+  /* index where every line starts */
+  starts = g_array_new (FALSE, FALSE, sizeof (gsize));
+  start = 0;
+  g_array_append_val (starts, start);
+  for (p = text; (p = memchr (p, '\n', end - p)) != NULL; )
+    {
+      start = ++p - text;
+      g_array_append_val (starts, start);
+    }
+
+  /* the reversed lines take exactly the same room */
+  reversed = q = g_malloc (length + 1);
+  for (n = starts->len; n > 0; n--)
+    {
+      start = g_array_index (starts, gsize, n - 1);
+      stop = (n < starts->len) ? g_array_index (starts, gsize, n) - 1 : length;
+
+      memcpy (q, text + start, stop - start);
+      q += stop - start;
+      if (n > 1)
+        *q++ = '\n';
+    }
+  *q = '\0';
+
+  g_array_free (starts, TRUE);
+
+  return reversed;
+}
+
+
+
+/**
+ * Line sorting
+ **/
+/* below this number of lines, sorting on worker threads doesn't pay */
+#define MOUSEPAD_SORT_PARALLEL_THRESHOLD 65536
+
+/* a line of a text snapshot, with its numeric value for numeric sorts */
+typedef struct
+{
+  const gchar *start;
+  gsize        length;
+  gdouble      number;
+}
+MousepadSortLine;
+
+typedef gint (*MousepadSortCompareFunc) (const MousepadSortLine *a,
+                                         const MousepadSortLine *b);
+
+/* a slice of the lines sorted or merged by a worker thread */
+typedef struct
+{
+  MousepadSortLine        *lines;
+  MousepadSortLine        *scratch;
+  gsize                    n_lines;
+  gsize                    middle;
+  MousepadSortCompareFunc  compare;
+}
+MousepadSortJob;
+
+
+
+static gint
+mousepad_util_sort_compare_bytes (const MousepadSortLine *a,
+                                  const MousepadSortLine *b)
+{
+  gint result;
+
+  /* byte order is code point order in UTF-8 */
+  result = memcmp (a->start, b->start, MIN (a->length, b->length));
+  if (result != 0)
+    return result;
+
+  return (a->length > b->length) - (a->length < b->length);
+}
+
+
+
+static gint
+mousepad_util_sort_compare_bytes_reversed (const MousepadSortLine *a,
+                                           const MousepadSortLine *b)
+{
+  return mousepad_util_sort_compare_bytes (b, a);
+}
+
+
+
+static gint
+mousepad_util_sort_compare_ignore_case (const MousepadSortLine *a,
+                                        const MousepadSortLine *b)
+{
+  gsize i, length = MIN (a->length, b->length);
+  gint  result;
+
+  /* only ascii letters are folded, the other bytes compare as they are */
+  for (i = 0; i < length; i++)
+    {
+      result = g_ascii_tolower ((guchar) a->start[i]) - g_ascii_tolower ((guchar) b->start[i]);
+      if (result != 0)
+        return result;
+    }
+
+  return (a->length > b->length) - (a->length < b->length);
+}
+
+
+
+static gdouble
+mousepad_util_sort_get_number (const gchar *start,
+                               gsize        length)
+{
+  const gchar *p = start, *end = start + length, *digits;
+  gchar        number[64];
+  gsize        n_digits;
+
+  /* only a plain decimal number is a key: g_ascii_strtod() also takes nan,
+   * inf and hex numbers, and a nan key would break the order of the sort */
+  while (p < end && (*p == ' ' || *p == '\t'))
+    p++;
+
+  start = p;
+  if (p < end && (*p == '+' || *p == '-'))
+    p++;
+
+  for (digits = p; p < end && g_ascii_isdigit (*p); p++);
+  n_digits = p - digits;
+  if (p < end && *p == '.')
+    for (digits = ++p; p < end && g_ascii_isdigit (*p); p++);
+  n_digits += p - digits;
+
+  /* lines without a number count as zero */
+  if (n_digits == 0)
+    return 0.0;
+
+  /* the exponent only when it has digits, "1e" is the number 1 */
+  if (p < end && (*p == 'e' || *p == 'E'))
+    {
+      digits = p + 1;
+      if (digits < end && (*digits == '+' || *digits == '-'))
+        digits++;
+      if (digits < end && g_ascii_isdigit (*digits))
+        for (p = digits; p < end && g_ascii_isdigit (*p); p++);
+    }
+
+  /* parsed from a copy so that it can't run into the next line */
+  length = MIN ((gsize) (p - start), sizeof (number) - 1);
+  memcpy (number, start, length);
+  number[length] = '\0';
+
+  return g_ascii_strtod (number, NULL);
+}
+
+
+
+static gint
+mousepad_util_sort_compare_numeric (const MousepadSortLine *a,
+                                    const MousepadSortLine *b)
+{
+  if (a->number != b->number)
+    return (a->number > b->number) ? 1 : -1;
+
+  return mousepad_util_sort_compare_bytes (a, b);
+}
+
+
+
+static gint
+mousepad_util_sort_compare_natural (const MousepadSortLine *a,
+                                    const MousepadSortLine *b)
+{
+  const gchar *p = a->start, *q = b->start;
+  const gchar *p_end = p + a->length, *q_end = q + b->length;
+  const gchar *p_digits, *q_digits;
+  gint         result;
+
+  while (p < p_end && q < q_end)
+    {
+      /* runs of digits compare by value: without their leading zeros,
+       * the longer run is the bigger number, then the digits decide */
+      if (g_ascii_isdigit (*p) && g_ascii_isdigit (*q))
+        {
+          for (; p < p_end - 1 && *p == '0' && g_ascii_isdigit (p[1]); p++);
+          for (; q < q_end - 1 && *q == '0' && g_ascii_isdigit (q[1]); q++);
+          for (p_digits = p; p < p_end && g_ascii_isdigit (*p); p++);
+          for (q_digits = q; q < q_end && g_ascii_isdigit (*q); q++);
+
+          if (p - p_digits != q - q_digits)
+            return (p - p_digits > q - q_digits) ? 1 : -1;
+
+          result = memcmp (p_digits, q_digits, p - p_digits);
+          if (result != 0)
+            return result;
+        }
+      else if (*p != *q)
+        return (guchar) *p - (guchar) *q;
+      else
+        {
+          p++;
+          q++;
+        }
+    }
+
+  if (p < p_end || q < q_end)
+    return (p < p_end) ? 1 : -1;
+
+  return mousepad_util_sort_compare_bytes (a, b);
+}
+
+
+
+static void
+mousepad_util_sort_merge (MousepadSortLine        *lines,
+                          MousepadSortLine        *scratch,
+                          gsize                    n_lines,
+                          gsize                    middle,
+                          MousepadSortCompareFunc  compare)
+{
+  gsize i = 0, j = middle, k = 0;
+
+  /* take from the left run on ties, which keeps the sort stable */
+  while (i < middle && j < n_lines)
+    {
+      if (compare (&lines[j], &lines[i]) < 0)
+        scratch[k++] = lines[j++];
+      else
+        scratch[k++] = lines[i++];
+    }
+
+  memcpy (scratch + k, lines + i, (middle - i) * sizeof (MousepadSortLine));
+  k += middle - i;
+  memcpy (scratch + k, lines + j, (n_lines - j) * sizeof (MousepadSortLine));
+
+  memcpy (lines, scratch, n_lines * sizeof (MousepadSortLine));
+}
+
+
+
+static void
+mousepad_util_sort_merge_sort (MousepadSortLine        *lines,
+                               MousepadSortLine        *scratch,
+                               gsize                    n_lines,
+                               MousepadSortCompareFunc  compare)
+{
+  MousepadSortLine line;
+  gsize            middle, i, j;
+
+  /* insertion sort for the short runs */
+  if (n_lines <= 16)
+    {
+      for (i = 1; i < n_lines; i++)
+        {
+          line = lines[i];
+          for (j = i; j > 0 && compare (&line, &lines[j - 1]) < 0; j--)
+            lines[j] = lines[j - 1];
+          lines[j] = line;
+        }
+
+      return;
+    }
+
+  middle = n_lines / 2;
+  mousepad_util_sort_merge_sort (lines, scratch, middle, compare);
+  mousepad_util_sort_merge_sort (lines + middle, scratch + middle, n_lines - middle, compare);
+
+  /* already in order */
+  if (compare (&lines[middle], &lines[middle - 1]) >= 0)
+    return;
+
+  mousepad_util_sort_merge (lines, scratch, n_lines, middle, compare);
+}
+
+
+
+static gpointer
+mousepad_util_sort_job_sort (gpointer data)
+{
+  MousepadSortJob *job = data;
+
+  mousepad_util_sort_merge_sort (job->lines, job->scratch, job->n_lines, job->compare);
+
+  return NULL;
+}
+
+
+
+static gpointer
+mousepad_util_sort_job_merge (gpointer data)
+{
+  MousepadSortJob *job = data;
+
+  mousepad_util_sort_merge (job->lines, job->scratch, job->n_lines, job->middle, job->compare);
+
+  return NULL;
+}
+
+
+
+/* sort the slices on worker threads, then merge them pairwise, each
+ * round of merges also running in parallel */
+static void
+mousepad_util_sort_parallel (MousepadSortLine        *lines,
+                             gsize                    n_lines,
+                             MousepadSortCompareFunc  compare)
+{
+  MousepadSortLine *scratch;
+  MousepadSortJob  *jobs;
+  GThread         **threads;
+  gsize            *bounds, width;
+  guint             n_slices, n, n_jobs;
+
+  scratch = g_new (MousepadSortLine, n_lines);
+
+  if (n_lines < MOUSEPAD_SORT_PARALLEL_THRESHOLD)
+    n_slices = 1;
+  else
+    n_slices = CLAMP (g_get_num_processors (), 1, 16);
+
+  /* the slice bounds, shared by the sorts and the merges */
+  bounds = g_new (gsize, n_slices + 1);
+  for (n = 0; n <= n_slices; n++)
+    bounds[n] = n_lines / n_slices * n + MIN (n, n_lines % n_slices);
+
+  jobs = g_new0 (MousepadSortJob, n_slices);
+  threads = g_new0 (GThread *, n_slices);
+
+  for (n = 0; n < n_slices; n++)
+    {
+      jobs[n].lines = lines + bounds[n];
+      jobs[n].scratch = scratch + bounds[n];
+      jobs[n].n_lines = bounds[n + 1] - bounds[n];
+      jobs[n].compare = compare;
+
+      if (n_slices > 1)
+        threads[n] = g_thread_new ("mousepad-sort", mousepad_util_sort_job_sort, &jobs[n]);
+      else
+        mousepad_util_sort_job_sort (&jobs[n]);
+    }
+
+  for (n = 0; n < n_slices; n++)
+    if (threads[n] != NULL)
+      g_thread_join (threads[n]);
+
+  /* merge the sorted slices, doubling their width every round */
+  for (width = 1; width < n_slices; width *= 2)
+    {
+      for (n = 0, n_jobs = 0; n + width < n_slices; n += 2 * width, n_jobs++)
+        {
+          jobs[n_jobs].lines = lines + bounds[n];
+          jobs[n_jobs].scratch = scratch + bounds[n];
+          jobs[n_jobs].n_lines = bounds[MIN (n + 2 * width, n_slices)] - bounds[n];
+          jobs[n_jobs].middle = bounds[n + width] - bounds[n];
+        }
+
+      /* the last merge has the calling thread to itself */
+      if (n_jobs == 1)
+        mousepad_util_sort_job_merge (&jobs[0]);
+      else
+        {
+          for (n = 0; n < n_jobs; n++)
+            threads[n] = g_thread_new ("mousepad-sort", mousepad_util_sort_job_merge, &jobs[n]);
+          for (n = 0; n < n_jobs; n++)
+            g_thread_join (threads[n]);
+        }
+    }
+
+  g_free (threads);
+  g_free (jobs);
+  g_free (bounds);
+  g_free (scratch);
+}
+
+
+
+static guint
+mousepad_util_sort_line_hash (gconstpointer key)
+{
+  const MousepadSortLine *line = key;
+  const gchar            *p, *end = line->start + line->length;
+  guint                   hash = 5381;
+
+  for (p = line->start; p < end; p++)
+    hash = (hash << 5) + hash + (guchar) *p;
+
+  return hash;
+}
+
+
+
+static gboolean
+mousepad_util_sort_line_equal (gconstpointer a,
+                               gconstpointer b)
+{
+  const MousepadSortLine *line_a = a, *line_b = b;
+
+  return line_a->length == line_b->length
+         && memcmp (line_a->start, line_b->start, line_a->length) == 0;
+}
+
+
+
+gchar *
+mousepad_util_sort_lines (const gchar      *text,
+                          gsize             length,
+                          MousepadSortType  type)
+{
+  MousepadSortCompareFunc  compare = NULL;
+  MousepadSortLine        *lines, line;
+  GHashTable              *seen;
+  const gchar             *p, *line_end, *end = text + length;
+  gchar                   *sorted, *q;
+  gsize                    n_lines, i, j;
+
+  /* index the lines once */
+  for (p = text, n_lines = 1; (p = memchr (p, '\n', end - p)) != NULL; p++)
+    n_lines++;
+
+  lines = g_new (MousepadSortLine, n_lines);
+  for (p = text, i = 0; i < n_lines; i++)
+    {
+      line_end = memchr (p, '\n', end - p);
+      lines[i].start = p;
+      lines[i].length = (line_end != NULL ? line_end : end) - p;
+      lines[i].number = 0.0;
+      p += lines[i].length + 1;
+    }
+
+  switch (type)
+    {
+      case MOUSEPAD_SORT_ASCENDING:
+        compare = mousepad_util_sort_compare_bytes;
+        break;
+
+      case MOUSEPAD_SORT_DESCENDING:
+        compare = mousepad_util_sort_compare_bytes_reversed;
+        break;
+
+      case MOUSEPAD_SORT_NUMERIC:
+        /* the leading number of the line */
+        for (i = 0; i < n_lines; i++)
+          lines[i].number = mousepad_util_sort_get_number (lines[i].start, lines[i].length);
+        compare = mousepad_util_sort_compare_numeric;
+        break;
+
+      case MOUSEPAD_SORT_NATURAL:
+        compare = mousepad_util_sort_compare_natural;
+        break;
+
+      case MOUSEPAD_SORT_IGNORE_CASE:
+        compare = mousepad_util_sort_compare_ignore_case;
+        break;
+
+      case MOUSEPAD_SORT_UNIQUE:
+        /* keep the first occurrence of every line, in place */
+        seen = g_hash_table_new (mousepad_util_sort_line_hash, mousepad_util_sort_line_equal);
+        for (i = j = 0; i < n_lines; i++)
+          if (g_hash_table_add (seen, &lines[i]))
+            lines[j++] = lines[i];
+        g_hash_table_destroy (seen);
+        n_lines = j;
+        break;
+
+      case MOUSEPAD_SORT_SHUFFLE:
+        /* Fisher-Yates */
+        for (i = n_lines; i > 1; i--)
+          {
+            j = g_random_int_range (0, i);
+            line = lines[i - 1];
+            lines[i - 1] = lines[j];
+            lines[j] = line;
+          }
+        break;
+
+      default:
+        g_assert_not_reached ();
+        break;
+    }
+
+  if (compare != NULL)
+    mousepad_util_sort_parallel (lines, n_lines, compare);
+
+  /* write the lines back, in a buffer that can't be too small */
+  sorted = q = g_malloc (length + 1);
+  for (i = 0; i < n_lines; i++)
+    {
+      if (i > 0)
+        *q++ = '\n';
+      memcpy (q, lines[i].start, lines[i].length);
+      q += lines[i].length;
+    }
+  *q = '\0';
+
+  g_free (lines);
+
+  return sorted;
+}
+
+
+
 gboolean
 mousepad_util_forward_iter_to_text (GtkTextIter       *iter,
                                     const GtkTextIter *limit)
@@ -620,6 +1385,370 @@ mousepad_util_search_flags_get_type (void)
 
 
 
+/**
+ * Literal search
+ **/
+typedef struct
+{
+  /* the needle, already folded when matching case-insensitively */
+  guchar   *needle;
+  gsize     length;
+  gboolean  match_case;
+
+  /* byte folding and Horspool bad character tables */
+  guchar    fold[256];
+  gsize     shift[256];
+}
+MousepadLiteralMatcher;
+
+
+
+static gboolean
+mousepad_util_literal_matcher_init (MousepadLiteralMatcher *matcher,
+                                    const gchar            *needle,
+                                    gboolean                match_case)
+{
+  const gchar *p;
+  gunichar     c;
+  gsize        i;
+
+  /* when ignoring case, we only fold ascii bytes, so refuse needles containing non-ascii
+   * characters that have a case: those are left to GtkSourceView */
+  if (! match_case)
+    for (p = needle; *p != '\0'; p = g_utf8_next_char (p))
+      {
+        c = g_utf8_get_char (p);
+        if (c >= 0x80 && (g_unichar_tolower (c) != c || g_unichar_toupper (c) != c))
+          return FALSE;
+      }
+
+  matcher->length = strlen (needle);
+  matcher->match_case = match_case;
+
+  /* folding table, the identity when matching case */
+  for (i = 0; i < 256; i++)
+    matcher->fold[i] = match_case ? i : g_ascii_tolower (i);
+
+  /* precompute the folded needle once */
+  matcher->needle = g_malloc (matcher->length + 1);
+  for (i = 0; i <= matcher->length; i++)
+    matcher->needle[i] = matcher->fold[(guchar) needle[i]];
+
+  /* bad character shifts, indexed by folded bytes */
+  for (i = 0; i < 256; i++)
+    matcher->shift[i] = matcher->length;
+  for (i = 0; i + 1 < matcher->length; i++)
+    matcher->shift[matcher->needle[i]] = matcher->length - 1 - i;
+
+  return TRUE;
+}
+
+
+
+static const gchar *
+mousepad_util_literal_matcher_find (MousepadLiteralMatcher *matcher,
+                                    const gchar            *haystack,
+                                    const gchar            *end)
+{
+  const guchar *h = (const guchar *) haystack;
+  const guchar *last, *n = matcher->needle;
+  gsize         m = matcher->length, i;
+  guchar        c;
+
+  if (G_UNLIKELY (m == 0 || (gsize) (end - haystack) < m))
+    return NULL;
+
+  /* last possible start position */
+  last = (const guchar *) end - m;
+
+  if (matcher->match_case)
+    {
+      /* let the (vectorized) libc memchr find candidates for the first byte */
+      while (h <= last && (h = memchr (h, n[0], last - h + 1)) != NULL)
+        {
+          if (memcmp (h + 1, n + 1, m - 1) == 0)
+            return (const gchar *) h;
+          h++;
+        }
+
+      return NULL;
+    }
+
+  /* Horspool on folded bytes */
+  while (h <= last)
+    {
+      c = matcher->fold[h[m - 1]];
+      if (c == n[m - 1])
+        {
+          for (i = 0; i < m - 1 && matcher->fold[h[i]] == n[i]; i++);
+          if (i == m - 1)
+            return (const gchar *) h;
+        }
+
+      h += matcher->shift[c];
+    }
+
+  return NULL;
+}
+
+
+
+static void
+mousepad_util_literal_matcher_clear (MousepadLiteralMatcher *matcher)
+{
+  g_free (matcher->needle);
+}
+
+
+
+gint
+mousepad_util_search_literal_count (const gchar *haystack,
+                                    gsize        length,
+                                    const gchar *needle,
+                                    gboolean     match_case)
+{
+  MousepadLiteralMatcher  matcher;
+  const gchar            *p, *end = haystack + length;
+  gint                    counter = 0;
+
+  g_return_val_if_fail (haystack != NULL && needle != NULL, -1);
+
+  if (*needle == '\0' || ! mousepad_util_literal_matcher_init (&matcher, needle, match_case))
+    return -1;
+
+  /* count non-overlapping occurrences, like GtkSourceView does */
+  for (p = haystack; (p = mousepad_util_literal_matcher_find (&matcher, p, end)) != NULL;
+       p += matcher.length)
+    counter++;
+
+  mousepad_util_literal_matcher_clear (&matcher);
+
+  return counter;
+}
+
+
+
+/**
+ * Compiled search patterns
+ **/
+typedef struct
+{
+  gchar  *key;
+  GRegex *regex;
+}
+MousepadRegexCacheItem;
+
+/* process-wide cache of compiled patterns, most recently used first: GtkSourceView
+ * compiles and runs its own pattern, these ones only serve the counts and the scrollbar
+ * markers computed here, whose word boundaries may differ slightly from its own */
+static GHashTable *regex_cache_table = NULL;
+static GQueue      regex_cache_lru = G_QUEUE_INIT;
+
+
+
+static void
+mousepad_util_regex_cache_item_free (MousepadRegexCacheItem *item)
+{
+  g_free (item->key);
+  g_regex_unref (item->regex);
+  g_slice_free (MousepadRegexCacheItem, item);
+}
+
+
+
+GRegex *
+mousepad_util_search_get_regex (const gchar          *string,
+                                MousepadSearchFlags   flags,
+                                GError              **error)
+{
+  MousepadRegexCacheItem *item;
+  GRegexCompileFlags      compile_flags;
+  GRegex                 *regex;
+  GList                  *link;
+  gchar                  *key, *pattern, *escaped;
+
+  g_return_val_if_fail (string != NULL, NULL);
+
+  /* the settings GtkSourceView takes into account when compiling a pattern */
+  flags &= MOUSEPAD_SEARCH_FLAGS_MATCH_CASE | MOUSEPAD_SEARCH_FLAGS_ENABLE_REGEX
+           | MOUSEPAD_SEARCH_FLAGS_WHOLE_WORD;
+  key = g_strdup_printf ("%x:%s", (guint) flags, string);
+
+  if (G_UNLIKELY (regex_cache_table == NULL))
+    regex_cache_table = g_hash_table_new (g_str_hash, g_str_equal);
+
+  /* move a cached pattern to the front of the list */
+  link = g_hash_table_lookup (regex_cache_table, key);
+  if (link != NULL)
+    {
+      g_queue_unlink (&regex_cache_lru, link);
+      g_queue_push_head_link (&regex_cache_lru, link);
+      g_free (key);
+
+      return g_regex_ref (((MousepadRegexCacheItem *) link->data)->regex);
+    }
+
+  /* build the pattern close to the way GtkSourceView does */
+  if (flags & MOUSEPAD_SEARCH_FLAGS_ENABLE_REGEX)
+    escaped = g_strdup (string);
+  else
+    escaped = g_regex_escape_string (string, -1);
+
+  /* the match limit bounds the backtracking steps spent at each start position, so that a
+   * catastrophic pattern fails with an error instead of running (almost) forever */
+  if (flags & MOUSEPAD_SEARCH_FLAGS_WHOLE_WORD)
+    pattern = g_strdup_printf ("(*LIMIT_MATCH=%d)\\b%s\\b",
+                               MOUSEPAD_SEARCH_REGEX_MATCH_LIMIT, escaped);
+  else
+    pattern = g_strdup_printf ("(*LIMIT_MATCH=%d)%s",
+                               MOUSEPAD_SEARCH_REGEX_MATCH_LIMIT, escaped);
+
+  /* compile it, with the JIT when available */
+  compile_flags = G_REGEX_MULTILINE | G_REGEX_OPTIMIZE;
+  if (! (flags & MOUSEPAD_SEARCH_FLAGS_MATCH_CASE))
+    compile_flags |= G_REGEX_CASELESS;
+
+  regex = g_regex_new (pattern, compile_flags, 0, error);
+
+  /* cleanup */
+  g_free (escaped);
+  g_free (pattern);
+
+  if (G_UNLIKELY (regex == NULL))
+    {
+      g_free (key);
+      return NULL;
+    }
+
+  /* insert the new pattern and evict the least recently used one if needed */
+  item = g_slice_new (MousepadRegexCacheItem);
+  item->key = key;
+  item->regex = g_regex_ref (regex);
+  g_queue_push_head (&regex_cache_lru, item);
+  g_hash_table_insert (regex_cache_table, key, regex_cache_lru.head);
+
+  if (regex_cache_lru.length > MOUSEPAD_SEARCH_REGEX_CACHE_SIZE)
+    {
+      item = g_queue_pop_tail (&regex_cache_lru);
+      g_hash_table_remove (regex_cache_table, item->key);
+      mousepad_util_regex_cache_item_free (item);
+    }
+
+  return regex;
+}
+
+
+
+void
+mousepad_util_search_regex_cache_clear (void)
+{
+  MousepadRegexCacheItem *item;
+
+  while ((item = g_queue_pop_head (&regex_cache_lru)) != NULL)
+    mousepad_util_regex_cache_item_free (item);
+
+  if (regex_cache_table != NULL)
+    {
+      g_hash_table_destroy (regex_cache_table);
+      regex_cache_table = NULL;
+    }
+}
+
+
+
+static gint
+mousepad_util_search_count_regex (GRegex      *regex,
+                                  const gchar *text)
+{
+  GMatchInfo *match_info;
+  GError     *error = NULL;
+  GTimer     *timer;
+  gint        counter = 0;
+
+  /* the whole text is the subject, so that matches may span any number of lines and
+   * anchors only match at its real end, the match limit bounds the time spent between
+   * two matches and the deadline the time spent on all of them */
+  timer = g_timer_new ();
+  g_regex_match_full (regex, text, -1, 0, 0, &match_info, &error);
+  while (g_match_info_matches (match_info))
+    {
+      counter++;
+      if (g_timer_elapsed (timer, NULL) > MOUSEPAD_SEARCH_REGEX_TIME_BUDGET)
+        break;
+
+      g_match_info_next (match_info, &error);
+    }
+
+  /* the match limit was reached (or another resource error occurred), or the pattern is
+   * too slow overall */
+  if (error != NULL || g_timer_elapsed (timer, NULL) > MOUSEPAD_SEARCH_REGEX_TIME_BUDGET)
+    counter = MOUSEPAD_SEARCH_TOO_EXPENSIVE;
+
+  /* cleanup */
+  g_match_info_free (match_info);
+  if (error != NULL)
+    g_error_free (error);
+
+  g_timer_destroy (timer);
+
+  return counter;
+}
+
+
+
+static gint
+mousepad_util_search_count (GtkTextBuffer       *buffer,
+                            const gchar         *string,
+                            MousepadSearchFlags  flags,
+                            gboolean            *exact)
+{
+  GtkTextIter  start, end;
+  GRegex      *regex = NULL;
+  gchar       *text;
+  gint         counter = -1;
+
+  /* only the literal count finds exactly what GtkSourceView finds */
+  *exact = FALSE;
+
+  /* patterns that don't compile are left to GtkSourceView, which reports the error */
+  if (flags & (MOUSEPAD_SEARCH_FLAGS_ENABLE_REGEX | MOUSEPAD_SEARCH_FLAGS_WHOLE_WORD))
+    {
+      regex = mousepad_util_search_get_regex (string, flags, NULL);
+      if (regex == NULL)
+        return -1;
+    }
+
+  /* work on a flat snapshot of the buffer, rather than stepping iters */
+  gtk_text_buffer_get_bounds (buffer, &start, &end);
+  text = gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
+
+  if (regex == NULL)
+    {
+      counter = mousepad_util_search_literal_count (text, strlen (text), string,
+                                                    flags & MOUSEPAD_SEARCH_FLAGS_MATCH_CASE);
+      *exact = (counter != -1);
+    }
+
+  /* literals with cased unicode characters use the compiled pattern too */
+  if (counter == -1)
+    {
+      if (regex == NULL)
+        regex = mousepad_util_search_get_regex (string, flags, NULL);
+
+      if (G_LIKELY (regex != NULL))
+        {
+          counter = mousepad_util_search_count_regex (regex, text);
+          g_regex_unref (regex);
+        }
+    }
+
+  g_free (text);
+
+  return counter;
+}
+
+
+
 gint
 mousepad_util_search (GtkSourceSearchContext *search_context,
                       const gchar            *string,
@@ -631,7 +1760,7 @@ mousepad_util_search (GtkSourceSearchContext *search_context,
   GtkTextIter              start, end, iter, bstart, fend, biter, fiter;
   gchar                   *selected_text;
   gint                     counter = 0;
-  gboolean                 found;
+  gboolean                 found, exact = FALSE;
 
   g_return_val_if_fail (GTK_SOURCE_IS_SEARCH_CONTEXT (search_context), -1);
   g_return_val_if_fail (string != NULL && g_utf8_validate (string, -1, NULL), -1);
@@ -652,14 +1781,38 @@ mousepad_util_search (GtkSourceSearchContext *search_context,
     {
       selection_buffer = GTK_TEXT_BUFFER (gtk_source_buffer_new (NULL));
       gtk_text_buffer_get_selection_bounds (buffer, &start, &end);
-      selected_text = gtk_text_buffer_get_text (buffer, &start, &end, FALSE);
+      selected_text = gtk_text_buffer_get_text (buffer, &start, &end, TRUE);
       gtk_text_buffer_set_text (selection_buffer, selected_text, -1);
       search_context = gtk_source_search_context_new (GTK_SOURCE_BUFFER (selection_buffer), NULL);
       gtk_text_buffer_get_start_iter (selection_buffer, &iter);
     }
 
-  /* set the search context settings */
+  /* count the occurrences of a literal on a snapshot of the buffer first when the entire
+   * area is searched, so that areas without any occurrence are not searched at all, and
+   * always probe regex patterns this way, so that a runaway pattern is caught before it
+   * reaches GtkSourceView, whose search can't be interrupted */
   search_settings = gtk_source_search_context_get_settings (search_context);
+  counter = -1;
+  if (((flags & MOUSEPAD_SEARCH_FLAGS_ENABLE_REGEX)
+       || ((flags & MOUSEPAD_SEARCH_FLAGS_ENTIRE_AREA) && ! (flags & MOUSEPAD_SEARCH_FLAGS_WHOLE_WORD)))
+      && *string != '\0')
+    counter = mousepad_util_search_count (
+                GTK_TEXT_BUFFER (gtk_source_search_context_get_buffer (search_context)),
+                string, flags, &exact);
+
+  /* abort the search, also dropping the occurrence highlighting of the pattern */
+  if (G_UNLIKELY (counter == MOUSEPAD_SEARCH_TOO_EXPENSIVE))
+    {
+      gtk_source_search_settings_set_search_text (search_settings, NULL);
+      goto leave;
+    }
+
+  /* a count from our own pattern only tells whether it is too expensive, GtkSourceView
+   * may find other matches (e.g. at other word boundaries) */
+  if (! exact)
+    counter = -1;
+
+  /* set the search context settings */
   gtk_source_search_settings_set_search_text (search_settings, string);
   gtk_source_search_settings_set_case_sensitive (search_settings,
                                                  flags & MOUSEPAD_SEARCH_FLAGS_MATCH_CASE);
@@ -671,7 +1824,9 @@ mousepad_util_search (GtkSourceSearchContext *search_context,
                                                 flags & MOUSEPAD_SEARCH_FLAGS_ENABLE_REGEX);
 
   /* search the string */
-  if (flags & MOUSEPAD_SEARCH_FLAGS_DIR_BACKWARD)
+  if (counter == 0)
+    found = FALSE;
+  else if (flags & MOUSEPAD_SEARCH_FLAGS_DIR_BACKWARD)
     found = gtk_source_search_context_backward2 (search_context, &iter, &start, &end, NULL);
   else
     found = gtk_source_search_context_forward2 (search_context, &iter, &start, &end, NULL);
@@ -680,7 +1835,7 @@ mousepad_util_search (GtkSourceSearchContext *search_context,
    * directions leads faster to a full scan) */
   if (! (flags & MOUSEPAD_SEARCH_FLAGS_ENTIRE_AREA) || *string == '\0')
     counter = found;
-  else
+  else if (counter == -1)
     {
       counter = gtk_source_search_context_get_occurrences_count (search_context);
       if (counter == -1)
@@ -746,6 +1901,8 @@ mousepad_util_search (GtkSourceSearchContext *search_context,
   else if (! (flags & MOUSEPAD_SEARCH_FLAGS_AREA_SELECTION))
     gtk_text_buffer_place_cursor (buffer, &iter);
 
+leave:
+
   /* thawn buffer notifications */
   g_object_thaw_notify (G_OBJECT (buffer));
 
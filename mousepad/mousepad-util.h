@@ -53,6 +53,31 @@ typedef enum
 }
 MousepadSearchFlags;
 
+/* returned by the search functions when the pattern exceeded its execution budget */
+#define MOUSEPAD_SEARCH_TOO_EXPENSIVE (-2)
+
+/* line operations done by mousepad_util_sort_lines () */
+typedef enum
+{
+  MOUSEPAD_SORT_ASCENDING,
+  MOUSEPAD_SORT_DESCENDING,
+  MOUSEPAD_SORT_NUMERIC,
+  MOUSEPAD_SORT_NATURAL,
+  MOUSEPAD_SORT_IGNORE_CASE,
+  MOUSEPAD_SORT_UNIQUE,
+  MOUSEPAD_SORT_SHUFFLE
+}
+MousepadSortType;
+
+/* a range of byte indexes on a line of a text snapshot */
+typedef struct
+{
+  gint line;
+  gint start;
+  gint end;
+}
+MousepadLineRange;
+
 gboolean   mousepad_util_iter_starts_word                 (const GtkTextIter   *iter);
 
 gboolean   mousepad_util_iter_ends_word                   (const GtkTextIter   *iter);
@@ -71,6 +96,10 @@ gchar     *mousepad_util_config_name                      (const gchar         *
 
 gchar     *mousepad_util_key_name                         (const gchar         *name);
 
+gchar     *mousepad_util_utf8_strdown                     (const gchar         *str);
+
+gchar     *mousepad_util_utf8_strup                       (const gchar         *str);
+
 gchar     *mousepad_util_utf8_strcapital                  (const gchar         *str);
 
 gchar     *mousepad_util_utf8_stropposite                 (const gchar         *str);
@@ -91,6 +120,25 @@ void       mousepad_util_dialog_header                    (GtkDialog           *
 gint       mousepad_util_get_real_line_offset             (const GtkTextIter   *iter,
                                                            gint                 tab_size);
 
+gchar     *mousepad_util_tabs_to_spaces                   (const gchar         *text,
+                                                           gsize                length,
+                                                           gint                 column,
+                                                           gint                 tab_size);
+
+gchar     *mousepad_util_spaces_to_tabs                   (const gchar         *text,
+                                                           gsize                length,
+                                                           gint                 tab_size);
+
+GArray    *mousepad_util_find_trailing_blanks             (const gchar         *text,
+                                                           gsize                length);
+
+gchar     *mousepad_util_reverse_lines                    (const gchar         *text,
+                                                           gsize                length);
+
+gchar     *mousepad_util_sort_lines                       (const gchar         *text,
+                                                           gsize                length,
+                                                           MousepadSortType     type);
+
 gboolean   mousepad_util_forward_iter_to_text             (GtkTextIter         *iter,
                                                            const GtkTextIter   *limit);
 
@@ -107,6 +155,17 @@ gint       mousepad_util_search                           (GtkSourceSearchContex
                                                            const gchar            *replace,
                                                            MousepadSearchFlags     flags);
 
+gint       mousepad_util_search_literal_count             (const gchar            *haystack,
+                                                           gsize                   length,
+                                                           const gchar            *needle,
+                                                           gboolean                match_case);
+
+GRegex    *mousepad_util_search_get_regex                 (const gchar            *string,
+                                                           MousepadSearchFlags     flags,
+                                                           GError                **error);
+
+void       mousepad_util_search_regex_cache_clear         (void);
+
 GIcon     *mousepad_util_icon_for_mime_type               (const gchar         *mime_type);
 
 gboolean   mousepad_util_container_has_children           (GtkContainer        *container);
@@ -27,6 +27,9 @@
 #define MOUSEPAD_VIEW_DEFAULT_FONT "Monospace 10"
 #define mousepad_view_get_buffer(view) (gtk_text_view_get_buffer (GTK_TEXT_VIEW (view)))
 
+/* maximum number of separate edits before a single one replaces them all */
+#define MOUSEPAD_VIEW_MAX_CHANGED_RUNS 256
+
 
 
 static void      mousepad_view_finalize                      (GObject            *object);
@@ -40,10 +43,40 @@ static void      mousepad_view_get_property                  (GObject
                                                               GParamSpec         *pspec);
 static gboolean  mousepad_view_key_press_event               (GtkWidget          *widget,
                                                               GdkEventKey        *event);
-static void      mousepad_view_indent_increase               (MousepadView       *view,
-                                                              GtkTextIter        *iter);
-static void      mousepad_view_indent_decrease               (MousepadView       *view,
-                                                              GtkTextIter        *iter);
+static gboolean  mousepad_view_button_press_event            (GtkWidget          *widget,
+                                                              GdkEventButton     *event);
+static gboolean  mousepad_view_button_release_event          (GtkWidget          *widget,
+                                                              GdkEventButton     *event);
+static gboolean  mousepad_view_motion_notify_event           (GtkWidget          *widget,
+                                                              GdkEventMotion     *event);
+static void      mousepad_view_draw_layer                    (GtkTextView        *text_view,
+                                                              GtkTextViewLayer    layer,
+                                                              cairo_t            *cr);
+static gboolean  mousepad_view_carets_key_press              (MousepadView       *view,
+                                                              GdkEventKey        *event,
+                                                              guint               modifiers);
+static void      mousepad_view_column_set                    (MousepadView       *view,
+                                                              gint                anchor_line,
+                                                              gint                anchor,
+                                                              gint                head_line,
+                                                              gint                head);
+static void      mousepad_view_column_clear                  (MousepadView       *view);
+static void      mousepad_view_column_buffer_changed         (GtkTextBuffer      *buffer,
+                                                              MousepadView       *view);
+static void      mousepad_view_column_at_location            (MousepadView       *view,
+                                                              gdouble             x,
+                                                              gdouble             y,
+                                                              gint               *line,
+                                                              gint               *column);
+static void      mousepad_view_column_draw                   (MousepadView       *view,
+                                                              cairo_t            *cr);
+static gboolean  mousepad_view_column_key_press              (MousepadView       *view,
+                                                              GdkEventKey        *event,
+                                                              guint               modifiers);
+static void      mousepad_view_indent_lines                  (MousepadView       *view,
+                                                              gint                start_line,
+                                                              gint                end_line,
+                                                              gboolean            increase);
 static void      mousepad_view_indent_selection              (MousepadView       *view,
                                                               gboolean            increase,
                                                               gboolean            force);
@@ -56,8 +89,46 @@ static void      mousepad_view_transpose_lines               (GtkTextBuffer
 static void      mousepad_view_transpose_words               (GtkTextBuffer       *buffer,
                                                               GtkTextIter         *iter);
 static void      mousepad_view_update_font                   (MousepadView        *view);
+static void      mousepad_view_update_wrap_mode              (MousepadView        *view);
+static void      mousepad_view_replace_changed               (GtkTextBuffer      *buffer,
+                                                              GtkTextIter        *start_iter,
+                                                              GtkTextIter        *end_iter,
+                                                              const gchar        *text,
+                                                              const gchar        *converted);
+static gchar    *mousepad_view_convert_case                  (const gchar        *text,
+                                                              gint                type);
+
+
+
+/* an extra caret, with its selection running from bound to insert */
+typedef struct
+{
+  GtkTextMark *insert;
+  GtkTextMark *bound;
+}
+MousepadCaret;
 
+/* a line of a column selection: the byte offset of the line in a
+ * snapshot, the byte indexes of the selected span on that line and,
+ * for a line too short to reach the span, the columns it lacks */
+typedef struct
+{
+  gint line;
+  gint offset;
+  gint start;
+  gint end;
+  gint missing;
+}
+MousepadColumnSpan;
 
+/* edits applied at every caret */
+enum
+{
+  CARETS_INSERT,
+  CARETS_BACKSPACE,
+  CARETS_DELETE,
+  CARETS_ERASE_SELECTION
+};
 
 struct _MousepadViewClass
 {
@@ -71,23 +142,21 @@ struct _MousepadView
   /* the selection style tag */
   GtkTextTag           *selection_tag;
 
-  /* list with all the selection marks */
-  GSList               *selection_marks;
-
-  /* selection timeout id */
-  guint                 selection_timeout_id;
+  /* column selection, as the lines and visual columns of two opposite
+   * corners, the spans on the lines are only computed when needed
+   * (anchor line = -1 = no column selection) */
+  gint                  column_anchor_line;
+  gint                  column_anchor;
+  gint                  column_head_line;
+  gint                  column_head;
 
-  /* coordinates for the selection */
-  gint                  selection_start_x;
-  gint                  selection_start_y;
-  gint                  selection_end_x;
-  gint                  selection_end_y;
+  /* if a column selection is being dragged, or its lines are being edited */
+  guint                 column_dragging : 1;
+  guint                 column_editing : 1;
 
-  /* length of the selection (-1 = zerro width selection, 0 = no selection) */
-  gint                  selection_length;
-
-  /* if the selection is in editing mode */
-  guint                 selection_editing : 1;
+  /* extra carets, sorted by position, and where to look for the next occurrence */
+  GArray               *carets;
+  GtkTextMark          *occurrence_mark;
 
   /* the font used in the view */
   PangoFontDescription *font_desc;
@@ -99,7 +168,13 @@ struct _MousepadView
 
   gchar                *color_scheme;
 
+  gboolean              word_wrap;
   gboolean              match_braces;
+
+  /* protection against lines too long to be laid out quickly, which may be
+   * wrapped at any character instead of scrolled to */
+  gboolean              long_lines;
+  gboolean              split_long_lines;
 };
 
 
@@ -113,6 +188,9 @@ enum
   PROP_COLOR_SCHEME,
   PROP_WORD_WRAP,
   PROP_MATCH_BRACES,
+  PROP_COLUMN_SELECTION,
+  PROP_LONG_LINES,
+  PROP_SPLIT_LONG_LINES,
   NUM_PROPERTIES
 };
 
@@ -125,8 +203,9 @@ G_DEFINE_TYPE (MousepadView, mousepad_view, GTK_SOURCE_TYPE_VIEW)
 static void
 mousepad_view_class_init (MousepadViewClass *klass)
 {
-  GObjectClass   *gobject_class;
-  GtkWidgetClass *widget_class;
+  GObjectClass     *gobject_class;
+  GtkWidgetClass   *widget_class;
+  GtkTextViewClass *textview_class;
 
   gobject_class = G_OBJECT_CLASS (klass);
   gobject_class->finalize = mousepad_view_finalize;
@@ -135,6 +214,12 @@ mousepad_view_class_init (MousepadViewClass *klass)
 
   widget_class = GTK_WIDGET_CLASS (klass);
   widget_class->key_press_event = mousepad_view_key_press_event;
+  widget_class->button_press_event = mousepad_view_button_press_event;
+  widget_class->button_release_event = mousepad_view_button_release_event;
+  widget_class->motion_notify_event = mousepad_view_motion_notify_event;
+
+  textview_class = GTK_TEXT_VIEW_CLASS (klass);
+  textview_class->draw_layer = mousepad_view_draw_layer;
 
   g_object_class_install_property (
     gobject_class,
@@ -189,6 +274,33 @@ mousepad_view_class_init (MousepadViewClass *klass)
                           "Whether to highlight matching braces, parens, brackets, etc.",
                           FALSE,
                           G_PARAM_READWRITE));
+
+  g_object_class_install_property (
+    gobject_class,
+    PROP_COLUMN_SELECTION,
+    g_param_spec_boolean ("column-selection",
+                          "ColumnSelection",
+                          "Whether there is a column selection, notified when it changes",
+                          FALSE,
+                          G_PARAM_READABLE));
+
+  g_object_class_install_property (
+    gobject_class,
+    PROP_LONG_LINES,
+    g_param_spec_boolean ("long-lines",
+                          "LongLines",
+                          "Whether the buffer has lines too long for highlighting and word wrap",
+                          FALSE,
+                          G_PARAM_READWRITE));
+
+  g_object_class_install_property (
+    gobject_class,
+    PROP_SPLIT_LONG_LINES,
+    g_param_spec_boolean ("split-long-lines",
+                          "SplitLongLines",
+                          "Whether to wrap long lines at any character for display",
+                          FALSE,
+                          G_PARAM_READWRITE));
 }
 
 
@@ -201,6 +313,11 @@ mousepad_view_buffer_changed (MousepadView *view,
   GtkSourceBuffer *buffer;
   buffer = (GtkSourceBuffer*) gtk_text_view_get_buffer (GTK_TEXT_VIEW (view));
 
+  /* the column selection holds line numbers, that other edits make stale */
+  if (GTK_IS_TEXT_BUFFER (buffer))
+    g_signal_connect_object (buffer, "changed",
+                             G_CALLBACK (mousepad_view_column_buffer_changed), view, 0);
+
   if (GTK_SOURCE_IS_BUFFER (buffer))
     {
       GtkSourceStyleSchemeManager *manager;
@@ -219,9 +336,10 @@ mousepad_view_buffer_changed (MousepadView *view,
       }
 #endif
 
+      /* highlighting and bracket matching crawl on long lines */
       gtk_source_buffer_set_style_scheme (buffer, scheme);
-      gtk_source_buffer_set_highlight_syntax (buffer, enable_highlight);
-      gtk_source_buffer_set_highlight_matching_brackets (buffer, view->match_braces);
+      gtk_source_buffer_set_highlight_syntax (buffer, enable_highlight && ! view->long_lines);
+      gtk_source_buffer_set_highlight_matching_brackets (buffer, view->match_braces && ! view->long_lines);
     }
 }
 
@@ -241,14 +359,18 @@ static void
 mousepad_view_init (MousepadView *view)
 {
   /* initialize selection variables */
-  view->selection_timeout_id = 0;
   view->selection_tag = NULL;
-  view->selection_marks = NULL;
-  view->selection_length = 0;
-  view->selection_editing = FALSE;
+  view->column_anchor_line = -1;
+  view->column_dragging = FALSE;
+  view->column_editing = FALSE;
+  view->carets = g_array_new (FALSE, FALSE, sizeof (MousepadCaret));
+  view->occurrence_mark = NULL;
   view->color_scheme = g_strdup ("none");
   view->font_desc = NULL;
+  view->word_wrap = FALSE;
   view->match_braces = FALSE;
+  view->long_lines = FALSE;
+  view->split_long_lines = FALSE;
   view->css_provider = gtk_css_provider_new ();
 
   /* make sure any buffers set on the view get the color scheme applied to them */
@@ -257,10 +379,6 @@ mousepad_view_init (MousepadView *view)
                     G_CALLBACK (mousepad_view_buffer_changed),
                     NULL);
 
-  /* reset drag coordinates */
-  view->selection_start_x = view->selection_end_x = -1;
-  view->selection_start_y = view->selection_end_y = -1;
-
   /* bind Gsettings */
 #define BIND_(setting, prop) \
   MOUSEPAD_SETTING_BIND (setting, view, prop, G_SETTINGS_BIND_DEFAULT)
@@ -282,6 +400,7 @@ mousepad_view_init (MousepadView *view)
   BIND_ (COLOR_SCHEME,           "color-scheme");
   BIND_ (WORD_WRAP,              "word-wrap");
   BIND_ (MATCH_BRACES,           "match-braces");
+  BIND_ (SPLIT_LONG_LINES,       "split-long-lines");
 
   /* override with default font when the setting is enabled */
   MOUSEPAD_SETTING_CONNECT_OBJECT (USE_DEFAULT_FONT,
@@ -299,13 +418,8 @@ mousepad_view_finalize (GObject *object)
 {
   MousepadView *view = MOUSEPAD_VIEW (object);
 
-  /* stop a running selection timeout */
-  if (G_UNLIKELY (view->selection_timeout_id != 0))
-    g_source_remove (view->selection_timeout_id);
-
-  /* free the selection marks list (marks are owned by the buffer) */
-  if (G_UNLIKELY (view->selection_marks != NULL))
-    g_slist_free (view->selection_marks);
+  /* free the carets array (marks are owned by the buffer) */
+  g_array_free (view->carets, TRUE);
 
   /* cleanup color scheme name */
   g_free (view->color_scheme);
@@ -346,6 +460,13 @@ mousepad_view_set_property (GObject      *object,
     case PROP_MATCH_BRACES:
       mousepad_view_set_match_braces (view, g_value_get_boolean (value));
       break;
+    case PROP_LONG_LINES:
+      mousepad_view_set_long_lines (view, g_value_get_boolean (value));
+      break;
+    case PROP_SPLIT_LONG_LINES:
+      view->split_long_lines = g_value_get_boolean (value);
+      mousepad_view_update_wrap_mode (view);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -385,6 +506,15 @@ mousepad_view_get_property (GObject    *object,
     case PROP_MATCH_BRACES:
       g_value_set_boolean (value, mousepad_view_get_match_braces (view));
       break;
+    case PROP_COLUMN_SELECTION:
+      g_value_set_boolean (value, view->column_anchor_line != -1);
+      break;
+    case PROP_LONG_LINES:
+      g_value_set_boolean (value, mousepad_view_get_long_lines (view));
+      break;
+    case PROP_SPLIT_LONG_LINES:
+      g_value_set_boolean (value, view->split_long_lines);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -402,7 +532,6 @@ mousepad_view_key_press_event (GtkWidget   *widget,
   GtkTextIter    iter;
   GtkTextMark   *cursor;
   guint          modifiers;
-  gboolean       is_editable;
 
   /* get the modifiers state */
   modifiers = event->state & gtk_accelerator_get_default_mod_mask ();
@@ -410,8 +539,13 @@ mousepad_view_key_press_event (GtkWidget   *widget,
   /* get the textview buffer */
   buffer = mousepad_view_get_buffer (view);
 
-  /* whether the textview is editable */
-  is_editable = gtk_text_view_get_editable(GTK_TEXT_VIEW (view));
+  /* the column selection goes first, it may hand over to the extra carets */
+  if (view->column_anchor_line != -1 && mousepad_view_column_key_press (view, event, modifiers))
+    return TRUE;
+
+  /* let the extra carets take the keys they handle */
+  if (view->carets->len > 0 && mousepad_view_carets_key_press (view, event, modifiers))
+    return TRUE;
 
   /* handle the key event */
   switch (event->keyval)
@@ -467,17 +601,6 @@ mousepad_view_key_press_event (GtkWidget   *widget,
           }
         break;
 
-      case GDK_KEY_Delete:
-      case GDK_KEY_KP_Delete:
-        if (view->selection_marks != NULL && is_editable)
-          {
-            /* delete or destroy the selection */
-            if (view->selection_length > 0)
-              mousepad_view_delete_selection (view);
-            return TRUE;
-          }
-        break;
-
       default:
         break;
     }
@@ -487,322 +610,1717 @@ mousepad_view_key_press_event (GtkWidget   *widget,
 
 
 
-/**
- * Indentation Functions
- **/
-static void
-mousepad_view_indent_increase (MousepadView *view,
-                               GtkTextIter  *iter)
+static gboolean
+mousepad_view_button_press_event (GtkWidget      *widget,
+                                  GdkEventButton *event)
 {
-  gchar         *string;
-  gint           offset, length, inline_len, tab_size;
-  GtkTextBuffer *buffer;
-
-  /* get the buffer */
-  buffer = mousepad_view_get_buffer (view);
-  tab_size = gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (view));
+  MousepadView *view = MOUSEPAD_VIEW (widget);
+  gint          line, column;
 
-  if (gtk_source_view_get_insert_spaces_instead_of_tabs (GTK_SOURCE_VIEW (view)))
+  if (event->type == GDK_BUTTON_PRESS && event->button == 1)
     {
-      /* get the offset */
-      offset = mousepad_util_get_real_line_offset (iter, tab_size);
+      /* a click puts the single caret back */
+      mousepad_view_clear_carets (view);
+      mousepad_view_column_clear (view);
 
-      /* calculate the length to inline with a tab */
-      inline_len = offset % tab_size;
+      /* dragging with control held selects a column */
+      if ((event->state & gtk_accelerator_get_default_mod_mask ()) == GDK_CONTROL_MASK
+          && event->window == gtk_text_view_get_window (GTK_TEXT_VIEW (view), GTK_TEXT_WINDOW_TEXT))
+        {
+          gtk_widget_grab_focus (widget);
+          mousepad_view_column_at_location (view, event->x, event->y, &line, &column);
+          view->column_dragging = TRUE;
+          mousepad_view_column_set (view, line, column, line, column);
 
-      if (inline_len == 0)
-        length = tab_size;
-      else
-        length = tab_size - inline_len;
+          return TRUE;
+        }
+    }
 
-      /* create spaces string */
-      string = g_strnfill (length, ' ');
+  return (*GTK_WIDGET_CLASS (mousepad_view_parent_class)->button_press_event) (widget, event);
+}
 
-      /* insert string */
-      gtk_text_buffer_insert (buffer, iter, string, length);
 
-      /* cleanup */
-      g_free (string);
-    }
-  else
+
+static gboolean
+mousepad_view_button_release_event (GtkWidget      *widget,
+                                    GdkEventButton *event)
+{
+  MousepadView *view = MOUSEPAD_VIEW (widget);
+
+  if (view->column_dragging && event->button == 1)
     {
-      /* insert a tab or a space */
-      gtk_text_buffer_insert (buffer, iter, "\t", -1);
+      view->column_dragging = FALSE;
+      return TRUE;
     }
+
+  return (*GTK_WIDGET_CLASS (mousepad_view_parent_class)->button_release_event) (widget, event);
 }
 
 
 
-static void
-mousepad_view_indent_decrease (MousepadView *view,
-                               GtkTextIter  *iter)
+static gboolean
+mousepad_view_motion_notify_event (GtkWidget      *widget,
+                                   GdkEventMotion *event)
 {
-  GtkTextBuffer *buffer;
-  GtkTextIter    start, end;
-  gint           columns, tab_size;
-  gunichar       c;
+  MousepadView *view = MOUSEPAD_VIEW (widget);
+  gint          line, column;
 
-  /* set iters */
-  start = end = *iter;
+  if (view->column_dragging)
+    {
+      mousepad_view_column_at_location (view, event->x, event->y, &line, &column);
+      if (line != view->column_head_line || column != view->column_head)
+        mousepad_view_column_set (view, view->column_anchor_line, view->column_anchor, line, column);
 
-  tab_size = gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (view));
-  columns = tab_size;
+      return TRUE;
+    }
 
-  /* walk until we've removed enough columns */
-  while (columns > 0)
-    {
-      /* get the character */
-      c = gtk_text_iter_get_char (&end);
+  return (*GTK_WIDGET_CLASS (mousepad_view_parent_class)->motion_notify_event) (widget, event);
+}
 
-      if (c == '\t')
-        columns -= tab_size;
-      else if (c == ' ')
-        columns--;
-      else
-        break;
 
-      /* go to the next character */
-      gtk_text_iter_forward_char (&end);
-    }
 
-  /* unindent the selection when the iters are not equal */
-  if (!gtk_text_iter_equal (&start, &end))
-    {
-      /* get the buffer */
-      buffer = mousepad_view_get_buffer (view);
+/**
+ * Multiple Carets
+ **/
+static gint
+mousepad_view_mark_get_offset (GtkTextBuffer *buffer,
+                               GtkTextMark   *mark)
+{
+  GtkTextIter iter;
 
-      /* remove the columns */
-      gtk_text_buffer_delete (buffer, &start, &end);
-    }
+  gtk_text_buffer_get_iter_at_mark (buffer, &iter, mark);
+
+  return gtk_text_iter_get_offset (&iter);
 }
 
 
 
-static void
-mousepad_view_indent_selection (MousepadView *view,
-                                gboolean      increase,
-                                gboolean      force)
+/* index of the first extra caret at or after offset */
+static guint
+mousepad_view_carets_lookup (MousepadView *view,
+                             gint          offset)
 {
   GtkTextBuffer *buffer;
-  GtkTextIter    start_iter, end_iter;
-  gint           start_line, end_line;
-  gint           i;
+  guint          lower = 0, upper = view->carets->len, middle;
 
-  /* get the textview buffer */
   buffer = mousepad_view_get_buffer (view);
 
-  if (gtk_text_buffer_get_selection_bounds (buffer, &start_iter, &end_iter) || force)
+  while (lower < upper)
     {
-      /* begin a user action */
-      gtk_text_buffer_begin_user_action (buffer);
-
-      /* get start and end line */
-      start_line = gtk_text_iter_get_line (&start_iter);
-      end_line = gtk_text_iter_get_line (&end_iter);
+      middle = (lower + upper) / 2;
+      if (mousepad_view_mark_get_offset (buffer, g_array_index (view->carets, MousepadCaret, middle).insert) < offset)
+        lower = middle + 1;
+      else
+        upper = middle;
+    }
 
-      /* only change indentation when an entire line is selected or multiple lines */
-      if (start_line != end_line
-          || ((gtk_text_iter_starts_line (&start_iter) && gtk_text_iter_ends_line (&end_iter)) || force))
-        {
-          /* change indentation of each line */
-          for (i = start_line; i <= end_line && i < G_MAXINT; i++)
-            {
-              /* get the iter of the line we're going to indent */
-              gtk_text_buffer_get_iter_at_line (buffer, &start_iter, i);
+  return lower;
+}
 
-              /* don't change indentation of empty lines */
-              if (gtk_text_iter_ends_line (&start_iter))
-                continue;
 
-              /* increase or decrease the indentation */
-              if (increase)
-                mousepad_view_indent_increase (view, &start_iter);
-              else
-                mousepad_view_indent_decrease (view, &start_iter);
-            }
-        }
 
-      /* end user action */
-      gtk_text_buffer_end_user_action (buffer);
+static gboolean
+mousepad_view_carets_add (MousepadView      *view,
+                          const GtkTextIter *insert,
+                          const GtkTextIter *bound)
+{
+  GtkTextBuffer     *buffer;
+  MousepadCaret      caret;
+  const GtkTextIter *iter;
+  gint               offset, bound_offset, primary, primary_bound;
+  guint              index;
 
-      /* put cursor on screen */
-      mousepad_view_scroll_to_cursor (view);
+  buffer = mousepad_view_get_buffer (view);
+  offset = gtk_text_iter_get_offset (insert);
+  bound_offset = gtk_text_iter_get_offset (bound);
+  primary = mousepad_view_mark_get_offset (buffer, gtk_text_buffer_get_insert (buffer));
+  primary_bound = mousepad_view_mark_get_offset (buffer, gtk_text_buffer_get_selection_bound (buffer));
+
+  /* don't add one for the selection of the primary caret */
+  if (MIN (offset, bound_offset) == MIN (primary, primary_bound)
+      && MAX (offset, bound_offset) == MAX (primary, primary_bound))
+    return FALSE;
+
+  /* a selection touching the one of the primary caret gets its caret at its other end,
+   * and carets don't stack */
+  if (offset == primary)
+    {
+      iter = insert;
+      insert = bound;
+      bound = iter;
+      offset = bound_offset;
+      if (offset == primary)
+        return FALSE;
     }
+
+  index = mousepad_view_carets_lookup (view, offset);
+  if (index < view->carets->len
+      && offset == mousepad_view_mark_get_offset (buffer, g_array_index (view->carets, MousepadCaret, index).insert))
+    return FALSE;
+
+  caret.insert = gtk_text_buffer_create_mark (buffer, NULL, insert, FALSE);
+  caret.bound = gtk_text_buffer_create_mark (buffer, NULL, bound, FALSE);
+  g_array_insert_val (view->carets, index, caret);
+
+  return TRUE;
 }
 
 
-void
-mousepad_view_scroll_to_cursor (MousepadView *view)
+
+/* all the carets in document order, the primary one included */
+static GArray *
+mousepad_view_carets_get_all (MousepadView *view)
 {
   GtkTextBuffer *buffer;
+  GArray        *carets;
+  MousepadCaret  primary;
+  guint          index;
 
-  g_return_if_fail (MOUSEPAD_IS_VIEW (view));
-
-  /* get the buffer */
   buffer = mousepad_view_get_buffer (view);
+  primary.insert = gtk_text_buffer_get_insert (buffer);
+  primary.bound = gtk_text_buffer_get_selection_bound (buffer);
+  index = mousepad_view_carets_lookup (view, mousepad_view_mark_get_offset (buffer, primary.insert));
 
-  /* scroll to visible area */
-  gtk_text_view_scroll_to_mark (GTK_TEXT_VIEW (view),
-                                gtk_text_buffer_get_insert (buffer),
-                                0.02, FALSE, 0.0, 0.0);
+  carets = g_array_sized_new (FALSE, FALSE, sizeof (MousepadCaret), view->carets->len + 1);
+  g_array_append_vals (carets, view->carets->data, index);
+  g_array_append_val (carets, primary);
+  g_array_append_vals (carets, &g_array_index (view->carets, MousepadCaret, index),
+                       view->carets->len - index);
+
+  return carets;
 }
 
 
 
 static void
-mousepad_view_transpose_range (GtkTextBuffer *buffer,
-                               GtkTextIter   *start_iter,
-                               GtkTextIter   *end_iter)
+mousepad_view_carets_update (MousepadView *view)
 {
-  gchar *string, *reversed;
-  gint   offset;
+  GtkTextBuffer   *buffer;
+  GtkStyleContext *context;
+  MousepadCaret   *caret;
+  GtkTextIter      start_iter, end_iter;
+  GdkRGBA          background, foreground;
+  gint             offset, previous, primary;
+  guint            i, n;
 
-  /* store start iter line offset */
-  offset = gtk_text_iter_get_offset (start_iter);
+  buffer = mousepad_view_get_buffer (view);
+  primary = mousepad_view_mark_get_offset (buffer, gtk_text_buffer_get_insert (buffer));
 
-  /* get selected text */
-  string = gtk_text_buffer_get_slice (buffer, start_iter, end_iter, FALSE);
-  if (G_LIKELY (string))
+  /* drop the carets that ran into each other, marks never cross so the order holds */
+  for (i = n = 0, previous = -1; i < view->carets->len; i++)
     {
-      /* reverse the string */
-      reversed = g_utf8_strreverse (string, -1);
+      caret = &g_array_index (view->carets, MousepadCaret, i);
+      offset = mousepad_view_mark_get_offset (buffer, caret->insert);
 
-      /* only change the buffer then the string changed */
-      if (G_LIKELY (reversed && strcmp (reversed, string) != 0))
+      if (offset == previous || offset == primary)
         {
-          /* delete the text between the iters */
-          gtk_text_buffer_delete (buffer, start_iter, end_iter);
+          gtk_text_buffer_delete_mark (buffer, caret->insert);
+          gtk_text_buffer_delete_mark (buffer, caret->bound);
+        }
+      else
+        {
+          g_array_index (view->carets, MousepadCaret, n++) = *caret;
+          previous = offset;
+        }
+    }
 
-          /* insert the reversed string */
-          gtk_text_buffer_insert (buffer, end_iter, reversed, -1);
+  g_array_set_size (view->carets, n);
 
-          /* restore start iter */
-          gtk_text_buffer_get_iter_at_offset (buffer, start_iter, offset);
+  /* create the tag for the selections of the extra carets */
+  if (view->selection_tag == NULL && n > 0)
+    {
+      context = gtk_widget_get_style_context (GTK_WIDGET (view));
+      if (! gtk_style_context_lookup_color (context, "theme_selected_bg_color", &background))
+        gdk_rgba_parse (&background, "#4a90d9");
+      if (! gtk_style_context_lookup_color (context, "theme_selected_fg_color", &foreground))
+        gdk_rgba_parse (&foreground, "#ffffff");
+
+      view->selection_tag = gtk_text_buffer_create_tag (buffer, NULL,
+                                                        "background-rgba", &background,
+                                                        "foreground-rgba", &foreground,
+                                                        NULL);
+    }
+
+  /* show the selections of the extra carets, removing the tag only where it was */
+  if (view->selection_tag != NULL)
+    {
+      gtk_text_buffer_get_start_iter (buffer, &start_iter);
+      if (! gtk_text_iter_has_tag (&start_iter, view->selection_tag))
+        gtk_text_iter_forward_to_tag_toggle (&start_iter, view->selection_tag);
+
+      while (! gtk_text_iter_is_end (&start_iter))
+        {
+          end_iter = start_iter;
+          gtk_text_iter_forward_to_tag_toggle (&end_iter, view->selection_tag);
+          gtk_text_buffer_remove_tag (buffer, view->selection_tag, &start_iter, &end_iter);
+
+          start_iter = end_iter;
+          gtk_text_iter_forward_to_tag_toggle (&start_iter, view->selection_tag);
         }
 
-      /* cleanup */
-      g_free (string);
-      g_free (reversed);
+      for (i = 0; i < n; i++)
+        {
+          caret = &g_array_index (view->carets, MousepadCaret, i);
+          gtk_text_buffer_get_iter_at_mark (buffer, &start_iter, caret->bound);
+          gtk_text_buffer_get_iter_at_mark (buffer, &end_iter, caret->insert);
+          if (! gtk_text_iter_equal (&start_iter, &end_iter))
+            gtk_text_buffer_apply_tag (buffer, view->selection_tag, &start_iter, &end_iter);
+        }
     }
+
+  /* redraw the carets */
+  gtk_widget_queue_draw (GTK_WIDGET (view));
 }
 
 
 
 static void
-mousepad_view_transpose_lines (GtkTextBuffer *buffer,
-                               GtkTextIter   *start_iter,
-                               GtkTextIter   *end_iter)
+mousepad_view_carets_edit (MousepadView *view,
+                           gint          type,
+                           const gchar  *text)
 {
-  GString *string;
-  gint     start_line, end_line;
-  gint     i;
-  gchar   *slice;
+  GtkTextBuffer  *buffer;
+  MousepadCaret  *caret;
+  GtkTextIter     start_iter, end_iter;
+  GArray         *carets;
+  gchar         **pieces = NULL;
+  guint           n;
 
-  /* make sure the order is ok */
-  gtk_text_iter_order (start_iter, end_iter);
+  buffer = mousepad_view_get_buffer (view);
+  carets = mousepad_view_carets_get_all (view);
 
-  /* get the line numbers */
-  start_line = gtk_text_iter_get_line (start_iter);
-  end_line = gtk_text_iter_get_line (end_iter);
+  /* a text with a line per caret is spread over the carets */
+  if (type == CARETS_INSERT && strchr (text, '\n') != NULL)
+    {
+      pieces = g_strsplit (text, "\n", -1);
+      if (g_strv_length (pieces) != carets->len)
+        {
+          g_strfreev (pieces);
+          pieces = NULL;
+        }
+    }
 
-  /* new string */
-  string = g_string_new (NULL);
+  /* one user action for all the carets, with notifications held until the end */
+  g_object_freeze_notify (G_OBJECT (buffer));
+  gtk_text_buffer_begin_user_action (buffer);
 
-  /* add the lines in reversed order to the string */
-  for (i = start_line; i <= end_line && i < G_MAXINT; i++)
+  /* edit from the last caret, so the edits don't move the carets still to visit */
+  for (n = carets->len; n > 0; n--)
     {
-      /* get start iter */
-      gtk_text_buffer_get_iter_at_line (buffer, start_iter, i);
+      caret = &g_array_index (carets, MousepadCaret, n - 1);
+      gtk_text_buffer_get_iter_at_mark (buffer, &start_iter, caret->bound);
+      gtk_text_buffer_get_iter_at_mark (buffer, &end_iter, caret->insert);
+      gtk_text_iter_order (&start_iter, &end_iter);
 
-      /* set end iter */
-      *end_iter = *start_iter;
+      /* every edit replaces the selection, otherwise delete a char around the caret */
+      if (! gtk_text_iter_equal (&start_iter, &end_iter))
+        gtk_text_buffer_delete (buffer, &start_iter, &end_iter);
+      else if (type == CARETS_BACKSPACE && gtk_text_iter_backward_cursor_position (&start_iter))
+        gtk_text_buffer_delete (buffer, &start_iter, &end_iter);
+      else if (type == CARETS_DELETE && gtk_text_iter_forward_cursor_position (&end_iter))
+        gtk_text_buffer_delete (buffer, &start_iter, &end_iter);
 
-      /* only prepend when the iters won't be equal */
-      if (!gtk_text_iter_ends_line (end_iter))
+      if (type == CARETS_INSERT)
         {
-          /* move the iter to the end of this line */
-          gtk_text_iter_forward_to_line_end (end_iter);
-
-          /* prepend line */
-          slice = gtk_text_buffer_get_slice (buffer, start_iter, end_iter, FALSE);
-          string = g_string_prepend (string, slice);
-          g_free (slice);
+          gtk_text_buffer_get_iter_at_mark (buffer, &start_iter, caret->insert);
+          gtk_text_buffer_insert (buffer, &start_iter, pieces != NULL ? pieces[n - 1] : text, -1);
         }
 
-      /* prepend new line */
-      if (i < end_line)
-        string = g_string_prepend_c (string, '\n');
+      /* collapse the selection on the caret */
+      gtk_text_buffer_get_iter_at_mark (buffer, &start_iter, caret->insert);
+      gtk_text_buffer_move_mark (buffer, caret->bound, &start_iter);
     }
 
-  /* get start iter again */
-  gtk_text_buffer_get_iter_at_line (buffer, start_iter, start_line);
+  gtk_text_buffer_end_user_action (buffer);
+  g_object_thaw_notify (G_OBJECT (buffer));
 
-  /* delete selection */
-  gtk_text_buffer_delete (buffer, start_iter, end_iter);
+  g_array_free (carets, TRUE);
+  g_strfreev (pieces);
 
-  /* insert reversed lines */
-  gtk_text_buffer_insert (buffer, end_iter, string->str, string->len);
+  mousepad_view_carets_update (view);
+  mousepad_view_scroll_to_cursor (view);
+}
 
-  /* cleanup */
-  g_string_free (string, TRUE);
 
-  /* restore start iter */
-  gtk_text_buffer_get_iter_at_line (buffer, start_iter, start_line);
-}
 
 static void
-mousepad_view_transpose_words (GtkTextBuffer *buffer,
-                               GtkTextIter   *iter)
+mousepad_view_carets_move (MousepadView *view,
+                           guint         keyval,
+                           gboolean      extend)
 {
-  GtkTextMark *left_mark, *right_mark;
-  GtkTextIter  start_left, end_left, start_right, end_right;
-  gchar       *word_left, *word_right;
-  gboolean     restore_cursor;
+  GtkTextBuffer *buffer;
+  MousepadCaret *caret;
+  GtkTextIter    iter, line_end;
+  GArray        *carets;
+  gint           line, offset;
+  guint          n;
 
-  /* left word end */
-  end_left = *iter;
-  if (!mousepad_util_iter_backward_text_start (&end_left))
-    return;
+  buffer = mousepad_view_get_buffer (view);
+  carets = mousepad_view_carets_get_all (view);
 
-  /* left word start */
-  start_left = end_left;
-  if (!mousepad_util_iter_backward_word_start (&start_left))
-    return;
+  /* moves are monotonic, so the carets stay sorted */
+  for (n = 0; n < carets->len; n++)
+    {
+      caret = &g_array_index (carets, MousepadCaret, n);
+      gtk_text_buffer_get_iter_at_mark (buffer, &iter, caret->insert);
 
-  /* right word start */
-  start_right = *iter;
-  if (!mousepad_util_iter_forward_text_start (&start_right))
-    return;
+      switch (keyval)
+        {
+          case GDK_KEY_Left:
+          case GDK_KEY_KP_Left:
+            gtk_text_iter_backward_cursor_position (&iter);
+            break;
 
-  /* right word end */
-  end_right = start_right;
-  if (!mousepad_util_iter_forward_word_end (&end_right))
-    return;
+          case GDK_KEY_Right:
+          case GDK_KEY_KP_Right:
+            gtk_text_iter_forward_cursor_position (&iter);
+            break;
 
-  /* check if we selected something usefull */
-  if (gtk_text_iter_get_line (&start_left) == gtk_text_iter_get_line (&end_right)
-      && !gtk_text_iter_equal (&start_left, &end_left)
-      && !gtk_text_iter_equal (&start_right, &end_right)
-      && !gtk_text_iter_equal (&end_left, &start_right))
-    {
-      /* get the words */
-      word_left = gtk_text_buffer_get_slice (buffer, &start_left, &end_left, FALSE);
-      word_right = gtk_text_buffer_get_slice (buffer, &start_right, &end_right, FALSE);
+          case GDK_KEY_Home:
+          case GDK_KEY_KP_Home:
+            gtk_text_iter_set_line_offset (&iter, 0);
+            break;
 
-      /* check if we need to restore the cursor afterwards */
-      restore_cursor = gtk_text_iter_equal (iter, &start_right);
+          case GDK_KEY_End:
+          case GDK_KEY_KP_End:
+            if (! gtk_text_iter_ends_line (&iter))
+              gtk_text_iter_forward_to_line_end (&iter);
+            break;
 
-      /* insert marks at the start and end of the right word */
-      left_mark = gtk_text_buffer_create_mark (buffer, NULL, &start_right, TRUE);
-      right_mark = gtk_text_buffer_create_mark (buffer, NULL, &end_right, FALSE);
+          default:
+            /* up or down, keeping the line offset where the line is long enough */
+            line = gtk_text_iter_get_line (&iter);
+            line += (keyval == GDK_KEY_Up || keyval == GDK_KEY_KP_Up) ? -1 : 1;
+            if (line < 0 || line >= gtk_text_buffer_get_line_count (buffer))
+              break;
+
+            offset = gtk_text_iter_get_line_offset (&iter);
+            gtk_text_buffer_get_iter_at_line (buffer, &iter, line);
+            line_end = iter;
+            if (! gtk_text_iter_ends_line (&line_end))
+              gtk_text_iter_forward_to_line_end (&line_end);
+
+            if (offset < gtk_text_iter_get_line_offset (&line_end))
+              gtk_text_iter_set_line_offset (&iter, offset);
+            else
+              iter = line_end;
+            break;
+        }
 
-      /* delete the left word and insert the right word there */
-      gtk_text_buffer_delete (buffer, &start_left, &end_left);
-      gtk_text_buffer_insert (buffer, &start_left, word_right, -1);
-      g_free (word_right);
+      gtk_text_buffer_move_mark (buffer, caret->insert, &iter);
+      if (! extend)
+        gtk_text_buffer_move_mark (buffer, caret->bound, &iter);
+    }
 
-      /* restore the right word iters */
-      gtk_text_buffer_get_iter_at_mark (buffer, &start_right, left_mark);
+  g_array_free (carets, TRUE);
+
+  mousepad_view_carets_update (view);
+  mousepad_view_scroll_to_cursor (view);
+}
+
+
+
+static gboolean
+mousepad_view_carets_key_press (MousepadView *view,
+                                GdkEventKey  *event,
+                                guint         modifiers)
+{
+  gunichar c;
+  gchar    buf[8], *text;
+  gboolean is_editable;
+
+  is_editable = gtk_text_view_get_editable (GTK_TEXT_VIEW (view));
+
+  switch (event->keyval)
+    {
+      case GDK_KEY_Escape:
+        mousepad_view_clear_carets (view);
+        return TRUE;
+
+      case GDK_KEY_Left:
+      case GDK_KEY_KP_Left:
+      case GDK_KEY_Right:
+      case GDK_KEY_KP_Right:
+      case GDK_KEY_Up:
+      case GDK_KEY_KP_Up:
+      case GDK_KEY_Down:
+      case GDK_KEY_KP_Down:
+      case GDK_KEY_Home:
+      case GDK_KEY_KP_Home:
+      case GDK_KEY_End:
+      case GDK_KEY_KP_End:
+        /* other moves (by word, page...) go back to a single caret */
+        if ((modifiers & ~GDK_SHIFT_MASK) != 0)
+          break;
+
+        mousepad_view_carets_move (view, event->keyval, (modifiers & GDK_SHIFT_MASK) != 0);
+        return TRUE;
+
+      case GDK_KEY_BackSpace:
+        if (is_editable)
+          mousepad_view_carets_edit (view, CARETS_BACKSPACE, NULL);
+        return TRUE;
+
+      case GDK_KEY_Delete:
+      case GDK_KEY_KP_Delete:
+        if (is_editable)
+          mousepad_view_carets_edit (view, CARETS_DELETE, NULL);
+        return TRUE;
+
+      case GDK_KEY_Return:
+      case GDK_KEY_KP_Enter:
+      case GDK_KEY_ISO_Enter:
+        if (is_editable)
+          mousepad_view_carets_edit (view, CARETS_INSERT, "\n");
+        return TRUE;
+
+      case GDK_KEY_Tab:
+      case GDK_KEY_KP_Tab:
+        if (is_editable)
+          {
+            if (gtk_source_view_get_insert_spaces_instead_of_tabs (GTK_SOURCE_VIEW (view)))
+              text = g_strnfill (gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (view)), ' ');
+            else
+              text = g_strdup ("\t");
+
+            mousepad_view_carets_edit (view, CARETS_INSERT, text);
+            g_free (text);
+          }
+        return TRUE;
+
+      default:
+        /* plain characters are typed at every caret, shortcuts are left to the window */
+        if ((modifiers & (GDK_CONTROL_MASK | GDK_MOD1_MASK)) != 0)
+          return FALSE;
+
+        c = gdk_keyval_to_unicode (event->keyval);
+        if (c == 0 || ! g_unichar_isprint (c))
+          return FALSE;
+
+        if (is_editable)
+          {
+            buf[g_unichar_to_utf8 (c, buf)] = '\0';
+            mousepad_view_carets_edit (view, CARETS_INSERT, buf);
+          }
+        return TRUE;
+    }
+
+  /* the key is not for the carets, back to a single caret */
+  mousepad_view_clear_carets (view);
+
+  return FALSE;
+}
+
+
+
+static void
+mousepad_view_draw_layer (GtkTextView      *text_view,
+                          GtkTextViewLayer  layer,
+                          cairo_t          *cr)
+{
+  MousepadView    *view = MOUSEPAD_VIEW (text_view);
+  GtkTextBuffer   *buffer;
+  GtkStyleContext *context;
+  GtkTextIter      iter, end_iter;
+  GdkRectangle     visible, location;
+  GdkRGBA          color;
+  guint            n;
+
+  (*GTK_TEXT_VIEW_CLASS (mousepad_view_parent_class)->draw_layer) (text_view, layer, cr);
+
+  if (layer == GTK_TEXT_VIEW_LAYER_BELOW_TEXT && view->column_anchor_line != -1)
+    mousepad_view_column_draw (view, cr);
+
+  if (layer != GTK_TEXT_VIEW_LAYER_ABOVE_TEXT || view->carets->len == 0)
+    return;
+
+  buffer = mousepad_view_get_buffer (view);
+
+  /* only look at the carets in the visible lines, the cairo context uses buffer coordinates */
+  gtk_text_view_get_visible_rect (text_view, &visible);
+  gtk_text_view_get_line_at_y (text_view, &iter, visible.y, NULL);
+  gtk_text_view_get_line_at_y (text_view, &end_iter, visible.y + visible.height, NULL);
+  if (! gtk_text_iter_ends_line (&end_iter))
+    gtk_text_iter_forward_to_line_end (&end_iter);
+
+  context = gtk_widget_get_style_context (GTK_WIDGET (view));
+  gtk_style_context_get_color (context, gtk_widget_get_state_flags (GTK_WIDGET (view)), &color);
+  gdk_cairo_set_source_rgba (cr, &color);
+
+  for (n = mousepad_view_carets_lookup (view, gtk_text_iter_get_offset (&iter)); n < view->carets->len; n++)
+    {
+      gtk_text_buffer_get_iter_at_mark (buffer, &iter, g_array_index (view->carets, MousepadCaret, n).insert);
+      if (gtk_text_iter_compare (&iter, &end_iter) > 0)
+        break;
+
+      gtk_text_view_get_cursor_locations (text_view, &iter, &location, NULL);
+      cairo_rectangle (cr, location.x, location.y, 1, location.height);
+    }
+
+  cairo_fill (cr);
+}
+
+
+
+/* make sure the primary caret has a selection, selecting the word under it if needed */
+static gchar *
+mousepad_view_carets_get_needle (MousepadView *view)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter    start_iter, end_iter;
+
+  buffer = mousepad_view_get_buffer (view);
+
+  if (! gtk_text_buffer_get_selection_bounds (buffer, &start_iter, &end_iter))
+    {
+      if (! mousepad_util_iter_inside_word (&start_iter)
+          && ! mousepad_util_iter_ends_word (&start_iter))
+        return NULL;
+
+      if (! mousepad_util_iter_starts_word (&start_iter))
+        mousepad_util_iter_backward_word_start (&start_iter);
+      if (! mousepad_util_iter_ends_word (&end_iter))
+        mousepad_util_iter_forward_word_end (&end_iter);
+
+      gtk_text_buffer_select_range (buffer, &end_iter, &start_iter);
+    }
+
+  return gtk_text_buffer_get_slice (buffer, &start_iter, &end_iter, TRUE);
+}
+
+
+
+void
+mousepad_view_add_next_occurrence (MousepadView *view)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter    iter, match_start, match_end;
+  gboolean       had_selection, found;
+  gchar         *needle;
+
+  g_return_if_fail (MOUSEPAD_IS_VIEW (view));
+
+  buffer = mousepad_view_get_buffer (view);
+
+  /* the first time only the word under the caret is selected */
+  had_selection = gtk_text_buffer_get_has_selection (buffer);
+  needle = mousepad_view_carets_get_needle (view);
+  if (needle == NULL || ! had_selection)
+    {
+      g_free (needle);
+      return;
+    }
+
+  /* resume the search after the last occurrence added */
+  if (view->carets->len == 0 || view->occurrence_mark == NULL)
+    {
+      gtk_text_buffer_get_selection_bounds (buffer, NULL, &iter);
+      if (view->occurrence_mark == NULL)
+        view->occurrence_mark = gtk_text_buffer_create_mark (buffer, NULL, &iter, FALSE);
+      else
+        gtk_text_buffer_move_mark (buffer, view->occurrence_mark, &iter);
+    }
+  else
+    gtk_text_buffer_get_iter_at_mark (buffer, &iter, view->occurrence_mark);
+
+  /* search forward, wrapping around once */
+  found = gtk_text_iter_forward_search (&iter, needle, GTK_TEXT_SEARCH_TEXT_ONLY,
+                                        &match_start, &match_end, NULL);
+  if (! found)
+    {
+      gtk_text_buffer_get_start_iter (buffer, &iter);
+      found = gtk_text_iter_forward_search (&iter, needle, GTK_TEXT_SEARCH_TEXT_ONLY,
+                                            &match_start, &match_end, NULL);
+    }
+
+  /* coming back to an occurrence that has a caret means they all have one */
+  if (found && mousepad_view_carets_add (view, &match_end, &match_start))
+    {
+      gtk_text_buffer_move_mark (buffer, view->occurrence_mark, &match_end);
+      gtk_text_view_scroll_to_iter (GTK_TEXT_VIEW (view), &match_end, 0.02, FALSE, 0.0, 0.0);
+      mousepad_view_carets_update (view);
+    }
+
+  g_free (needle);
+}
+
+
+
+void
+mousepad_view_select_all_occurrences (MousepadView *view)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter    start_iter, end_iter;
+  const gchar   *p, *match;
+  gchar         *needle, *text;
+  gint           offset, needle_chars;
+  gsize          needle_len;
+
+  g_return_if_fail (MOUSEPAD_IS_VIEW (view));
+
+  buffer = mousepad_view_get_buffer (view);
+
+  needle = mousepad_view_carets_get_needle (view);
+  if (needle == NULL || *needle == '\0')
+    {
+      g_free (needle);
+      return;
+    }
+
+  mousepad_view_clear_carets (view);
+
+  /* scan a snapshot of the buffer, carrying the char offset along */
+  needle_len = strlen (needle);
+  needle_chars = g_utf8_strlen (needle, needle_len);
+  gtk_text_buffer_get_bounds (buffer, &start_iter, &end_iter);
+  text = gtk_text_buffer_get_slice (buffer, &start_iter, &end_iter, TRUE);
+
+  for (p = text, offset = 0; (match = strstr (p, needle)) != NULL; p = match + needle_len)
+    {
+      offset += g_utf8_strlen (p, match - p);
+      gtk_text_buffer_get_iter_at_offset (buffer, &start_iter, offset);
+      offset += needle_chars;
+      gtk_text_buffer_get_iter_at_offset (buffer, &end_iter, offset);
+
+      /* the occurrence of the primary caret is refused here, the ones touching it are
+       * given their caret at their other end */
+      mousepad_view_carets_add (view, &end_iter, &start_iter);
+    }
+
+  g_free (text);
+  g_free (needle);
+
+  mousepad_view_carets_update (view);
+}
+
+
+
+void
+mousepad_view_add_carets_to_lines (MousepadView *view)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter    start_iter, end_iter, iter;
+  gint           line, last_line;
+
+  g_return_if_fail (MOUSEPAD_IS_VIEW (view));
+
+  buffer = mousepad_view_get_buffer (view);
+
+  if (! gtk_text_buffer_get_selection_bounds (buffer, &start_iter, &end_iter))
+    return;
+
+  /* a selection ending at the start of a line doesn't include that line */
+  last_line = gtk_text_iter_get_line (&end_iter);
+  if (gtk_text_iter_starts_line (&end_iter) && last_line > gtk_text_iter_get_line (&start_iter))
+    last_line--;
+
+  mousepad_view_clear_carets (view);
+
+  /* the primary caret goes to the end of the first line */
+  iter = start_iter;
+  if (! gtk_text_iter_ends_line (&iter))
+    gtk_text_iter_forward_to_line_end (&iter);
+  gtk_text_buffer_place_cursor (buffer, &iter);
+
+  for (line = gtk_text_iter_get_line (&start_iter) + 1; line <= last_line; line++)
+    {
+      gtk_text_buffer_get_iter_at_line (buffer, &iter, line);
+      if (! gtk_text_iter_ends_line (&iter))
+        gtk_text_iter_forward_to_line_end (&iter);
+
+      mousepad_view_carets_add (view, &iter, &iter);
+    }
+
+  mousepad_view_carets_update (view);
+}
+
+
+
+void
+mousepad_view_clear_carets (MousepadView *view)
+{
+  GtkTextBuffer *buffer;
+  MousepadCaret *caret;
+  guint          n;
+
+  g_return_if_fail (MOUSEPAD_IS_VIEW (view));
+
+  if (view->carets->len == 0)
+    return;
+
+  buffer = mousepad_view_get_buffer (view);
+
+  for (n = 0; n < view->carets->len; n++)
+    {
+      caret = &g_array_index (view->carets, MousepadCaret, n);
+      gtk_text_buffer_delete_mark (buffer, caret->insert);
+      gtk_text_buffer_delete_mark (buffer, caret->bound);
+    }
+
+  g_array_set_size (view->carets, 0);
+  mousepad_view_carets_update (view);
+}
+
+
+
+static gchar *
+mousepad_view_carets_get_text (MousepadView *view)
+{
+  GtkTextBuffer *buffer;
+  MousepadCaret *caret;
+  GtkTextIter    start_iter, end_iter;
+  GString       *string;
+  GArray        *carets;
+  gchar         *slice;
+  guint          n;
+
+  buffer = mousepad_view_get_buffer (view);
+  carets = mousepad_view_carets_get_all (view);
+  string = g_string_new (NULL);
+
+  /* the selections, a line each */
+  for (n = 0; n < carets->len; n++)
+    {
+      caret = &g_array_index (carets, MousepadCaret, n);
+      gtk_text_buffer_get_iter_at_mark (buffer, &start_iter, caret->bound);
+      gtk_text_buffer_get_iter_at_mark (buffer, &end_iter, caret->insert);
+      gtk_text_iter_order (&start_iter, &end_iter);
+
+      slice = gtk_text_buffer_get_slice (buffer, &start_iter, &end_iter, TRUE);
+      if (n > 0)
+        g_string_append_c (string, '\n');
+      g_string_append (string, slice);
+      g_free (slice);
+    }
+
+  g_array_free (carets, TRUE);
+
+  return g_string_free (string, FALSE);
+}
+
+
+
+/**
+ * Column Selection
+ **/
+static void
+mousepad_view_column_set (MousepadView *view,
+                          gint          anchor_line,
+                          gint          anchor,
+                          gint          head_line,
+                          gint          head)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter    iter;
+  gint           tab_size, column;
+
+  buffer = mousepad_view_get_buffer (view);
+
+  view->column_anchor_line = anchor_line;
+  view->column_anchor = anchor;
+  view->column_head_line = head_line;
+  view->column_head = head;
+
+  /* put the cursor at the head corner, or as close as the line allows */
+  tab_size = gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (view));
+  gtk_text_buffer_get_iter_at_line (buffer, &iter, head_line);
+  for (column = 0; column < head && ! gtk_text_iter_ends_line (&iter); gtk_text_iter_forward_char (&iter))
+    column += (gtk_text_iter_get_char (&iter) == '\t') ? tab_size - column % tab_size : 1;
+
+  gtk_text_buffer_place_cursor (buffer, &iter);
+  gtk_text_view_scroll_mark_onscreen (GTK_TEXT_VIEW (view), gtk_text_buffer_get_insert (buffer));
+
+  g_object_notify (G_OBJECT (view), "column-selection");
+  gtk_widget_queue_draw (GTK_WIDGET (view));
+}
+
+
+
+static void
+mousepad_view_column_clear (MousepadView *view)
+{
+  view->column_dragging = FALSE;
+
+  if (view->column_anchor_line == -1)
+    return;
+
+  view->column_anchor_line = -1;
+
+  g_object_notify (G_OBJECT (view), "column-selection");
+  gtk_widget_queue_draw (GTK_WIDGET (view));
+}
+
+
+
+static void
+mousepad_view_column_buffer_changed (GtkTextBuffer *buffer,
+                                     MousepadView  *view)
+{
+  /* undo, replace all and the like may have moved the lines, the column code
+   * keeps its selection valid itself (a buffer replaced on the view is ignored) */
+  if (view->column_anchor_line != -1 && ! view->column_editing
+      && gtk_text_view_get_buffer (GTK_TEXT_VIEW (view)) == buffer)
+    mousepad_view_column_clear (view);
+}
+
+
+
+static void
+mousepad_view_column_at_location (MousepadView *view,
+                                  gdouble       x,
+                                  gdouble       y,
+                                  gint         *line,
+                                  gint         *column)
+{
+  GtkTextView  *text_view = GTK_TEXT_VIEW (view);
+  GtkTextIter   iter;
+  GdkRectangle  location;
+  PangoLayout  *layout;
+  gint          buffer_x, buffer_y, trailing, width;
+
+  gtk_text_view_window_to_buffer_coords (text_view, GTK_TEXT_WINDOW_TEXT, x, y, &buffer_x, &buffer_y);
+
+  /* round to the nearest character boundary */
+  gtk_text_view_get_iter_at_position (text_view, &iter, &trailing, buffer_x, buffer_y);
+  if (trailing > 0 && ! gtk_text_iter_ends_line (&iter))
+    gtk_text_iter_forward_char (&iter);
+
+  *line = gtk_text_iter_get_line (&iter);
+  *column = mousepad_util_get_real_line_offset (&iter, gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (view)));
+
+  /* past the end of the line, count the columns in the empty space */
+  gtk_text_view_get_iter_location (text_view, &iter, &location);
+  if (gtk_text_iter_ends_line (&iter) && buffer_x > location.x)
+    {
+      layout = gtk_widget_create_pango_layout (GTK_WIDGET (view), " ");
+      pango_layout_get_pixel_size (layout, &width, NULL);
+      g_object_unref (layout);
+
+      if (width > 0)
+        *column += (buffer_x - location.x + width / 2) / width;
+    }
+}
+
+
+
+/* the span between two visual columns of every line between first_line
+ * and last_line, computed in a single walk over a snapshot of those lines */
+static GArray *
+mousepad_view_column_get_spans (MousepadView  *view,
+                                gint           first_line,
+                                gint           last_line,
+                                gint           start_column,
+                                gint           end_column,
+                                gchar        **text)
+{
+  GtkTextBuffer      *buffer;
+  GtkTextIter         start_iter, end_iter;
+  MousepadColumnSpan  span;
+  GArray             *spans;
+  const gchar        *p, *line_start;
+  gint                tab_size, column;
+
+  buffer = mousepad_view_get_buffer (view);
+  tab_size = gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (view));
+  spans = g_array_new (FALSE, FALSE, sizeof (MousepadColumnSpan));
+
+  /* lines may have gone since the selection was made */
+  last_line = MIN (last_line, gtk_text_buffer_get_line_count (buffer) - 1);
+  if (first_line > last_line)
+    {
+      *text = g_strdup ("");
+      return spans;
+    }
+
+  gtk_text_buffer_get_iter_at_line (buffer, &start_iter, first_line);
+  gtk_text_buffer_get_iter_at_line (buffer, &end_iter, last_line);
+  if (! gtk_text_iter_ends_line (&end_iter))
+    gtk_text_iter_forward_to_line_end (&end_iter);
+
+  *text = gtk_text_buffer_get_slice (buffer, &start_iter, &end_iter, TRUE);
+
+  for (p = *text, span.line = first_line; span.line <= last_line; span.line++)
+    {
+      line_start = p;
+      span.offset = p - *text;
+      span.start = -1;
+      span.missing = 0;
+
+      /* a character is in the span when its first column is */
+      for (column = 0; *p != '\0' && *p != '\n' && *p != '\r' && column < end_column; p = g_utf8_next_char (p))
+        {
+          if (span.start == -1 && column >= start_column)
+            span.start = p - line_start;
+
+          column += (*p == '\t') ? tab_size - column % tab_size : 1;
+        }
+
+      /* lines too short for the span get an empty one at their end */
+      span.end = p - line_start;
+      if (span.start == -1)
+        {
+          span.start = span.end;
+          span.missing = MAX (start_column - column, 0);
+        }
+
+      g_array_append_val (spans, span);
+
+      /* skip the rest of the line and its delimiter */
+      p += strcspn (p, "\r\n");
+      if (p[0] == '\r' && p[1] == '\n')
+        p++;
+      if (*p != '\0')
+        p++;
+    }
+
+  return spans;
+}
+
+
+
+static GArray *
+mousepad_view_column_get_all_spans (MousepadView  *view,
+                                    gchar        **text)
+{
+  return mousepad_view_column_get_spans (view,
+                                         MIN (view->column_anchor_line, view->column_head_line),
+                                         MAX (view->column_anchor_line, view->column_head_line),
+                                         MIN (view->column_anchor, view->column_head),
+                                         MAX (view->column_anchor, view->column_head),
+                                         text);
+}
+
+
+
+static gint
+mousepad_view_column_get_length (MousepadView *view)
+{
+  MousepadColumnSpan *span;
+  GArray             *spans;
+  gchar              *text;
+  gint                length = 0;
+  guint               n;
+
+  spans = mousepad_view_column_get_all_spans (view, &text);
+  for (n = 0; n < spans->len; n++)
+    {
+      span = &g_array_index (spans, MousepadColumnSpan, n);
+      length += g_utf8_strlen (text + span->offset + span->start, span->end - span->start);
+    }
+
+  g_array_free (spans, TRUE);
+  g_free (text);
+
+  return length;
+}
+
+
+
+static gchar *
+mousepad_view_column_get_text (MousepadView *view)
+{
+  MousepadColumnSpan *span;
+  GString            *string;
+  GArray             *spans;
+  gchar              *text;
+  guint               n;
+
+  spans = mousepad_view_column_get_all_spans (view, &text);
+  string = g_string_sized_new (strlen (text));
+
+  /* the spans, a line each */
+  for (n = 0; n < spans->len; n++)
+    {
+      span = &g_array_index (spans, MousepadColumnSpan, n);
+      if (n > 0)
+        g_string_append_c (string, '\n');
+      g_string_append_len (string, text + span->offset + span->start, span->end - span->start);
+    }
+
+  g_array_free (spans, TRUE);
+  g_free (text);
+
+  return g_string_free (string, FALSE);
+}
+
+
+
+static void
+mousepad_view_column_delete (MousepadView *view)
+{
+  GtkTextBuffer      *buffer;
+  MousepadColumnSpan *span;
+  GtkTextIter         start_iter, end_iter;
+  GArray             *spans;
+  gchar              *text;
+  gint                column;
+  guint               n;
+
+  buffer = mousepad_view_get_buffer (view);
+  spans = mousepad_view_column_get_all_spans (view, &text);
+
+  /* one user action, deleting from the last line so the line indexes stay valid */
+  view->column_editing = TRUE;
+  g_object_freeze_notify (G_OBJECT (buffer));
+  gtk_text_buffer_begin_user_action (buffer);
+
+  for (n = spans->len; n > 0; n--)
+    {
+      span = &g_array_index (spans, MousepadColumnSpan, n - 1);
+      if (span->start == span->end)
+        continue;
+
+      gtk_text_buffer_get_iter_at_line_index (buffer, &start_iter, span->line, span->start);
+      gtk_text_buffer_get_iter_at_line_index (buffer, &end_iter, span->line, span->end);
+      gtk_text_buffer_delete (buffer, &start_iter, &end_iter);
+    }
+
+  gtk_text_buffer_end_user_action (buffer);
+  g_object_thaw_notify (G_OBJECT (buffer));
+  view->column_editing = FALSE;
+
+  g_array_free (spans, TRUE);
+  g_free (text);
+
+  /* keep an empty column, typing goes on all its lines */
+  column = MIN (view->column_anchor, view->column_head);
+  mousepad_view_column_set (view, view->column_anchor_line, column, view->column_head_line, column);
+}
+
+
+
+static void
+mousepad_view_column_convert_case (MousepadView *view,
+                                   gint          type)
+{
+  GtkTextBuffer      *buffer;
+  MousepadColumnSpan *span;
+  GtkTextIter         start_iter, end_iter;
+  GArray             *spans;
+  gchar              *text, *piece, *converted;
+  guint               n;
+
+  buffer = mousepad_view_get_buffer (view);
+  spans = mousepad_view_column_get_all_spans (view, &text);
+
+  view->column_editing = TRUE;
+  g_object_freeze_notify (G_OBJECT (buffer));
+  gtk_text_buffer_begin_user_action (buffer);
+
+  for (n = spans->len; n > 0; n--)
+    {
+      span = &g_array_index (spans, MousepadColumnSpan, n - 1);
+      if (span->start == span->end)
+        continue;
+
+      piece = g_strndup (text + span->offset + span->start, span->end - span->start);
+      converted = mousepad_view_convert_case (piece, type);
+
+      /* only update the lines where the span changed */
+      if (G_LIKELY (converted && strcmp (piece, converted) != 0))
+        {
+          gtk_text_buffer_get_iter_at_line_index (buffer, &start_iter, span->line, span->start);
+          gtk_text_buffer_get_iter_at_line_index (buffer, &end_iter, span->line, span->end);
+          mousepad_view_replace_changed (buffer, &start_iter, &end_iter, piece, converted);
+        }
+
+      g_free (converted);
+      g_free (piece);
+    }
+
+  gtk_text_buffer_end_user_action (buffer);
+  g_object_thaw_notify (G_OBJECT (buffer));
+  view->column_editing = FALSE;
+
+  g_array_free (spans, TRUE);
+  g_free (text);
+
+  gtk_widget_queue_draw (GTK_WIDGET (view));
+}
+
+
+
+/* turn the column selection into a caret per line, each selecting its span */
+static void
+mousepad_view_column_to_carets (MousepadView *view)
+{
+  GtkTextBuffer      *buffer;
+  MousepadColumnSpan *span;
+  GtkTextIter         start_iter, end_iter;
+  GArray             *spans;
+  gchar              *text;
+  guint               n, primary;
+
+  buffer = mousepad_view_get_buffer (view);
+  spans = mousepad_view_column_get_all_spans (view, &text);
+  g_free (text);
+
+  /* the primary caret stays on the line of the head corner */
+  primary = (view->column_head_line < view->column_anchor_line || spans->len == 0) ? 0 : spans->len - 1;
+
+  mousepad_view_clear_carets (view);
+  mousepad_view_column_clear (view);
+
+  /* the primary caret goes first, so the extra carets are not refused for being on it */
+  for (n = 0; n < spans->len; n++)
+    {
+      span = &g_array_index (spans, MousepadColumnSpan, (n + primary) % spans->len);
+      gtk_text_buffer_get_iter_at_line_index (buffer, &start_iter, span->line, span->start);
+      gtk_text_buffer_get_iter_at_line_index (buffer, &end_iter, span->line, span->end);
+
+      if (n == 0)
+        gtk_text_buffer_select_range (buffer, &end_iter, &start_iter);
+      else
+        mousepad_view_carets_add (view, &end_iter, &start_iter);
+    }
+
+  g_array_free (spans, TRUE);
+
+  mousepad_view_carets_update (view);
+}
+
+
+
+static void
+mousepad_view_column_draw (MousepadView *view,
+                           cairo_t      *cr)
+{
+  GtkTextView        *text_view = GTK_TEXT_VIEW (view);
+  GtkTextBuffer      *buffer;
+  GtkStyleContext    *context;
+  MousepadColumnSpan *span;
+  GtkTextIter         iter;
+  GdkRectangle        visible, start_location, end_location;
+  GdkRGBA             color;
+  GArray             *spans;
+  gchar              *text;
+  gint                first_line, last_line, y, height;
+  guint               n;
+
+  buffer = mousepad_view_get_buffer (view);
+
+  /* only the visible lines of the selection are looked at */
+  gtk_text_view_get_visible_rect (text_view, &visible);
+  gtk_text_view_get_line_at_y (text_view, &iter, visible.y, NULL);
+  first_line = MAX (gtk_text_iter_get_line (&iter), MIN (view->column_anchor_line, view->column_head_line));
+  gtk_text_view_get_line_at_y (text_view, &iter, visible.y + visible.height, NULL);
+  last_line = MIN (gtk_text_iter_get_line (&iter), MAX (view->column_anchor_line, view->column_head_line));
+
+  context = gtk_widget_get_style_context (GTK_WIDGET (view));
+  if (! gtk_style_context_lookup_color (context, "theme_selected_bg_color", &color))
+    gdk_rgba_parse (&color, "#4a90d9");
+  gdk_cairo_set_source_rgba (cr, &color);
+
+  spans = mousepad_view_column_get_spans (view, first_line, last_line,
+                                          MIN (view->column_anchor, view->column_head),
+                                          MAX (view->column_anchor, view->column_head),
+                                          &text);
+  for (n = 0; n < spans->len; n++)
+    {
+      span = &g_array_index (spans, MousepadColumnSpan, n);
+
+      /* an empty column is drawn as a thin line, short lines are left out */
+      if (span->start == span->end && view->column_anchor != view->column_head)
+        continue;
+
+      gtk_text_buffer_get_iter_at_line_index (buffer, &iter, span->line, span->start);
+      gtk_text_view_get_iter_location (text_view, &iter, &start_location);
+      gtk_text_view_get_line_yrange (text_view, &iter, &y, &height);
+      gtk_text_buffer_get_iter_at_line_index (buffer, &iter, span->line, span->end);
+      gtk_text_view_get_iter_location (text_view, &iter, &end_location);
+
+      cairo_rectangle (cr, start_location.x, y, MAX (end_location.x - start_location.x, 1), height);
+    }
+
+  cairo_fill (cr);
+
+  g_array_free (spans, TRUE);
+  g_free (text);
+}
+
+
+
+static gboolean
+mousepad_view_column_key_press (MousepadView *view,
+                                GdkEventKey  *event,
+                                guint         modifiers)
+{
+  gboolean is_editable;
+
+  /* modifiers alone keep the selection, for the shortcuts of the window */
+  if (event->is_modifier)
+    return FALSE;
+
+  is_editable = gtk_text_view_get_editable (GTK_TEXT_VIEW (view));
+
+  switch (event->keyval)
+    {
+      case GDK_KEY_Escape:
+        mousepad_view_column_clear (view);
+        return TRUE;
+
+      case GDK_KEY_BackSpace:
+      case GDK_KEY_Delete:
+      case GDK_KEY_KP_Delete:
+        /* an empty column deletes a character on every line, like the carets */
+        if (is_editable && view->column_anchor == view->column_head)
+          {
+            mousepad_view_column_to_carets (view);
+            return FALSE;
+          }
+
+        if (is_editable)
+          mousepad_view_column_delete (view);
+        return TRUE;
+
+      case GDK_KEY_Left:
+      case GDK_KEY_KP_Left:
+      case GDK_KEY_Right:
+      case GDK_KEY_KP_Right:
+      case GDK_KEY_Up:
+      case GDK_KEY_KP_Up:
+      case GDK_KEY_Down:
+      case GDK_KEY_KP_Down:
+      case GDK_KEY_Home:
+      case GDK_KEY_KP_Home:
+      case GDK_KEY_End:
+      case GDK_KEY_KP_End:
+      case GDK_KEY_Page_Up:
+      case GDK_KEY_KP_Page_Up:
+      case GDK_KEY_Page_Down:
+      case GDK_KEY_KP_Page_Down:
+        mousepad_view_column_clear (view);
+        return FALSE;
+
+      default:
+        /* shortcuts are left to the window */
+        if ((modifiers & (GDK_CONTROL_MASK | GDK_MOD1_MASK)) != 0)
+          return FALSE;
+
+        /* typing happens at a caret on every line of the selection */
+        if (is_editable)
+          mousepad_view_column_to_carets (view);
+        else
+          mousepad_view_column_clear (view);
+        return FALSE;
+    }
+}
+
+
+
+/* paste a line of the string on every line from the cursor down, at the
+ * visual column of the cursor, without asking the view for any layout */
+static void
+mousepad_view_column_paste (MousepadView *view,
+                            const gchar  *string)
+{
+  GtkTextBuffer      *buffer;
+  MousepadColumnSpan *span;
+  GtkTextIter         iter;
+  GString            *piece;
+  GArray             *spans;
+  gchar             **pieces, *text, *padding;
+  gint                first_line, last_line, n_lines, column, end_index = 0;
+  guint               n, n_pieces;
+
+  buffer = mousepad_view_get_buffer (view);
+
+  /* a trailing line break doesn't ask for one more line */
+  pieces = g_strsplit (string, "\n", -1);
+  n_pieces = g_strv_length (pieces);
+  if (n_pieces > 1 && *pieces[n_pieces - 1] == '\0')
+    n_pieces--;
+
+  gtk_text_buffer_get_iter_at_mark (buffer, &iter, gtk_text_buffer_get_insert (buffer));
+  column = mousepad_util_get_real_line_offset (&iter, gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (view)));
+  first_line = gtk_text_iter_get_line (&iter);
+  last_line = first_line + n_pieces - 1;
+
+  g_object_freeze_notify (G_OBJECT (buffer));
+  gtk_text_buffer_begin_user_action (buffer);
+
+  /* the lines missing at the end of the buffer are added at once */
+  n_lines = gtk_text_buffer_get_line_count (buffer);
+  if (last_line >= n_lines)
+    {
+      text = g_strnfill (last_line - n_lines + 1, '\n');
+      gtk_text_buffer_get_end_iter (buffer, &iter);
+      gtk_text_buffer_insert (buffer, &iter, text, -1);
+      g_free (text);
+    }
+
+  /* where the column starts on every line, from a single walk over them */
+  spans = mousepad_view_column_get_spans (view, first_line, last_line, column, column, &text);
+  piece = g_string_new (NULL);
+  g_free (text);
+
+  /* insert from the last line, so the line indexes of the others stay valid */
+  for (n = spans->len; n > 0; n--)
+    {
+      span = &g_array_index (spans, MousepadColumnSpan, n - 1);
+      g_string_assign (piece, pieces[n - 1]);
+
+      /* the buffer only knows \n, drop the \r of a \r\n delimiter */
+      if (piece->len > 0 && piece->str[piece->len - 1] == '\r')
+        g_string_truncate (piece, piece->len - 1);
+
+      /* pad the lines too short to reach the column */
+      if (piece->len > 0 && span->missing > 0)
+        {
+          padding = g_strnfill (span->missing, ' ');
+          g_string_prepend (piece, padding);
+          g_free (padding);
+        }
+
+      if (n == spans->len)
+        end_index = span->start + piece->len;
+
+      if (piece->len > 0)
+        {
+          gtk_text_buffer_get_iter_at_line_index (buffer, &iter, span->line, span->start);
+          gtk_text_buffer_insert (buffer, &iter, piece->str, piece->len);
+        }
+    }
+
+  /* set the cursor after the last piece */
+  gtk_text_buffer_get_iter_at_line_index (buffer, &iter, last_line, end_index);
+  gtk_text_buffer_place_cursor (buffer, &iter);
+
+  gtk_text_buffer_end_user_action (buffer);
+  g_object_thaw_notify (G_OBJECT (buffer));
+
+  g_string_free (piece, TRUE);
+  g_array_free (spans, TRUE);
+  g_strfreev (pieces);
+}
+
+
+
+/**
+ * Indentation Functions
+ **/
+static void
+mousepad_view_indent_lines (MousepadView *view,
+                            gint          start_line,
+                            gint          end_line,
+                            gboolean      increase)
+{
+  GtkTextBuffer     *buffer;
+  GtkTextMark       *marks[2];
+  MousepadLineRange  range, *edit;
+  GtkTextIter        start_iter, end_iter, iter;
+  GString           *indented;
+  GArray            *edits;
+  const gchar       *p, *line_end;
+  gchar             *text, *indent;
+  gint               tab_size, columns, to_line_end[2], mark_line[2];
+  gsize              indent_len;
+  guint              n;
+
+  buffer = mousepad_view_get_buffer (view);
+  tab_size = gtk_source_view_get_tab_width (GTK_SOURCE_VIEW (view));
+
+  /* a line start is always aligned on a tab stop, so a level is a full tab */
+  if (gtk_source_view_get_insert_spaces_instead_of_tabs (GTK_SOURCE_VIEW (view)))
+    indent = g_strnfill (tab_size, ' ');
+  else
+    indent = g_strdup ("\t");
+  indent_len = strlen (indent);
+
+  /* take the lines out of the buffer once */
+  gtk_text_buffer_get_iter_at_line (buffer, &start_iter, start_line);
+  gtk_text_buffer_get_iter_at_line (buffer, &end_iter, end_line);
+  if (! gtk_text_iter_ends_line (&end_iter))
+    gtk_text_iter_forward_to_line_end (&end_iter);
+  text = gtk_text_buffer_get_slice (buffer, &start_iter, &end_iter, TRUE);
+
+  /* compute the new leading whitespace of every line in one pass, keeping
+   * both the edits and the whole indented text */
+  edits = g_array_new (FALSE, FALSE, sizeof (MousepadLineRange));
+  indented = g_string_sized_new (strlen (text) + (increase ? (end_line - start_line + 1) * indent_len : 0));
+  for (p = text, range.line = start_line; range.line <= end_line; range.line++)
+    {
+      line_end = p + strcspn (p, "\r\n");
+      range.start = range.end = 0;
+
+      /* don't change indentation of empty lines */
+      if (line_end > p)
+        {
+          if (increase)
+            {
+              g_string_append_len (indented, indent, indent_len);
+              g_array_append_val (edits, range);
+            }
+          else
+            {
+              /* remove up to a tab worth of columns */
+              for (columns = tab_size; columns > 0 && p + range.end < line_end; range.end++)
+                {
+                  if (p[range.end] == '\t')
+                    columns -= tab_size;
+                  else if (p[range.end] == ' ')
+                    columns--;
+                  else
+                    break;
+                }
+
+              if (range.end > 0)
+                g_array_append_val (edits, range);
+            }
+        }
+
+      /* copy the rest of the line with its delimiter */
+      if (line_end[0] == '\r' && line_end[1] == '\n')
+        line_end++;
+      if (*line_end != '\0')
+        line_end++;
+      g_string_append_len (indented, p + range.end, line_end - p - range.end);
+      p = line_end;
+    }
+
+  if (edits->len > 0)
+    {
+      g_object_freeze_notify (G_OBJECT (buffer));
+      gtk_text_buffer_begin_user_action (buffer);
+
+      if (edits->len <= MOUSEPAD_VIEW_MAX_CHANGED_RUNS)
+        {
+          /* a few lines are edited in place, from the last one so the line
+           * indexes of the others stay valid */
+          for (n = edits->len; n > 0; n--)
+            {
+              edit = &g_array_index (edits, MousepadLineRange, n - 1);
+              gtk_text_buffer_get_iter_at_line (buffer, &iter, edit->line);
+              if (increase)
+                gtk_text_buffer_insert (buffer, &iter, indent, indent_len);
+              else
+                {
+                  gtk_text_buffer_get_iter_at_line_index (buffer, &end_iter, edit->line, edit->end);
+                  gtk_text_buffer_delete (buffer, &iter, &end_iter);
+                }
+            }
+        }
+      else
+        {
+          /* remember the selection relative to the line ends, which don't move */
+          marks[0] = gtk_text_buffer_get_insert (buffer);
+          marks[1] = gtk_text_buffer_get_selection_bound (buffer);
+          for (n = 0; n < 2; n++)
+            {
+              gtk_text_buffer_get_iter_at_mark (buffer, &iter, marks[n]);
+              mark_line[n] = gtk_text_iter_get_line (&iter);
+              to_line_end[n] = gtk_text_iter_get_chars_in_line (&iter) - gtk_text_iter_get_line_offset (&iter);
+            }
+
+          /* many lines are replaced at once, which makes a compact undo record */
+          mousepad_view_replace_changed (buffer, &start_iter, &end_iter, text, indented->str);
+
+          /* put the selection back, clamped to the line start */
+          for (n = 2; n > 0; n--)
+            {
+              gtk_text_buffer_get_iter_at_line (buffer, &iter, mark_line[n - 1]);
+              gtk_text_iter_set_line_offset (&iter, MAX (gtk_text_iter_get_chars_in_line (&iter)
+                                                         - to_line_end[n - 1], 0));
+              gtk_text_buffer_move_mark (buffer, marks[n - 1], &iter);
+            }
+        }
+
+      gtk_text_buffer_end_user_action (buffer);
+      g_object_thaw_notify (G_OBJECT (buffer));
+    }
+
+  g_array_free (edits, TRUE);
+  g_string_free (indented, TRUE);
+  g_free (indent);
+  g_free (text);
+}
+
+
+
+static void
+mousepad_view_indent_selection (MousepadView *view,
+                                gboolean      increase,
+                                gboolean      force)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter    start_iter, end_iter;
+  gint           start_line, end_line;
+
+  /* get the textview buffer */
+  buffer = mousepad_view_get_buffer (view);
+
+  if (gtk_text_buffer_get_selection_bounds (buffer, &start_iter, &end_iter) || force)
+    {
+      /* get start and end line */
+      start_line = gtk_text_iter_get_line (&start_iter);
+      end_line = gtk_text_iter_get_line (&end_iter);
+
+      /* only change indentation when an entire line is selected or multiple lines */
+      if (start_line != end_line
+          || ((gtk_text_iter_starts_line (&start_iter) && gtk_text_iter_ends_line (&end_iter)) || force))
+        {
+          /* change indentation of all the lines at once */
+          mousepad_view_indent_lines (view, start_line, end_line, increase);
+        }
+
+      /* put cursor on screen */
+      mousepad_view_scroll_to_cursor (view);
+    }
+}
+
+
+
+void
+mousepad_view_scroll_to_cursor (MousepadView *view)
+{
+  GtkTextBuffer *buffer;
+
+  g_return_if_fail (MOUSEPAD_IS_VIEW (view));
+
+  /* get the buffer */
+  buffer = mousepad_view_get_buffer (view);
+
+  /* scroll to visible area */
+  gtk_text_view_scroll_to_mark (GTK_TEXT_VIEW (view),
+                                gtk_text_buffer_get_insert (buffer),
+                                0.02, FALSE, 0.0, 0.0);
+}
+
+
+
+static void
+mousepad_view_transpose_range (GtkTextBuffer *buffer,
+                               GtkTextIter   *start_iter,
+                               GtkTextIter   *end_iter)
+{
+  gchar *string, *reversed;
+  gint   offset;
+
+  /* store start iter line offset */
+  offset = gtk_text_iter_get_offset (start_iter);
+
+  /* get selected text */
+  string = gtk_text_buffer_get_slice (buffer, start_iter, end_iter, TRUE);
+  if (G_LIKELY (string))
+    {
+      /* reverse the string */
+      reversed = g_utf8_strreverse (string, -1);
+
+      /* only change the buffer then the string changed */
+      if (G_LIKELY (reversed && strcmp (reversed, string) != 0))
+        {
+          /* delete the text between the iters */
+          gtk_text_buffer_delete (buffer, start_iter, end_iter);
+
+          /* insert the reversed string */
+          gtk_text_buffer_insert (buffer, end_iter, reversed, -1);
+
+          /* restore start iter */
+          gtk_text_buffer_get_iter_at_offset (buffer, start_iter, offset);
+        }
+
+      /* cleanup */
+      g_free (string);
+      g_free (reversed);
+    }
+}
+
+
+
+static void
+mousepad_view_transpose_lines (GtkTextBuffer *buffer,
+                               GtkTextIter   *start_iter,
+                               GtkTextIter   *end_iter)
+{
+  gint   start_line;
+  gchar *text, *reversed;
+
+  /* make sure the order is ok */
+  gtk_text_iter_order (start_iter, end_iter);
+
+  /* extend the iters to whole lines */
+  start_line = gtk_text_iter_get_line (start_iter);
+  gtk_text_iter_set_line_offset (start_iter, 0);
+  if (!gtk_text_iter_ends_line (end_iter))
+    gtk_text_iter_forward_to_line_end (end_iter);
+
+  /* reverse the lines of the block at once */
+  text = gtk_text_buffer_get_slice (buffer, start_iter, end_iter, TRUE);
+  reversed = mousepad_util_reverse_lines (text, strlen (text));
+
+  /* only change the buffer when the lines changed */
+  if (strcmp (reversed, text) != 0)
+    {
+      /* delete the lines */
+      gtk_text_buffer_delete (buffer, start_iter, end_iter);
+
+      /* insert reversed lines */
+      gtk_text_buffer_insert (buffer, end_iter, reversed, -1);
+    }
+
+  /* cleanup */
+  g_free (text);
+  g_free (reversed);
+
+  /* restore start iter */
+  gtk_text_buffer_get_iter_at_line (buffer, start_iter, start_line);
+}
+
+
+
+static void
+mousepad_view_transpose_words (GtkTextBuffer *buffer,
+                               GtkTextIter   *iter)
+{
+  GtkTextMark *left_mark, *right_mark;
+  GtkTextIter  start_left, end_left, start_right, end_right;
+  gchar       *word_left, *word_right;
+  gboolean     restore_cursor;
+
+  /* left word end */
+  end_left = *iter;
+  if (!mousepad_util_iter_backward_text_start (&end_left))
+    return;
+
+  /* left word start */
+  start_left = end_left;
+  if (!mousepad_util_iter_backward_word_start (&start_left))
+    return;
+
+  /* right word start */
+  start_right = *iter;
+  if (!mousepad_util_iter_forward_text_start (&start_right))
+    return;
+
+  /* right word end */
+  end_right = start_right;
+  if (!mousepad_util_iter_forward_word_end (&end_right))
+    return;
+
+  /* check if we selected something usefull */
+  if (gtk_text_iter_get_line (&start_left) == gtk_text_iter_get_line (&end_right)
+      && !gtk_text_iter_equal (&start_left, &end_left)
+      && !gtk_text_iter_equal (&start_right, &end_right)
+      && !gtk_text_iter_equal (&end_left, &start_right))
+    {
+      /* get the words */
+      word_left = gtk_text_buffer_get_slice (buffer, &start_left, &end_left, TRUE);
+      word_right = gtk_text_buffer_get_slice (buffer, &start_right, &end_right, TRUE);
+
+      /* check if we need to restore the cursor afterwards */
+      restore_cursor = gtk_text_iter_equal (iter, &start_right);
+
+      /* insert marks at the start and end of the right word */
+      left_mark = gtk_text_buffer_create_mark (buffer, NULL, &start_right, TRUE);
+      right_mark = gtk_text_buffer_create_mark (buffer, NULL, &end_right, FALSE);
+
+      /* delete the left word and insert the right word there */
+      gtk_text_buffer_delete (buffer, &start_left, &end_left);
+      gtk_text_buffer_insert (buffer, &start_left, word_right, -1);
+      g_free (word_right);
+
+      /* restore the right word iters */
+      gtk_text_buffer_get_iter_at_mark (buffer, &start_right, left_mark);
       gtk_text_buffer_get_iter_at_mark (buffer, &end_right, right_mark);
 
       /* delete the right words and insert the left word there */
@@ -896,11 +2414,63 @@ mousepad_view_transpose (MousepadView *view)
 
 
 
+void
+mousepad_view_reverse_lines (MousepadView *view)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter    start_iter, end_iter, iter;
+  gint           line, offset, n_lines;
+
+  g_return_if_fail (MOUSEPAD_IS_VIEW (view));
+
+  /* get the buffer */
+  buffer = mousepad_view_get_buffer (view);
+
+  /* a final line break stays at the end */
+  gtk_text_buffer_get_bounds (buffer, &start_iter, &end_iter);
+  if (gtk_text_iter_starts_line (&end_iter) && ! gtk_text_iter_is_start (&end_iter))
+    gtk_text_iter_backward_char (&end_iter);
+
+  /* remember where the cursor is */
+  gtk_text_buffer_get_iter_at_mark (buffer, &iter, gtk_text_buffer_get_insert (buffer));
+  line = gtk_text_iter_get_line (&iter);
+  offset = gtk_text_iter_get_line_offset (&iter);
+  n_lines = gtk_text_iter_get_line (&end_iter) + 1;
+
+  /* reverse all the lines */
+  gtk_text_buffer_begin_user_action (buffer);
+  mousepad_view_transpose_lines (buffer, &start_iter, &end_iter);
+  gtk_text_buffer_end_user_action (buffer);
+
+  /* the cursor follows its line */
+  if (line < n_lines)
+    {
+      gtk_text_buffer_get_iter_at_line (buffer, &iter, n_lines - 1 - line);
+      if (offset < gtk_text_iter_get_chars_in_line (&iter))
+        gtk_text_iter_set_line_offset (&iter, offset);
+      else if (! gtk_text_iter_ends_line (&iter))
+        gtk_text_iter_forward_to_line_end (&iter);
+    }
+  else
+    {
+      /* the empty line after the final line break stays at the end */
+      gtk_text_buffer_get_end_iter (buffer, &iter);
+    }
+
+  gtk_text_buffer_place_cursor (buffer, &iter);
+
+  /* put cursor on screen */
+  mousepad_view_scroll_to_cursor (view);
+}
+
+
+
 void
 mousepad_view_clipboard_cut (MousepadView *view)
 {
   GtkClipboard  *clipboard;
   GtkTextBuffer *buffer;
+  gchar         *text;
 
   g_return_if_fail (MOUSEPAD_IS_VIEW (view));
   g_return_if_fail (mousepad_view_get_selection_length (view, NULL) > 0);
@@ -911,6 +2481,32 @@ mousepad_view_clipboard_cut (MousepadView *view)
   /* get the buffer */
   buffer = mousepad_view_get_buffer (view);
 
+  /* cut the spans of a column selection, a line each */
+  if (view->column_anchor_line != -1)
+    {
+      text = mousepad_view_column_get_text (view);
+      gtk_clipboard_set_text (clipboard, text, -1);
+      g_free (text);
+
+      if (gtk_text_view_get_editable (GTK_TEXT_VIEW (view)))
+        mousepad_view_column_delete (view);
+
+      return;
+    }
+
+  /* cut the selections of all the carets */
+  if (view->carets->len > 0)
+    {
+      text = mousepad_view_carets_get_text (view);
+      gtk_clipboard_set_text (clipboard, text, -1);
+      g_free (text);
+
+      if (gtk_text_view_get_editable (GTK_TEXT_VIEW (view)))
+        mousepad_view_carets_edit (view, CARETS_ERASE_SELECTION, NULL);
+
+      return;
+    }
+
   /* cut from buffer */
   gtk_text_buffer_cut_clipboard (buffer, clipboard, gtk_text_view_get_editable (GTK_TEXT_VIEW (view)));
 
@@ -925,6 +2521,7 @@ mousepad_view_clipboard_copy (MousepadView *view)
 {
   GtkClipboard  *clipboard;
   GtkTextBuffer *buffer;
+  gchar         *text;
 
   g_return_if_fail (MOUSEPAD_IS_VIEW (view));
   g_return_if_fail (mousepad_view_get_selection_length (view, NULL) > 0);
@@ -935,8 +2532,22 @@ mousepad_view_clipboard_copy (MousepadView *view)
   /* get the buffer */
   buffer = mousepad_view_get_buffer (view);
 
-  /* copy from buffer */
-  gtk_text_buffer_copy_clipboard (buffer, clipboard);
+  /* copy the spans of a column selection or the selections of all the carets, a line each */
+  if (view->column_anchor_line != -1 || view->carets->len > 0)
+    {
+      if (view->column_anchor_line != -1)
+        text = mousepad_view_column_get_text (view);
+      else
+        text = mousepad_view_carets_get_text (view);
+
+      gtk_clipboard_set_text (clipboard, text, -1);
+      g_free (text);
+    }
+  else
+    {
+      /* copy from buffer */
+      gtk_text_buffer_copy_clipboard (buffer, clipboard);
+    }
 
   /* put cursor on screen */
   mousepad_view_scroll_to_cursor (view);
@@ -949,16 +2560,11 @@ mousepad_view_clipboard_paste (MousepadView *view,
                                const gchar  *string,
                                gboolean      paste_as_column)
 {
-  GtkClipboard   *clipboard;
-  GtkTextBuffer  *buffer;
-  GtkTextView    *textview = GTK_TEXT_VIEW (view);
-  gchar          *text = NULL;
-  GtkTextMark    *mark;
-  GtkTextIter     iter;
-  GtkTextIter     start_iter, end_iter;
-  GdkRectangle    rect;
-  gchar         **pieces;
-  gint            i, y;
+  GtkClipboard  *clipboard;
+  GtkTextBuffer *buffer;
+  gchar         *text = NULL;
+  GtkTextIter    start_iter, end_iter;
+  gint           line, column;
 
   if (string == NULL)
     {
@@ -979,52 +2585,36 @@ mousepad_view_clipboard_paste (MousepadView *view,
   /* get the buffer */
   buffer = mousepad_view_get_buffer (view);
 
-  /* begin user action */
-  gtk_text_buffer_begin_user_action (buffer);
-
-  if (paste_as_column)
+  /* a column selection is replaced line by line, a column is pasted at its top left corner */
+  if (view->column_anchor_line != -1)
     {
-      /* chop the string into pieces */
-      pieces = g_strsplit (string, "\n", -1);
-
-      /* get iter at cursor position */
-      mark = gtk_text_buffer_get_insert (buffer);
-      gtk_text_buffer_get_iter_at_mark (buffer, &iter, mark);
-
-      /* get the iter location */
-      gtk_text_view_get_iter_location (textview, &iter, &rect);
-
-      /* insert the pieces in the buffer */
-      for (i = 0; pieces[i] != NULL; i++)
+      if (paste_as_column)
         {
-          /* insert the text in the buffer */
-          gtk_text_buffer_insert (buffer, &iter, pieces[i], -1);
-
-          /* break if the next piece is null */
-          if (G_UNLIKELY (pieces[i+1] == NULL))
-            break;
+          line = MIN (view->column_anchor_line, view->column_head_line);
+          column = MIN (view->column_anchor, view->column_head);
+          mousepad_view_column_set (view, line, column, line, column);
+          mousepad_view_column_clear (view);
+        }
+      else
+        mousepad_view_column_to_carets (view);
+    }
 
-          /* move the iter to the next line */
-          if (!gtk_text_iter_forward_line (&iter))
-            {
-              /* no new line, insert a new line */
-              gtk_text_buffer_insert (buffer, &iter, "\n", 1);
-            }
-          else
-            {
-              /* get the y coordinate for this line */
-              gtk_text_view_get_line_yrange (textview, &iter, &y, NULL);
+  /* paste at every caret */
+  if (view->carets->len > 0 && ! paste_as_column)
+    {
+      mousepad_view_carets_edit (view, CARETS_INSERT, string);
+      g_free (text);
 
-              /* get the iter at the correct coordinate */
-              gtk_text_view_get_iter_at_location (textview, &iter, rect.x, y);
-            }
-        }
+      return;
+    }
 
-      /* cleanup */
-      g_strfreev (pieces);
+  /* begin user action */
+  gtk_text_buffer_begin_user_action (buffer);
 
-      /* set the cursor to the last iter position */
-      gtk_text_buffer_place_cursor (buffer, &iter);
+  if (paste_as_column)
+    {
+      /* paste a line per line, at the column of the cursor */
+      mousepad_view_column_paste (view, string);
     }
   else
     {
@@ -1062,6 +2652,20 @@ mousepad_view_delete_selection (MousepadView *view)
   /* get the buffer */
   buffer = mousepad_view_get_buffer (view);
 
+  /* delete the spans of a column selection */
+  if (view->column_anchor_line != -1)
+    {
+      mousepad_view_column_delete (view);
+      return;
+    }
+
+  /* delete the selections of all the carets */
+  if (view->carets->len > 0)
+    {
+      mousepad_view_carets_edit (view, CARETS_ERASE_SELECTION, NULL);
+      return;
+    }
+
   /* delete the selection */
   gtk_text_buffer_delete_selection (buffer, TRUE, gtk_text_view_get_editable (GTK_TEXT_VIEW (view)));
 
@@ -1082,6 +2686,10 @@ mousepad_view_select_all (MousepadView *view)
   /* get the buffer */
   buffer = mousepad_view_get_buffer (view);
 
+  /* back to a single selection */
+  mousepad_view_clear_carets (view);
+  mousepad_view_column_clear (view);
+
   /* get the start and end iter */
   gtk_text_buffer_get_bounds (buffer, &start, &end);
 
@@ -1091,109 +2699,193 @@ mousepad_view_select_all (MousepadView *view)
 
 
 
-void
-mousepad_view_convert_selection_case (MousepadView *view,
-                                      gint          type)
+/* a run of characters that changed between two strings */
+typedef struct
 {
-  gchar         *text;
-  gchar         *converted;
-  GtkTextBuffer *buffer;
-  GtkTextIter    start_iter, end_iter;
-  gint           offset = -1;
-  GSList        *li = NULL;
+  gint         start;
+  gint         end;
+  const gchar *replacement;
+  gsize        length;
+}
+MousepadChangedRun;
 
-  g_return_if_fail (MOUSEPAD_IS_VIEW (view));
-  g_return_if_fail (mousepad_view_get_selection_length (view, NULL) > 0);
 
-  /* get the buffer */
-  buffer = mousepad_view_get_buffer (view);
 
-  /* begin a user action */
-  gtk_text_buffer_begin_user_action (buffer);
+static void
+mousepad_view_replace_changed (GtkTextBuffer *buffer,
+                               GtkTextIter   *start_iter,
+                               GtkTextIter   *end_iter,
+                               const gchar   *text,
+                               const gchar   *converted)
+{
+  MousepadChangedRun *run, *last;
+  GArray             *runs;
+  const gchar        *p, *q;
+  gsize               length, new_length, prefix, suffix;
+  gint                offset, n_chars, skip;
+  guint               n;
+
+  length = strlen (text);
+  new_length = strlen (converted);
+  offset = gtk_text_iter_get_offset (start_iter);
+  runs = g_array_new (FALSE, FALSE, sizeof (MousepadChangedRun));
 
-  if (view->selection_marks == NULL)
+  /* a case conversion mostly maps one character to one character of the same
+   * size, walk both strings side by side to collect the changed runs */
+  if (length == new_length)
     {
-      /* get selection bounds */
-      gtk_text_buffer_get_selection_bounds (buffer, &start_iter, &end_iter);
+      for (p = text, q = converted, n_chars = 0; *p != '\0'; p += skip, q += skip, n_chars++)
+        {
+          skip = g_utf8_skip[*(const guchar *) p];
+          if (skip != g_utf8_skip[*(const guchar *) q])
+            break;
+
+          if (memcmp (p, q, skip) == 0)
+            continue;
+
+          /* extend the last run or start a new one */
+          last = runs->len > 0 ? &g_array_index (runs, MousepadChangedRun, runs->len - 1) : NULL;
+          if (last != NULL && last->end == n_chars)
+            {
+              last->end++;
+              last->length += skip;
+            }
+          else if (runs->len < MOUSEPAD_VIEW_MAX_CHANGED_RUNS)
+            {
+              g_array_set_size (runs, runs->len + 1);
+              run = &g_array_index (runs, MousepadChangedRun, runs->len - 1);
+              run->start = n_chars;
+              run->end = n_chars + 1;
+              run->replacement = q;
+              run->length = skip;
+            }
+          else
+            break;
+        }
 
-      /* get string offset */
-      offset = gtk_text_iter_get_offset (&start_iter);
+      /* fall back on a single edit if the strings went out of step */
+      if (*p != '\0')
+        g_array_set_size (runs, 0);
+    }
 
-      /* enter the loop without hassle */
-      goto selection_enter;
+  if (runs->len == 0)
+    {
+      /* replace everything between the common prefix and suffix */
+      for (prefix = 0; prefix < length && prefix < new_length && text[prefix] == converted[prefix]; prefix++);
+      while (prefix > 0 && (text[prefix] & 0xc0) == 0x80)
+        prefix--;
+
+      for (suffix = 0; suffix < length - prefix && suffix < new_length - prefix
+           && text[length - suffix - 1] == converted[new_length - suffix - 1]; suffix++);
+      while (suffix > 0 && (text[length - suffix] & 0xc0) == 0x80)
+        suffix--;
+
+      g_array_set_size (runs, 1);
+      run = &g_array_index (runs, MousepadChangedRun, 0);
+      run->start = g_utf8_strlen (text, prefix);
+      run->end = run->start + g_utf8_strlen (text + prefix, length - prefix - suffix);
+      run->replacement = converted + prefix;
+      run->length = new_length - prefix - suffix;
     }
 
-  /* replace all selected items */
-  for (li = view->selection_marks; li != NULL; li = li->next)
+  /* apply the runs from the end, so the offsets of the others stay valid */
+  for (n = runs->len; n > 0; n--)
     {
-      /* get iters from column selection */
-      gtk_text_buffer_get_iter_at_mark (buffer, &start_iter, li->data);
-      li = li->next;
-      gtk_text_buffer_get_iter_at_mark (buffer, &end_iter, li->data);
+      run = &g_array_index (runs, MousepadChangedRun, n - 1);
+      gtk_text_buffer_get_iter_at_offset (buffer, start_iter, offset + run->start);
+      gtk_text_buffer_get_iter_at_offset (buffer, end_iter, offset + run->end);
+      gtk_text_buffer_delete (buffer, start_iter, end_iter);
+      gtk_text_buffer_insert (buffer, start_iter, run->replacement, run->length);
+    }
 
-      /* label for normal selections */
-      selection_enter:
+  g_array_free (runs, TRUE);
 
-      /* get the selected string */
-      text = gtk_text_buffer_get_slice (buffer, &start_iter, &end_iter, FALSE);
-      if (G_LIKELY (text != NULL))
-        {
-          switch (type)
-            {
-              case LOWERCASE:
-                converted = g_utf8_strdown (text, -1);
-                break;
+  /* leave the iters around the converted string */
+  gtk_text_buffer_get_iter_at_offset (buffer, start_iter, offset);
+  gtk_text_buffer_get_iter_at_offset (buffer, end_iter, offset + g_utf8_strlen (converted, -1));
+}
 
-              case UPPERCASE:
-                converted = g_utf8_strup (text, -1);
-                break;
 
-              case TITLECASE:
-                converted = mousepad_util_utf8_strcapital (text);
-                break;
 
-              case OPPOSITE_CASE:
-                converted = mousepad_util_utf8_stropposite (text);
-                break;
+static gchar *
+mousepad_view_convert_case (const gchar *text,
+                            gint         type)
+{
+  switch (type)
+    {
+      case LOWERCASE:
+        return mousepad_util_utf8_strdown (text);
 
-              default:
-                g_assert_not_reached ();
-                break;
-            }
+      case UPPERCASE:
+        return mousepad_util_utf8_strup (text);
 
-          /* only update the buffer if the string changed */
-          if (G_LIKELY (converted && strcmp (text, converted) != 0))
-            {
-              /* debug check */
-              g_return_if_fail (g_utf8_validate (converted, -1, NULL));
+      case TITLECASE:
+        return mousepad_util_utf8_strcapital (text);
 
-              /* delete old string */
-              gtk_text_buffer_delete (buffer, &start_iter, &end_iter);
+      case OPPOSITE_CASE:
+        return mousepad_util_utf8_stropposite (text);
 
-              /* insert string */
-              gtk_text_buffer_insert (buffer, &end_iter, converted, -1);
-            }
+      default:
+        g_assert_not_reached ();
+        return NULL;
+    }
+}
 
-          /* cleanup */
-          g_free (converted);
-          g_free (text);
-        }
 
-      /* leave for normal selections */
-      if (offset != -1)
-        break;
+
+void
+mousepad_view_convert_selection_case (MousepadView *view,
+                                      gint          type)
+{
+  gchar         *text;
+  gchar         *converted;
+  GtkTextBuffer *buffer;
+  GtkTextIter    start_iter, end_iter;
+  gint           offset;
+
+  g_return_if_fail (MOUSEPAD_IS_VIEW (view));
+  g_return_if_fail (mousepad_view_get_selection_length (view, NULL) > 0);
+
+  /* convert the span of every line of a column selection */
+  if (view->column_anchor_line != -1)
+    {
+      mousepad_view_column_convert_case (view, type);
+      return;
     }
 
-  /* restore selection if needed */
-  if (offset != -1)
+  /* get the buffer */
+  buffer = mousepad_view_get_buffer (view);
+
+  /* begin a user action */
+  gtk_text_buffer_begin_user_action (buffer);
+
+  /* get selection bounds */
+  gtk_text_buffer_get_selection_bounds (buffer, &start_iter, &end_iter);
+
+  /* get string offset */
+  offset = gtk_text_iter_get_offset (&start_iter);
+
+  /* get the selected string */
+  text = gtk_text_buffer_get_slice (buffer, &start_iter, &end_iter, TRUE);
+  if (G_LIKELY (text != NULL))
     {
-      /* restore start iter */
-      gtk_text_buffer_get_iter_at_offset (buffer, &start_iter, offset);
+      converted = mousepad_view_convert_case (text, type);
 
-      /* select range */
-      gtk_text_buffer_select_range (buffer, &end_iter, &start_iter);
+      /* only update the buffer where the string changed */
+      if (G_LIKELY (converted && strcmp (text, converted) != 0))
+        mousepad_view_replace_changed (buffer, &start_iter, &end_iter, text, converted);
+
+      /* cleanup */
+      g_free (converted);
+      g_free (text);
     }
 
+  /* restore start iter */
+  gtk_text_buffer_get_iter_at_offset (buffer, &start_iter, offset);
+
+  /* select range */
+  gtk_text_buffer_select_range (buffer, &end_iter, &start_iter);
+
   /* end user action */
   gtk_text_buffer_end_user_action (buffer);
 }
@@ -1207,15 +2899,13 @@ mousepad_view_convert_spaces_and_tabs (MousepadView *view,
   GtkTextBuffer *buffer;
   GtkTextMark   *mark;
   GtkTextIter    start_iter, end_iter;
-  GtkTextIter    iter;
+  GtkTextIter    iter, line_end;
   gint           tab_size;
-  gboolean       in_range = FALSE;
-  gboolean       no_forward;
-  gunichar       c;
-  gint           offset;
-  gint           n_spaces = 0;
+  gint           column;
+  gint           line, index;
   gint           start_offset = -1;
-  gchar         *string;
+  gsize          length, new_length, prefix, suffix;
+  gchar         *slice, *converted;
 
   g_return_if_fail (MOUSEPAD_IS_VIEW (view));
 
@@ -1252,108 +2942,55 @@ mousepad_view_convert_spaces_and_tabs (MousepadView *view,
   /* create a mark to restore the end iter after modifieing the buffer */
   mark = gtk_text_buffer_create_mark (buffer, NULL, &end_iter, FALSE);
 
-  /* walk the text between the iters */
-  for (;;)
+  /* the visual column of the start iter, the kernels follow it from there */
+  column = mousepad_util_get_real_line_offset (&start_iter, tab_size);
+  line = gtk_text_iter_get_line (&start_iter);
+  index = gtk_text_iter_get_line_index (&start_iter);
+
+  /* convert the text line by line, only replacing what changed in each line */
+  for (iter = start_iter;; line++, column = 0, index = 0)
     {
-      /* get the character */
-      c = gtk_text_iter_get_char (&start_iter);
+      line_end = iter;
+      if (! gtk_text_iter_ends_line (&line_end))
+        gtk_text_iter_forward_to_line_end (&line_end);
+      if (gtk_text_iter_compare (&line_end, &end_iter) > 0)
+        line_end = end_iter;
 
-      /* reset */
-      no_forward = FALSE;
+      slice = gtk_text_iter_get_slice (&iter, &line_end);
+      length = strlen (slice);
 
       if (type == SPACES_TO_TABS)
-        {
-          if (c == ' ' || in_range)
-            {
-              if (in_range == FALSE)
-                {
-                  /* set the start iter */
-                  iter = start_iter;
-
-                  /* get the real offset of the start iter */
-                  offset = mousepad_util_get_real_line_offset (&iter, tab_size);
-
-                  /* the number of spaces to inline with the tabs */
-                  n_spaces = tab_size - offset % tab_size;
-                }
-
-              /* check if we can already insert a tab */
-              if (n_spaces == 0)
-                {
-                  /* delete the selected spaces */
-                  gtk_text_buffer_delete (buffer, &iter, &start_iter);
-                  gtk_text_buffer_insert (buffer, &start_iter, "\t", 1);
-
-                  /* restore the end iter */
-                  gtk_text_buffer_get_iter_at_mark (buffer, &end_iter, mark);
-
-                  /* stop being inside a range */
-                  in_range = FALSE;
-
-                  /* no need to forward (iter moved after the insert */
-                  no_forward = TRUE;
-                }
-              else
-                {
-                  /* check whether we're still in a range */
-                  in_range = (c == ' ');
-                }
-
-              /* decrease counter */
-              n_spaces--;
-            }
-
-          /* go to next line if we reached text */
-          if (!g_unichar_isspace (c))
-            {
-              /* continue to the next line if we hit non spaces */
-              gtk_text_iter_forward_line (&start_iter);
-
-              /* make sure there is no valid range anymore */
-              in_range = FALSE;
+        converted = mousepad_util_spaces_to_tabs (slice, length, tab_size);
+      else
+        converted = mousepad_util_tabs_to_spaces (slice, length, column, tab_size);
 
-              /* no need to forward */
-              no_forward = TRUE;
-            }
-        }
-      else if (type == TABS_TO_SPACES && c == '\t')
+      if (converted != NULL)
         {
-          /* get the real offset of the iter */
-          offset = mousepad_util_get_real_line_offset (&start_iter, tab_size);
-
-          /* the number of spaces to inline with the tabs */
-          n_spaces = tab_size - offset % tab_size;
-
-          /* move one character forwards */
-          iter = start_iter;
-          gtk_text_iter_forward_char (&start_iter);
-
-          /* delete the tab */
-          gtk_text_buffer_delete (buffer, &iter, &start_iter);
-
-          /* create a string with the number of spaces */
-          string = g_strnfill (n_spaces, ' ');
+          new_length = strlen (converted);
 
-          /* insert the spaces */
-          gtk_text_buffer_insert (buffer, &start_iter, string, n_spaces);
+          /* skip the unchanged head and tail of the line */
+          for (prefix = 0; prefix < length && prefix < new_length
+               && slice[prefix] == converted[prefix]; prefix++);
+          for (suffix = 0; suffix < length - prefix && suffix < new_length - prefix
+               && slice[length - suffix - 1] == converted[new_length - suffix - 1]; suffix++);
 
-          /* cleanup */
-          g_free (string);
+          gtk_text_buffer_get_iter_at_line_index (buffer, &iter, line, index + prefix);
+          gtk_text_buffer_get_iter_at_line_index (buffer, &line_end, line, index + length - suffix);
+          gtk_text_buffer_delete (buffer, &iter, &line_end);
+          gtk_text_buffer_insert (buffer, &iter, converted + prefix, new_length - prefix - suffix);
 
           /* restore the end iter */
           gtk_text_buffer_get_iter_at_mark (buffer, &end_iter, mark);
 
-          /* iter already moved by the insert */
-          no_forward = TRUE;
+          g_free (converted);
         }
 
-      /* break when the iters are equal (or start is bigger) */
-      if (gtk_text_iter_compare (&start_iter, &end_iter) >= 0)
-        break;
+      g_free (slice);
 
-      /* forward the iter */
-      if (G_LIKELY (no_forward == FALSE))
-        gtk_text_iter_forward_char (&start_iter);
+      /* next line, if any left */
+      gtk_text_buffer_get_iter_at_line (buffer, &iter, line);
+      if (! gtk_text_iter_forward_line (&iter) || gtk_text_iter_compare (&iter, &end_iter) >= 0)
+        break;
     }
 
   /* delete our mark */
@@ -1374,72 +3011,88 @@ mousepad_view_convert_spaces_and_tabs (MousepadView *view,
 
 
 
-void
-mousepad_view_strip_trailing_spaces (MousepadView *view)
+gboolean
+mousepad_view_strip_trailing_spaces_range (MousepadView *view,
+                                           gint          start_line,
+                                           gint          end_line)
 {
-  GtkTextBuffer *buffer;
-  GtkTextIter    start_iter, end_iter, needle;
-  gint           start, end, i;
-  gunichar       c;
+  MousepadLineRange *range;
+  GtkTextBuffer     *buffer;
+  GtkTextIter        start_iter, end_iter;
+  GArray            *ranges;
+  gchar             *text;
+  guint              n;
 
-  g_return_if_fail (MOUSEPAD_IS_VIEW (view));
+  g_return_val_if_fail (MOUSEPAD_IS_VIEW (view), FALSE);
 
   /* get the buffer */
   buffer = mousepad_view_get_buffer (view);
 
-  /* get range in line numbers */
-  if (gtk_text_buffer_get_selection_bounds (buffer, &start_iter, &end_iter))
+  /* get a snapshot of the lines, up to the end of the buffer for a negative end line */
+  gtk_text_buffer_get_iter_at_line (buffer, &start_iter, start_line);
+  if (end_line < 0)
+    gtk_text_buffer_get_end_iter (buffer, &end_iter);
+  else
     {
-      start = gtk_text_iter_get_line (&start_iter);
-      end = gtk_text_iter_get_line (&end_iter) + 1;
+      gtk_text_buffer_get_iter_at_line (buffer, &end_iter, end_line);
+      if (! gtk_text_iter_ends_line (&end_iter))
+        gtk_text_iter_forward_to_line_end (&end_iter);
     }
-  else
+
+  text = gtk_text_buffer_get_slice (buffer, &start_iter, &end_iter, TRUE);
+  ranges = mousepad_util_find_trailing_blanks (text, strlen (text));
+  g_free (text);
+
+  /* leave the buffer, and the undo history, alone if all the lines are clean */
+  if (ranges->len == 0)
     {
-      start = 0;
-      end = gtk_text_buffer_get_line_count (buffer);
+      g_array_free (ranges, TRUE);
+      return FALSE;
     }
 
-  /* begin a user action and free notifications */
+  /* begin a user action and freeze notifications */
   g_object_freeze_notify (G_OBJECT (buffer));
   gtk_text_buffer_begin_user_action (buffer);
 
-  /* walk all the selected lines */
-  for (i = start; i < end; i++)
+  /* delete the ranges bottom-up, so no deletion moves text we still have to visit */
+  for (n = ranges->len; n > 0; n--)
     {
-      /* get the iter at the line */
-      gtk_text_buffer_get_iter_at_line (buffer, &end_iter, i);
+      range = &g_array_index (ranges, MousepadLineRange, n - 1);
+      gtk_text_buffer_get_iter_at_line_index (buffer, &start_iter,
+                                              start_line + range->line, range->start);
+      gtk_text_buffer_get_iter_at_line_index (buffer, &end_iter,
+                                              start_line + range->line, range->end);
+      gtk_text_buffer_delete (buffer, &start_iter, &end_iter);
+    }
 
-      /* continue if the line is empty */
-      if (gtk_text_iter_ends_line (&end_iter))
-        continue;
+  /* end the user action */
+  gtk_text_buffer_end_user_action (buffer);
+  g_object_thaw_notify (G_OBJECT (buffer));
 
-      /* move the iter to the end of the line */
-      gtk_text_iter_forward_to_line_end (&end_iter);
+  g_array_free (ranges, TRUE);
 
-      /* initialize the iters */
-      needle = start_iter = end_iter;
+  return TRUE;
+}
 
-      /* walk backwards until we hit something else then a space or tab */
-      while (gtk_text_iter_backward_char (&needle))
-        {
-          /* get the character */
-          c = gtk_text_iter_get_char (&needle);
 
-          /* set the start iter of the spaces range or stop searching */
-          if (c == ' ' || c == '\t')
-            start_iter = needle;
-          else
-            break;
-        }
 
-      /* remove the spaces/tabs if the iters are not equal */
-      if (!gtk_text_iter_equal (&start_iter, &end_iter))
-        gtk_text_buffer_delete (buffer, &start_iter, &end_iter);
-    }
+void
+mousepad_view_strip_trailing_spaces (MousepadView *view)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter    start_iter, end_iter;
 
-  /* end the user action */
-  gtk_text_buffer_end_user_action (buffer);
-  g_object_thaw_notify (G_OBJECT (buffer));
+  g_return_if_fail (MOUSEPAD_IS_VIEW (view));
+
+  /* get the buffer */
+  buffer = mousepad_view_get_buffer (view);
+
+  /* strip the selected lines or the whole buffer */
+  if (gtk_text_buffer_get_selection_bounds (buffer, &start_iter, &end_iter))
+    mousepad_view_strip_trailing_spaces_range (view, gtk_text_iter_get_line (&start_iter),
+                                               gtk_text_iter_get_line (&end_iter));
+  else
+    mousepad_view_strip_trailing_spaces_range (view, 0, -1);
 }
 
 
@@ -1510,7 +3163,7 @@ mousepad_view_move_selection (MousepadView *view,
       mark = gtk_text_buffer_create_mark (buffer, NULL, &iter, TRUE);
 
       /* copy the line above the selection  */
-      text = gtk_text_buffer_get_slice (buffer, &start_iter, &end_iter, FALSE);
+      text = gtk_text_buffer_get_slice (buffer, &start_iter, &end_iter, TRUE);
 
       /* delete the new line that we're going to insert later on */
       if (insert_eol && type == MOVE_LINE_UP)
@@ -1569,6 +3222,68 @@ mousepad_view_move_selection (MousepadView *view,
 
 
 
+void
+mousepad_view_sort_lines (MousepadView *view,
+                          gint          type)
+{
+  GtkTextBuffer *buffer;
+  GtkTextIter    start_iter, end_iter;
+  gchar         *text, *sorted;
+  gint           start_line;
+  gboolean       has_selection;
+
+  g_return_if_fail (MOUSEPAD_IS_VIEW (view));
+
+  /* get the buffer */
+  buffer = mousepad_view_get_buffer (view);
+
+  /* the selected lines, or the whole document */
+  has_selection = gtk_text_buffer_get_selection_bounds (buffer, &start_iter, &end_iter);
+  if (! has_selection)
+    gtk_text_buffer_get_bounds (buffer, &start_iter, &end_iter);
+
+  /* a line break ending the selection or the document stays where it is */
+  if (gtk_text_iter_starts_line (&end_iter)
+      && gtk_text_iter_get_line (&end_iter) > gtk_text_iter_get_line (&start_iter))
+    gtk_text_iter_backward_char (&end_iter);
+
+  /* extend the iters to whole lines */
+  start_line = gtk_text_iter_get_line (&start_iter);
+  gtk_text_iter_set_line_offset (&start_iter, 0);
+  if (!gtk_text_iter_ends_line (&end_iter))
+    gtk_text_iter_forward_to_line_end (&end_iter);
+
+  /* sort the lines extracted at once */
+  text = gtk_text_buffer_get_slice (buffer, &start_iter, &end_iter, TRUE);
+  sorted = mousepad_util_sort_lines (text, strlen (text), type);
+
+  /* write the result back as one replacement */
+  if (strcmp (text, sorted) != 0)
+    {
+      gtk_text_buffer_begin_user_action (buffer);
+      gtk_text_buffer_delete (buffer, &start_iter, &end_iter);
+      gtk_text_buffer_insert (buffer, &start_iter, sorted, -1);
+      gtk_text_buffer_end_user_action (buffer);
+
+      /* restore the selection over the lines */
+      if (has_selection)
+        {
+          end_iter = start_iter;
+          gtk_text_buffer_get_iter_at_line (buffer, &start_iter, start_line);
+          gtk_text_buffer_select_range (buffer, &end_iter, &start_iter);
+        }
+    }
+
+  /* cleanup */
+  g_free (text);
+  g_free (sorted);
+
+  /* put cursor on screen */
+  mousepad_view_scroll_to_cursor (view);
+}
+
+
+
 void
 mousepad_view_duplicate (MousepadView *view)
 {
@@ -1624,7 +3339,7 @@ mousepad_view_indent (MousepadView *view,
 
 
 
-gboolean
+gint
 mousepad_view_get_selection_length (MousepadView *view,
                                     gboolean     *is_column_selection)
 {
@@ -1633,19 +3348,19 @@ mousepad_view_get_selection_length (MousepadView *view,
   gint           sel_length = 0;
   gboolean       column_selection;
 
-  g_return_val_if_fail (MOUSEPAD_IS_VIEW (view), FALSE);
+  g_return_val_if_fail (MOUSEPAD_IS_VIEW (view), 0);
 
   /* get the text buffer */
   buffer = mousepad_view_get_buffer (view);
 
   /* whether this is a column selection */
-  column_selection = view->selection_marks != NULL || view->selection_start_x != -1;
+  column_selection = view->column_anchor_line != -1;
 
   /* we have a vertical selection */
   if (column_selection)
     {
-      /* get the selection count from the selection draw function */
-      sel_length = view->selection_length;
+      /* count the characters of the spans */
+      sel_length = mousepad_view_column_get_length (view);
     }
   else if (gtk_text_buffer_get_selection_bounds (buffer, &sel_start, &sel_end))
     {
@@ -1876,14 +3591,32 @@ mousepad_view_get_color_scheme (MousepadView *view)
 
 
 
+static void
+mousepad_view_update_wrap_mode (MousepadView *view)
+{
+  GtkWrapMode mode;
+
+  /* long lines are never word wrapped, which needs the word boundaries of the whole
+   * line, but they may be split anywhere for display */
+  if (view->long_lines)
+    mode = view->split_long_lines ? GTK_WRAP_CHAR : GTK_WRAP_NONE;
+  else
+    mode = view->word_wrap ? GTK_WRAP_WORD_CHAR : GTK_WRAP_NONE;
+
+  if (gtk_text_view_get_wrap_mode (GTK_TEXT_VIEW (view)) != mode)
+    gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (view), mode);
+}
+
+
+
 void
 mousepad_view_set_word_wrap (MousepadView *view,
                              gboolean      enabled)
 {
   g_return_if_fail (MOUSEPAD_IS_VIEW (view));
 
-  gtk_text_view_set_wrap_mode (GTK_TEXT_VIEW (view),
-                               enabled ? GTK_WRAP_WORD_CHAR : GTK_WRAP_NONE);
+  view->word_wrap = enabled;
+  mousepad_view_update_wrap_mode (view);
   g_object_notify (G_OBJECT (view), "word-wrap");
 }
 
@@ -1892,13 +3625,9 @@ mousepad_view_set_word_wrap (MousepadView *view,
 gboolean
 mousepad_view_get_word_wrap (MousepadView *view)
 {
-  GtkWrapMode mode;
-
   g_return_val_if_fail (MOUSEPAD_IS_VIEW (view), FALSE);
 
-  mode = gtk_text_view_get_wrap_mode (GTK_TEXT_VIEW (view));
-
-  return (mode == GTK_WRAP_WORD_CHAR);
+  return view->word_wrap;
 }
 
 
@@ -1925,3 +3654,32 @@ mousepad_view_get_match_braces (MousepadView *view)
 
   return view->match_braces;
 }
+
+
+
+void
+mousepad_view_set_long_lines (MousepadView *view,
+                              gboolean      long_lines)
+{
+  g_return_if_fail (MOUSEPAD_IS_VIEW (view));
+
+  if (view->long_lines == long_lines)
+    return;
+
+  view->long_lines = long_lines;
+
+  mousepad_view_buffer_changed (view, NULL, NULL);
+  mousepad_view_update_wrap_mode (view);
+
+  g_object_notify (G_OBJECT (view), "long-lines");
+}
+
+
+
+gboolean
+mousepad_view_get_long_lines (MousepadView *view)
+{
+  g_return_val_if_fail (MOUSEPAD_IS_VIEW (view), FALSE);
+
+  return view->long_lines;
+}
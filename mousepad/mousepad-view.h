@@ -26,6 +26,9 @@ G_BEGIN_DECLS
 #define MOUSEPAD_IS_VIEW_CLASS(klass) (G_TYPE_CHECK_CLASS_CAST ((klass), MOUSEPADL_TYPE_VIEW))
 #define MOUSEPAD_VIEW_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), MOUSEPAD_TYPE_VIEW, MousepadViewClass))
 
+/* length in bytes of a line too long to be highlighted and word wrapped */
+#define MOUSEPAD_VIEW_LONG_LINE_LENGTH 65536
+
 typedef struct _MousepadViewClass MousepadViewClass;
 typedef struct _MousepadView      MousepadView;
 
@@ -61,6 +64,11 @@ void            mousepad_view_scroll_to_cursor          (MousepadView      *view
 
 void            mousepad_view_transpose                 (MousepadView      *view);
 
+void            mousepad_view_reverse_lines             (MousepadView      *view);
+
+void            mousepad_view_sort_lines                (MousepadView      *view,
+                                                         gint               type);
+
 void            mousepad_view_clipboard_cut             (MousepadView      *view);
 
 void            mousepad_view_clipboard_copy            (MousepadView      *view);
@@ -73,12 +81,24 @@ void            mousepad_view_delete_selection          (MousepadView      *view
 
 void            mousepad_view_select_all                (MousepadView      *view);
 
+void            mousepad_view_add_next_occurrence       (MousepadView      *view);
+
+void            mousepad_view_select_all_occurrences    (MousepadView      *view);
+
+void            mousepad_view_add_carets_to_lines       (MousepadView      *view);
+
+void            mousepad_view_clear_carets              (MousepadView      *view);
+
 void            mousepad_view_convert_selection_case    (MousepadView      *view,
                                                          gint               type);
 
 void            mousepad_view_convert_spaces_and_tabs   (MousepadView      *view,
                                                          gint               type);
 
+gboolean        mousepad_view_strip_trailing_spaces_range (MousepadView      *view,
+                                                           gint               start_line,
+                                                           gint               end_line);
+
 void            mousepad_view_strip_trailing_spaces     (MousepadView      *view);
 
 void            mousepad_view_move_selection            (MousepadView      *view,
@@ -120,6 +140,11 @@ void            mousepad_view_set_match_braces          (MousepadView      *view
 
 gboolean        mousepad_view_get_match_braces          (MousepadView      *view);
 
+void            mousepad_view_set_long_lines            (MousepadView      *view,
+                                                         gboolean           long_lines);
+
+gboolean        mousepad_view_get_long_lines            (MousepadView      *view);
+
 G_END_DECLS
 
 #endif /* !__MOUSEPAD_VIEW_H__ */
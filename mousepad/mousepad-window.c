@@ -25,6 +25,7 @@
 #include <mousepad/mousepad-search-bar.h>
 #include <mousepad/mousepad-statusbar.h>
 #include <mousepad/mousepad-print.h>
+#include <mousepad/mousepad-word-provider.h>
 #include <mousepad/mousepad-window.h>
 
 #include <glib/gstdio.h>
@@ -118,6 +119,10 @@ static void              mousepad_window_notebook_removed             (GtkNotebo
                                                                        GtkWidget              *page,
                                                                        guint                   page_num,
                                                                        MousepadWindow         *window);
+static void              mousepad_window_notebook_reordered           (GtkNotebook            *notebook,
+                                                                       GtkWidget              *page,
+                                                                       guint                   page_num,
+                                                                       MousepadWindow         *window);
 #if !GTK_CHECK_VERSION (3, 22, 0)
 static void              mousepad_window_notebook_menu_position       (GtkMenu                *menu,
                                                                        gint                   *x,
@@ -137,6 +142,12 @@ static GtkNotebook      *mousepad_window_notebook_create_window       (GtkNotebo
                                                                        gint                    y,
                                                                        MousepadWindow         *window);
 
+/* outline signals */
+static void              mousepad_window_outline_row_activated        (GtkTreeView            *tree_view,
+                                                                       GtkTreePath            *path,
+                                                                       GtkTreeViewColumn      *column,
+                                                                       MousepadWindow         *window);
+
 /* document signals */
 static void              mousepad_window_modified_changed             (MousepadWindow         *window);
 static void              mousepad_window_cursor_changed               (MousepadDocument       *document,
@@ -150,6 +161,9 @@ static void              mousepad_window_selection_changed            (MousepadD
 static void              mousepad_window_overwrite_changed            (MousepadDocument       *document,
                                                                        gboolean                overwrite,
                                                                        MousepadWindow         *window);
+static void              mousepad_window_long_lines_changed           (MousepadDocument       *document,
+                                                                       gboolean                long_lines,
+                                                                       MousepadWindow         *window);
 static void              mousepad_window_buffer_language_changed      (MousepadDocument       *document,
                                                                        GtkSourceLanguage      *language,
                                                                        MousepadWindow         *window);
@@ -176,12 +190,20 @@ static void              mousepad_window_menu_textview_popup          (GtkTextVi
                                                                        MousepadWindow         *window);
 static void              mousepad_window_update_fullscreen_action     (MousepadWindow         *window);
 static void              mousepad_window_update_line_numbers_action   (MousepadWindow         *window);
+static gboolean          mousepad_window_strip_on_save_enabled        (MousepadDocument       *document);
+static void              mousepad_window_strip_on_save                (MousepadDocument       *document);
 static void              mousepad_window_update_document_actions      (MousepadWindow         *window);
 static void              mousepad_window_update_color_scheme_action   (MousepadWindow         *window);
 static void              mousepad_window_update_actions               (MousepadWindow         *window);
 static void              mousepad_window_update_gomenu                (GSimpleAction          *action,
                                                                        GVariant               *value,
                                                                        gpointer                data);
+static void              mousepad_window_update_gomenu_items          (MousepadWindow         *window);
+static void              mousepad_window_queue_gomenu_update          (MousepadWindow         *window);
+static void              mousepad_window_gomenu_item_inserted         (GtkMenuShell           *menu,
+                                                                       GtkWidget              *menu_item,
+                                                                       gint                    position,
+                                                                       MousepadWindow         *window);
 static void              mousepad_window_update_tabs                  (MousepadWindow         *window,
                                                                        gchar                  *key,
                                                                        GSettings              *settings);
@@ -210,6 +232,8 @@ static void              mousepad_window_drag_data_received           (GtkWidget
 
 /* search bar */
 static void              mousepad_window_hide_search_bar              (MousepadWindow         *window);
+static void              mousepad_window_highlight_terms              (MousepadWindow         *window,
+                                                                       gchar                 **terms);
 
 /* history clipboard functions */
 static void              mousepad_window_paste_history_add            (MousepadWindow         *window);
@@ -329,6 +353,12 @@ static void              mousepad_window_action_strip_trailing_spaces (GSimpleAc
 static void              mousepad_window_action_transpose             (GSimpleAction          *action,
                                                                        GVariant               *value,
                                                                        gpointer                data);
+static void              mousepad_window_action_reverse_lines         (GSimpleAction          *action,
+                                                                       GVariant               *value,
+                                                                       gpointer                data);
+static void              mousepad_window_action_sort_lines            (GSimpleAction          *action,
+                                                                       GVariant               *value,
+                                                                       gpointer                data);
 static void              mousepad_window_action_move_line_up          (GSimpleAction          *action,
                                                                        GVariant               *value,
                                                                        gpointer                data);
@@ -357,6 +387,15 @@ static void              mousepad_window_action_replace_destroy       (MousepadW
 static void              mousepad_window_action_replace               (GSimpleAction          *action,
                                                                        GVariant               *value,
                                                                        gpointer                data);
+static void              mousepad_window_action_add_next_occurrence   (GSimpleAction          *action,
+                                                                       GVariant               *value,
+                                                                       gpointer                data);
+static void              mousepad_window_action_select_occurrences    (GSimpleAction          *action,
+                                                                       GVariant               *value,
+                                                                       gpointer                data);
+static void              mousepad_window_action_add_cursors_to_lines  (GSimpleAction          *action,
+                                                                       GVariant               *value,
+                                                                       gpointer                data);
 static void              mousepad_window_action_go_to_position        (GSimpleAction          *action,
                                                                        GVariant               *value,
                                                                        gpointer                data);
@@ -404,6 +443,9 @@ static void              mousepad_window_action_word_wrap             (GSimpleAc
 static void              mousepad_window_action_write_bom             (GSimpleAction          *action,
                                                                        GVariant               *value,
                                                                        gpointer                data);
+static void              mousepad_window_action_strip_on_save         (GSimpleAction          *action,
+                                                                       GVariant               *value,
+                                                                       gpointer                data);
 static void              mousepad_window_action_prev_tab              (GSimpleAction          *action,
                                                                        GVariant               *value,
                                                                        gpointer                data);
@@ -422,6 +464,25 @@ static void              mousepad_window_action_about                 (GSimpleAc
 
 
 
+typedef struct
+{
+  /* what the document actions show, computed from the active document */
+  gboolean            previous_tab;
+  gboolean            next_tab;
+  gint                page_num;
+  gint                n_pages;
+  gboolean            read_only;
+  gboolean            has_filename;
+  MousepadLineEnding  line_ending;
+  gboolean            write_bom;
+  gboolean            write_bom_sensitive;
+  gboolean            strip_on_save;
+  gboolean            can_undo;
+  gboolean            can_redo;
+  const gchar        *language_id;
+}
+MousepadWindowActionState;
+
 struct _MousepadWindowClass
 {
   GtkApplicationWindowClass __parent__;
@@ -439,11 +500,31 @@ struct _MousepadWindow
   GtkWidget           *menubar_box;
   GtkWidget           *menubar;
   GtkWidget           *toolbar;
+  GtkWidget           *paned;
   GtkWidget           *notebook;
+  GtkWidget           *outline;
   GtkWidget           *search_bar;
   GtkWidget           *statusbar;
   GtkWidget           *replace_dialog;
 
+  /* terms highlighted in all the documents, managed from the search bar */
+  gchar              **highlight_terms;
+
+  /* completion of the words of all the documents */
+  MousepadWordProvider *word_provider;
+
+  /* action states last applied, only what differs is applied on tab switches */
+  MousepadWindowActionState action_state;
+  gboolean             action_state_valid;
+
+  /* settings read on tab switches */
+  gboolean             cycle_tabs;
+  gboolean             path_in_title;
+
+  /* the "Go to Tab" items of this window, kept in sync with the notebook pages */
+  GMenu               *gomenu;
+  guint                gomenu_idle_id;
+
   /* contextual gtkmenus created from the GtkBuilder */
   GtkWidget           *textview_menu;
   GtkWidget           *tab_menu;
@@ -528,9 +609,11 @@ static const GActionEntry action_entries[] =
     { "edit.convert.strip-trailing-spaces", mousepad_window_action_strip_trailing_spaces, NULL, NULL, NULL },
 
     { "edit.convert.transpose", mousepad_window_action_transpose, NULL, NULL, NULL },
+    { "edit.convert.reverse-lines", mousepad_window_action_reverse_lines, NULL, NULL, NULL },
   /* "Move selection" submenu */
     { "edit.move-selection.line-up", mousepad_window_action_move_line_up, NULL, NULL, NULL },
     { "edit.move-selection.line-down", mousepad_window_action_move_line_down, NULL, NULL, NULL },
+    { "edit.sort-lines", mousepad_window_action_sort_lines, "i", NULL, NULL },
   { "edit.duplicate-line-selection", mousepad_window_action_duplicate, NULL, NULL, NULL },
   { "edit.increase-indent", mousepad_window_action_increase_indent, NULL, NULL, NULL },
   { "edit.decrease-indent", mousepad_window_action_decrease_indent, NULL, NULL, NULL },
@@ -543,6 +626,10 @@ static const GActionEntry action_entries[] =
   { "search.find-previous", mousepad_window_action_find_previous, NULL, NULL, NULL },
   { "search.find-and-replace", mousepad_window_action_replace, NULL, NULL, NULL },
 
+  { "search.add-next-occurrence", mousepad_window_action_add_next_occurrence, NULL, NULL, NULL },
+  { "search.select-all-occurrences", mousepad_window_action_select_occurrences, NULL, NULL, NULL },
+  { "search.add-cursors-to-lines", mousepad_window_action_add_cursors_to_lines, NULL, NULL, NULL },
+
   { "search.go-to", mousepad_window_action_go_to_position, NULL, NULL, NULL },
 
   /* "View" menu */
@@ -572,6 +659,7 @@ static const GActionEntry action_entries[] =
       { "document.line-ending", mousepad_window_action_line_ending, "i", "0", NULL },
 
     { "document.write-unicode-bom", NULL, NULL, "false", mousepad_window_action_write_bom },
+    { "document.strip-on-save", NULL, NULL, "false", mousepad_window_action_strip_on_save },
 
     { "document.previous-tab", mousepad_window_action_prev_tab, NULL, NULL, NULL },
     { "document.next-tab", mousepad_window_action_next_tab, NULL, NULL, NULL },
@@ -643,55 +731,69 @@ static const gchar *menubar_tooltips[] =
       N_("Remove all the trailing spaces from the selected line(s) or document"),
 
       N_("Reverse the order of something"),
+      N_("Reverse the order of the lines in the document"),
     /* "Move selection" submenu */
     NULL,
       N_("Move the selection one line up"),
       N_("Move the selection one line down"),
+    /* "Sort Lines" submenu */
+    NULL,
+      N_("Sort the selected lines or the document in ascending order"),
+      N_("Sort the selected lines or the document in descending order"),
+      N_("Sort the selected lines or the document by their leading number"),
+      N_("Sort the selected lines or the document, comparing numbers by value"),
+      N_("Sort the selected lines or the document, ignoring case"),
+      N_("Remove the duplicated lines from the selection or document"),
+      N_("Shuffle the selected lines or the document"),
     N_("Duplicate the current line or selection"),
     N_("Increase the indentation of the selection or current line"),
-    N_("Decrease the indentation of the selection or current line"), /* 40, textview menu end */
+    N_("Decrease the indentation of the selection or current line"), /* 49, textview menu end */
 
     N_("Show the preferences dialog"),
 
   /* "Search" menu */
   NULL,
-    N_("Search for text"), /* 43, toolbar item 12 */
+    N_("Search for text"), /* 52, toolbar item 12 */
     N_("Search forwards for the same text"),
     N_("Search backwards for the same text"),
-    N_("Search for and replace text"), /* 46, toolbar item 13 */
+    N_("Search for and replace text"), /* 55, toolbar item 13 */
 
-    N_("Go to a specific location in the document"), /* 47, toolbar item 14 */
+    N_("Select the next occurrence of the selection with an extra cursor"),
+    N_("Select all the occurrences of the selection with extra cursors"),
+    N_("Put a cursor at the end of each selected line"),
+
+    N_("Go to a specific location in the document"), /* 59, toolbar item 14 */
 
   /* "View" menu */
-  NULL, /* 48, view menu insertion flag */
+  NULL, /* 60, view menu insertion flag */
     N_("Change the editor font"),
 
     /* "Color Scheme" submenu */
-    NULL, /* 50, style sheme menu insertion flag */
+    NULL, /* 62, style sheme menu insertion flag */
     N_("Show line numbers"),
 
-    N_("Change the visibility of the main menubar"), /* 52, textview menu additional item */
+    N_("Change the visibility of the main menubar"), /* 64, textview menu additional item */
     N_("Change the visibility of the toolbar"),
     N_("Change the visibility of the statusbar"),
 
-    N_("Make the window fullscreen"), /* 55, toolbar item 15 */
+    N_("Make the window fullscreen"), /* 67, toolbar item 15 */
 
   /* "Document" menu */
-  NULL, /* 56, document menu insertion flag */
+  NULL, /* 68, document menu insertion flag */
     N_("Toggle breaking lines in between words"),
     N_("Auto indent a new line"),
     /* "Tab Size" submenu */
-    NULL, /* 59, tab size menu insertion flag */
+    NULL, /* 71, tab size menu insertion flag */
       NULL,
       NULL,
       NULL,
       NULL,
-      N_("Set custom tab size"), /* 64, custom tab size tooltip */
+      N_("Set custom tab size"), /* 76, custom tab size tooltip */
 
       N_("Insert spaces when the tab button is pressed"),
 
     /* "Filetype" submenu */
-    NULL, /* 66, languages menu insertion flag */
+    NULL, /* 78, languages menu insertion flag */
     /* "Line Ending" submenu */
     NULL,
       N_("Set the line ending of the document to Unix (LF)"),
@@ -699,6 +801,7 @@ static const gchar *menubar_tooltips[] =
       N_("Set the line ending of the document to DOS / Windows (CR LF)"),
 
     N_("Store the byte-order mark in the file"),
+    N_("Remove the trailing spaces when saving documents of this filetype"),
 
     N_("Select the previous tab"),
     N_("Select the next tab"),
@@ -785,11 +888,24 @@ mousepad_window_update_window_title (MousepadWindow *window,
                                      gchar          *key,
                                      GSettings      *settings)
 {
+  window->path_in_title = MOUSEPAD_SETTING_GET_BOOLEAN (PATH_IN_TITLE);
   mousepad_window_set_title (window);
 }
 
 
 
+/* Called when cycle-tabs setting changes to update the tab actions. */
+static void
+mousepad_window_update_cycle_tabs (MousepadWindow *window,
+                                   gchar          *key,
+                                   GSettings      *settings)
+{
+  window->cycle_tabs = MOUSEPAD_SETTING_GET_BOOLEAN (CYCLE_TABS);
+  mousepad_window_update_actions (window);
+}
+
+
+
 /* Called when always-show-tabs setting changes to update the UI. */
 static void
 mousepad_window_update_tabs (MousepadWindow *window,
@@ -885,7 +1001,8 @@ mousepad_window_create_contextual_menus (MousepadWindow *window)
   GPtrArray   *tooltips;
   gint         textview_menu_indices[] = { 16, 17, 18, 19, 20, 21, 22, 23, 24, 25,
                                            26, 27, 28, 29, 30, 31, 32, 33, 34, 35,
-                                           36, 37, 38, 39, 40, 52 };
+                                           36, 37, 38, 39, 40, 41, 42, 43, 44, 45,
+                                           46, 47, 48, 49, 64 };
   gint         tab_menu_indices[] = { 7, 8, 10, 12, 13 };
   guint        index;
 
@@ -994,6 +1111,11 @@ mousepad_window_create_menubar (MousepadWindow *window)
   mousepad_util_container_move_children (GTK_CONTAINER (style_schemes_menu), GTK_CONTAINER (gtkmenu));
   gtk_widget_destroy (style_schemes_menu);
 
+  /* the "Go to Tab" items are the only ones inserted later in the document menu */
+  gtkmenu = mousepad_window_get_menubar_submenu (window, window->menubar, "document-menu-flag");
+  g_signal_connect_object (gtkmenu, "insert",
+                           G_CALLBACK (mousepad_window_gomenu_item_inserted), window, 0);
+
   /* insert the menubar in its previously reserved space */
   gtk_box_pack_start (GTK_BOX (window->menubar_box), window->menubar, TRUE, TRUE, 0);
 
@@ -1021,7 +1143,7 @@ mousepad_window_create_menubar (MousepadWindow *window)
   if (! show)
     {
       tooltips = g_ptr_array_new ();
-      g_ptr_array_add (tooltips, (gpointer) menubar_tooltips[52]);
+      g_ptr_array_add (tooltips, (gpointer) menubar_tooltips[64]);
       mousepad_window_menu_set_tooltips (window, window->textview_menu, tooltips, 1, 0);
       g_ptr_array_free (tooltips, TRUE);
     }
@@ -1129,11 +1251,11 @@ mousepad_window_create_toolbar (MousepadWindow *window)
   gtk_toolbar_insert (GTK_TOOLBAR (window->toolbar), item, -1);
 
   mousepad_window_toolbar_insert (window, _("_Find"), "edit-find",
-                                  menubar_tooltips[43], "win.search.find");
+                                  menubar_tooltips[52], "win.search.find");
   mousepad_window_toolbar_insert (window, _("Find and Rep_lace..."), "edit-find-replace",
-                                  menubar_tooltips[46], "win.search.find-and-replace");
+                                  menubar_tooltips[55], "win.search.find-and-replace");
   mousepad_window_toolbar_insert (window, _("_Go to..."), "go-jump",
-                                  menubar_tooltips[47], "win.search.go-to");
+                                  menubar_tooltips[59], "win.search.go-to");
 
   /* make the last toolbar separator so it expands properly */
   item = gtk_separator_tool_item_new ();
@@ -1142,7 +1264,7 @@ mousepad_window_create_toolbar (MousepadWindow *window)
   gtk_tool_item_set_expand (item, TRUE);
 
   mousepad_window_toolbar_insert (window, _("_Fullscreen"), "view-fullscreen",
-                                  menubar_tooltips[55], "win.view.fullscreen");
+                                  menubar_tooltips[67], "win.view.fullscreen");
 
   /* insert the toolbar in the main window box and show all widgets */
   gtk_box_pack_start (GTK_BOX (window->box), window->toolbar, FALSE, FALSE, 0);
@@ -1252,6 +1374,8 @@ mousepad_window_create_notebook (MousepadWindow *window)
                     G_CALLBACK (mousepad_window_notebook_added), window);
   g_signal_connect (G_OBJECT (window->notebook), "page-removed",
                     G_CALLBACK (mousepad_window_notebook_removed), window);
+  g_signal_connect (G_OBJECT (window->notebook), "page-reordered",
+                    G_CALLBACK (mousepad_window_notebook_reordered), window);
   g_signal_connect (G_OBJECT (window->notebook), "button-press-event",
                     G_CALLBACK (mousepad_window_notebook_button_press_event), window);
   g_signal_connect (G_OBJECT (window->notebook), "button-release-event",
@@ -1259,9 +1383,50 @@ mousepad_window_create_notebook (MousepadWindow *window)
   g_signal_connect (G_OBJECT (window->notebook), "create-window",
                     G_CALLBACK (mousepad_window_notebook_create_window), window);
 
-  /* append and show the notebook */
-  gtk_box_pack_start (GTK_BOX (window->box), window->notebook, TRUE, TRUE, PADDING);
+  /* append and show the notebook, beside the outline */
+  window->paned = gtk_paned_new (GTK_ORIENTATION_HORIZONTAL);
+  gtk_paned_pack1 (GTK_PANED (window->paned), window->notebook, TRUE, FALSE);
+  gtk_box_pack_start (GTK_BOX (window->box), window->paned, TRUE, TRUE, PADDING);
   gtk_widget_show (window->notebook);
+  gtk_widget_show (window->paned);
+}
+
+
+
+static void
+mousepad_window_create_outline (MousepadWindow *window)
+{
+  GtkTreeViewColumn *column;
+  GtkCellRenderer   *renderer;
+  GtkWidget         *scrolled_window;
+
+  /* the model is the outline of the active document */
+  window->outline = gtk_tree_view_new ();
+  gtk_tree_view_set_headers_visible (GTK_TREE_VIEW (window->outline), FALSE);
+  gtk_tree_view_set_activate_on_single_click (GTK_TREE_VIEW (window->outline), TRUE);
+  gtk_tree_view_set_search_column (GTK_TREE_VIEW (window->outline), MOUSEPAD_OUTLINE_COLUMN_NAME);
+
+  renderer = gtk_cell_renderer_text_new ();
+  g_object_set (renderer, "ellipsize", PANGO_ELLIPSIZE_END, NULL);
+  column = gtk_tree_view_column_new_with_attributes (NULL, renderer,
+                                                     "text", MOUSEPAD_OUTLINE_COLUMN_NAME,
+                                                     "xpad", MOUSEPAD_OUTLINE_COLUMN_PADDING,
+                                                     NULL);
+  gtk_tree_view_append_column (GTK_TREE_VIEW (window->outline), column);
+
+  g_signal_connect (window->outline, "row-activated",
+                    G_CALLBACK (mousepad_window_outline_row_activated), window);
+
+  /* append the outline, shown when enabled */
+  scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+  gtk_scrolled_window_set_policy (GTK_SCROLLED_WINDOW (scrolled_window),
+                                  GTK_POLICY_NEVER, GTK_POLICY_AUTOMATIC);
+  gtk_widget_set_size_request (scrolled_window, 200, -1);
+  gtk_container_add (GTK_CONTAINER (scrolled_window), window->outline);
+  gtk_paned_pack2 (GTK_PANED (window->paned), scrolled_window, FALSE, FALSE);
+  gtk_widget_show (window->outline);
+
+  MOUSEPAD_SETTING_BIND (OUTLINE_VISIBLE, scrolled_window, "visible", G_SETTINGS_BIND_GET);
 }
 
 
@@ -1338,11 +1503,17 @@ mousepad_window_init (MousepadWindow *window)
   /* initialize stuff */
   window->save_geometry_timer_id = 0;
   window->fullscreen_bars_timer_id = 0;
+  window->gomenu = g_menu_new ();
+  window->gomenu_idle_id = 0;
   window->search_bar = NULL;
   window->statusbar = NULL;
   window->replace_dialog = NULL;
+  window->highlight_terms = NULL;
   window->active = NULL;
   window->recent_manager = NULL;
+  window->action_state_valid = FALSE;
+  window->cycle_tabs = MOUSEPAD_SETTING_GET_BOOLEAN (CYCLE_TABS);
+  window->path_in_title = MOUSEPAD_SETTING_GET_BOOLEAN (PATH_IN_TITLE);
 
   /* increase clipboard history ref count */
   clipboard_history_ref_count++;
@@ -1384,6 +1555,12 @@ mousepad_window_init (MousepadWindow *window)
   /* create the notebook */
   mousepad_window_create_notebook (window);
 
+  /* create the outline panel */
+  mousepad_window_create_outline (window);
+
+  /* complete words from all the documents of the notebook */
+  window->word_provider = mousepad_word_provider_new (GTK_NOTEBOOK (window->notebook));
+
   /* create the statusbar */
   mousepad_window_create_statusbar (window);
 
@@ -1400,6 +1577,11 @@ mousepad_window_init (MousepadWindow *window)
                                    G_CALLBACK (mousepad_window_update_window_title),
                                    window, G_CONNECT_SWAPPED);
 
+  /* update the tab actions when 'cycle-tabs' setting changes */
+  MOUSEPAD_SETTING_CONNECT_OBJECT (CYCLE_TABS,
+                                   G_CALLBACK (mousepad_window_update_cycle_tabs),
+                                   window, G_CONNECT_SWAPPED);
+
   /* update the tabs when 'always-show-tabs' setting changes */
   MOUSEPAD_SETTING_CONNECT_OBJECT (ALWAYS_SHOW_TABS,
                                    G_CALLBACK (mousepad_window_update_tabs),
@@ -1426,6 +1608,9 @@ mousepad_window_init (MousepadWindow *window)
   MOUSEPAD_SETTING_CONNECT_OBJECT (INSERT_SPACES,
                                    G_CALLBACK (mousepad_window_update_document_actions),
                                    window, G_CONNECT_SWAPPED);
+  MOUSEPAD_SETTING_CONNECT_OBJECT (STRIP_ON_SAVE,
+                                   G_CALLBACK (mousepad_window_update_document_actions),
+                                   window, G_CONNECT_SWAPPED);
 
   /* set the initial style scheme from the setting */
   mousepad_window_update_color_scheme_action (window);
@@ -1442,6 +1627,9 @@ static void
 mousepad_window_dispose (GObject *object)
 {
   MousepadWindow *window = MOUSEPAD_WINDOW (object);
+  GtkApplication *application;
+  GMenuModel     *section;
+  GMenu          *menu;
 
   /* destroy the save geometry timer source */
   if (G_UNLIKELY (window->save_geometry_timer_id != 0))
@@ -1451,6 +1639,26 @@ mousepad_window_dispose (GObject *object)
   if (G_UNLIKELY (window->fullscreen_bars_timer_id != 0))
     g_source_remove (window->fullscreen_bars_timer_id);
 
+  /* destroy the "Go to Tab" update source */
+  if (G_UNLIKELY (window->gomenu_idle_id != 0))
+    g_source_remove (window->gomenu_idle_id);
+
+  /* stop showing the "Go to Tab" items of this window in the shared submenu */
+  application = gtk_window_get_application (GTK_WINDOW (window));
+  if (application != NULL)
+    {
+      menu = G_MENU (gtk_builder_get_object (mousepad_application_get_builder (
+                       MOUSEPAD_APPLICATION (application)), "document.go-to-tab"));
+      section = g_menu_model_get_n_items (G_MENU_MODEL (menu)) > 0
+                ? g_menu_model_get_item_link (G_MENU_MODEL (menu), 0, G_MENU_LINK_SECTION) : NULL;
+
+      if (section == G_MENU_MODEL (window->gomenu))
+        g_menu_remove_all (menu);
+
+      if (section != NULL)
+        g_object_unref (section);
+    }
+
   (*G_OBJECT_CLASS (mousepad_window_parent_class)->dispose) (object);
 }
 
@@ -1459,6 +1667,13 @@ mousepad_window_dispose (GObject *object)
 static void
 mousepad_window_finalize (GObject *object)
 {
+  MousepadWindow *window = MOUSEPAD_WINDOW (object);
+
+  /* cleanup */
+  g_strfreev (window->highlight_terms);
+  g_object_unref (window->word_provider);
+  g_object_unref (window->gomenu);
+
   /* decrease history clipboard ref count */
   clipboard_history_ref_count--;
 
@@ -1623,9 +1838,9 @@ mousepad_window_menubar_set_insertion_flags (MousepadWindow  *window,
   /* take into account the style schemes menu insertion in the basic menubar */
   application = MOUSEPAD_APPLICATION (gtk_window_get_application (GTK_WINDOW (window)));
   n_style_schemes = mousepad_application_get_n_style_schemes (application);
-  document_menu_index = 56 + n_style_schemes;
-  tab_size_menu_index = 59 + n_style_schemes;
-  languages_menu_index = 66 + n_style_schemes;
+  document_menu_index = 68 + n_style_schemes;
+  tab_size_menu_index = 71 + n_style_schemes;
+  languages_menu_index = 78 + n_style_schemes;
 
   children = gtk_container_get_children (GTK_CONTAINER (menu));
 
@@ -1638,9 +1853,9 @@ mousepad_window_menubar_set_insertion_flags (MousepadWindow  *window,
             gtk_widget_set_name (child->data, "template-menu-flag");
           else if (*index == 5)
             gtk_widget_set_name (child->data, "recent-menu-flag");
-          else if (*index == 48)
+          else if (*index == 60)
             gtk_widget_set_name (child->data, "view-menu-flag");
-          else if (*index == 50)
+          else if (*index == 62)
             gtk_widget_set_name (child->data, "style-schemes-menu-flag");
           else if (*index == document_menu_index)
             gtk_widget_set_name (child->data, "document-menu-flag");
@@ -1818,45 +2033,35 @@ mousepad_window_open_file (MousepadWindow   *window,
                            const gchar      *filename,
                            MousepadEncoding  encoding)
 {
-  MousepadDocument *document;
-  GError           *error = NULL;
-  gint              result;
-  gint              npages = 0, i;
-  gint              response;
-  const gchar      *charset;
-  const gchar      *opened_filename;
-  GtkWidget        *dialog;
-  gboolean          encoding_from_recent = FALSE;
-  gchar            *uri;
-  GtkRecentInfo    *info;
+  MousepadApplication *application;
+  MousepadDocument    *document;
+  GError              *error = NULL;
+  gint                 result;
+  gint                 response;
+  const gchar         *charset;
+  GtkWidget           *dialog, *notebook;
+  gboolean             encoding_from_recent = FALSE;
+  gchar               *uri;
+  GtkRecentInfo       *info;
 
   g_return_val_if_fail (MOUSEPAD_IS_WINDOW (window), FALSE);
   g_return_val_if_fail (filename != NULL && *filename != '\0', FALSE);
 
-  /* check if the file is already openend */
-  npages = gtk_notebook_get_n_pages (GTK_NOTEBOOK (window->notebook));
-  for (i = 0; i < npages; i++)
+  /* check if the file is already opened, in any window */
+  application = MOUSEPAD_APPLICATION (gtk_window_get_application (GTK_WINDOW (window)));
+  document = mousepad_application_find_document (application, filename);
+  if (document != NULL && GTK_IS_NOTEBOOK (notebook = gtk_widget_get_parent (GTK_WIDGET (document))))
     {
-      document = MOUSEPAD_DOCUMENT (gtk_notebook_get_nth_page (GTK_NOTEBOOK (window->notebook), i));
-
-      /* debug check */
-      g_return_val_if_fail (MOUSEPAD_IS_DOCUMENT (document), FALSE);
-
-      if (G_LIKELY (document))
-        {
-          /* get the filename */
-          opened_filename = mousepad_file_get_filename (MOUSEPAD_DOCUMENT (document)->file);
+      /* switch to the tab */
+      gtk_notebook_set_current_page (GTK_NOTEBOOK (notebook),
+                                     gtk_notebook_page_num (GTK_NOTEBOOK (notebook), GTK_WIDGET (document)));
 
-          /* see if the file is already opened */
-          if (opened_filename && strcmp (filename, opened_filename) == 0)
-            {
-              /* switch to the tab */
-              gtk_notebook_set_current_page (GTK_NOTEBOOK (window->notebook), i);
+      /* raise its window if it is another one */
+      if (notebook != window->notebook)
+        gtk_window_present (GTK_WINDOW (gtk_widget_get_toplevel (notebook)));
 
-              /* and we're done */
-              return TRUE;
-            }
-        }
+      /* and we're done */
+      return TRUE;
     }
 
   /* new document */
@@ -1885,6 +2090,11 @@ mousepad_window_open_file (MousepadWindow   *window,
   switch (result)
     {
       case 0:
+        /* protect the view against very long lines */
+        mousepad_view_set_long_lines (document->textview,
+                                      mousepad_file_get_longest_line (document->file)
+                                      > MOUSEPAD_VIEW_LONG_LINE_LENGTH);
+
         /* add the document to the window */
         mousepad_window_add (window, document);
 
@@ -2164,7 +2374,7 @@ mousepad_window_set_title (MousepadWindow *window)
   g_return_if_fail (MOUSEPAD_IS_WINDOW (window));
 
   /* whether to show the full path */
-  show_full_path = MOUSEPAD_SETTING_GET_BOOLEAN (PATH_IN_TITLE);
+  show_full_path = window->path_in_title;
 
   /* name we display in the title */
   if (G_UNLIKELY (show_full_path && mousepad_document_get_filename (document)))
@@ -2178,8 +2388,9 @@ mousepad_window_set_title (MousepadWindow *window)
   else
     string = g_strdup_printf ("%s%s - %s", gtk_text_buffer_get_modified (document->buffer) ? "*" : "", title, PACKAGE_NAME);
 
-  /* set the window title */
-  gtk_window_set_title (GTK_WINDOW (window), string);
+  /* set the window title, unless the previous document had the same */
+  if (g_strcmp0 (string, gtk_window_get_title (GTK_WINDOW (window))) != 0)
+    gtk_window_set_title (GTK_WINDOW (window), string);
 
   /* cleanup */
   g_free (string);
@@ -2236,6 +2447,10 @@ mousepad_window_notebook_switch_page (GtkNotebook     *notebook,
       /* set new active document */
       window->active = document;
 
+      /* show its outline */
+      gtk_tree_view_set_model (GTK_TREE_VIEW (window->outline),
+                               mousepad_outline_get_model (mousepad_document_get_outline (document)));
+
       /* set the window title */
       mousepad_window_set_title (window);
 
@@ -2269,6 +2484,8 @@ mousepad_window_notebook_added (GtkNotebook     *notebook,
                     G_CALLBACK (mousepad_window_selection_changed), window);
   g_signal_connect (G_OBJECT (page), "overwrite-changed",
                     G_CALLBACK (mousepad_window_overwrite_changed), window);
+  g_signal_connect (G_OBJECT (page), "long-lines-changed",
+                    G_CALLBACK (mousepad_window_long_lines_changed), window);
   g_signal_connect (G_OBJECT (page), "language-changed",
                     G_CALLBACK (mousepad_window_buffer_language_changed), window);
   g_signal_connect (G_OBJECT (page), "drag-data-received",
@@ -2281,9 +2498,26 @@ mousepad_window_notebook_added (GtkNotebook     *notebook,
                             G_CALLBACK (mousepad_window_modified_changed), window);
   g_signal_connect (G_OBJECT (document->textview), "populate-popup",
                     G_CALLBACK (mousepad_window_menu_textview_popup), window);
+  g_signal_connect_swapped (G_OBJECT (document->file), "filename-changed",
+                            G_CALLBACK (mousepad_window_queue_gomenu_update), window);
+
+  /* highlight the terms of this window */
+  mousepad_document_set_highlight_terms (document, (const gchar * const *) window->highlight_terms,
+                                         MOUSEPAD_SETTING_GET_BOOLEAN (SEARCH_MATCH_CASE));
+
+  /* let the other windows find the file of the document */
+  mousepad_application_index_document (MOUSEPAD_APPLICATION (gtk_window_get_application (GTK_WINDOW (window))),
+                                       document);
+
+  /* complete the words of this window */
+  gtk_source_completion_add_provider (gtk_source_view_get_completion (GTK_SOURCE_VIEW (document->textview)),
+                                      GTK_SOURCE_COMPLETION_PROVIDER (window->word_provider), NULL);
 
   /* change the visibility of the tabs accordingly */
   mousepad_window_update_tabs (window, NULL, NULL);
+
+  /* add the tab to the "Go to Tab" menu */
+  mousepad_window_queue_gomenu_update (window);
 }
 
 
@@ -2306,6 +2540,7 @@ mousepad_window_notebook_removed (GtkNotebook     *notebook,
   mousepad_disconnect_by_func (G_OBJECT (page), mousepad_window_cursor_changed, window);
   mousepad_disconnect_by_func (G_OBJECT (page), mousepad_window_selection_changed, window);
   mousepad_disconnect_by_func (G_OBJECT (page), mousepad_window_overwrite_changed, window);
+  mousepad_disconnect_by_func (G_OBJECT (page), mousepad_window_long_lines_changed, window);
   mousepad_disconnect_by_func (G_OBJECT (page), mousepad_window_buffer_language_changed, window);
   mousepad_disconnect_by_func (G_OBJECT (page), mousepad_window_drag_data_received, window);
   mousepad_disconnect_by_func (G_OBJECT (document->buffer), mousepad_window_can_undo, window);
@@ -2314,6 +2549,15 @@ mousepad_window_notebook_removed (GtkNotebook     *notebook,
                                mousepad_window_modified_changed, window);
   mousepad_disconnect_by_func (G_OBJECT (document->textview),
                                mousepad_window_menu_textview_popup, window);
+  mousepad_disconnect_by_func (G_OBJECT (document->file),
+                               mousepad_window_queue_gomenu_update, window);
+
+  /* stop completing the words of this window */
+  gtk_source_completion_remove_provider (gtk_source_view_get_completion (GTK_SOURCE_VIEW (document->textview)),
+                                         GTK_SOURCE_COMPLETION_PROVIDER (window->word_provider), NULL);
+
+  /* remove the tab from the "Go to Tab" menu */
+  mousepad_window_queue_gomenu_update (window);
 
   /* get the number of pages in this notebook */
   npages = gtk_notebook_get_n_pages (notebook);
@@ -2336,6 +2580,23 @@ mousepad_window_notebook_removed (GtkNotebook     *notebook,
 
 
 
+static void
+mousepad_window_notebook_reordered (GtkNotebook     *notebook,
+                                    GtkWidget       *page,
+                                    guint            page_num,
+                                    MousepadWindow  *window)
+{
+  g_return_if_fail (MOUSEPAD_IS_WINDOW (window));
+
+  /* the tabs have moved in the "Go to Tab" menu */
+  mousepad_window_queue_gomenu_update (window);
+
+  /* the position of the active tab may have changed */
+  mousepad_window_update_actions (window);
+}
+
+
+
 #if !GTK_CHECK_VERSION (3, 22, 0)
 static void
 mousepad_window_notebook_menu_position (GtkMenu  *menu,
@@ -2570,6 +2831,33 @@ mousepad_window_notebook_create_window (GtkNotebook    *notebook,
 
 
 
+/**
+ * Outline Signals Functions
+ **/
+static void
+mousepad_window_outline_row_activated (GtkTreeView       *tree_view,
+                                       GtkTreePath       *path,
+                                       GtkTreeViewColumn *column,
+                                       MousepadWindow    *window)
+{
+  GtkTreeIter row;
+  GtkTextIter iter;
+
+  g_return_if_fail (MOUSEPAD_IS_WINDOW (window));
+  g_return_if_fail (MOUSEPAD_IS_DOCUMENT (window->active));
+
+  if (! gtk_tree_model_get_iter (gtk_tree_view_get_model (tree_view), &row, path))
+    return;
+
+  /* jump to the symbol */
+  mousepad_outline_get_iter (mousepad_document_get_outline (window->active), &row, &iter);
+  gtk_text_buffer_place_cursor (window->active->buffer, &iter);
+  mousepad_view_scroll_to_cursor (window->active->textview);
+  gtk_widget_grab_focus (GTK_WIDGET (window->active->textview));
+}
+
+
+
 /**
  * Document Signals Functions
  **/
@@ -2616,7 +2904,8 @@ mousepad_window_selection_changed (MousepadDocument *document,
   const gchar *action_names_1[] = { "edit.convert.tabs-to-spaces",
                                     "edit.convert.spaces-to-tabs",
                                     "edit.duplicate-line-selection",
-                                    "edit.convert.strip-trailing-spaces" };
+                                    "edit.convert.strip-trailing-spaces",
+                                    "edit.sort-lines" };
   const gchar *action_names_2[] = { "edit.move-selection.line-up",
                                     "edit.move-selection.line-down" };
   const gchar *action_names_3[] = { "edit.cut",
@@ -2675,16 +2964,53 @@ mousepad_window_overwrite_changed (MousepadDocument *document,
 
 
 
+static void
+mousepad_window_long_lines_changed (MousepadDocument *document,
+                                    gboolean          long_lines,
+                                    MousepadWindow   *window)
+{
+  g_return_if_fail (MOUSEPAD_IS_WINDOW (window));
+  g_return_if_fail (MOUSEPAD_IS_DOCUMENT (document));
+
+  /* tell why highlighting and word wrap are off */
+  if (window->statusbar && document == window->active)
+    mousepad_statusbar_set_long_lines (MOUSEPAD_STATUSBAR (window->statusbar), long_lines);
+}
+
+
+
 static void
 mousepad_window_buffer_language_changed (MousepadDocument  *document,
                                          GtkSourceLanguage *language,
                                          MousepadWindow    *window)
 {
+  GAction     *action;
+  const gchar *language_id;
+
   g_return_if_fail (MOUSEPAD_IS_WINDOW (window));
   g_return_if_fail (MOUSEPAD_IS_DOCUMENT (document));
 
   /* update the filetype shown in the statusbar */
   mousepad_statusbar_set_language (MOUSEPAD_STATUSBAR (window->statusbar), language);
+
+  if (document != window->active)
+    return;
+
+  /* strip on save is a per-language option */
+  mousepad_window_update_document_actions (window);
+
+  /* the strip on save state applied is only reused for the language it was read for */
+  language_id = g_intern_string (language ? gtk_source_language_get_id (language) : "plain-text");
+  if (language_id != window->action_state.language_id)
+    {
+      lock_menu_updates++;
+
+      action = g_action_map_lookup_action (G_ACTION_MAP (window), "document.filetype");
+      g_simple_action_set_state (G_SIMPLE_ACTION (action), g_variant_new_string (language_id));
+      window->action_state.language_id = language_id;
+
+      lock_menu_updates--;
+    }
 }
 
 
@@ -2698,7 +3024,12 @@ mousepad_window_can_undo (MousepadWindow *window,
   GAction     *action;
   gboolean     can_undo;
 
+  /* the other documents are synced on tab switches */
+  if (window->active == NULL || buffer != G_OBJECT (window->active->buffer))
+    return;
+
   can_undo = gtk_source_buffer_can_undo (GTK_SOURCE_BUFFER (buffer));
+  window->action_state.can_undo = can_undo;
 
   action = g_action_map_lookup_action (G_ACTION_MAP (window), "edit.undo");
   g_simple_action_set_enabled (G_SIMPLE_ACTION (action), can_undo);
@@ -2719,7 +3050,12 @@ mousepad_window_can_redo (MousepadWindow *window,
   GAction     *action;
   gboolean     can_redo;
 
+  /* the other documents are synced on tab switches */
+  if (window->active == NULL || buffer != G_OBJECT (window->active->buffer))
+    return;
+
   can_redo = gtk_source_buffer_can_redo (GTK_SOURCE_BUFFER (buffer));
+  window->action_state.can_redo = can_redo;
 
   action = g_action_map_lookup_action (G_ACTION_MAP (window), "edit.redo");
   g_simple_action_set_enabled (G_SIMPLE_ACTION (action), can_redo);
@@ -3009,7 +3345,7 @@ mousepad_window_menu_tab_sizes_update (MousepadWindow *window)
   /* set the "Other" menu tooltip */
   gtkmenu = mousepad_window_get_menubar_submenu (window, window->menubar, "tab-size-menu-flag");
   tooltips = g_ptr_array_new ();
-  g_ptr_array_add (tooltips, (gpointer) menubar_tooltips[64]);
+  g_ptr_array_add (tooltips, (gpointer) menubar_tooltips[76]);
   mousepad_window_menu_set_tooltips (window, gtkmenu, tooltips, 1, 2);
   g_ptr_array_free (tooltips, TRUE);
 
@@ -3120,6 +3456,40 @@ mousepad_window_update_line_numbers_action (MousepadWindow *window)
 
 
 
+static gboolean
+mousepad_window_strip_on_save_enabled (MousepadDocument *document)
+{
+  const gchar  *language_id;
+  gchar       **languages;
+  gboolean      enabled = FALSE;
+  guint         n;
+
+  /* documents without a language are listed as plain text */
+  language_id = mousepad_file_get_language_id (document->file);
+  if (language_id == NULL)
+    language_id = "plain-text";
+
+  MOUSEPAD_SETTING_GET (STRIP_ON_SAVE, "^as", &languages);
+  for (n = 0; languages[n] != NULL && ! enabled; n++)
+    enabled = (strcmp (languages[n], language_id) == 0);
+
+  g_strfreev (languages);
+
+  return enabled;
+}
+
+
+
+static void
+mousepad_window_strip_on_save (MousepadDocument *document)
+{
+  /* clean lines are left untouched, so this is a no-op for a clean document */
+  if (mousepad_window_strip_on_save_enabled (document))
+    mousepad_view_strip_trailing_spaces_range (document->textview, 0, -1);
+}
+
+
+
 static void
 mousepad_window_update_document_actions (MousepadWindow *window)
 {
@@ -3150,6 +3520,11 @@ mousepad_window_update_document_actions (MousepadWindow *window)
       action = g_action_map_lookup_action (G_ACTION_MAP (window), "document.tab.insert-spaces");
       g_simple_action_set_state (G_SIMPLE_ACTION (action), g_variant_new_boolean (active));
 
+      active = mousepad_window_strip_on_save_enabled (window->active);
+      action = g_action_map_lookup_action (G_ACTION_MAP (window), "document.strip-on-save");
+      g_simple_action_set_state (G_SIMPLE_ACTION (action), g_variant_new_boolean (active));
+      window->action_state.strip_on_save = active;
+
       /* allow menu actions again */
       lock_menu_updates--;
     }
@@ -3182,14 +3557,12 @@ mousepad_window_update_color_scheme_action (MousepadWindow *window)
 static void
 mousepad_window_update_actions (MousepadWindow *window)
 {
-  GAction            *action;
-  GtkNotebook        *notebook;
-  MousepadDocument   *document;
-  GtkSourceLanguage  *language;
-  MousepadLineEnding  line_ending;
-  gboolean            cycle_tabs, sensitive, value;
-  gint                n_pages, page_num;
-  const gchar        *language_id;
+  MousepadWindowActionState  state, *applied = &window->action_state;
+  GAction                   *action;
+  GtkNotebook               *notebook;
+  MousepadDocument          *document;
+  GtkSourceLanguage         *language;
+  gboolean                   valid = window->action_state_valid;
 
   g_return_if_fail (MOUSEPAD_IS_WINDOW (window));
 
@@ -3202,61 +3575,108 @@ mousepad_window_update_actions (MousepadWindow *window)
       /* avoid menu actions */
       lock_menu_updates++;
 
-      /* determine the number of pages and the current page number */
-      n_pages = gtk_notebook_get_n_pages (notebook);
-      page_num = gtk_notebook_page_num (notebook, GTK_WIDGET (document));
-
-      /* whether we cycle tabs */
-      cycle_tabs = MOUSEPAD_SETTING_GET_BOOLEAN (CYCLE_TABS);
+      /* what the actions show for this document */
+      state.n_pages = gtk_notebook_get_n_pages (notebook);
+      state.page_num = gtk_notebook_page_num (notebook, GTK_WIDGET (document));
+      state.previous_tab = (window->cycle_tabs && state.n_pages > 1) || state.page_num > 0;
+      state.next_tab = (window->cycle_tabs && state.n_pages > 1) || state.page_num < state.n_pages - 1;
+      state.read_only = mousepad_file_get_read_only (document->file);
+      state.has_filename = mousepad_file_get_filename (document->file) != NULL;
+      state.line_ending = mousepad_file_get_line_ending (document->file);
+      state.write_bom = mousepad_file_get_write_bom (document->file, &state.write_bom_sensitive);
+      state.can_undo = gtk_source_buffer_can_undo (GTK_SOURCE_BUFFER (document->buffer));
+      state.can_redo = gtk_source_buffer_can_redo (GTK_SOURCE_BUFFER (document->buffer));
+      language = gtk_source_buffer_get_language (GTK_SOURCE_BUFFER (document->buffer));
+      state.language_id = g_intern_string (language ? gtk_source_language_get_id (language) : "plain-text");
+
+      /* strip on save is a per-language setting */
+      state.strip_on_save = (valid && state.language_id == applied->language_id)
+                            ? applied->strip_on_save : mousepad_window_strip_on_save_enabled (document);
+
+      /* only apply what differs from the previous document */
+#define CHANGED(field) (! valid || state.field != applied->field)
 
       /* set the sensitivity of the back and forward buttons in the go menu */
-      action = g_action_map_lookup_action (G_ACTION_MAP (window), "document.previous-tab");
-      g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
-                                   (cycle_tabs && n_pages > 1) || page_num > 0);
+      if (CHANGED (previous_tab))
+        {
+          action = g_action_map_lookup_action (G_ACTION_MAP (window), "document.previous-tab");
+          g_simple_action_set_enabled (G_SIMPLE_ACTION (action), state.previous_tab);
+        }
 
-      action = g_action_map_lookup_action (G_ACTION_MAP (window), "document.next-tab");
-      g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
-                                   (cycle_tabs && n_pages > 1 ) || page_num < n_pages - 1);
+      if (CHANGED (next_tab))
+        {
+          action = g_action_map_lookup_action (G_ACTION_MAP (window), "document.next-tab");
+          g_simple_action_set_enabled (G_SIMPLE_ACTION (action), state.next_tab);
+        }
 
       /* set the reload, detach and save sensitivity */
-      action = g_action_map_lookup_action (G_ACTION_MAP (window), "file.save");
-      g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
-                                   ! mousepad_file_get_read_only (document->file));
+      if (CHANGED (read_only))
+        {
+          action = g_action_map_lookup_action (G_ACTION_MAP (window), "file.save");
+          g_simple_action_set_enabled (G_SIMPLE_ACTION (action), ! state.read_only);
+        }
 
-      action = g_action_map_lookup_action (G_ACTION_MAP (window), "file.detach-tab");
-      g_simple_action_set_enabled (G_SIMPLE_ACTION (action), n_pages > 1);
+      if (CHANGED (n_pages))
+        {
+          action = g_action_map_lookup_action (G_ACTION_MAP (window), "file.detach-tab");
+          g_simple_action_set_enabled (G_SIMPLE_ACTION (action), state.n_pages > 1);
+        }
 
-      action = g_action_map_lookup_action (G_ACTION_MAP (window), "file.revert");
-      g_simple_action_set_enabled (G_SIMPLE_ACTION (action),
-                                   mousepad_file_get_filename (document->file) != NULL);
+      if (CHANGED (has_filename))
+        {
+          action = g_action_map_lookup_action (G_ACTION_MAP (window), "file.revert");
+          g_simple_action_set_enabled (G_SIMPLE_ACTION (action), state.has_filename);
+        }
 
       /* set the current line ending type */
-      line_ending = mousepad_file_get_line_ending (document->file);
-      action = g_action_map_lookup_action (G_ACTION_MAP (window), "document.line-ending");
-      g_simple_action_set_state (G_SIMPLE_ACTION (action), g_variant_new_int32 (line_ending));
+      if (CHANGED (line_ending))
+        {
+          action = g_action_map_lookup_action (G_ACTION_MAP (window), "document.line-ending");
+          g_simple_action_set_state (G_SIMPLE_ACTION (action), g_variant_new_int32 (state.line_ending));
+        }
 
       /* write bom */
-      action = g_action_map_lookup_action (G_ACTION_MAP (window), "document.write-unicode-bom");
-      value = mousepad_file_get_write_bom (document->file, &sensitive);
-      g_simple_action_set_state (G_SIMPLE_ACTION (action), g_variant_new_boolean (value));
-      g_simple_action_set_enabled (G_SIMPLE_ACTION (action), sensitive);
+      if (CHANGED (write_bom) || CHANGED (write_bom_sensitive))
+        {
+          action = g_action_map_lookup_action (G_ACTION_MAP (window), "document.write-unicode-bom");
+          g_simple_action_set_state (G_SIMPLE_ACTION (action), g_variant_new_boolean (state.write_bom));
+          g_simple_action_set_enabled (G_SIMPLE_ACTION (action), state.write_bom_sensitive);
+        }
 
-      /* toggle the document settings */
-      mousepad_window_update_document_actions (window);
+      /* the other document settings are global, only synced to their settings */
+      if (! valid)
+        mousepad_window_update_document_actions (window);
+      else if (CHANGED (strip_on_save))
+        {
+          action = g_action_map_lookup_action (G_ACTION_MAP (window), "document.strip-on-save");
+          g_simple_action_set_state (G_SIMPLE_ACTION (action), g_variant_new_boolean (state.strip_on_save));
+        }
 
       /* set the sensitivity of the undo and redo actions */
-      mousepad_window_can_undo (window, NULL, G_OBJECT (document->buffer));
-      mousepad_window_can_redo (window, NULL, G_OBJECT (document->buffer));
+      if (CHANGED (can_undo))
+        mousepad_window_can_undo (window, NULL, G_OBJECT (document->buffer));
+
+      if (CHANGED (can_redo))
+        mousepad_window_can_redo (window, NULL, G_OBJECT (document->buffer));
 
       /* active this tab in the go menu */
-      action = g_action_map_lookup_action (G_ACTION_MAP (window), "document.go-to-tab");
-      g_simple_action_set_state (G_SIMPLE_ACTION (action), g_variant_new_int32 (page_num));
+      if (CHANGED (page_num))
+        {
+          action = g_action_map_lookup_action (G_ACTION_MAP (window), "document.go-to-tab");
+          g_simple_action_set_state (G_SIMPLE_ACTION (action), g_variant_new_int32 (state.page_num));
+        }
 
       /* update the currently active language */
-      language = gtk_source_buffer_get_language (GTK_SOURCE_BUFFER (window->active->buffer));
-      language_id = language ? gtk_source_language_get_id (language) : "plain-text";
-      action = g_action_map_lookup_action (G_ACTION_MAP (window), "document.filetype");
-      g_simple_action_set_state (G_SIMPLE_ACTION (action), g_variant_new_string (language_id));
+      if (CHANGED (language_id))
+        {
+          action = g_action_map_lookup_action (G_ACTION_MAP (window), "document.filetype");
+          g_simple_action_set_state (G_SIMPLE_ACTION (action), g_variant_new_string (state.language_id));
+        }
+
+#undef CHANGED
+
+      *applied = state;
+      window->action_state_valid = TRUE;
 
       /* allow menu actions again */
       lock_menu_updates--;
@@ -3270,77 +3690,173 @@ mousepad_window_update_gomenu (GSimpleAction *action,
                                GVariant      *value,
                                gpointer       data)
 {
-  MousepadWindow   *window = MOUSEPAD_WINDOW (data);
-  MousepadDocument *document;
-  GtkBuilder       *builder;
-  GtkWidget        *gtkmenu;
-  GMenu            *menu;
-  GMenuItem        *item;
-  GAction          *subaction;
-  GPtrArray        *tooltips;
-  const gchar      *label;
-  gchar            *action_name, *accelerator;
-  guint             n_pages, n_tooltips, n;
+  MousepadWindow *window = MOUSEPAD_WINDOW (data);
+  GtkBuilder     *builder;
+  GMenuModel     *section;
+  GMenu          *menu;
 
   g_return_if_fail (MOUSEPAD_IS_WINDOW (window));
 
   /* opening the menu */
   if (g_variant_get_boolean (value))
     {
-      /* prevent menu updates */
-      lock_menu_updates++;
+      /* apply a pending update of the items right away */
+      if (window->gomenu_idle_id != 0)
+        {
+          g_source_remove (window->gomenu_idle_id);
+          mousepad_window_update_gomenu_items (window);
+        }
 
-      /* get and empty the "Go to tab" submenu */
+      /* the "Go to Tab" submenu is shared by all the windows: show the items of this one,
+       * unless they are already there */
       builder = mousepad_application_get_builder (MOUSEPAD_APPLICATION (
                   gtk_window_get_application (GTK_WINDOW (window))));
       menu = G_MENU (gtk_builder_get_object (builder, "document.go-to-tab"));
-      g_menu_remove_all (menu);
-
-      /* walk through the notebook pages */
-      n_pages = gtk_notebook_get_n_pages (GTK_NOTEBOOK (window->notebook));
-      tooltips = g_ptr_array_new ();
-      n_tooltips = 0;
+      section = g_menu_model_get_n_items (G_MENU_MODEL (menu)) > 0
+                ? g_menu_model_get_item_link (G_MENU_MODEL (menu), 0, G_MENU_LINK_SECTION) : NULL;
 
-      for (n = 0; n < n_pages; ++n)
+      if (section != G_MENU_MODEL (window->gomenu))
         {
-          document = MOUSEPAD_DOCUMENT (gtk_notebook_get_nth_page (GTK_NOTEBOOK (window->notebook), n));
+          g_menu_remove_all (menu);
+          g_menu_append_section (menu, NULL, G_MENU_MODEL (window->gomenu));
+        }
 
-          /* add the item to the "Go to Tab" submenu */
-          g_ptr_array_add (tooltips, (gchar*) mousepad_document_get_filename (document));
-          n_tooltips++;
-          label = mousepad_document_get_basename (document);
-          action_name = g_strdup_printf ("win.document.go-to-tab(%d)", n);
-          item = g_menu_item_new (label, action_name);
-          g_free (action_name);
+      if (section != NULL)
+        g_object_unref (section);
+    }
+}
 
-          if (G_LIKELY (n < 9))
-            {
-              /* create an accelerator and add it to the menu item */
-              accelerator = g_strdup_printf ("<Alt>%d", n + 1);
-              g_menu_item_set_attribute_value (item, "accel", g_variant_new_string (accelerator));
-              g_free (accelerator);
-            }
 
-          /* add the menu item */
-          g_menu_append_item (menu, item);
-          g_object_unref (item);
 
-          /* select the active entry */
-          if ((guint) gtk_notebook_get_current_page (GTK_NOTEBOOK (window->notebook)) == n)
+static void
+mousepad_window_update_gomenu_items (MousepadWindow *window)
+{
+  MousepadDocument *document;
+  GMenuItem        *item;
+  const gchar      *label;
+  gchar            *item_label, *action_name, *accelerator;
+  gint              n_pages, n_items, n;
+
+  n_pages = gtk_notebook_get_n_pages (GTK_NOTEBOOK (window->notebook));
+  n_items = g_menu_model_get_n_items (G_MENU_MODEL (window->gomenu));
+
+  /* an item only depends on the position and the name of its tab: only replace the
+   * items whose tab has changed */
+  for (n = 0; n < n_pages; n++)
+    {
+      document = MOUSEPAD_DOCUMENT (gtk_notebook_get_nth_page (GTK_NOTEBOOK (window->notebook), n));
+      label = mousepad_document_get_basename (document);
+
+      if (n < n_items)
+        {
+          if (g_menu_model_get_item_attribute (G_MENU_MODEL (window->gomenu), n,
+                                               G_MENU_ATTRIBUTE_LABEL, "s", &item_label))
             {
-              subaction = g_action_map_lookup_action (G_ACTION_MAP (window), "document.go-to-tab");
-              g_simple_action_set_state (G_SIMPLE_ACTION (subaction), g_variant_new_int32 (n));
+              if (g_strcmp0 (label, item_label) == 0)
+                {
+                  g_free (item_label);
+                  continue;
+                }
+
+              g_free (item_label);
             }
+
+          g_menu_remove (window->gomenu, n);
         }
+      else
+        n_items++;
 
-      /* update the tooltips */
-      gtkmenu = mousepad_window_get_menubar_submenu (window, window->menubar, "document-menu-flag");
-      mousepad_window_menu_set_tooltips (window, gtkmenu, tooltips, n_tooltips, 0);
-      g_ptr_array_free (tooltips, TRUE);
+      action_name = g_strdup_printf ("win.document.go-to-tab(%d)", n);
+      item = g_menu_item_new (label, action_name);
+      g_free (action_name);
 
-      /* release our lock */
-      lock_menu_updates--;
+      if (G_LIKELY (n < 9))
+        {
+          /* create an accelerator and add it to the menu item */
+          accelerator = g_strdup_printf ("<Alt>%d", n + 1);
+          g_menu_item_set_attribute_value (item, "accel", g_variant_new_string (accelerator));
+          g_free (accelerator);
+        }
+
+      /* insert the menu item */
+      g_menu_insert_item (window->gomenu, n, item);
+      g_object_unref (item);
     }
+
+  /* remove the items of the closed tabs */
+  while (n_items > n_pages)
+    g_menu_remove (window->gomenu, --n_items);
+}
+
+
+
+static gboolean
+mousepad_window_gomenu_idle (gpointer data)
+{
+  mousepad_window_update_gomenu_items (MOUSEPAD_WINDOW (data));
+
+  return FALSE;
+}
+
+
+
+static void
+mousepad_window_gomenu_idle_destroy (gpointer data)
+{
+  MOUSEPAD_WINDOW (data)->gomenu_idle_id = 0;
+}
+
+
+
+static void
+mousepad_window_queue_gomenu_update (MousepadWindow *window)
+{
+  /* tabs are often added or closed in a row, update the items once for all of them */
+  if (window->gomenu_idle_id == 0 && ! gtk_widget_in_destruction (GTK_WIDGET (window)))
+    window->gomenu_idle_id = g_idle_add_full (G_PRIORITY_LOW, mousepad_window_gomenu_idle,
+                                              window, mousepad_window_gomenu_idle_destroy);
+}
+
+
+
+static void
+mousepad_window_gomenu_item_selected (GtkWidget      *menu_item,
+                                      MousepadWindow *window)
+{
+  GtkWidget *document;
+  GList     *children;
+  gint       n_items, position;
+
+  /* the "Go to Tab" items are the last ones of the document menu */
+  children = gtk_container_get_children (GTK_CONTAINER (gtk_widget_get_parent (menu_item)));
+  position = g_list_length (children) - g_list_index (children, menu_item) - 1;
+  g_list_free (children);
+
+  /* show the file of the tab as tooltip */
+  n_items = g_menu_model_get_n_items (G_MENU_MODEL (window->gomenu));
+  document = gtk_notebook_get_nth_page (GTK_NOTEBOOK (window->notebook), n_items - 1 - position);
+  if (document != NULL)
+    mousepad_statusbar_push_tooltip (MOUSEPAD_STATUSBAR (window->statusbar),
+                                     mousepad_document_get_filename (MOUSEPAD_DOCUMENT (document)));
+}
+
+
+
+static void
+mousepad_window_gomenu_item_inserted (GtkMenuShell   *menu,
+                                      GtkWidget      *menu_item,
+                                      gint            position,
+                                      MousepadWindow *window)
+{
+  if (GTK_IS_SEPARATOR_MENU_ITEM (menu_item))
+    return;
+
+  /* their tab is only known from their position in the shown menu, so their tooltip
+   * is looked up when they are selected */
+  g_signal_connect_object (menu_item, "select",
+                           G_CALLBACK (mousepad_window_gomenu_item_selected), window, 0);
+  g_signal_connect_object (menu_item, "deselect",
+                           G_CALLBACK (mousepad_window_menu_item_deselected), window, 0);
 }
 
 
@@ -3737,7 +4253,7 @@ mousepad_window_search (MousepadWindow      *window,
                         const gchar         *string,
                         const gchar         *replacement)
 {
-  gint       nmatches = 0;
+  gint       nmatches = 0, n;
   gint       npages, i;
   GtkWidget *document;
 
@@ -3759,8 +4275,17 @@ mousepad_window_search (MousepadWindow      *window,
           document = gtk_notebook_get_nth_page (GTK_NOTEBOOK (window->notebook), i);
 
           /* replace the matches in the document */
-          nmatches += mousepad_util_search (MOUSEPAD_DOCUMENT (document)->search_context, string,
-                                            replacement, flags);
+          n = mousepad_util_search (MOUSEPAD_DOCUMENT (document)->search_context, string,
+                                    replacement, flags);
+
+          /* the pattern is too expensive, there is no point in trying the other documents */
+          if (G_UNLIKELY (n == MOUSEPAD_SEARCH_TOO_EXPENSIVE))
+            {
+              nmatches = n;
+              break;
+            }
+
+          nmatches += n;
         }
     }
   else if (window->active != NULL)
@@ -3811,6 +4336,33 @@ mousepad_window_hide_search_bar (MousepadWindow *window)
 
 
 
+static void
+mousepad_window_highlight_terms (MousepadWindow  *window,
+                                 gchar          **terms)
+{
+  GtkWidget *document;
+  gboolean   match_case;
+  gint       npages, i;
+
+  g_return_if_fail (MOUSEPAD_IS_WINDOW (window));
+
+  /* store the terms for the documents added later */
+  g_strfreev (window->highlight_terms);
+  window->highlight_terms = g_strdupv (terms);
+
+  /* apply them to all the documents of this window */
+  match_case = MOUSEPAD_SETTING_GET_BOOLEAN (SEARCH_MATCH_CASE);
+  npages = gtk_notebook_get_n_pages (GTK_NOTEBOOK (window->notebook));
+  for (i = 0; i < npages; i++)
+    {
+      document = gtk_notebook_get_nth_page (GTK_NOTEBOOK (window->notebook), i);
+      mousepad_document_set_highlight_terms (MOUSEPAD_DOCUMENT (document),
+                                             (const gchar * const *) terms, match_case);
+    }
+}
+
+
+
 /**
  * Paste from History
  **/
@@ -4194,6 +4746,11 @@ mousepad_window_action_new_from_template (GSimpleAction *action,
       /* handle the result */
       if (G_LIKELY (result == 0))
         {
+          /* protect the view against very long lines */
+          mousepad_view_set_long_lines (document->textview,
+                                        mousepad_file_get_longest_line (document->file)
+                                        > MOUSEPAD_VIEW_LONG_LINE_LENGTH);
+
           /* no errors, insert the document */
           mousepad_window_add (window, document);
           mousepad_file_set_language (window->active->file, language);
@@ -4466,6 +5023,7 @@ mousepad_window_action_save (GSimpleAction *action,
 
           case MOUSEPAD_RESPONSE_SAVE:
             /* save the document */
+            mousepad_window_strip_on_save (document);
             window->save_succeed = mousepad_file_save (document->file, &error);
             break;
         }
@@ -4474,6 +5032,10 @@ mousepad_window_action_save (GSimpleAction *action,
         {
           /* update the window title */
           mousepad_window_set_title (window);
+
+          /* the file may have just been created */
+          mousepad_application_index_document (MOUSEPAD_APPLICATION (gtk_window_get_application (GTK_WINDOW (window))),
+                                               document);
         }
       else if (error != NULL)
         {
@@ -4599,6 +5161,7 @@ mousepad_window_action_save_all (GSimpleAction *action,
           && mousepad_file_get_externally_modified (document->file, NULL) == FALSE)
         {
           /* try to quickly save the file */
+          mousepad_window_strip_on_save (document);
           succeed = mousepad_file_save (document->file, &error);
 
           /* break on problems */
@@ -4720,6 +5283,13 @@ mousepad_window_action_revert (GSimpleAction *action,
       mousepad_dialogs_show_error (GTK_WINDOW (window), error, _("Failed to reload the document"));
       g_error_free (error);
     }
+  else
+    {
+      /* the long lines may have come or gone */
+      mousepad_view_set_long_lines (document->textview,
+                                    mousepad_file_get_longest_line (document->file)
+                                    > MOUSEPAD_VIEW_LONG_LINE_LENGTH);
+    }
 }
 
 
@@ -5200,6 +5770,38 @@ mousepad_window_action_transpose (GSimpleAction *action,
 
 
 
+static void
+mousepad_window_action_reverse_lines (GSimpleAction *action,
+                                      GVariant      *value,
+                                      gpointer       data)
+{
+  MousepadWindow *window = MOUSEPAD_WINDOW (data);
+
+  g_return_if_fail (MOUSEPAD_IS_WINDOW (window));
+  g_return_if_fail (MOUSEPAD_IS_DOCUMENT (window->active));
+
+  /* reverse the lines of the document */
+  mousepad_view_reverse_lines (window->active->textview);
+}
+
+
+
+static void
+mousepad_window_action_sort_lines (GSimpleAction *action,
+                                   GVariant      *value,
+                                   gpointer       data)
+{
+  MousepadWindow *window = MOUSEPAD_WINDOW (data);
+
+  g_return_if_fail (MOUSEPAD_IS_WINDOW (window));
+  g_return_if_fail (MOUSEPAD_IS_DOCUMENT (window->active));
+
+  /* sort the lines the way the menu item says */
+  mousepad_view_sort_lines (window->active->textview, g_variant_get_int32 (value));
+}
+
+
+
 static void
 mousepad_window_action_move_line_up (GSimpleAction *action,
                                      GVariant      *value,
@@ -5304,6 +5906,8 @@ mousepad_window_action_find (GSimpleAction *action,
                                 G_CALLBACK (mousepad_window_hide_search_bar), window);
       g_signal_connect_swapped (G_OBJECT (window->search_bar), "search",
                                 G_CALLBACK (mousepad_window_search), window);
+      g_signal_connect_swapped (G_OBJECT (window->search_bar), "terms-changed",
+                                G_CALLBACK (mousepad_window_highlight_terms), window);
     }
 
   /* set the search entry text */
@@ -5441,6 +6045,54 @@ mousepad_window_action_replace (GSimpleAction *action,
 
 
 
+static void
+mousepad_window_action_add_next_occurrence (GSimpleAction *action,
+                                            GVariant      *value,
+                                            gpointer       data)
+{
+  MousepadWindow *window = MOUSEPAD_WINDOW (data);
+
+  g_return_if_fail (MOUSEPAD_IS_WINDOW (window));
+  g_return_if_fail (MOUSEPAD_IS_DOCUMENT (window->active));
+
+  /* add a cursor on the next occurrence of the selection */
+  mousepad_view_add_next_occurrence (window->active->textview);
+}
+
+
+
+static void
+mousepad_window_action_select_occurrences (GSimpleAction *action,
+                                           GVariant      *value,
+                                           gpointer       data)
+{
+  MousepadWindow *window = MOUSEPAD_WINDOW (data);
+
+  g_return_if_fail (MOUSEPAD_IS_WINDOW (window));
+  g_return_if_fail (MOUSEPAD_IS_DOCUMENT (window->active));
+
+  /* add a cursor on every occurrence of the selection */
+  mousepad_view_select_all_occurrences (window->active->textview);
+}
+
+
+
+static void
+mousepad_window_action_add_cursors_to_lines (GSimpleAction *action,
+                                             GVariant      *value,
+                                             gpointer       data)
+{
+  MousepadWindow *window = MOUSEPAD_WINDOW (data);
+
+  g_return_if_fail (MOUSEPAD_IS_WINDOW (window));
+  g_return_if_fail (MOUSEPAD_IS_DOCUMENT (window->active));
+
+  /* add a cursor at the end of each selected line */
+  mousepad_view_add_carets_to_lines (window->active->textview);
+}
+
+
+
 static void
 mousepad_window_action_go_to_position (GSimpleAction *action,
                                        GVariant      *value,
@@ -5666,7 +6318,7 @@ mousepad_window_update_main_widgets (MousepadWindow *window)
   if (! mb_active)
     {
       tooltips = g_ptr_array_new ();
-      g_ptr_array_add (tooltips, (gpointer) menubar_tooltips[52]);
+      g_ptr_array_add (tooltips, (gpointer) menubar_tooltips[64]);
       mousepad_window_menu_set_tooltips (window, window->textview_menu, tooltips, 1, 0);
       g_ptr_array_free (tooltips, TRUE);
     }
@@ -5786,6 +6438,7 @@ mousepad_window_action_line_ending (GSimpleAction *action,
 
       /* set the current state and the new line ending on the file */
       g_simple_action_set_state (action, value);
+      window->action_state.line_ending = g_variant_get_int32 (value);
       mousepad_file_set_line_ending (window->active->file, g_variant_get_int32 (value));
 
       /* make buffer as modified to show the user the change is not saved */
@@ -5864,6 +6517,7 @@ mousepad_window_action_language (GSimpleAction *action,
       lock_menu_updates++;
 
       g_simple_action_set_state (action, value);
+      window->action_state.language_id = g_intern_string (g_variant_get_string (value, NULL));
       language = gtk_source_language_manager_get_language (gtk_source_language_manager_get_default (),
                                                            g_variant_get_string (value, NULL));
       mousepad_file_set_language (window->active->file, language);
@@ -5933,6 +6587,7 @@ mousepad_window_action_write_bom (GSimpleAction *action,
 
       /* set the current state */
       g_simple_action_set_state (action, value);
+      window->action_state.write_bom = g_variant_get_boolean (value);
 
       /* set new value */
       mousepad_file_set_write_bom (window->active->file, g_variant_get_boolean (value));
@@ -5947,6 +6602,49 @@ mousepad_window_action_write_bom (GSimpleAction *action,
 
 
 
+static void
+mousepad_window_action_strip_on_save (GSimpleAction *action,
+                                      GVariant      *value,
+                                      gpointer       data)
+{
+  MousepadWindow  *window = MOUSEPAD_WINDOW (data);
+  GPtrArray       *list;
+  const gchar     *language_id;
+  gchar          **languages;
+  guint            n;
+
+  g_return_if_fail (MOUSEPAD_IS_WINDOW (window));
+  g_return_if_fail (MOUSEPAD_IS_DOCUMENT (window->active));
+
+  /* leave when menu updates are locked */
+  if (lock_menu_updates == 0)
+    {
+      language_id = mousepad_file_get_language_id (window->active->file);
+      if (language_id == NULL)
+        language_id = "plain-text";
+
+      /* rebuild the language list with or without the active language */
+      MOUSEPAD_SETTING_GET (STRIP_ON_SAVE, "^as", &languages);
+      list = g_ptr_array_new ();
+      for (n = 0; languages[n] != NULL; n++)
+        if (strcmp (languages[n], language_id) != 0)
+          g_ptr_array_add (list, languages[n]);
+
+      if (g_variant_get_boolean (value))
+        g_ptr_array_add (list, (gpointer) language_id);
+
+      g_ptr_array_add (list, NULL);
+
+      /* the action state is synced back through the setting */
+      MOUSEPAD_SETTING_SET (STRIP_ON_SAVE, "^as", list->pdata);
+
+      g_ptr_array_free (list, TRUE);
+      g_strfreev (languages);
+    }
+}
+
+
+
 static void
 mousepad_window_action_prev_tab (GSimpleAction *action,
                                  GVariant      *value,
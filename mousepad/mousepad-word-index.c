@@ -0,0 +1,572 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <mousepad/mousepad-private.h>
+#include <mousepad/mousepad-word-index.h>
+
+
+
+/* maximum length (in bytes) of an indexed word, and size (in bytes or characters) of an
+ * edit above which the whole buffer is indexed again in the background */
+#define MOUSEPAD_WORD_INDEX_MAX_BYTES     64
+#define MOUSEPAD_WORD_INDEX_REBUILD_SIZE  (1 << 16)
+
+
+
+typedef struct
+{
+  guint count;
+  gchar word[1];
+}
+MousepadWord;
+
+typedef struct
+{
+  /* word → its GSequenceIter in the sorted sequence of MousepadWord */
+  GHashTable *words;
+  GSequence  *sorted;
+}
+MousepadWordVocabulary;
+
+
+
+static void  mousepad_word_index_finalize      (GObject           *object);
+static void  mousepad_word_index_insert_text   (GtkTextBuffer     *buffer,
+                                                GtkTextIter       *location,
+                                                gchar             *text,
+                                                gint               len,
+                                                MousepadWordIndex *index);
+static void  mousepad_word_index_inserted_text (GtkTextBuffer     *buffer,
+                                                GtkTextIter       *location,
+                                                gchar             *text,
+                                                gint               len,
+                                                MousepadWordIndex *index);
+static void  mousepad_word_index_delete_range  (GtkTextBuffer     *buffer,
+                                                GtkTextIter       *start,
+                                                GtkTextIter       *end,
+                                                MousepadWordIndex *index);
+static void  mousepad_word_index_deleted_range (GtkTextBuffer     *buffer,
+                                                GtkTextIter       *start,
+                                                GtkTextIter       *end,
+                                                MousepadWordIndex *index);
+static void  mousepad_word_index_build         (MousepadWordIndex *index);
+static void  mousepad_word_index_scan_range    (MousepadWordIndex *index,
+                                                const GtkTextIter *start,
+                                                const GtkTextIter *end,
+                                                gint               delta);
+
+
+
+struct _MousepadWordIndexClass
+{
+  GObjectClass __parent__;
+};
+
+struct _MousepadWordIndex
+{
+  GObject                 __parent__;
+
+  /* the indexed buffer */
+  GtkTextBuffer          *buffer;
+
+  /* the words of the buffer with their number of occurrences */
+  MousepadWordVocabulary *vocabulary;
+
+  /* the words around an edit, between its "before" and "after" handlers: offset of the
+   * first character, and number of characters after the last one up to the buffer end */
+  gint                    edit_start;
+  gint                    edit_tail;
+  guint                   edit_pending : 1;
+
+  /* a background build is running, and the region edited since its snapshot */
+  GtkTextMark            *dirty_start;
+  GtkTextMark            *dirty_end;
+  guint                   building : 1;
+  guint                   dirty : 1;
+};
+
+
+
+G_DEFINE_TYPE (MousepadWordIndex, mousepad_word_index, G_TYPE_OBJECT)
+
+
+
+static void
+mousepad_word_index_class_init (MousepadWordIndexClass *klass)
+{
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = mousepad_word_index_finalize;
+}
+
+
+
+/**
+ * Vocabulary
+ **/
+static gint
+mousepad_word_compare (gconstpointer a,
+                       gconstpointer b,
+                       gpointer      data)
+{
+  return strcmp (((const MousepadWord *) a)->word, ((const MousepadWord *) b)->word);
+}
+
+
+
+static MousepadWordVocabulary *
+mousepad_word_vocabulary_new (void)
+{
+  MousepadWordVocabulary *vocabulary;
+
+  vocabulary = g_new (MousepadWordVocabulary, 1);
+  vocabulary->words = g_hash_table_new (g_str_hash, g_str_equal);
+  vocabulary->sorted = g_sequence_new (g_free);
+
+  return vocabulary;
+}
+
+
+
+static void
+mousepad_word_vocabulary_free (gpointer data)
+{
+  MousepadWordVocabulary *vocabulary = data;
+
+  /* the words are owned by the sequence */
+  g_hash_table_destroy (vocabulary->words);
+  g_sequence_free (vocabulary->sorted);
+  g_free (vocabulary);
+}
+
+
+
+static void
+mousepad_word_vocabulary_add (MousepadWordVocabulary *vocabulary,
+                              const gchar            *word,
+                              gsize                   length,
+                              gint                    delta)
+{
+  MousepadWord  *entry;
+  GSequenceIter *iter;
+  gchar          key[MOUSEPAD_WORD_INDEX_MAX_BYTES + 1];
+
+  memcpy (key, word, length);
+  key[length] = '\0';
+
+  iter = g_hash_table_lookup (vocabulary->words, key);
+  if (iter != NULL)
+    {
+      entry = g_sequence_get (iter);
+      if (delta > 0 || entry->count > (guint) -delta)
+        entry->count += delta;
+      else
+        {
+          /* last occurrence gone */
+          g_hash_table_remove (vocabulary->words, entry->word);
+          g_sequence_remove (iter);
+        }
+    }
+  else if (delta > 0)
+    {
+      entry = g_malloc (G_STRUCT_OFFSET (MousepadWord, word) + length + 1);
+      entry->count = delta;
+      memcpy (entry->word, key, length + 1);
+
+      iter = g_sequence_insert_sorted (vocabulary->sorted, entry, mousepad_word_compare, NULL);
+      g_hash_table_insert (vocabulary->words, entry->word, iter);
+    }
+}
+
+
+
+static void
+mousepad_word_vocabulary_scan (MousepadWordVocabulary *vocabulary,
+                               const gchar            *text,
+                               const gchar            *end,
+                               gint                    delta)
+{
+  const gchar *p = text, *word;
+  guint        n_chars;
+
+  while (p < end)
+    {
+      /* skip to the next word */
+      while (p < end && ! mousepad_word_index_is_word_char (g_utf8_get_char (p)))
+        p = g_utf8_next_char (p);
+
+      for (word = p, n_chars = 0; p < end && mousepad_word_index_is_word_char (g_utf8_get_char (p)); n_chars++)
+        p = g_utf8_next_char (p);
+
+      /* numbers are not worth completing */
+      if (n_chars >= MOUSEPAD_WORD_INDEX_MIN_CHARS && p - word <= MOUSEPAD_WORD_INDEX_MAX_BYTES
+          && ! g_unichar_isdigit (g_utf8_get_char (word)))
+        mousepad_word_vocabulary_add (vocabulary, word, p - word, delta);
+    }
+}
+
+
+
+static void
+mousepad_word_index_init (MousepadWordIndex *index)
+{
+  index->vocabulary = mousepad_word_vocabulary_new ();
+  index->edit_pending = FALSE;
+  index->building = FALSE;
+  index->dirty = FALSE;
+}
+
+
+
+static void
+mousepad_word_index_finalize (GObject *object)
+{
+  MousepadWordIndex *index = MOUSEPAD_WORD_INDEX (object);
+
+  /* no build is running, since it holds a reference on us */
+  g_signal_handlers_disconnect_by_data (index->buffer, index);
+  gtk_text_buffer_delete_mark (index->buffer, index->dirty_start);
+  gtk_text_buffer_delete_mark (index->buffer, index->dirty_end);
+  g_object_unref (index->buffer);
+
+  mousepad_word_vocabulary_free (index->vocabulary);
+
+  (*G_OBJECT_CLASS (mousepad_word_index_parent_class)->finalize) (object);
+}
+
+
+
+/**
+ * Background build
+ **/
+static void
+mousepad_word_index_build_thread (GTask        *task,
+                                  gpointer      source_object,
+                                  gpointer      task_data,
+                                  GCancellable *cancellable)
+{
+  MousepadWordVocabulary *vocabulary;
+  const gchar            *text = task_data;
+
+  vocabulary = mousepad_word_vocabulary_new ();
+  mousepad_word_vocabulary_scan (vocabulary, text, text + strlen (text), 1);
+
+  g_task_return_pointer (task, vocabulary, mousepad_word_vocabulary_free);
+}
+
+
+
+static void
+mousepad_word_index_build_ready (GObject      *object,
+                                 GAsyncResult *result,
+                                 gpointer      data)
+{
+  MousepadWordIndex      *index = MOUSEPAD_WORD_INDEX (object);
+  MousepadWordVocabulary *vocabulary;
+  GtkTextIter             start, end;
+  const gchar            *text, *text_start, *text_end;
+  gint                    head, tail;
+
+  text = g_task_get_task_data (G_TASK (result));
+  vocabulary = g_task_propagate_pointer (G_TASK (result), NULL);
+  index->building = FALSE;
+
+  mousepad_word_vocabulary_free (index->vocabulary);
+  index->vocabulary = vocabulary;
+
+  if (! index->dirty)
+    return;
+
+  index->dirty = FALSE;
+
+  /* extend the region edited meanwhile to the words it touches */
+  gtk_text_buffer_get_iter_at_mark (index->buffer, &start, index->dirty_start);
+  gtk_text_buffer_get_iter_at_mark (index->buffer, &end, index->dirty_end);
+  while (gtk_text_iter_backward_char (&start))
+    if (! mousepad_word_index_is_word_char (gtk_text_iter_get_char (&start)))
+      {
+        gtk_text_iter_forward_char (&start);
+        break;
+      }
+
+  while (mousepad_word_index_is_word_char (gtk_text_iter_get_char (&end)))
+    gtk_text_iter_forward_char (&end);
+
+  /* the text around it is the same in the snapshot: replace the words of the region
+   * in the snapshot by the current ones */
+  head = gtk_text_iter_get_offset (&start);
+  tail = gtk_text_buffer_get_char_count (index->buffer) - gtk_text_iter_get_offset (&end);
+  text_start = g_utf8_offset_to_pointer (text, head);
+  text_end = g_utf8_offset_to_pointer (text + strlen (text), -tail);
+  if (text_start < text_end)
+    mousepad_word_vocabulary_scan (vocabulary, text_start, text_end, -1);
+
+  mousepad_word_index_scan_range (index, &start, &end, 1);
+}
+
+
+
+static void
+mousepad_word_index_build (MousepadWordIndex *index)
+{
+  GtkTextIter  start, end;
+  GTask       *task;
+
+  index->building = TRUE;
+  index->dirty = FALSE;
+  index->edit_pending = FALSE;
+
+  gtk_text_buffer_get_bounds (index->buffer, &start, &end);
+
+  task = g_task_new (index, NULL, mousepad_word_index_build_ready, NULL);
+  g_task_set_task_data (task, gtk_text_buffer_get_text (index->buffer, &start, &end, TRUE), g_free);
+  g_task_run_in_thread (task, mousepad_word_index_build_thread);
+  g_object_unref (task);
+}
+
+
+
+/**
+ * Incremental updates
+ **/
+static void
+mousepad_word_index_scan_range (MousepadWordIndex *index,
+                                const GtkTextIter *start,
+                                const GtkTextIter *end,
+                                gint               delta)
+{
+  gchar *text;
+
+  text = gtk_text_iter_get_slice (start, end);
+  mousepad_word_vocabulary_scan (index->vocabulary, text, text + strlen (text), delta);
+  g_free (text);
+}
+
+
+
+static void
+mousepad_word_index_edit_begin (MousepadWordIndex *index,
+                                const GtkTextIter *edit_start,
+                                const GtkTextIter *edit_end)
+{
+  GtkTextIter start = *edit_start, end = *edit_end;
+
+  /* extend the edit to the words it touches, the only ones it may change */
+  while (gtk_text_iter_backward_char (&start))
+    if (! mousepad_word_index_is_word_char (gtk_text_iter_get_char (&start)))
+      {
+        gtk_text_iter_forward_char (&start);
+        break;
+      }
+
+  while (mousepad_word_index_is_word_char (gtk_text_iter_get_char (&end)))
+    gtk_text_iter_forward_char (&end);
+
+  /* drop them for now */
+  mousepad_word_index_scan_range (index, &start, &end, -1);
+
+  /* the text after the edit is left as is, so remember its distance to the buffer end */
+  index->edit_start = gtk_text_iter_get_offset (&start);
+  index->edit_tail = gtk_text_buffer_get_char_count (index->buffer) - gtk_text_iter_get_offset (&end);
+  index->edit_pending = TRUE;
+}
+
+
+
+static void
+mousepad_word_index_edit_end (MousepadWordIndex *index)
+{
+  GtkTextIter start, end;
+
+  if (! index->edit_pending)
+    return;
+
+  index->edit_pending = FALSE;
+
+  /* index the words of the edited region again */
+  gtk_text_buffer_get_iter_at_offset (index->buffer, &start, index->edit_start);
+  gtk_text_buffer_get_iter_at_offset (index->buffer, &end,
+                                      gtk_text_buffer_get_char_count (index->buffer) - index->edit_tail);
+  mousepad_word_index_scan_range (index, &start, &end, 1);
+}
+
+
+
+static void
+mousepad_word_index_add_dirty (MousepadWordIndex *index,
+                               const GtkTextIter *start,
+                               const GtkTextIter *end)
+{
+  GtkTextIter iter;
+
+  /* the region edited during a build, fixed once the build is installed */
+  if (! index->dirty)
+    {
+      gtk_text_buffer_move_mark (index->buffer, index->dirty_start, start);
+      gtk_text_buffer_move_mark (index->buffer, index->dirty_end, end);
+      index->dirty = TRUE;
+      return;
+    }
+
+  gtk_text_buffer_get_iter_at_mark (index->buffer, &iter, index->dirty_start);
+  if (gtk_text_iter_compare (start, &iter) < 0)
+    gtk_text_buffer_move_mark (index->buffer, index->dirty_start, start);
+
+  gtk_text_buffer_get_iter_at_mark (index->buffer, &iter, index->dirty_end);
+  if (gtk_text_iter_compare (end, &iter) > 0)
+    gtk_text_buffer_move_mark (index->buffer, index->dirty_end, end);
+}
+
+
+
+static void
+mousepad_word_index_insert_text (GtkTextBuffer     *buffer,
+                                 GtkTextIter       *location,
+                                 gchar             *text,
+                                 gint               len,
+                                 MousepadWordIndex *index)
+{
+  if (index->building)
+    mousepad_word_index_add_dirty (index, location, location);
+  else if (len <= MOUSEPAD_WORD_INDEX_REBUILD_SIZE)
+    mousepad_word_index_edit_begin (index, location, location);
+}
+
+
+
+static void
+mousepad_word_index_inserted_text (GtkTextBuffer     *buffer,
+                                   GtkTextIter       *location,
+                                   gchar             *text,
+                                   gint               len,
+                                   MousepadWordIndex *index)
+{
+  /* index large insertions (e.g. when loading a file) in the background */
+  if (index->building)
+    return;
+  else if (len > MOUSEPAD_WORD_INDEX_REBUILD_SIZE)
+    mousepad_word_index_build (index);
+  else
+    mousepad_word_index_edit_end (index);
+}
+
+
+
+static void
+mousepad_word_index_delete_range (GtkTextBuffer     *buffer,
+                                  GtkTextIter       *start,
+                                  GtkTextIter       *end,
+                                  MousepadWordIndex *index)
+{
+  if (index->building)
+    mousepad_word_index_add_dirty (index, start, end);
+  else if (gtk_text_iter_get_offset (end) - gtk_text_iter_get_offset (start)
+           <= MOUSEPAD_WORD_INDEX_REBUILD_SIZE)
+    mousepad_word_index_edit_begin (index, start, end);
+}
+
+
+
+static void
+mousepad_word_index_deleted_range (GtkTextBuffer     *buffer,
+                                   GtkTextIter       *start,
+                                   GtkTextIter       *end,
+                                   MousepadWordIndex *index)
+{
+  if (index->building)
+    return;
+  else if (! index->edit_pending)
+    mousepad_word_index_build (index);
+  else
+    mousepad_word_index_edit_end (index);
+}
+
+
+
+/**
+ * Public
+ **/
+MousepadWordIndex *
+mousepad_word_index_new (GtkTextBuffer *buffer)
+{
+  MousepadWordIndex *index;
+  GtkTextIter        start;
+
+  g_return_val_if_fail (GTK_IS_TEXT_BUFFER (buffer), NULL);
+
+  index = g_object_new (MOUSEPAD_TYPE_WORD_INDEX, NULL);
+  index->buffer = g_object_ref (buffer);
+
+  /* text inserted at the edges of the edited region belongs to it */
+  gtk_text_buffer_get_start_iter (buffer, &start);
+  index->dirty_start = gtk_text_buffer_create_mark (buffer, NULL, &start, TRUE);
+  index->dirty_end = gtk_text_buffer_create_mark (buffer, NULL, &start, FALSE);
+
+  g_signal_connect (buffer, "insert-text", G_CALLBACK (mousepad_word_index_insert_text), index);
+  g_signal_connect_after (buffer, "insert-text", G_CALLBACK (mousepad_word_index_inserted_text), index);
+  g_signal_connect (buffer, "delete-range", G_CALLBACK (mousepad_word_index_delete_range), index);
+  g_signal_connect_after (buffer, "delete-range", G_CALLBACK (mousepad_word_index_deleted_range), index);
+
+  /* the buffer may not be empty */
+  if (gtk_text_buffer_get_char_count (buffer) > 0)
+    mousepad_word_index_build (index);
+
+  return index;
+}
+
+
+
+gboolean
+mousepad_word_index_is_word_char (gunichar c)
+{
+  return c == '_' || g_unichar_isalnum (c);
+}
+
+
+
+void
+mousepad_word_index_collect (MousepadWordIndex *index,
+                             const gchar       *prefix,
+                             GHashTable        *counts)
+{
+  MousepadWord  *key, *entry;
+  GSequenceIter *iter;
+  gsize          length;
+
+  g_return_if_fail (MOUSEPAD_IS_WORD_INDEX (index));
+  g_return_if_fail (prefix != NULL);
+
+  /* the words starting with the prefix follow it in the sorted sequence, the search
+   * leaving out the prefix itself, which is most likely the word being typed */
+  length = strlen (prefix);
+  key = g_malloc (G_STRUCT_OFFSET (MousepadWord, word) + length + 1);
+  memcpy (key->word, prefix, length + 1);
+
+  for (iter = g_sequence_search (index->vocabulary->sorted, key, mousepad_word_compare, NULL);
+       ! g_sequence_iter_is_end (iter); iter = g_sequence_iter_next (iter))
+    {
+      entry = g_sequence_get (iter);
+      if (strncmp (entry->word, prefix, length) != 0)
+        break;
+
+      g_hash_table_replace (counts, entry->word,
+                            GUINT_TO_POINTER (GPOINTER_TO_UINT (g_hash_table_lookup (counts, entry->word))
+                                              + entry->count));
+    }
+
+  g_free (key);
+}
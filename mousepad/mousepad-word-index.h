@@ -0,0 +1,49 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __MOUSEPAD_WORD_INDEX_H__
+#define __MOUSEPAD_WORD_INDEX_H__
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* minimum number of characters of an indexed word */
+#define MOUSEPAD_WORD_INDEX_MIN_CHARS 3
+
+typedef struct _MousepadWordIndexClass MousepadWordIndexClass;
+typedef struct _MousepadWordIndex      MousepadWordIndex;
+
+#define MOUSEPAD_TYPE_WORD_INDEX            (mousepad_word_index_get_type ())
+#define MOUSEPAD_WORD_INDEX(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), MOUSEPAD_TYPE_WORD_INDEX, MousepadWordIndex))
+#define MOUSEPAD_WORD_INDEX_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), MOUSEPAD_TYPE_WORD_INDEX, MousepadWordIndexClass))
+#define MOUSEPAD_IS_WORD_INDEX(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), MOUSEPAD_TYPE_WORD_INDEX))
+#define MOUSEPAD_IS_WORD_INDEX_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), MOUSEPAD_TYPE_WORD_INDEX))
+#define MOUSEPAD_WORD_INDEX_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), MOUSEPAD_TYPE_WORD_INDEX, MousepadWordIndexClass))
+
+GType              mousepad_word_index_get_type      (void) G_GNUC_CONST;
+
+MousepadWordIndex *mousepad_word_index_new           (GtkTextBuffer     *buffer);
+
+gboolean           mousepad_word_index_is_word_char  (gunichar           c);
+
+void               mousepad_word_index_collect       (MousepadWordIndex *index,
+                                                      const gchar       *prefix,
+                                                      GHashTable        *counts);
+
+G_END_DECLS
+
+#endif /* !__MOUSEPAD_WORD_INDEX_H__ */
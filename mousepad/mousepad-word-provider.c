@@ -0,0 +1,276 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <mousepad/mousepad-private.h>
+#include <mousepad/mousepad-document.h>
+#include <mousepad/mousepad-settings.h>
+#include <mousepad/mousepad-word-index.h>
+#include <mousepad/mousepad-word-provider.h>
+
+
+
+/* maximum number of proposals shown */
+#define MOUSEPAD_WORD_PROVIDER_MAX_PROPOSALS 100
+
+
+
+typedef struct
+{
+  const gchar *word;
+  guint        count;
+}
+MousepadWordProposal;
+
+
+
+static void     mousepad_word_provider_iface_init        (GtkSourceCompletionProviderIface *iface);
+static void     mousepad_word_provider_finalize          (GObject                          *object);
+static void     mousepad_word_provider_update_activation (MousepadWordProvider             *provider);
+static gchar   *mousepad_word_provider_get_name          (GtkSourceCompletionProvider      *completion_provider);
+static void     mousepad_word_provider_populate          (GtkSourceCompletionProvider      *completion_provider,
+                                                          GtkSourceCompletionContext       *context);
+static gboolean mousepad_word_provider_get_start_iter    (GtkSourceCompletionProvider      *completion_provider,
+                                                          GtkSourceCompletionContext       *context,
+                                                          GtkSourceCompletionProposal      *proposal,
+                                                          GtkTextIter                      *iter);
+static GtkSourceCompletionActivation
+                mousepad_word_provider_get_activation    (GtkSourceCompletionProvider      *completion_provider);
+
+
+
+struct _MousepadWordProviderClass
+{
+  GObjectClass __parent__;
+};
+
+struct _MousepadWordProvider
+{
+  GObject      __parent__;
+
+  /* the notebook whose documents provide the words */
+  GtkNotebook *notebook;
+
+  /* whether proposals are shown while typing, or only on request */
+  guint        interactive : 1;
+};
+
+
+
+G_DEFINE_TYPE_WITH_CODE (MousepadWordProvider, mousepad_word_provider, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (GTK_SOURCE_TYPE_COMPLETION_PROVIDER,
+                                                mousepad_word_provider_iface_init))
+
+
+
+static void
+mousepad_word_provider_class_init (MousepadWordProviderClass *klass)
+{
+  GObjectClass *gobject_class;
+
+  gobject_class = G_OBJECT_CLASS (klass);
+  gobject_class->finalize = mousepad_word_provider_finalize;
+}
+
+
+
+static void
+mousepad_word_provider_iface_init (GtkSourceCompletionProviderIface *iface)
+{
+  iface->get_name = mousepad_word_provider_get_name;
+  iface->populate = mousepad_word_provider_populate;
+  iface->get_start_iter = mousepad_word_provider_get_start_iter;
+  iface->get_activation = mousepad_word_provider_get_activation;
+}
+
+
+
+static void
+mousepad_word_provider_init (MousepadWordProvider *provider)
+{
+  provider->notebook = NULL;
+
+  /* follow the setting */
+  mousepad_word_provider_update_activation (provider);
+  MOUSEPAD_SETTING_CONNECT_OBJECT (WORD_COMPLETION,
+                                   G_CALLBACK (mousepad_word_provider_update_activation),
+                                   provider, G_CONNECT_SWAPPED);
+}
+
+
+
+static void
+mousepad_word_provider_finalize (GObject *object)
+{
+  MousepadWordProvider *provider = MOUSEPAD_WORD_PROVIDER (object);
+
+  if (provider->notebook != NULL)
+    g_object_remove_weak_pointer (G_OBJECT (provider->notebook), (gpointer *) &provider->notebook);
+
+  (*G_OBJECT_CLASS (mousepad_word_provider_parent_class)->finalize) (object);
+}
+
+
+
+static void
+mousepad_word_provider_update_activation (MousepadWordProvider *provider)
+{
+  provider->interactive = MOUSEPAD_SETTING_GET_BOOLEAN (WORD_COMPLETION);
+}
+
+
+
+static gchar *
+mousepad_word_provider_get_name (GtkSourceCompletionProvider *completion_provider)
+{
+  return g_strdup (_("Words"));
+}
+
+
+
+static gboolean
+mousepad_word_provider_get_start_iter (GtkSourceCompletionProvider *completion_provider,
+                                       GtkSourceCompletionContext  *context,
+                                       GtkSourceCompletionProposal *proposal,
+                                       GtkTextIter                 *iter)
+{
+  gtk_source_completion_context_get_iter (context, iter);
+
+  /* the proposal replaces the beginning of the word before the cursor */
+  while (gtk_text_iter_backward_char (iter))
+    if (! mousepad_word_index_is_word_char (gtk_text_iter_get_char (iter)))
+      {
+        gtk_text_iter_forward_char (iter);
+        break;
+      }
+
+  return TRUE;
+}
+
+
+
+static gint
+mousepad_word_provider_compare (gconstpointer a,
+                                gconstpointer b)
+{
+  const MousepadWordProposal *proposal_a = a, *proposal_b = b;
+
+  /* most frequent words first */
+  if (proposal_a->count != proposal_b->count)
+    return proposal_a->count > proposal_b->count ? -1 : 1;
+
+  return g_utf8_collate (proposal_a->word, proposal_b->word);
+}
+
+
+
+static void
+mousepad_word_provider_populate (GtkSourceCompletionProvider *completion_provider,
+                                 GtkSourceCompletionContext  *context)
+{
+  MousepadWordProvider *provider = MOUSEPAD_WORD_PROVIDER (completion_provider);
+  MousepadWordProposal  word_proposal;
+  MousepadDocument     *document;
+  GHashTableIter        iter;
+  GtkTextIter           start, end;
+  GHashTable           *counts;
+  GArray               *word_proposals;
+  GList                *proposals = NULL;
+  gpointer              word, count;
+  gchar                *prefix;
+  guint                 n;
+  gint                  n_pages, page;
+
+  mousepad_word_provider_get_start_iter (completion_provider, context, NULL, &start);
+  gtk_source_completion_context_get_iter (context, &end);
+
+  /* while typing, wait for the beginning of a word */
+  if (provider->notebook == NULL
+      || gtk_text_iter_get_offset (&end) - gtk_text_iter_get_offset (&start)
+         < (gtk_source_completion_context_get_activation (context)
+            == GTK_SOURCE_COMPLETION_ACTIVATION_INTERACTIVE ? MOUSEPAD_WORD_INDEX_MIN_CHARS - 1 : 1))
+    {
+      gtk_source_completion_context_add_proposals (context, completion_provider, NULL, TRUE);
+      return;
+    }
+
+  /* merge the words of all the documents, borrowing them from their index */
+  prefix = gtk_text_iter_get_slice (&start, &end);
+  counts = g_hash_table_new (g_str_hash, g_str_equal);
+  n_pages = gtk_notebook_get_n_pages (provider->notebook);
+  for (page = 0; page < n_pages; page++)
+    {
+      document = MOUSEPAD_DOCUMENT (gtk_notebook_get_nth_page (provider->notebook, page));
+      mousepad_word_index_collect (mousepad_document_get_word_index (document), prefix, counts);
+    }
+
+  word_proposals = g_array_sized_new (FALSE, FALSE, sizeof (MousepadWordProposal),
+                                      g_hash_table_size (counts));
+  g_hash_table_iter_init (&iter, counts);
+  while (g_hash_table_iter_next (&iter, &word, &count))
+    {
+      word_proposal.word = word;
+      word_proposal.count = GPOINTER_TO_UINT (count);
+      g_array_append_val (word_proposals, word_proposal);
+    }
+
+  g_array_sort (word_proposals, mousepad_word_provider_compare);
+
+  /* build the proposals from the least to the most frequent word */
+  for (n = MIN (word_proposals->len, MOUSEPAD_WORD_PROVIDER_MAX_PROPOSALS); n > 0; n--)
+    {
+      word = (gpointer) g_array_index (word_proposals, MousepadWordProposal, n - 1).word;
+      proposals = g_list_prepend (proposals, gtk_source_completion_item_new (word, word, NULL, NULL));
+    }
+
+  gtk_source_completion_context_add_proposals (context, completion_provider, proposals, TRUE);
+
+  /* cleanup */
+  g_list_free_full (proposals, g_object_unref);
+  g_array_free (word_proposals, TRUE);
+  g_hash_table_destroy (counts);
+  g_free (prefix);
+}
+
+
+
+static GtkSourceCompletionActivation
+mousepad_word_provider_get_activation (GtkSourceCompletionProvider *completion_provider)
+{
+  MousepadWordProvider *provider = MOUSEPAD_WORD_PROVIDER (completion_provider);
+
+  if (provider->interactive)
+    return GTK_SOURCE_COMPLETION_ACTIVATION_INTERACTIVE | GTK_SOURCE_COMPLETION_ACTIVATION_USER_REQUESTED;
+
+  return GTK_SOURCE_COMPLETION_ACTIVATION_USER_REQUESTED;
+}
+
+
+
+MousepadWordProvider *
+mousepad_word_provider_new (GtkNotebook *notebook)
+{
+  MousepadWordProvider *provider;
+
+  g_return_val_if_fail (GTK_IS_NOTEBOOK (notebook), NULL);
+
+  provider = g_object_new (MOUSEPAD_TYPE_WORD_PROVIDER, NULL);
+
+  /* the provider is owned by the notebook window */
+  provider->notebook = notebook;
+  g_object_add_weak_pointer (G_OBJECT (notebook), (gpointer *) &provider->notebook);
+
+  return provider;
+}
@@ -0,0 +1,41 @@
+/*
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along with
+ * this program; if not, write to the Free Software Foundation, Inc., 59 Temple
+ * Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef __MOUSEPAD_WORD_PROVIDER_H__
+#define __MOUSEPAD_WORD_PROVIDER_H__
+
+#include <gtk/gtk.h>
+#include <gtksourceview/gtksource.h>
+
+G_BEGIN_DECLS
+
+typedef struct _MousepadWordProviderClass MousepadWordProviderClass;
+typedef struct _MousepadWordProvider      MousepadWordProvider;
+
+#define MOUSEPAD_TYPE_WORD_PROVIDER            (mousepad_word_provider_get_type ())
+#define MOUSEPAD_WORD_PROVIDER(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), MOUSEPAD_TYPE_WORD_PROVIDER, MousepadWordProvider))
+#define MOUSEPAD_WORD_PROVIDER_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), MOUSEPAD_TYPE_WORD_PROVIDER, MousepadWordProviderClass))
+#define MOUSEPAD_IS_WORD_PROVIDER(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), MOUSEPAD_TYPE_WORD_PROVIDER))
+#define MOUSEPAD_IS_WORD_PROVIDER_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), MOUSEPAD_TYPE_WORD_PROVIDER))
+#define MOUSEPAD_WORD_PROVIDER_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), MOUSEPAD_TYPE_WORD_PROVIDER, MousepadWordProviderClass))
+
+GType                 mousepad_word_provider_get_type (void) G_GNUC_CONST;
+
+MousepadWordProvider *mousepad_word_provider_new      (GtkNotebook *notebook);
+
+G_END_DECLS
+
+#endif /* !__MOUSEPAD_WORD_PROVIDER_H__ */